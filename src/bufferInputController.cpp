@@ -2,6 +2,9 @@
 This file represents the controller that adds text to a WL_Buffer. 
 Copy, Paste, write text, move cursor around
 
+Multiple cursors: Ctrl Shift Up/Down adds one on the line above/below, Ctrl Shift L gives every line of the selection one, 
+Ctrl Enter when finding puts one on every match & Ctrl drag with the mouse makes a column of them. Escape gets rid of them.
+
 */
 
 
@@ -26,266 +29,548 @@ static bool optionCanMoveDown(BufferControllerOption option) {
     }
 }
 
-static void updateNewCursorPos(WL_Buffer *b, int new_cursor_pos_inBytes, Selectable_State *selectable_state) {
+static void updateNewCursorPos(WL_Buffer *b, s64 new_cursor_pos_inBytes, Selectable_State *selectable_state) {
 	if(new_cursor_pos_inBytes >= 0){ //is valid move
 		if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) 
 		{
-			update_select(selectable_state, b->cursorAt_inBytes);
+			update_select(selectable_state, wl_buffer_get_cursor(b));
 		} else {
 			end_select(selectable_state);
 		}
 
-	    b->cursorAt_inBytes = new_cursor_pos_inBytes;
+	    wl_buffer_set_cursor(b, new_cursor_pos_inBytes);
 
 	    if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) 
 	    {
 	    	assert(selectable_state->is_active);
-	    	update_select(selectable_state, b->cursorAt_inBytes);
+	    	update_select(selectable_state, wl_buffer_get_cursor(b));
 	    } else {
 			end_select(selectable_state);
 		}
 	}
 }
 
-static int getCursorPosAtStartOfLine(WL_Buffer *b) {
-	u8 *start = (u8 *)(b->bufferMemory + (b->cursorAt_inBytes)); 
-	u8 *at = start;
-
-	if(*at == '\n' && (at - 1) >= b->bufferMemory) { at--; } //NOTE: Move past new line
-	if(*at == '\r' && (at - 1) >= b->bufferMemory) { at--; } //NOTE: Move past new line
+static s64 getCursorPosAtStartOfLine(WL_Buffer *b) {
+	s64 result = wl_buffer_get_line_start(b, wl_buffer_get_cursor(b));
+	return result;
 
-	//NOTE: Walk backwards till you find a new line
-	while(at >= b->bufferMemory) {
-		if(*at == '\n' || *at == '\r' || at == b->bufferMemory) {
-			//NOTE: Found new line
-			if(*at == '\n' || *at == '\r') {at++;}
-			break;
-		}
-		at--;
-	}
+}
 
-	int result = (int)(at - b->bufferMemory);
+static s64 getCursorPosAtEndOfLine(WL_Buffer *b) {
+	s64 result = wl_buffer_get_line_end(b, wl_buffer_get_cursor(b));
 	return result;
+}
+
+static float getRuneWidth(Font *font, float fontScale, u32 rune) {
+	float factor = 1.0f;
+
+	if(rune == '\t') {
+		rune = (u32)' ';
+		factor = 4.0f;
+	} 
+
+	GlyphInfo g = easyFont_getGlyph(font, rune);	
+	assert(g.unicodePoint == rune);
 
+	return (g.width + g.xoffset)*fontScale*factor;
 }
 
-static int getCursorPosAtEndOfLine(WL_Buffer *b) {
-	u8 *start = (u8 *)(b->bufferMemory + (b->cursorAt_inBytes)); 
-	u8 *at = start;
+#define X_POS_DECODE_CHUNK_SIZE_IN_BYTES 256
 
-	//NOTE: Walk backwards till you find a new line
-	while(at < (b->bufferMemory + b->bufferSize_inUse_inBytes)) {
-		if(*at == '\n' || *at == '\r') {
-			//NOTE: Found new line
-			break;
+static float getXposAtOffset(WL_Buffer *b, s64 cursor, Font *font, float fontScale) {
+	s64 at = wl_buffer_get_line_start(b, cursor);
+
+	float xAt = 0;
+
+	//NOTE: Copy the line out a chunk at a time and decode the whole chunk at once, instead of going back to the buffer for every rune
+	char bytes[X_POS_DECODE_CHUNK_SIZE_IN_BYTES];
+	u32 runes[X_POS_DECODE_CHUNK_SIZE_IN_BYTES];
+
+	//Now walk forwards to get x posistion
+	while(at < cursor) {
+		s64 count = cursor - at;
+		if(count > X_POS_DECODE_CHUNK_SIZE_IN_BYTES) { count = X_POS_DECODE_CHUNK_SIZE_IN_BYTES; }
+
+		wl_buffer_copy_bytes(b, at, count, (u8 *)bytes);
+
+		//NOTE: Don't decode a codepoint that's cut in half, it'll be at the start of the next chunk 
+		if(at + count < cursor) {
+			s64 last_start = count - 1;
+			while(last_start > 0 && easyUnicode_isContinuationByte(bytes[last_start])) {
+				last_start--;
+			}
+			if(last_start + easyUnicode_unicodeLength(bytes[last_start]) > count) {
+				count = last_start;
+			}
 		}
-		at++;
+
+		int rune_count = easyUnicode_utf8StreamToUtf32Stream(bytes, (int)count, runes);
+		for(int i = 0; i < rune_count; ++i) {
+			xAt += getRuneWidth(font, fontScale, runes[i]);
+		}
+
+		at += count;
 	}
 
-	int result = (int)(at - b->bufferMemory);
-	return result;
+	return xAt;
 }
 
 static float getXposAtInLine(WL_Buffer *b, Font *font, float fontScale) {
-	u8 *start = (u8 *)(b->bufferMemory + (b->cursorAt_inBytes)); 
-	u8 *at = start;
+	return getXposAtOffset(b, wl_buffer_get_cursor(b), font, fontScale);
+}
+
+//NOTE: Walk along the line that starts at lineStart and find the cursor position closest to xPos
+static s64 getCursorPosClosestToX(WL_Buffer *b, s64 lineStart, float xPos, Font *font, float fontScale) {
+	s64 lineEnd = wl_buffer_get_line_end(b, lineStart);
 
-	//NOTE: Walk backwards till you find a new line
-	while(at >= b->bufferMemory) {
-		if(*at == '\n' || *at == '\r' || at == b->bufferMemory) {
-			//NOTE: Found new line
+	s64 at = lineStart;
+	s64 new_cursor_pos_inBytes = lineStart;
+
+	float xAt = 0; 
+	float bestPos = get_abs_value(xPos);
+
+	//NOTE: Walk until end of line or best_position is found
+	while(at < lineEnd) {
+		u32 rune = wl_buffer_get_rune(b, &at);
+		xAt += getRuneWidth(font, fontScale, rune);
+
+		float val = get_abs_value(xAt - xPos);
+		if(val < bestPos) {
+			bestPos = val;
+			new_cursor_pos_inBytes = at;
+		} else {
 			break;
 		}
-		at--;
 	}
 
-	if(*at == '\n' || *at == '\r') {
-		at++;
-	}
+	return new_cursor_pos_inBytes;
+}
 
-	float xAt = 0;
-	//Now walk forwards to get x posistion
-	while(*at != '\n' && *at != '\r' && at < (b->bufferMemory + b->bufferSize_inUse_inBytes) && at < (b->bufferMemory + b->cursorAt_inBytes)) {
-		u32 rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&((char *)at), true);
-		float factor = 1.0f;
+static s64 getCusorPosLineBelow(WL_Buffer *b, Font *font, float fontScale, WL_Open_Buffer *open_buffer) {
+	s64 new_cursor_pos_inBytes = -1; //-1 not valid move
+
+	s64 line = wl_buffer_get_line_index(b, wl_buffer_get_cursor(b));
+
+	if((line + 1) < wl_buffer_get_line_count(b)) {
+		s64 lineBelowStart = wl_buffer_get_offset_of_line(b, line + 1);
+		new_cursor_pos_inBytes = getCursorPosClosestToX(b, lineBelowStart, open_buffer->moveVertical_xPos, font, fontScale);
+	} else {
+		//NOTE: We are on the last line of the buffer so don't bother trying to move down, so new_cursor_pos_inBytes is invalid 
+	}
+	
+	return new_cursor_pos_inBytes;
+}
 
-		if(rune == '\t') {
-			rune = (u32)' ';
-			factor = 4.0f;
-		} 
+static s64 getCusorPosLineAbove(EditorState *editorState, WL_Buffer *b, Font *font, float fontScale, WL_Open_Buffer *open_buffer) {
+	s64 new_cursor_pos_inBytes = -1; //-1 not valid move
 
-		GlyphInfo g = easyFont_getGlyph(font, rune);	
-		assert(g.unicodePoint == rune);
+	s64 line = wl_buffer_get_line_index(b, wl_buffer_get_cursor(b));
 
-		xAt += (g.width + g.xoffset)*fontScale*factor;
+	if(line > 0) {
+		s64 lineAboveStart = wl_buffer_get_offset_of_line(b, line - 1);
+		new_cursor_pos_inBytes = getCursorPosClosestToX(b, lineAboveStart, open_buffer->moveVertical_xPos, font, fontScale);
+	} else {
+		//NOTE: We are on the first line of the buffer so don't bother trying to move up
 	}
 
+	return new_cursor_pos_inBytes;
+}
 
-	return xAt;
+//NOTE: helper function to remove text if it is highlighted
+static void remove_text_if_highlighted(Selectable_State *selectable_state, WL_Buffer *b) {
+    if(selectable_state->is_active) {
+        Selectable_Diff diff = selectable_get_bytes_diff(selectable_state);
+        removeTextFromBuffer(b, diff.start, diff.size);
+
+        end_select(selectable_state);
+    }
 }
 
-static int getCusorPosLineBelow(WL_Buffer *b, Font *font, float fontScale, WL_Open_Buffer *open_buffer) {
-	int new_cursor_pos_inBytes = -1; //-1 not valid move
+//NOTE: MULTIPLE CURSORS. The extra cursors are anchors in the buffer, so they move along with the text when it's edited & only 
+//      cost O(log n) to keep up to date. Any edit that goes through them is one transaction over all the cursors at once, so it's 
+//      one pass over the text & one undo group however many cursors there are.
+
+//NOTE: Where one of the cursors edits. cursor_index is into the Selectable_State cursors, -1 for the main cursor
+struct Multi_Cursor_Site {
+    s64 start;
+    s64 end;
+    s64 cursor;
+    s32 cursor_index;
+};
+
+static void multiCursor_add(Selectable_State *state, WL_Buffer *b, s64 cursor, s64 select_start) {
+    if(state->cursor_count >= state->cursor_total) {
+        s32 new_total = (state->cursor_total > 0) ? 2*state->cursor_total : 64;
+        if(state->cursors) {
+            state->cursors = (Selectable_Cursor *)easyPlatform_reallocMemory(state->cursors, state->cursor_total*sizeof(Selectable_Cursor), new_total*sizeof(Selectable_Cursor));
+        } else {
+            state->cursors = (Selectable_Cursor *)easyPlatform_allocateMemory(new_total*sizeof(Selectable_Cursor), EASY_PLATFORM_MEMORY_NONE);
+        }
+        state->cursor_total = new_total;
+    }
 
-	u8 *at =  b->bufferMemory + b->cursorAt_inBytes;
+    //NOTE: Text put in right at a cursor pushes it along, like it does when you type
+    Selectable_Cursor *c = &state->cursors[state->cursor_count++];
+    c->cursor = anchorSet_add(&b->anchors, cursor, WL_ANCHOR_MOVES_WITH_INSERT);
+    c->select_start = anchorSet_add(&b->anchors, select_start, WL_ANCHOR_MOVES_WITH_INSERT);
+}
 
-	bool found = false;
-	while(at < (b->bufferMemory + b->bufferSize_inUse_inBytes) && !found) {
-		//NOTE: look for two lines above
+static void multiCursor_clear(Selectable_State *state, WL_Buffer *b) {
+    for(s32 i = 0; i < state->cursor_count; ++i) {
+        anchorSet_remove(&b->anchors, state->cursors[i].cursor);
+        anchorSet_remove(&b->anchors, state->cursors[i].select_start);
+    }
+    state->cursor_count = 0;
+}
 
-		if(at == (b->bufferMemory + b->bufferSize_inUse_inBytes - 1)) {
-			//NOTE: We are one the first line of the buffer so don't bother trying to move down, so new_cursor_pos_inBytes is invalid 
-			found = true;
-			break;
-		}
+static void multiCursor_free(Selectable_State *state, WL_Buffer *b) {
+    multiCursor_clear(state, b);
+    if(state->cursors) {
+        easyPlatform_freeMemory(state->cursors);
+    }
+    state->cursors = 0;
+    state->cursor_total = 0;
+}
 
-		if((*at == '\n' || *at == '\r') && !found) {
+static Multi_Cursor_Site multiCursor_get_site(Selectable_State *state, WL_Buffer *b, s32 cursor_index) {
+    Multi_Cursor_Site site = {};
+    site.cursor_index = cursor_index;
 
-			//NOTE: Found new line
-			found = true;
+    if(cursor_index < 0) {
+        site.cursor = wl_buffer_get_cursor(b);
+        site.start = site.end = site.cursor;
 
-			if(*at == '\r') { at++; } //NOTE: Move past new line
-			if(*at == '\n') { at++; } //NOTE: Move past new line
+        if(state->is_active) {
+            Selectable_Diff diff = selectable_get_bytes_diff(state);
+            site.start = diff.start;
+            site.end = diff.start + diff.size;
+        }
+    } else {
+        site.cursor = anchorSet_get_offset(&b->anchors, state->cursors[cursor_index].cursor);
+        s64 select_start = anchorSet_get_offset(&b->anchors, state->cursors[cursor_index].select_start);
 
-			bool looking_for = true;
+        site.start = (select_start < site.cursor) ? select_start : site.cursor;
+        site.end = (select_start < site.cursor) ? site.cursor : select_start;
+    }
 
-			if(*at == '\r' || *at == '\n') {
-				//NOTE: we are at a new line which got missed in the loop below, so we just set the new cursor position here
-				new_cursor_pos_inBytes = at - b->bufferMemory;
-				looking_for = false;
+    return site;
+}
 
-			}
+static int multiCursor_compare_sites(const void *a, const void *b) {
+    s64 a_start = ((Multi_Cursor_Site *)a)->start;
+    s64 b_start = ((Multi_Cursor_Site *)b)->start;
+    return (a_start < b_start) ? -1 : ((a_start > b_start) ? 1 : 0);
+}
+
+//NOTE: The cursors are nearly always in order already, they only get out of order when new ones are added. So if there's only a 
+//      few out of place it's an insertion sort, which is O(cursors) for them, otherwise it's qsort.
+#define MULTI_CURSOR_MAX_OUT_OF_ORDER_FOR_INSERTION_SORT 32
 
+static void multiCursor_sort_sites(Multi_Cursor_Site *sites, s32 site_count) {
+    s32 out_of_order_count = 0;
+    for(s32 i = 1; i < site_count; ++i) {
+        if(sites[i - 1].start > sites[i].start) {
+            out_of_order_count++;
+        }
+    }
 
-			
-			float xAt = 0; 
-			float bestPos = FLT_MAX;
+    if(out_of_order_count > MULTI_CURSOR_MAX_OUT_OF_ORDER_FOR_INSERTION_SORT) {
+        qsort(sites, site_count, sizeof(Multi_Cursor_Site), multiCursor_compare_sites);
+    } else if(out_of_order_count > 0) {
+        for(s32 i = 1; i < site_count; ++i) {
+            Multi_Cursor_Site site = sites[i];
 
-			//NOTE: Walk until end of line or best_position is found
-			while(*at != '\n' && *at != '\r' && at < (b->bufferMemory + b->bufferSize_inUse_inBytes) && looking_for) {
-				u32 rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&((char *)at), true);
-				float factor = 1.0f;
+            s32 j = i - 1;
+            while(j >= 0 && sites[j].start > site.start) {
+                sites[j + 1] = sites[j];
+                j--;
+            }
+            sites[j + 1] = site;
+        }
+    }
+}
 
-				if(rune == '\t') {
-					rune = (u32)' ';
-					factor = 4.0f;
-				} 
+//NOTE: All the cursors, the main one too, in order through the text. Cursors that overlap get merged into one, keeping the main 
+//      one if it's there. The extra cursors get put in the same order so it's quick to sort them next time.
+static Multi_Cursor_Site *multiCursor_get_sites(Selectable_State *state, WL_Buffer *b, Memory_Arena *arena, s32 *site_count) {
+    s32 count = 0;
+    Multi_Cursor_Site *sites = pushArray(arena, (state->cursor_count + 1), Multi_Cursor_Site);
 
-				GlyphInfo g = easyFont_getGlyph(font, rune);	
-				assert(g.unicodePoint == rune);
+    sites[count++] = multiCursor_get_site(state, b, -1);
+    for(s32 i = 0; i < state->cursor_count; ++i) {
+        sites[count++] = multiCursor_get_site(state, b, i);
+    }
 
-				xAt += (g.width + g.xoffset)*fontScale*factor;
+    multiCursor_sort_sites(sites, count);
 
-				float val = get_abs_value(xAt - open_buffer->moveVertical_xPos);
-				if(val < bestPos) {
-					bestPos = val;
-					new_cursor_pos_inBytes = at - b->bufferMemory;
-				} else {
-					looking_for = false;						
-				}
+    s32 merged_count = 0;
+    for(s32 i = 0; i < count; ++i) {
+        Multi_Cursor_Site site = sites[i];
 
-				//NOTE: at incremented by the getglyph function
-			}
-		}
+        if(merged_count > 0) {
+            Multi_Cursor_Site *last = &sites[merged_count - 1];
 
-		at++;
-	}
-	return new_cursor_pos_inBytes;
+            if(site.start < last->end || site.start == last->start) {
+                //NOTE: Keep the main cursor, the extra one goes
+                Multi_Cursor_Site *to_remove = &site;
+                if(site.cursor_index < 0) {
+                    to_remove = last;
+                }
+                
+                if(to_remove->cursor_index >= 0) {
+                    anchorSet_remove(&b->anchors, state->cursors[to_remove->cursor_index].cursor);
+                    anchorSet_remove(&b->anchors, state->cursors[to_remove->cursor_index].select_start);
+                }
+
+                if(site.cursor_index < 0) {
+                    last->cursor_index = -1;
+                    last->cursor = site.cursor;
+                }
+
+                if(site.end > last->end) {
+                    last->end = site.end;
+                }
+                continue;
+            }
+        }
+
+        sites[merged_count++] = site;
+    }
+
+    //NOTE: Put the extra cursors in the order of the sites
+    Selectable_Cursor *old_cursors = pushArray(arena, state->cursor_count, Selectable_Cursor);
+    memcpy(old_cursors, state->cursors, state->cursor_count*sizeof(Selectable_Cursor));
+
+    state->cursor_count = 0;
+    for(s32 i = 0; i < merged_count; ++i) {
+        if(sites[i].cursor_index >= 0) {
+            state->cursors[state->cursor_count] = old_cursors[sites[i].cursor_index];
+            sites[i].cursor_index = state->cursor_count++;
+        }
+    }
+
+    *site_count = merged_count;
+    return sites;
 }
 
-static int getCusorPosLineAbove(EditorState *editorState, WL_Buffer *b, Font *font, float fontScale, WL_Open_Buffer *open_buffer) {
-	int new_cursor_pos_inBytes = -1; //-1 not valid move
+//NOTE: Just the extra cursors that are between start & end, in order through the text. For drawing them.
+static Multi_Cursor_Site *multiCursor_get_sites_in_range(Selectable_State *state, WL_Buffer *b, Memory_Arena *arena, s64 start, s64 end, s32 *site_count) {
+    s32 count = 0;
+    Multi_Cursor_Site *sites = pushArray(arena, state->cursor_count, Multi_Cursor_Site);
 
-	u8 *at =  b->bufferMemory + b->cursorAt_inBytes;
+    for(s32 i = 0; i < state->cursor_count; ++i) {
+        Multi_Cursor_Site site = multiCursor_get_site(state, b, i);
+        if(site.end >= start && site.start <= end) {
+            sites[count++] = site;
+        }
+    }
 
-	//NOTE: Because we're moving backwards we could be at the end of line and the cursor would be at a newline, so this would cound as a new line, so we move back from these
-	if(*at == '\n' && (at - 1) >= b->bufferMemory) { at--; } //NOTE: Move past new line
-	if(*at == '\r' && (at - 1) >= b->bufferMemory) { at--; } //NOTE: Move past new line
+    multiCursor_sort_sites(sites, count);
 
-	int newlineCount = 0;
-	bool found = false;
-	while(at >= b->bufferMemory && !found) {
-		//NOTE: look for two lines above
+    *site_count = count;
+    return sites;
+}
 
-		if(at == b->bufferMemory && newlineCount == 0) {
-			//NOTE: We are one the first line of the buffer so don't bother trying to move up
-			found = true;
-			break;
-		}
+//NOTE: Puts the text in at every cursor, over what it's got selected. If remove_rune_before is set cursors without anything selected 
+//      take out the rune before them too, like backspace. 
+static void multiCursor_replace_text(Selectable_State *state, WL_Buffer *b, char *text, s64 text_size, bool remove_rune_before) {
+    s32 site_count = 0;
+    Multi_Cursor_Site *sites = multiCursor_get_sites(state, b, &globalPerFrameArena, &site_count);
 
-		if(*at == '\n' || *at == '\r' || (newlineCount == 1 && at == b->bufferMemory)) {
+    WL_Buffer_Transaction transaction = {};
 
-			
-			if(newlineCount == 0) {
-				if((at - 1) >= b->bufferMemory && *at == '\n' && *(at - 1) == '\r') {
-					at--; //Move past the newline 'token'because two characters cound as one new line :(
-				}
-			}
-			//NOTE: Found new line
-			newlineCount++;
+    s64 last_end = 0;
+    s64 shift = 0;
+    for(s32 i = 0; i < site_count; ++i) {
+        Multi_Cursor_Site *site = &sites[i];
+
+        if(remove_rune_before && site->start == site->end && site->start > 0) {
+            s64 rune_start = site->start - wl_buffer_get_size_of_rune_before(b, site->start);
+
+            //NOTE: Not if the cursor before already took it out
+            if(rune_start >= last_end) {
+                site->start = rune_start;
+            }
+        }
+
+        wl_buffer_transaction_add(&transaction, site->start, site->end - site->start, text, text_size);
+        last_end = site->end;
+
+        //NOTE: Where the cursor ends up, after the text it put in
+        site->cursor = site->start + shift + text_size;
+        shift += text_size - (site->end - site->start);
+    }
+
+    wl_buffer_commit_transaction(b, &transaction);
 
-			if(newlineCount > 1) {
+    for(s32 i = 0; i < site_count; ++i) {
+        Multi_Cursor_Site *site = &sites[i];
 
-				//NOTE: Found new line
-				found = true;
+        if(site->cursor_index < 0) {
+            wl_buffer_set_cursor(b, site->cursor);
+        } else {
+            anchorSet_set_offset(&b->anchors, state->cursors[site->cursor_index].cursor, site->cursor);
+            anchorSet_set_offset(&b->anchors, state->cursors[site->cursor_index].select_start, site->cursor);
+        }
+    }
 
-				if(*at == '\r') { at++; } //NOTE: Move past new line
-				if(*at == '\n') { at++; } //NOTE: Move past new line
+    end_select(state);
+}
 
-				bool looking_for = true;
+//NOTE: Where a cursor at offset goes with an arrow key, HOME or END. The same offset if it can't move.
+static s64 multiCursor_get_moved_offset(WL_Buffer *b, s64 offset, PlatformKeyType command, bool by_token, Font *font, float fontScale) {
+    s64 result = offset;
 
-				if(*at == '\r' || *at == '\n') {
-					//NOTE: we are at a new line which got missed in the loop below, so we just set the new cursor position here
-					new_cursor_pos_inBytes = at - b->bufferMemory;
-					looking_for = false;
+    if(command == PLATFORM_KEY_LEFT && offset > 0) {
+        s64 bytesOfPrevRune = wl_buffer_get_size_of_rune_before(b, offset);
 
-				}
+        if(by_token) {
+            EasyToken token = wl_buffer_peek_token_backwards(b, offset);
+            if(token.type != TOKEN_UNINITIALISED) {
+                bytesOfPrevRune = token.size;
+            }
+        }
 
-				float xAt = 0; 
-				float bestPos = FLT_MAX;
+        //NOTE: Windows style newline
+        if(offset >= 2 && wl_buffer_get_byte(b, offset - 2) == '\r' && wl_buffer_get_byte(b, offset - 1) == '\n') {
+            bytesOfPrevRune = 2;
+        }
 
-				//NOTE: Walk until end of line or best_position is found
-				while(looking_for && *at != '\n' && *at != '\r' && at < (b->bufferMemory + b->bufferSize_inUse_inBytes)) {
-					u32 rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&((char *)at), true);
-					float factor = 1.0f;
+        result = offset - bytesOfPrevRune;
+    } else if(command == PLATFORM_KEY_RIGHT && offset < wl_buffer_get_size_in_bytes(b)) {
+        s64 bytesOfNextRune = wl_buffer_get_size_of_rune_at(b, offset);
 
-					if(rune == '\t') {
-						rune = (u32)' ';
-						factor = 4.0f;
-					} 
+        if(by_token) {
+            EasyToken token = wl_buffer_peek_token_forward(b, offset);
+            if(token.type != TOKEN_UNINITIALISED) {
+                bytesOfNextRune = token.size;
+            }
+        }
 
-					GlyphInfo g = easyFont_getGlyph(font, rune);	
-					assert(g.unicodePoint == rune);
+        //NOTE: Windows style newline
+        if(wl_buffer_get_byte(b, offset) == '\r' && wl_buffer_get_byte(b, offset + 1) == '\n') {
+            bytesOfNextRune = 2;
+        }
 
-					xAt += (g.width + g.xoffset)*fontScale*factor;
+        result = offset + bytesOfNextRune;
+    } else if(command == PLATFORM_KEY_HOME) {
+        result = wl_buffer_get_line_start(b, offset);
+    } else if(command == PLATFORM_KEY_END) {
+        result = wl_buffer_get_line_end(b, offset);
+    } else if(command == PLATFORM_KEY_UP || command == PLATFORM_KEY_DOWN) {
+        s64 line = wl_buffer_get_line_index(b, offset) + ((command == PLATFORM_KEY_UP) ? -1 : 1);
+
+        if(line >= 0 && line < wl_buffer_get_line_count(b)) {
+            float xPos = getXposAtOffset(b, offset, font, fontScale);
+            result = getCursorPosClosestToX(b, wl_buffer_get_offset_of_line(b, line), xPos, font, fontScale);
+        }
+    }
 
-					float val = get_abs_value(xAt - open_buffer->moveVertical_xPos);
-					if(val < bestPos) {
-						bestPos = val;
-						new_cursor_pos_inBytes = at - b->bufferMemory;
-					} else {
-						looking_for = false;						
-					}
+    return result;
+}
 
-					//NOTE: at incremented by the getglyph function
-				}
-			}
-		}
+//NOTE: Moves the extra cursors the same way the main one moved
+static void multiCursor_move(Selectable_State *state, WL_Buffer *b, PlatformKeyType command, bool by_token, bool extend_select, Font *font, float fontScale) {
+    for(s32 i = 0; i < state->cursor_count; ++i) {
+        Selectable_Cursor *c = &state->cursors[i];
 
-		at--;
-	}
+        s64 offset = multiCursor_get_moved_offset(b, anchorSet_get_offset(&b->anchors, c->cursor), command, by_token, font, fontScale);
 
-	return new_cursor_pos_inBytes;
+        anchorSet_set_offset(&b->anchors, c->cursor, offset);
+        if(!extend_select) {
+            anchorSet_set_offset(&b->anchors, c->select_start, offset);
+        }
+    }
 }
 
-//NOTE: helper function to remove text if it is highlighted
-static void remove_text_if_highlighted(Selectable_State *selectable_state, WL_Buffer *b) {
-    if(selectable_state->is_active) {
-        Selectable_Diff diff = selectable_get_bytes_diff(selectable_state);
-        removeTextFromBuffer(b, diff.start, diff.size);
+//NOTE: A cursor on the line above or below all the others, at xPos across the line
+static void multiCursor_add_on_next_line(Selectable_State *state, WL_Buffer *b, bool below, float xPos, Font *font, float fontScale) {
+    s64 line = wl_buffer_get_line_index(b, wl_buffer_get_cursor(b));
 
-        end_select(selectable_state);
+    for(s32 i = 0; i < state->cursor_count; ++i) {
+        s64 l = wl_buffer_get_line_index(b, anchorSet_get_offset(&b->anchors, state->cursors[i].cursor));
+        if((below && l > line) || (!below && l < line)) {
+            line = l;
+        }
+    }
+
+    line += (below) ? 1 : -1;
+
+    if(line >= 0 && line < wl_buffer_get_line_count(b)) {
+        s64 offset = getCursorPosClosestToX(b, wl_buffer_get_offset_of_line(b, line), xPos, font, fontScale);
+        multiCursor_add(state, b, offset, offset);
+    }
+}
+
+//NOTE: A cursor for every line of the selection, with that line's bit of it selected. The main cursor gets the last line.
+static void multiCursor_split_selection_into_lines(Selectable_State *state, WL_Buffer *b) {
+    if(!state->is_active) {
+        return;
+    }
+
+    Selectable_Diff diff = selectable_get_bytes_diff(state);
+    s64 end = diff.start + diff.size;
+
+    s64 first_line = wl_buffer_get_line_index(b, diff.start);
+    s64 last_line = wl_buffer_get_line_index(b, end);
+
+    for(s64 line = first_line; line < last_line; ++line) {
+        s64 line_start = wl_buffer_get_offset_of_line(b, line);
+        if(line_start < diff.start) { line_start = diff.start; }
+
+        multiCursor_add(state, b, wl_buffer_get_line_end(b, line_start), line_start);
+    }
+
+    s64 line_start = wl_buffer_get_offset_of_line(b, last_line);
+    if(line_start < diff.start) { line_start = diff.start; }
+
+    end_select(state);
+    update_select(state, line_start);
+    update_select(state, end);
+    wl_buffer_set_cursor(b, end);
+}
+
+//NOTE: A cursor on every match, with the match selected. The main cursor gets the first one.
+static void multiCursor_select_matches(Selectable_State *state, WL_Buffer *b, size_t *offsets, s32 offset_count, s64 match_size) {
+    if(offset_count <= 0) {
+        return;
     }
+
+    multiCursor_clear(state, b);
+
+    for(s32 i = 1; i < offset_count; ++i) {
+        multiCursor_add(state, b, offsets[i] + match_size, offsets[i]);
+    }
+
+    end_select(state);
+    update_select(state, offsets[0]);
+    update_select(state, offsets[0] + match_size);
+    wl_buffer_set_cursor(b, offsets[0] + match_size);
+}
+
+//NOTE: A column of cursors, one on every line from the start offset's line to the end offset's, each one selecting across from 
+//      where the start offset is on its line to where the end offset is. The main cursor is the end offset.
+static void multiCursor_select_column(Selectable_State *state, WL_Buffer *b, s64 start_offset, s64 end_offset, Font *font, float fontScale) {
+    multiCursor_clear(state, b);
+
+    float start_x = getXposAtOffset(b, start_offset, font, fontScale);
+    float end_x = getXposAtOffset(b, end_offset, font, fontScale);
+
+    s64 start_line = wl_buffer_get_line_index(b, start_offset);
+    s64 end_line = wl_buffer_get_line_index(b, end_offset);
+    s64 step = (end_line >= start_line) ? 1 : -1;
+
+    for(s64 line = start_line; line != end_line; line += step) {
+        s64 line_start = wl_buffer_get_offset_of_line(b, line);
+        multiCursor_add(state, b, getCursorPosClosestToX(b, line_start, end_x, font, fontScale), getCursorPosClosestToX(b, line_start, start_x, font, fontScale));
+    }
+
+    s64 select_start = getCursorPosClosestToX(b, wl_buffer_get_offset_of_line(b, end_line), start_x, font, fontScale);
+
+    end_select(state);
+    update_select(state, select_start);
+    update_select(state, end_offset);
+    wl_buffer_set_cursor(b, end_offset);
 }
 
 static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *open_buffer, WL_Buffer *b, BufferControllerOption option, Selectable_State *selectable_state, bool justNumber = false) { //NOTE: Just number could be change to flags if we have more options
@@ -330,17 +615,31 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
     //NOTE: Ctrl A -> select all
     if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && global_platformInput.keyStates[PLATFORM_KEY_A].pressedCount > 0) 
     {
+        multiCursor_clear(selectable_state, b);
         end_select(selectable_state);
 
         update_select(&open_buffer->selectable_state, 0);
-        update_select(&open_buffer->selectable_state, b->bufferSize_inUse_inBytes);
+        update_select(&open_buffer->selectable_state, wl_buffer_get_size_in_bytes(b));
 
-        b->cursorAt_inBytes = b->bufferSize_inUse_inBytes;
+        wl_buffer_set_cursor(b, wl_buffer_get_size_in_bytes(b));
 
         open_buffer->should_scroll_to = true;
 
     }
 
+    //NOTE: Ctrl Shift L -> a cursor on every line of the selection
+    if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown && global_platformInput.keyStates[PLATFORM_KEY_L].pressedCount > 0 && option == BUFFER_ALL) 
+    {
+        multiCursor_split_selection_into_lines(selectable_state, b);
+    }
+
+    //NOTE: Escape -> back to just the one cursor
+    if(global_platformInput.keyStates[PLATFORM_KEY_ESCAPE].pressedCount > 0 && selectable_state->cursor_count > 0) 
+    {
+        multiCursor_clear(selectable_state, b);
+        end_select(selectable_state);
+    }
+
     //NOTE: Any text added if not pressing ctrl
     if(global_platformInput.textInput_utf8[0] != '\0' && !global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown) {
 
@@ -372,9 +671,17 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
             
         }
 
-        remove_text_if_highlighted(selectable_state, b);
+        char *typed = (char *)global_platformInput.textInput_utf8;
+
+        if(selectable_state->cursor_count > 0) {
+            //NOTE: Every cursor types it, as one undo group
+            multiCursor_replace_text(selectable_state, b, typed, easyString_getSizeInBytes_utf8(typed), false);
+        } else {
+            remove_text_if_highlighted(selectable_state, b);
 
-        addTextToBuffer(b, (char *)global_platformInput.textInput_utf8, b->cursorAt_inBytes);
+            //NOTE: Typing joins onto the last undo block so undo goes back a word at a time, not a key at a time
+            addTypedTextToBuffer(b, typed, easyString_getSizeInBytes_utf8(typed), wl_buffer_get_cursor(b));
+        }
 
         if(open_buffer) {
             open_buffer->is_up_to_date = false;
@@ -399,38 +706,21 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
         {   
             if(selectable_state->is_active && selectable_state->start_offset_in_bytes < selectable_state->end_offset_in_bytes) {
                 Selectable_Diff diff = selectable_get_bytes_diff(selectable_state);
-                platform_copy_text_utf8_to_clipboard((char *)(((u8 *)b->bufferMemory) + diff.start), diff.size);
+                platform_copy_text_utf8_to_clipboard(wl_buffer_copy_to_arena(b, diff.start, diff.size, &globalPerFrameArena), diff.size);
 
                 remove_text_if_highlighted(selectable_state, b);
 
                 end_select(selectable_state);
 
             } else {
-                endGapBuffer(b);
-
                 //NOTE: cut whole line
-                size_t new_cursor_pos_inBytes_start = b->cursorAt_inBytes;
-
-                u8 *start = (u8 *)(b->bufferMemory + (b->cursorAt_inBytes)); 
-
-                while(start >= b->bufferMemory && start[0] != '\n') {
-                    new_cursor_pos_inBytes_start--;
-                    start--;
-                }
-
-                //NOTE: Move past the newline because we don't want to take it out
-                if(start[0] == '\n') { new_cursor_pos_inBytes_start++; }
-
-                size_t new_cursor_pos_inBytes_end = b->cursorAt_inBytes;
+                s64 new_cursor_pos_inBytes_start = wl_buffer_get_line_start(b, wl_buffer_get_cursor(b));
 
-                start = (u8 *)(b->bufferMemory + (b->cursorAt_inBytes)); 
+                s64 new_cursor_pos_inBytes_end = wl_buffer_get_line_end(b, wl_buffer_get_cursor(b));
 
-                while(start[0] != '\0' && start[0] != '\n') {
-                    new_cursor_pos_inBytes_end++;
-                    start++;
-                }
-
-                if(start[0] == '\n') { new_cursor_pos_inBytes_end++; }
+                //NOTE: Take the newline out with the line
+                if(wl_buffer_get_byte(b, new_cursor_pos_inBytes_end) == '\r') { new_cursor_pos_inBytes_end++; }
+                if(wl_buffer_get_byte(b, new_cursor_pos_inBytes_end) == '\n') { new_cursor_pos_inBytes_end++; }
 
 
                 removeTextFromBuffer(b, new_cursor_pos_inBytes_start, new_cursor_pos_inBytes_end - new_cursor_pos_inBytes_start);
@@ -442,7 +732,7 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
         {
             if(selectable_state->is_active) {
                 Selectable_Diff diff = selectable_get_bytes_diff(selectable_state);
-                platform_copy_text_utf8_to_clipboard((char *)(((u8 *)b->bufferMemory) + diff.start), diff.size);
+                platform_copy_text_utf8_to_clipboard(wl_buffer_copy_to_arena(b, diff.start, diff.size, &globalPerFrameArena), diff.size);
 
             } 
         }
@@ -453,7 +743,11 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
             char *text_from_clipboard = platform_get_text_utf8_from_clipboard(&globalPerFrameArena);
             
             //NOTE: Any text added
-            addTextToBuffer(b, (char *)text_from_clipboard, b->cursorAt_inBytes);
+            if(selectable_state->cursor_count > 0) {
+                multiCursor_replace_text(selectable_state, b, text_from_clipboard, easyString_getSizeInBytes_utf8(text_from_clipboard), false);
+            } else {
+                addTextToBuffer(b, (char *)text_from_clipboard, wl_buffer_get_cursor(b));
+            }
 
             if(open_buffer) {
                 open_buffer->is_up_to_date = false;
@@ -466,122 +760,63 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
 
         //NOTE: UNDO REDO commands 
         if(option == BUFFER_ALL) {
+            UndoRedoBlock *block = NULL;
 
-            //NOTE: Loop this if undo commands are in a group
-            bool hasBlocks = true;
-            s32 startGroupId = -1;
-            while(hasBlocks) {
-
-                UndoRedoBlock *block = NULL;
-                bool isRedo = true;
-
-                //NOTE: Ctrl Z -> undo operation
-                if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && command == PLATFORM_KEY_Z) 
-                {   
-                    isRedo = false;
-                    UndoRedoBlock *nextBlock = see_undo_block(&b->undo_redo_state);
-
-                    //NOTE: If there are any blocks to get, is part of this group or is not in a group or starting a group
-                    if(nextBlock && (nextBlock->groupId == startGroupId || nextBlock->groupId < 0 || (nextBlock->groupId >= 0 && startGroupId < 0))) {
-                        block = get_undo_block(&b->undo_redo_state);
-                    }
-                    
-                }
-
-                //NOTE: Ctrl Y -> redo operation
-                if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && command == PLATFORM_KEY_Y) 
-                {
-                    UndoRedoBlock *nextBlock = see_redo_block(&b->undo_redo_state);
+            //NOTE: Ctrl Z -> undo operation. Undoes the whole group if the block's in one
+            if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && command == PLATFORM_KEY_Z) 
+            {   
+                block = wl_buffer_undo(b);
+            }
 
-                    if(nextBlock && (nextBlock->groupId == startGroupId || nextBlock->groupId < 0 || (nextBlock->groupId >= 0 && startGroupId < 0))) {
-                        block = get_redo_block(&b->undo_redo_state);
-                    }
+            //NOTE: Ctrl Y -> redo operation
+            if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && command == PLATFORM_KEY_Y) 
+            {
+                //NOTE: Ctrl Shift Y -> redo down the next branch of the undo tree instead
+                if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) {
+                    undoRedo_next_redo_branch(&b->undo_redo_state);
                 }
 
-                if(block) {
-
-                    if(startGroupId < 0) {
-                        //NOTE: Initilise the start group id
-                        startGroupId = block->groupId;
-                    }
+                block = wl_buffer_redo(b);
+            }
 
-                    bool shouldInsert = true;
-
-                    UndoRedo_BlockType commandType = block->type;
-
-                    if(!isRedo) {
-                        //NOTE: Reverse the command on the buffer block
-                        if(commandType == UNDO_REDO_INSERT) {
-                            commandType = UNDO_REDO_DELETE;
-                        } else {
-                            assert(commandType == UNDO_REDO_DELETE);
-                            commandType = UNDO_REDO_INSERT;
-                        }
-                    } 
-
-                    //NOTE: Check if buffer is in a saved state based on the new undo state 
-                    if(open_buffer) {
-                        open_buffer->moveVertical_xPos = -1;
-
-                        assert(block->id > 0);
-
-                        u32 id_to_check = (isRedo) ? block->id : (block->id -1);
-
-                        //NOTE: Check if it is up to date based on the id we saved at
-                        if(open_buffer->current_save_undo_redo_id == id_to_check) {
-                            open_buffer->is_up_to_date = true;
-                        } else {
-                            open_buffer->is_up_to_date = false;
-                        }
-                        
-                        open_buffer->should_scroll_to = true;
-                        end_select(selectable_state);
-                    }   
-
-                    if(block->byteAt != b->cursorAt_inBytes) {
-                        endGapBuffer(b);
-                    }
+            //NOTE: Check if buffer is in a saved state based on the new undo state 
+            if(block && open_buffer) {
+                open_buffer->moveVertical_xPos = -1;
 
-                    if(commandType == UNDO_REDO_INSERT) { //NOTE: Insert
-                        addTextToBuffer(b, block->string, block->byteAt, false);
-                    } else {
-                        assert(commandType == UNDO_REDO_DELETE); //NOTE: Delete
-                    
-                        removeTextFromBuffer(b, block->byteAt, block->stringLength, false);
+                assert(block->id > 0);
 
-                    }
+                //NOTE: The block we're at now, after the undo or redo
+                u32 id_to_check = undoRedo_get_current_id(&b->undo_redo_state);
 
-                    //NOTE: See if this block is part of the groupId or is a single command
-                    if(block->groupId < 0) {
-                        hasBlocks = false;
-                    }
+                //NOTE: Check if it is up to date based on the id we saved at
+                if(open_buffer->current_save_undo_redo_id == id_to_check) {
+                    open_buffer->is_up_to_date = true;
                 } else {
-                    //NOTE: If we don't have any more blocks left, get out of the loop
-                    hasBlocks = false;
+                    open_buffer->is_up_to_date = false;
                 }
+                
                 open_buffer->should_scroll_to = true;
-
-                //NOTE: For testing
-                hasBlocks = false;
-            }
+                end_select(selectable_state);
+            }   
         }
 
-        if(command == PLATFORM_KEY_BACKSPACE && b->cursorAt_inBytes > 0) {
+        if(command == PLATFORM_KEY_BACKSPACE && (wl_buffer_get_cursor(b) > 0 || selectable_state->cursor_count > 0)) {
             if(open_buffer) {
                 //NOTE: de activate the move vertical position so it gets a new one next time
                 open_buffer->moveVertical_xPos = -1;
             }
             size_t startByte = 0;
             size_t totalBytes = 0;
-            if(selectable_state->is_active) {
+            if(selectable_state->cursor_count > 0) {
+                multiCursor_replace_text(selectable_state, b, 0, 0, true);
+            } else if(selectable_state->is_active) {
                 remove_text_if_highlighted(selectable_state, b);
             } else {
-                u32 bytesOfPrevRune = size_of_last_utf8_codepoint_in_bytes((char *)&b->bufferMemory[b->cursorAt_inBytes], b->cursorAt_inBytes);
-                assert(bytesOfPrevRune == 1 || bytesOfPrevRune == 0);
+                s64 bytesOfPrevRune = wl_buffer_get_size_of_rune_before(b, wl_buffer_get_cursor(b));
                 
-                startByte = b->cursorAt_inBytes - bytesOfPrevRune;
+                startByte = wl_buffer_get_cursor(b) - bytesOfPrevRune;
                 totalBytes = bytesOfPrevRune;
-                removeTextFromBuffer(b, startByte, totalBytes);
+                removeTypedTextFromBuffer(b, startByte, totalBytes);
             }
 
             if(open_buffer) {
@@ -592,20 +827,24 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
             
         }
 
+        //NOTE: The extra cursors move the same way as the main one
+        if(selectable_state->cursor_count > 0 && (command == PLATFORM_KEY_LEFT || command == PLATFORM_KEY_RIGHT || command == PLATFORM_KEY_HOME || command == PLATFORM_KEY_END || 
+            ((command == PLATFORM_KEY_UP || command == PLATFORM_KEY_DOWN) && !(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown)))) 
+        {
+            multiCursor_move(selectable_state, b, command, global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown, global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown, &editorState->font, editorState->fontScale);
+        }
+
         if(command == PLATFORM_KEY_LEFT) {
+            s64 cursor = wl_buffer_get_cursor(b);
             
-            endGapBuffer(b);
-
             if(open_buffer) {
                 open_buffer->moveVertical_xPos = -1;
             }
             
-            u32 bytesOfPrevRune = size_of_last_utf8_codepoint_in_bytes((char *)&b->bufferMemory[b->cursorAt_inBytes], b->cursorAt_inBytes);
-            
-            assert(bytesOfPrevRune == 1 || bytesOfPrevRune == 0);
+            s64 bytesOfPrevRune = wl_buffer_get_size_of_rune_before(b, cursor);
 
-            if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown) {
-                EasyToken token = peekTokenBackwards_tokenNotComplete((char *)(b->bufferMemory + (b->cursorAt_inBytes - 1)), (char *)b->bufferMemory);
+            if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && cursor > 0) {
+                EasyToken token = wl_buffer_peek_token_backwards(b, cursor);
             
                 if(token.type != TOKEN_UNINITIALISED) {
                     bytesOfPrevRune = token.size;
@@ -613,27 +852,27 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
             }
 
             //NOTE: Move cursor left 
-            if(b->cursorAt_inBytes > 0) {
+            if(cursor > 0) {
 
                 //NOTE: Windows style newline
-                if(b->cursorAt_inBytes >= 2 && b->bufferMemory[b->cursorAt_inBytes - 2] == '\r' && b->bufferMemory[b->cursorAt_inBytes - 1] == '\n') {
+                if(cursor >= 2 && wl_buffer_get_byte(b, cursor - 2) == '\r' && wl_buffer_get_byte(b, cursor - 1) == '\n') {
                     bytesOfPrevRune = 2;
                 }
 
                 if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) 
                 {
-                    update_select(selectable_state, b->cursorAt_inBytes);
+                    update_select(selectable_state, cursor);
                 } else {
                     end_select(selectable_state);
                 }
                 
 
-                b->cursorAt_inBytes -= bytesOfPrevRune;
+                wl_buffer_set_cursor(b, cursor - bytesOfPrevRune);
 
                 if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) 
                 {
                     assert(selectable_state->is_active);
-                    update_select(selectable_state, b->cursorAt_inBytes);
+                    update_select(selectable_state, wl_buffer_get_cursor(b));
                 } else {
                     end_select(selectable_state);
                 }
@@ -642,10 +881,9 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
         }
 
         if(command == PLATFORM_KEY_RIGHT) {
+            s64 cursor = wl_buffer_get_cursor(b);
 
-            u32 bytesOfNextRune = size_of_next_utf8_codepoint_in_bytes((char *)&b->bufferMemory[b->cursorAt_inBytes]);
-            assert(bytesOfNextRune == 1 || bytesOfNextRune == 0);
-            endGapBuffer(b);
+            s64 bytesOfNextRune = wl_buffer_get_size_of_rune_at(b, cursor);
 
             if(open_buffer) {
                 open_buffer->moveVertical_xPos = -1;
@@ -653,7 +891,7 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
 
             if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown) {
 
-                EasyToken token = peekTokenForward_tokenNotComplete((char *)(b->bufferMemory + (b->cursorAt_inBytes)), (char *)(b->bufferMemory + (b->bufferSize_inUse_inBytes)));
+                EasyToken token = wl_buffer_peek_token_forward(b, cursor);
 
                 if(token.type != TOKEN_UNINITIALISED) {
                     bytesOfNextRune = token.size;
@@ -662,27 +900,27 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
             
             
             //NOTE: Move cursor right 
-            if(b->cursorAt_inBytes < b->bufferSize_inUse_inBytes) {
+            if(cursor < wl_buffer_get_size_in_bytes(b)) {
 
                 //NOTE: Windows style newline
-                if(b->cursorAt_inBytes < (b->bufferSize_inUse_inBytes - 1) && b->bufferMemory[b->cursorAt_inBytes] == '\r' && b->bufferMemory[b->cursorAt_inBytes + 1] == '\n') {
+                if(wl_buffer_get_byte(b, cursor) == '\r' && wl_buffer_get_byte(b, cursor + 1) == '\n') {
                     bytesOfNextRune = 2;
                 }
 
                 if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) 
                 {
 
-                    update_select(selectable_state, b->cursorAt_inBytes);
+                    update_select(selectable_state, cursor);
                 } else {
                     end_select(selectable_state);
                 }
 
-                b->cursorAt_inBytes += bytesOfNextRune;
+                wl_buffer_set_cursor(b, cursor + bytesOfNextRune);
 
                 if(global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown) 
                 {
                     assert(selectable_state->is_active);
-                    update_select(selectable_state, b->cursorAt_inBytes);
+                    update_select(selectable_state, wl_buffer_get_cursor(b));
                 } else {
                     end_select(selectable_state);
                 }
@@ -691,10 +929,8 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
 
         if(command == PLATFORM_KEY_END) {
 
-            endGapBuffer(b);
-
             
-            int new_cursor_pos_inBytes = getCursorPosAtEndOfLine(b);
+            s64 new_cursor_pos_inBytes = getCursorPosAtEndOfLine(b);
 
             
             updateNewCursorPos(b, new_cursor_pos_inBytes, selectable_state);
@@ -702,39 +938,46 @@ static void process_buffer_controller(EditorState *editorState, WL_Open_Buffer *
 
         if(command == PLATFORM_KEY_HOME) {
 
-            endGapBuffer(b);
-            int new_cursor_pos_inBytes = getCursorPosAtStartOfLine(b);
+            s64 new_cursor_pos_inBytes = getCursorPosAtStartOfLine(b);
             updateNewCursorPos( b, new_cursor_pos_inBytes, selectable_state);
             
             
         }  
 
+        //NOTE: Ctrl Shift Up/Down -> add a cursor on the line above or below, in the same column as the main one
+        if((command == PLATFORM_KEY_UP || command == PLATFORM_KEY_DOWN) && global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && global_platformInput.keyStates[PLATFORM_KEY_SHIFT].isDown && option == BUFFER_ALL) {
+            assert(open_buffer);
+
+            if(open_buffer->moveVertical_xPos < 0) {
+                open_buffer->moveVertical_xPos = getXposAtInLine(b, &editorState->font, editorState->fontScale);
+            }
+
+            multiCursor_add_on_next_line(selectable_state, b, command == PLATFORM_KEY_DOWN, open_buffer->moveVertical_xPos, &editorState->font, editorState->fontScale);
+            continue;
+        }
+
         if(command == PLATFORM_KEY_UP && optionCanMoveUp(option)) { //NOTE: Some buffer controllers you can't move up 
 
             assert(open_buffer); //NOTE: Must have an open buffer to fo this option
 
-            endGapBuffer(b);
-
             if(open_buffer->moveVertical_xPos < 0) {
                 open_buffer->moveVertical_xPos = getXposAtInLine(b, &editorState->font, editorState->fontScale);
             }
 
             assert(open_buffer->moveVertical_xPos  >= 0);
-            int new_cursor_pos_inBytes = getCusorPosLineAbove(editorState, b, &editorState->font, editorState->fontScale, open_buffer);
+            s64 new_cursor_pos_inBytes = getCusorPosLineAbove(editorState, b, &editorState->font, editorState->fontScale, open_buffer);
             
             updateNewCursorPos(b, new_cursor_pos_inBytes, selectable_state);
         }  
 
         if(command == PLATFORM_KEY_DOWN && optionCanMoveDown(option)) {
             assert(open_buffer);//NOTE: Must have an open buffer to do this option
-            endGapBuffer(b);
-
             if(open_buffer->moveVertical_xPos < 0) {
                 open_buffer->moveVertical_xPos = getXposAtInLine(b, &editorState->font, editorState->fontScale);
             }
 
             assert(open_buffer->moveVertical_xPos  >= 0);
-            int new_cursor_pos_inBytes = getCusorPosLineBelow(b, &editorState->font, editorState->fontScale, open_buffer);
+            s64 new_cursor_pos_inBytes = getCusorPosLineBelow(b, &editorState->font, editorState->fontScale, open_buffer);
 
             updateNewCursorPos(b, new_cursor_pos_inBytes, selectable_state);				   	
         }      
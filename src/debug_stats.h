@@ -10,34 +10,101 @@ struct DEBUG_stats {
 	int render_command_count;
 	int draw_call_count;
 
+	//NOTE: The undo history's text, added up over all the buffers. See undoRedo_update
+	s64 undo_bytes_uncompressed;
+	s64 undo_bytes_compressed_from; //NOTE: The size it was before it got compressed
+	s64 undo_bytes_compressed;
+	s64 undo_bytes_spilled;
+
+	//NOTE: Hash table of the live heap blocks keyed on the pointer, open addressing.
+	//		Grows when it gets 3/4 full so long sessions don't run out of slots.
 	u32 memory_block_count;
-	DEBUG_memory_ptr_to_size memory_blocks[512];
+	u32 memory_block_total;
+	DEBUG_memory_ptr_to_size *memory_blocks;
 
 };
 
+static inline u32 DEBUG_memory_block_hash(void *ptr, u32 total) {
+	u64 key = (u64)(size_t)ptr;
+	key ^= (key >> 33);
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= (key >> 33);
+	return (u32)(key & (total - 1));
+}
+
+static void DEBUG_insert_memory_block(DEBUG_memory_ptr_to_size *blocks, u32 total, void *ptr, size_t size) {
+	u32 index = DEBUG_memory_block_hash(ptr, total);
+	while(blocks[index].ptr) {
+		index = (index + 1) & (total - 1);
+	}
+	blocks[index].ptr = ptr;
+	blocks[index].size = size;
+}
+
 static void DEBUG_add_memory_block_size(DEBUG_stats *stats, void *ptr, size_t size) {
-	assert(stats->memory_block_count < arrayCount(stats->memory_blocks));
+	if(!ptr) {
+		return;
+	}
 
-	stats->total_heap_allocated += size;
-	DEBUG_memory_ptr_to_size *block = &stats->memory_blocks[stats->memory_block_count++];
+	//NOTE: Use the heap directly so we don't track our own table
+	if(4*(stats->memory_block_count + 1) > 3*stats->memory_block_total) {
+		u32 new_total = (stats->memory_block_total) ? 2*stats->memory_block_total : 1024;
+		DEBUG_memory_ptr_to_size *new_blocks = (DEBUG_memory_ptr_to_size *)HeapAlloc(GetProcessHeap(), 0, new_total*sizeof(DEBUG_memory_ptr_to_size));
+		memset(new_blocks, 0, new_total*sizeof(DEBUG_memory_ptr_to_size));
+
+		for(u32 i = 0; i < stats->memory_block_total; ++i) {
+			if(stats->memory_blocks[i].ptr) {
+				DEBUG_insert_memory_block(new_blocks, new_total, stats->memory_blocks[i].ptr, stats->memory_blocks[i].size);
+			}
+		}
 
-	block->size = size;
-	block->ptr = ptr;
+		if(stats->memory_blocks) {
+			HeapFree(GetProcessHeap(), 0, stats->memory_blocks);
+		}
+
+		stats->memory_blocks = new_blocks;
+		stats->memory_block_total = new_total;
+	}
+
+	stats->total_heap_allocated += size;
+	stats->memory_block_count++;
+	DEBUG_insert_memory_block(stats->memory_blocks, stats->memory_block_total, ptr, size);
 }
 
 
 static void DEUBG_remove_memory_block_size(DEBUG_stats *stats, void *ptr) {
-    if(ptr) {
-        for(int i = 0; i < stats->memory_block_count; ++i) {
-            DEBUG_memory_ptr_to_size *block = &stats->memory_blocks[i];
+    if(ptr && stats->memory_block_total > 0) {
+        u32 mask = stats->memory_block_total - 1;
+        u32 index = DEBUG_memory_block_hash(ptr, stats->memory_block_total);
+
+        while(stats->memory_blocks[index].ptr && stats->memory_blocks[index].ptr != ptr) {
+            index = (index + 1) & mask;
+        }
+
+        DEBUG_memory_ptr_to_size *block = &stats->memory_blocks[index];
+
+        if(block->ptr == ptr) {
+            assert(stats->total_heap_allocated >= block->size);
+            stats->total_heap_allocated -= block->size;
+            stats->memory_block_count--;
+            block->ptr = 0;
+            block->size = 0;
 
-            if(block->ptr == ptr) {
-            	assert(stats->total_heap_allocated >= block->size);
-				stats->total_heap_allocated -= block->size;
-				stats->memory_block_count--;
-				stats->memory_blocks[i] = stats->memory_blocks[stats->memory_block_count];
+            //NOTE: Shift the blocks after it back so nothing gets lost behind the empty slot
+            u32 empty = index;
+            u32 at = (index + 1) & mask;
+            while(stats->memory_blocks[at].ptr) {
+                u32 home = DEBUG_memory_block_hash(stats->memory_blocks[at].ptr, stats->memory_block_total);
 
-            	break;
+                //NOTE: Only move it if its home slot isn't between the empty slot and where it is now
+                bool can_move = (empty <= at) ? (home <= empty || home > at) : (home <= empty && home > at);
+                if(can_move) {
+                    stats->memory_blocks[empty] = stats->memory_blocks[at];
+                    stats->memory_blocks[at].ptr = 0;
+                    stats->memory_blocks[at].size = 0;
+                    empty = at;
+                }
+                at = (at + 1) & mask;
             }
         }
     }
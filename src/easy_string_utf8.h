@@ -23,6 +23,16 @@ easyUnicode_utf8_codepoint_To_Utf32_codepoint(char **streamPtr, int advancePtr)
 easyUnicode_utf8StreamToUtf32Stream_allocates(char *string) - turn the whole NULL TERMINATED string from utf8 to utf32 encoding
 Use easyString_free_Utf32_string(ptr) to free the memory from the function above when finished
 
+easyUnicode_utf8StreamToUtf32Stream(char *string, int sizeInBytes, unsigned int *dest) - same as above but for sizeInBytes of a string 
+into your own buffer, which has to be sizeInBytes big. Returns how many codepoints it wrote. The string has to end on a whole codepoint.
+
+easyString_getAsciiRunLength_utf8(char *string, int sizeInBytes) - how many bytes from the start are ascii, so you can use them as 
+codepoints straight away without decoding them
+
+////////////////////////////////////////////////////////////////////
+The size, length, ascii run & utf32 functions look at 16 bytes at a time with SSE2. Define EASY_STRING_NO_SIMD to turn that off. 
+The _scalar versions of them do the same thing a byte at a time, and give the same answers for valid utf8.
+
 ////////////////////////////////////////////////////////////////////
 String compare functions:
 int easyString_stringsMatch_withCount(char *a, int aLength, char *b, int bLength) - compares strings ignoring whether they're null terminated or not
@@ -114,6 +124,10 @@ int easyString_getSizeInBytes_utf8(char *string);
 
 int easyString_getStringLength_utf8(char *string);
 
+int easyString_getAsciiRunLength_utf8(char *string, int sizeInBytes);
+
+int easyUnicode_utf8StreamToUtf32Stream(char *stream, int sizeInBytes, unsigned int *dest);
+
 unsigned int *easyUnicode_utf8StreamToUtf32Stream_allocates(char *stream);
 
 void easyString_free_Utf32_string(char *string);
@@ -129,6 +143,21 @@ int easyString_string_contains_utf8(char *string, char *sub_string);
 
 #if EASY_STRING_IMPLEMENTATION
 
+#ifndef EASY_STRING_NO_SIMD
+#include <emmintrin.h>
+
+//NOTE: Finding the null terminator reads whole aligned 16 byte blocks. They can't cross into the next page so it's safe, 
+//		but the end of the last block can be past the end of the string which the address sanitizer doesn't like.
+#if defined(_MSC_VER)
+#define EASY_STRING_NO_SANITIZE __declspec(no_sanitize_address)
+#elif defined(__GNUC__) || defined(__clang__)
+#define EASY_STRING_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define EASY_STRING_NO_SANITIZE
+#endif
+
+#endif
+
 // The leading bytes and the continuation bytes do not share values 
 // (continuation bytes start with 10 while single bytes start with 0 and longer lead bytes start with 11)
 
@@ -226,10 +255,11 @@ unsigned int easyUnicode_utf8_codepoint_To_Utf32_codepoint(char **streamPtr, int
 					EASY_HEADERS_ASSERT(easyUnicode_isContinuationByte(secondByte));
 					EASY_HEADERS_ASSERT(easyUnicode_isContinuationByte(thirdByte));
 					EASY_HEADERS_ASSERT(easyUnicode_isContinuationByte(fourthByte));
-					result |= (thirdByte & sixBitsFull);
-					result |= ((secondByte & sixBitsFull) << 6);
-					result |= ((firstByte & sixBitsFull) << 12);
-					result |= ((firstByte & fourBitsFull) << 18);
+					unsigned int threeBitsFull = (1 << 2 | 1 << 1 | 1 << 0);
+					result |= (fourthByte & sixBitsFull);
+					result |= ((thirdByte & sixBitsFull) << 6);
+					result |= ((secondByte & sixBitsFull) << 12);
+					result |= ((firstByte & threeBitsFull) << 18);
 
 					if(advancePtr) (*streamPtr) += 4;
 				} break;
@@ -292,7 +322,7 @@ int size_of_next_utf8_codepoint_in_bytes(char *string) {
 }
 
 
-int easyString_getSizeInBytes_utf8(char *string) {
+int easyString_getSizeInBytes_utf8_scalar(char *string) {
     unsigned int result = 0;
     unsigned char *at = (unsigned char *)string;
     while(*at) {
@@ -302,6 +332,54 @@ int easyString_getSizeInBytes_utf8(char *string) {
     return result;
 }
 
+#ifndef EASY_STRING_NO_SIMD
+
+//NOTE: Counts the bits without needing popcnt 
+static inline int easyString_countBits(unsigned int bits) {
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (int)((((bits + (bits >> 4)) & 0x0F0F0F0F)*0x01010101) >> 24);
+}
+
+static inline int easyString_firstBitSet(unsigned int bits) {
+    int result = 0;
+    while(!(bits & 1)) {
+        bits >>= 1;
+        result++;
+    }
+    return result;
+}
+
+//NOTE: Walks the string 16 aligned bytes at a time, calling block_func with the mask of the bytes that are in the string.
+//      Stops after the block with the null terminator in it. 
+#define EASY_STRING_FOR_EACH_ALIGNED_BLOCK(string, block_func) { \
+    unsigned char *block_at = (unsigned char *)((size_t)(string) & ~(size_t)15); \
+    unsigned int in_string = 0xFFFF & (0xFFFF << ((unsigned char *)(string) - block_at)); \
+    for(;;) { \
+        __m128i block = _mm_load_si128((__m128i *)block_at); \
+        unsigned int zeros = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128())) & in_string; \
+        if(zeros) { in_string &= ((zeros & (~zeros + 1)) - 1); } \
+        block_func \
+        if(zeros) { break; } \
+        block_at += 16; \
+        in_string = 0xFFFF; \
+    } \
+}
+
+EASY_STRING_NO_SANITIZE int easyString_getSizeInBytes_utf8(char *string) {
+    int result = 0;
+    EASY_STRING_FOR_EACH_ALIGNED_BLOCK(string, { result += easyString_countBits(in_string); });
+    return result;
+}
+
+#else
+
+int easyString_getSizeInBytes_utf8(char *string) {
+    return easyString_getSizeInBytes_utf8_scalar(string);
+}
+
+#endif
+
 int easyString_getSizeInBytes_utf16(u16 *string) { //doesnt include null terminator
     size_t result = 0;
     u16 *at = string;
@@ -313,7 +391,7 @@ int easyString_getSizeInBytes_utf16(u16 *string) { //doesnt include null termina
 }
 
 
-int easyString_getStringLength_utf8(char *string) {
+int easyString_getStringLength_utf8_scalar(char *string) {
     unsigned int result = 0;
     unsigned char *at = (unsigned char *)string;
     while(*at) {
@@ -323,22 +401,107 @@ int easyString_getStringLength_utf8(char *string) {
     return result;
 }
 
+int easyString_getAsciiRunLength_utf8_scalar(char *string, int sizeInBytes) {
+    int result = 0;
+    while(result < sizeInBytes && easyUnicode_isSingleByte(string[result])) {
+        result++;
+    }
+    return result;
+}
+
+int easyUnicode_utf8StreamToUtf32Stream_scalar(char *stream, int sizeInBytes, unsigned int *dest) {
+    char *at = stream;
+    unsigned int *dest_at = dest;
+    while((at - stream) < sizeInBytes) {
+        char *a = at;
+        *dest_at = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&at, 1);
+        EASY_HEADERS_ASSERT(at != a);
+        dest_at++;
+    }
+    return (int)(dest_at - dest);
+}
+
+#ifndef EASY_STRING_NO_SIMD
+
+//NOTE: Every byte that isn't a continuation byte starts a codepoint, so count those
+EASY_STRING_NO_SANITIZE int easyString_getStringLength_utf8(char *string) {
+    int result = 0;
+    __m128i last_continuation = _mm_set1_epi8((char)0xBF);
+    EASY_STRING_FOR_EACH_ALIGNED_BLOCK(string, { 
+        unsigned int starts = (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(block, last_continuation)); 
+        result += easyString_countBits(starts & in_string); 
+    });
+    return result;
+}
+
+int easyString_getAsciiRunLength_utf8(char *string, int sizeInBytes) {
+    int result = 0;
+    while(result + 16 <= sizeInBytes) {
+        unsigned int not_ascii = (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((__m128i *)(string + result)));
+        if(not_ascii) {
+            return result + easyString_firstBitSet(not_ascii);
+        }
+        result += 16;
+    }
+    return result + easyString_getAsciiRunLength_utf8_scalar(string + result, sizeInBytes - result);
+}
+
+//NOTE: Runs of 16 ascii bytes get widened to utf32 straight away, everything else is decoded one codepoint at a time
+int easyUnicode_utf8StreamToUtf32Stream(char *stream, int sizeInBytes, unsigned int *dest) {
+    int at = 0;
+    unsigned int *dest_at = dest;
+    __m128i zero = _mm_setzero_si128();
+    while(at < sizeInBytes) {
+        if(at + 16 <= sizeInBytes) {
+            __m128i block = _mm_loadu_si128((__m128i *)(stream + at));
+            if(_mm_movemask_epi8(block) == 0) {
+                __m128i low = _mm_unpacklo_epi8(block, zero);
+                __m128i high = _mm_unpackhi_epi8(block, zero);
+                _mm_storeu_si128((__m128i *)(dest_at + 0), _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128((__m128i *)(dest_at + 4), _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128((__m128i *)(dest_at + 8), _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128((__m128i *)(dest_at + 12), _mm_unpackhi_epi16(high, zero));
+                dest_at += 16;
+                at += 16;
+                continue;
+            }
+        }
+
+        char *a = stream + at;
+        char *codepoint_at = a;
+        *dest_at = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&codepoint_at, 1);
+        EASY_HEADERS_ASSERT(codepoint_at != a);
+        at += (int)(codepoint_at - a);
+        dest_at++;
+    }
+    return (int)(dest_at - dest);
+}
+
+#else
+
+int easyString_getStringLength_utf8(char *string) {
+    return easyString_getStringLength_utf8_scalar(string);
+}
+
+int easyString_getAsciiRunLength_utf8(char *string, int sizeInBytes) {
+    return easyString_getAsciiRunLength_utf8_scalar(string, sizeInBytes);
+}
+
+int easyUnicode_utf8StreamToUtf32Stream(char *stream, int sizeInBytes, unsigned int *dest) {
+    return easyUnicode_utf8StreamToUtf32Stream_scalar(stream, sizeInBytes, dest);
+}
+
+#endif
 
-//TODO: this would be a good place for simd. 
 //NOTE: You have to free your string 
 
 //IMPORTANT: string must be null terminated. 
 unsigned int *easyUnicode_utf8StreamToUtf32Stream_allocates(char *stream) {
-	unsigned int size = easyString_getStringLength_utf8(stream) + 1; //for null terminator
-	unsigned int *result = (unsigned int *)(EASY_HEADERS_ALLOC(size*sizeof(unsigned int)));
-	unsigned int *at = result;
-	while(*stream) {
-		char *a = stream;
-		*at = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&stream, 1);
-		EASY_HEADERS_ASSERT(stream != a);
-		at++;
-	}
-	result[size - 1] = '\0';
+	int sizeInBytes = easyString_getSizeInBytes_utf8(stream);
+	//NOTE: Never more codepoints than bytes, +1 for the null terminator
+	unsigned int *result = (unsigned int *)(EASY_HEADERS_ALLOC((sizeInBytes + 1)*sizeof(unsigned int)));
+	int count = easyUnicode_utf8StreamToUtf32Stream(stream, sizeInBytes, result);
+	result[count] = '\0';
 	return result;
 }
 
@@ -536,22 +699,28 @@ static String_Query_Search_Results string_utf8_find_sub_string(char *text, char
 		at += size_of_sub_string_in_bytes;
 
 		bool looping = true;
-		bool endNextLoop = false;
 		while(looping) {
 
 			if(string_utf8_matchStringBackwards_(at, sub_string_utf8, size_of_sub_string_in_bytes)) {
-				//NOTE: Push into table as a found
-				assert(512 > result.byteOffsetCount);
-				int byte_at = (at - text);
+				//NOTE: Push into table as a found. Big files can have more than fit, so just keep the first ones
+				s64 byte_at = (at - text);
 				assert(byte_at >= 0);
-				result.byteOffsets[result.byteOffsetCount++] = byte_at - size_of_sub_string_in_bytes; //NOTE: Move backwards to the start
+				if(result.byteOffsetCount < arrayCount(result.byteOffsets)) {
+					result.byteOffsets[result.byteOffsetCount++] = byte_at - size_of_sub_string_in_bytes; //NOTE: Move backwards to the start
+				}
 			}
 			
+			//NOTE: Already checked the last spot, don't read past the null terminator
+			if(!at[0]) {
+				looping = false;
+				break;
+			}
+
 			u32 runeAt = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&at, false);
 
 			int bytesToAdvance = get_shift_from_table(&shift_table, runeAt);
 
-			char *temp = at + 1;
+			char *temp = at;
 
 			//NOTE: This will move past the null terminator, so we need to check if we moved past it in this move
 			at += bytesToAdvance;
@@ -567,18 +736,6 @@ static String_Query_Search_Results string_utf8_find_sub_string(char *text, char
 				temp++;
 			}
 
-			
-			
-
-
-			if(endNextLoop) {
-				looping = false;
-			}
-
-			if(!at[0]) {
-				endNextLoop = true;;
-			}
-
 		}
 	}
 
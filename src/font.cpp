@@ -291,10 +291,27 @@ static DrawTextDetails draw_text(Renderer *renderer, Font *font, char *str, floa
     //NOTE: cursor position default
     float2 cursorPosition = make_float2(xAt, yAt);
 
+    int sizeInBytes = easyString_getSizeInBytes_utf8(str);
+
+    //NOTE: How many of the next bytes are ascii, so they can be used as runes without decoding them
+    int asciiRunLeft = 0;
+
     while(*at) {
 
         char *temp = at;
-        u32 rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&((char *)at), true);
+
+        if(asciiRunLeft == 0) {
+            asciiRunLeft = easyString_getAsciiRunLength_utf8(at, sizeInBytes - (int)(at - str));
+        }
+
+        u32 rune = 0;
+        if(asciiRunLeft > 0) {
+            rune = (u8)(*at);
+            at++;
+            asciiRunLeft--;
+        } else {
+            rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&((char *)at), true);
+        }
 
         float factor = 1.0f;
 
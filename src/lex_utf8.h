@@ -101,7 +101,7 @@ typedef struct {
     bool isType; 
     
     EasyTokenType type;
-    int size;
+    s64 size;
     
     u32 lineNumber;
     
@@ -149,7 +149,7 @@ bool lexIsNewLine(char value) {
     return (value == '\n' || value == '\r');
 }
 
-EasyToken lexInitToken(EasyTokenType type, char *at, int size, u32 lineNumber) {
+EasyToken lexInitToken(EasyTokenType type, char *at, s64 size, u32 lineNumber) {
     EasyToken result = {};
     result.type = type;
     result.at = at;
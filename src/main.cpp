@@ -5,8 +5,18 @@
 #include "lex_utf8.h"
 #include "color.cpp"
 #include "selectable.cpp"
+#include "wl_lz.cpp"
 #include "undo_redo.cpp"
+#include "wl_gap_buffer.cpp"
+#include "wl_line_index.cpp"
+#include "wl_line_buffer.cpp"
+#include "wl_piece_table.cpp"
+#include "wl_rope.cpp"
+#include "wl_buffer_storage.cpp"
+#include "wl_anchor_set.cpp"
+#include "wl_encoding.cpp"
 #include "wl_buffer.cpp"
+#include "wl_undo_journal.cpp"
 #include "wl_ast.cpp"
 #include "font.cpp"
 #include "ui.cpp"
@@ -31,11 +41,94 @@ enum Open_Buffer_Type {
 
 };
 
+//NOTE: How much the thread loading a file reads at a time
+#define FILE_LOAD_CHUNK_SIZE_IN_BYTES (1024*1024)
+
+//NOTE: How much of a loading file we add to the buffer each frame, so the frame doesn't stall on a big file
+#define FILE_LOAD_MAX_BYTES_ADDED_PER_FRAME (4*1024*1024)
+
+//NOTE: A file being read on another thread. The thread fills memory, and each frame the main thread adds what's arrived to the buffer.
+//		Really big utf8 files are memory mapped instead, then memory is the file and the thread checks it's utf8 instead of reading it. 
+//		What's been checked goes in the buffer straight out of the map. See thread_work_check_file_map
+struct File_Load {
+	Platform_File_Handle file;
+	s64 file_size_in_bytes;
+
+	u8 *memory;
+	bool is_mapped;
+	s64 bom_size_in_bytes; //NOTE: The buffer's text starts after this
+
+	//NOTE: Written by the loading thread
+	volatile s64 bytes_read;
+	volatile s64 valid_utf8_size; //NOTE: How much of the mapped file is utf8, from the start
+	volatile bool finished;
+
+	//NOTE: The lines of the whole file, from line_index_start in memory. The loading thread builds it once the file's all there if it's utf8, 
+	//		so the main thread doesn't have to find them a chunk at a time as it adds the text. See update_file_load
+	WL_Line_Index line_index;
+	s64 line_index_start;
+	volatile bool line_index_built;
+
+	//NOTE: Written by the main thread to tell the loading thread to stop
+	volatile bool cancelled;
+
+	//NOTE: Only used by the main thread
+	s64 bytes_added;
+	bool started;
+	bool transcoded; //NOTE: Some of the text had to be turned into utf8, so the buffer isn't the file's bytes
+	WL_Text_Encoding encoding;
+};
+
+//NOTE: A save being written on another thread. It writes a snapshot of the buffer to a temp file next to the real one, 
+//		then the main thread moves it over the real file, so a crash halfway through a save never leaves half a file.
+struct File_Save {
+	//NOTE: The main thread and the saving thread each hold a reference
+	WL_Buffer_Snapshot *snapshot;
+	Platform_File_Handle file;
+
+	//NOTE: Where the undo buffer was when we took the snapshot
+	s32 undo_redo_id;
+
+	//NOTE: Written by the saving thread. If the write failed the real file doesn't get replaced
+	volatile bool write_failed;
+	volatile bool finished;
+};
+
+//NOTE: Prettify working out its edits from a snapshot on another thread. The main thread does them if the buffer hasn't changed since.
+struct Prettify_Job {
+	WL_Buffer_Snapshot *snapshot;
+
+	//NOTE: Filled in by the prettify thread, see wl_buffer_prettify_snapshot
+	WL_Buffer_Transaction transaction;
+	char *tabs;
+
+	//NOTE: Written by the prettify thread
+	volatile bool finished;
+};
+
+//NOTE: The temp file a save gets written to before it replaces the real file
+#define FILE_SAVE_TEMP_EXTENSION ".woodland_save"
+
 typedef struct {
 	char *name;
 	char *file_name_utf8;
 	bool is_up_to_date;
 
+	//NOTE: Not null while the file is still loading on another thread
+	File_Load *file_load;
+
+	//NOTE: Not null while the file is being saved on another thread
+	File_Save *file_save;
+
+	//NOTE: The last save didn't make it into the file, so the title says so. Whatever got written is left in the temp file
+	bool save_failed;
+
+	//NOTE: Not null while prettify is working on another thread
+	Prettify_Job *prettify_job;
+
+	//NOTE: Start the undo journal once the file's finished loading, see start_undo_journal
+	bool wants_undo_journal;
+
 	Open_Buffer_Type type;
 
 	//NOTE: We have both of these since threads can change the current time stamp. 
@@ -114,6 +207,11 @@ typedef struct {
 
 	String_Query_Search_Results current_search_reults;
 	char *lastQueryString;
+
+	//NOTE: An anchor for each search result, so they stay on the text they matched if the buffer changes. See update_search_results
+	WL_Anchor *search_result_anchors;
+	WL_Buffer *search_results_buffer;
+
 	int searchIndexAt;
 
 	float line_spacing;
@@ -130,8 +228,46 @@ typedef struct {
 #include "single_search.cpp"
 #include "threads.cpp"
 
+//NOTE: Let go of the search results' anchors
+static void clear_search_results(EditorState *editorState) {
+	if(editorState->search_result_anchors) {
+		for(int i = 0; i < editorState->current_search_reults.byteOffsetCount; ++i) {
+			anchorSet_remove(&editorState->search_results_buffer->anchors, editorState->search_result_anchors[i]);
+		}
+		platform_free_memory(editorState->search_result_anchors);
+
+		editorState->search_result_anchors = 0;
+		editorState->search_results_buffer = 0;
+	}
+
+	editorState->current_search_reults.byteOffsetCount = 0;
+}
+
+static void set_search_results(EditorState *editorState, WL_Buffer *b, String_Query_Search_Results *results) {
+	clear_search_results(editorState);
+	editorState->current_search_reults = *results;
+
+	if(results->byteOffsetCount > 0) {
+		editorState->search_results_buffer = b;
+		editorState->search_result_anchors = (WL_Anchor *)platform_alloc_memory(results->byteOffsetCount*sizeof(WL_Anchor), false);
+
+		//NOTE: Text typed right in front of a match pushes the match along
+		for(int i = 0; i < results->byteOffsetCount; ++i) {
+			editorState->search_result_anchors[i] = anchorSet_add(&b->anchors, results->byteOffsets[i], WL_ANCHOR_MOVES_WITH_INSERT);
+		}
+	}
+}
+
+//NOTE: The buffer might have changed since the search, so get the offsets back out of the anchors
+static void update_search_results(EditorState *editorState) {
+	for(int i = 0; i < editorState->current_search_reults.byteOffsetCount; ++i) {
+		editorState->current_search_reults.byteOffsets[i] = anchorSet_get_offset(&editorState->search_results_buffer->anchors, editorState->search_result_anchors[i]);
+	}
+}
+
 static void set_editor_mode(EditorState *editorState, EditorMode mode) {
 	refresh_buffer(&editorState->searchBar);
+	clear_search_results(editorState);
 	if(editorState->lastQueryString) {
 		easyPlatform_freeMemory(editorState->lastQueryString);
 	}
@@ -280,15 +416,6 @@ void drawAndUpdateBufferSelection(EditorState *editorState, Renderer *renderer,
 #include "wl_project_tree.cpp"
 #include "wl_window.cpp"
 
-static bool has_utf8_BOM(u8 *txt) {
-	bool result = false;
-	if(txt[0] == (u8)239 && txt[1] == (u8)187 && txt[2] == (u8)191) {
-		result = true;
-	}
-
-	return result;
-}
-
 static int open_new_backing_buffer(EditorState *editorState) {
 	assert(editorState->buffer_count_used < MAX_BUFFER_COUNT);
 		
@@ -305,6 +432,13 @@ static int open_new_backing_buffer(EditorState *editorState) {
 	open_buffer->name = "untitled";
 	open_buffer->file_name_utf8 = 0;
 	open_buffer->is_up_to_date = true;
+	open_buffer->file_load = 0;
+	open_buffer->file_save = 0;
+	open_buffer->save_failed = false;
+	open_buffer->prettify_job = 0;
+	open_buffer->wants_undo_journal = false;
+
+	memset(&open_buffer->selectable_state, 0, sizeof(Selectable_State));
 
 	open_buffer->max_scroll_bounds = make_float2(0, 0);
 
@@ -366,6 +500,332 @@ static void close_current_window(EditorState *editorState) {
 
 }
 
+//NOTE: Adds the text that's arrived from the loading thread to the end of the buffer. Called every frame until the file has finished loading.
+static void update_file_load(WL_Open_Buffer *open_buffer) {
+	File_Load *load = open_buffer->file_load;
+	WL_Buffer *b = &open_buffer->buffer;
+
+	//NOTE: Read finished first, so if it's finished we know bytes_read is the final amount
+	bool finished = load->finished;
+	s64 bytes_read = load->bytes_read;
+
+	//NOTE: Wait till we have enough to guess the encoding from
+	s64 detect_size = (load->file_size_in_bytes < ENCODING_DETECT_SAMPLE_SIZE_IN_BYTES) ? load->file_size_in_bytes : ENCODING_DETECT_SAMPLE_SIZE_IN_BYTES;
+	if(!load->started && bytes_read > 0 && (bytes_read >= detect_size || finished)) {
+		load->started = true;
+
+		//NOTE: Don't add the BOM to the buffer
+		load->encoding = encoding_detect(load->memory, bytes_read, &load->bytes_added);
+		load->bom_size_in_bytes = load->bytes_added;
+
+		//NOTE: The user might have already typed into the buffer, in which case we keep the storage type it has
+		if(wl_buffer_get_size_in_bytes(b) == 0) {
+			//NOTE: We haven't got the whole file yet so guess the line count from what we have
+			s64 newlines = lineIndex_count_newlines(load->memory, bytes_read);
+			s64 lineCount = 1 + (newlines*load->file_size_in_bytes) / bytes_read;
+
+			wl_buffer_change_storage_type(b, bufferStorage_pick_type(load->file_size_in_bytes, lineCount, false));
+		}
+	}
+
+	if(!load->started && !finished) {
+		return;
+	}
+
+	//NOTE: The loading thread found all the lines in the file. If the buffer's still just the file's text, the rest of it goes in at once with 
+	//		those lines. Otherwise they've typed into it while it was loading, so the index doesn't match & the rest goes in a chunk at a time.
+	//		It's built before the load finishes, so once we know it's finished bytes_read is all the file.
+	bool buffer_is_file = (b->undo_redo_state.block_count == 0 && !load->transcoded && wl_buffer_get_size_in_bytes(b) == load->bytes_added - load->bom_size_in_bytes);
+	bool index_fits = (load->encoding == WL_TEXT_ENCODING_UTF8 && load->line_index_start == load->bom_size_in_bytes && bufferStorage_uses_line_index(b->storage.type));
+
+	if(finished && load->line_index_built && load->started && !load->cancelled && buffer_is_file && index_fits && bytes_read > load->bytes_added) {
+		if(load->is_mapped) {
+			wl_buffer_add_file_map_text(b, load->bytes_added - load->bom_size_in_bytes, bytes_read - load->bytes_added, &load->line_index);
+		} else {
+			wl_buffer_append_with_line_index(b, load->memory + load->bytes_added, bytes_read - load->bytes_added, &load->line_index);
+		}
+		load->bytes_added = bytes_read;
+	}
+
+	if(!load->cancelled) {
+		s64 end = bytes_read;
+
+		if((end - load->bytes_added) > FILE_LOAD_MAX_BYTES_ADDED_PER_FRAME) {
+			end = load->bytes_added + FILE_LOAD_MAX_BYTES_ADDED_PER_FRAME;
+		}
+
+		if(!(finished && end == bytes_read)) {
+			//NOTE: Don't split a codepoint across frames, leave the last one for next time if it's not all here
+			end = encoding_get_chunk_end(load->encoding, load->memory, load->bytes_added, end);
+		}
+
+		//NOTE: The mapped file's text doesn't need copying if it's utf8. The BOM's not in the buffer's text
+		s64 valid_end = (load->valid_utf8_size < end) ? load->valid_utf8_size : end;
+		if(load->is_mapped && valid_end > load->bytes_added) {
+			wl_buffer_add_file_map_text(b, load->bytes_added - load->bom_size_in_bytes, valid_end - load->bytes_added);
+			load->bytes_added = valid_end;
+		}
+
+		if(end > load->bytes_added) {
+			u8 *text = load->memory + load->bytes_added;
+			s64 text_size = end - load->bytes_added;
+
+			//NOTE: Valid utf8 goes straight in, everything else has to be turned into it first
+			u8 *utf8 = 0;
+			s64 utf8_size = 0;
+			if(load->encoding != WL_TEXT_ENCODING_UTF8 || !encoding_is_valid_utf8(text, text_size)) {
+				utf8 = (u8 *)platform_alloc_memory(encoding_get_max_utf8_size(load->encoding, text_size), false);
+				utf8_size = encoding_transcode_to_utf8(load->encoding, text, text_size, utf8);
+				load->transcoded = true;
+			}
+
+			//NOTE: Always add to the end, since the user might be moving around or typing in what's arrived already. 
+			//		Doesn't go in the undo buffer, and the cursor's an anchor so it stays where the user put it.
+			//		The sizes come from the read, not the text, so a zero byte in the file doesn't cut the chunk short.
+			if(utf8) {
+				wl_buffer_insert_bytes(b, wl_buffer_get_size_in_bytes(b), utf8, utf8_size);
+			} else {
+				wl_buffer_insert_bytes(b, wl_buffer_get_size_in_bytes(b), text, text_size);
+			}
+
+			load->bytes_added = end;
+
+			if(utf8) {
+				platform_free_memory(utf8);
+			}
+		}
+	}
+
+	//NOTE: Can't free the memory till the thread's finished with it
+	if(finished && (load->cancelled || load->bytes_added >= bytes_read)) {
+		//NOTE: Only part of the file is in the buffer, so the journal wouldn't match it
+		if(load->cancelled) {
+			open_buffer->wants_undo_journal = false;
+		}
+
+		//NOTE: The buffer owns the mapped file
+		if(!load->is_mapped) {
+			platform_free_memory(load->memory);
+		}
+
+		//NOTE: Still here if the buffer didn't take it
+		lineIndex_free(&load->line_index);
+		platform_free_memory(load);
+		open_buffer->file_load = 0;
+	}
+}
+
+//NOTE: Writes the buffer as it is now on another thread, so the user can keep editing while a big file saves. See update_file_save
+static void begin_file_save(WL_Open_Buffer *open_buffer) {
+	assert(open_buffer->file_name_utf8);
+	assert(!open_buffer->file_save);
+
+	char *temp_path = concatInArena(open_buffer->file_name_utf8, FILE_SAVE_TEMP_EXTENSION, &globalPerFrameArena);
+	Platform_File_Handle handle = platform_begin_file_write_utf8_file_path(temp_path);
+
+	if(!handle.has_errors) {
+		File_Save *save = (File_Save *)platform_alloc_memory(sizeof(File_Save), true);
+		save->file = handle;
+		save->undo_redo_id = undoRedo_get_current_id(&open_buffer->buffer.undo_redo_state);
+		//NOTE: Typing after the save can't join onto a block from before it, or undoing back to the save id would miss text
+		undoRedo_stop_coalescing(&open_buffer->buffer.undo_redo_state);
+		save->snapshot = wl_buffer_take_snapshot(&open_buffer->buffer);
+		wl_buffer_retain_snapshot(save->snapshot);
+
+		//NOTE: The journal starts again from the text we're saving
+		if(open_buffer->buffer.undo_redo_state.journal) {
+			undoJournal_begin_rebase(open_buffer->buffer.undo_redo_state.journal, &open_buffer->buffer.undo_redo_state, save->snapshot->size_in_bytes, save->undo_redo_id);
+		}
+
+		open_buffer->file_save = save;
+
+		if(global_platform.push_work_onto_queue) {
+			global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_save_file, save);
+		} else {
+			thread_work_save_file(save);
+		}
+	} else {
+		open_buffer->save_failed = true;
+	}
+}
+
+//NOTE: Once the saving thread has finished writing the temp file, move it over the real file. Called every frame until the save is done.
+static void update_file_save(WL_Open_Buffer *open_buffer) {
+	File_Save *save = open_buffer->file_save;
+	WL_Buffer *b = &open_buffer->buffer;
+
+	//NOTE: Can't replace the file while we've got it mapped. Jobs reading the buffer through a snapshot might still be reading the map too, 
+	//		they let go of it when they finish so wait for them. The snapshot we saved holds it as well, that's the 2, 
+	//		but another job could be holding that one too.
+	bool remap_file = (save->finished && !save->write_failed && wl_buffer_is_file_mapped(b));
+	if(remap_file) {
+		wl_buffer_free_released_snapshots();
+	}
+	bool file_map_in_use = (remap_file && (wl_buffer_get_file_map_ref_count(b) > 2 || save->snapshot->ref_count > 1));
+
+	if(save->finished && !file_map_in_use) {
+		char *temp_path = concatInArena(open_buffer->file_name_utf8, FILE_SAVE_TEMP_EXTENSION, &globalPerFrameArena);
+
+		//NOTE: If nothing's changed since the snapshot, the saved file has exactly the text in the buffer
+		bool buffer_matches_file = wl_buffer_snapshot_is_current(save->snapshot);
+
+		//NOTE: Work out where the text from the old file is in the new one while we've still got the snapshot, so we can read it out of the new one
+		//		instead of copying the old file into memory
+		WL_Piece *rebased_pieces = 0;
+		s64 rebased_piece_count = 0;
+		if(remap_file && !buffer_matches_file) {
+			rebased_pieces = wl_buffer_rebase_onto_saved_file(b, save->snapshot, &rebased_piece_count);
+		}
+
+		wl_buffer_release_snapshot(save->snapshot);
+		wl_buffer_free_released_snapshots();
+
+		s64 skip_in_bytes = 0;
+		if(remap_file) {
+			skip_in_bytes = wl_buffer_unmap_file(b);
+		}
+
+		bool replaced = false;
+		if(!save->write_failed) {
+			replaced = platform_replace_file_utf8(temp_path, open_buffer->file_name_utf8);
+		}
+
+		if(remap_file) {
+			//NOTE: The real file has the new text if it got replaced, otherwise it's still the old one. If we can't get that back the temp file still has the new text.
+			bool mapped_new_text = replaced;
+			Platform_File_Map file_map = {};
+			bool mapped = platform_map_file_read_only_wideChar(platform_utf8_to_wide_char(open_buffer->file_name_utf8, &globalPerFrameArena), &file_map);
+			if(!mapped && !replaced) {
+				mapped_new_text = true;
+				mapped = platform_map_file_read_only_wideChar(platform_utf8_to_wide_char(temp_path, &globalPerFrameArena), &file_map);
+			}
+			assert(mapped);
+
+			if(!mapped_new_text) {
+				wl_buffer_map_file(b, file_map, skip_in_bytes);
+			} else if(buffer_matches_file) {
+				wl_buffer_swap_to_file_map(b, file_map);
+			} else {
+				wl_buffer_map_file(b, file_map, 0, rebased_pieces, rebased_piece_count);
+			}
+		}
+
+		if(rebased_pieces) {
+			platform_free_memory(rebased_pieces);
+		}
+
+		//NOTE: Leave the temp file if it didn't work, it's the only copy of what we tried to save
+		open_buffer->save_failed = !replaced;
+
+		if(replaced) {
+			open_buffer->name = getFileLastPortion(open_buffer->file_name_utf8);
+			open_buffer->is_up_to_date = buffer_matches_file;
+
+			//NOTE: Update the save position in the redo buffer so we know when we're back to a save position
+			open_buffer->current_save_undo_redo_id = save->undo_redo_id;
+
+			//NOTE: We changed the file, so the file stamp thread shouldn't think someone else did
+			open_buffer->current_time_stamp = open_buffer->last_time_stamp = platform_get_file_time_utf8_filename(open_buffer->file_name_utf8);
+		}
+
+		if(b->undo_redo_state.journal) {
+			undoJournal_end_rebase(b->undo_redo_state.journal, replaced, open_buffer->last_time_stamp);
+		}
+
+		platform_free_memory(save);
+		open_buffer->file_save = 0;
+	}
+}
+
+//NOTE: Prettifies a snapshot of the buffer on another thread so a big file doesn't hold up the frame. See update_prettify
+static void begin_prettify(WL_Open_Buffer *open_buffer) {
+	assert(!open_buffer->prettify_job);
+
+	Prettify_Job *job = (Prettify_Job *)platform_alloc_memory(sizeof(Prettify_Job), true);
+	job->snapshot = wl_buffer_take_snapshot(&open_buffer->buffer);
+
+	open_buffer->prettify_job = job;
+
+	if(global_platform.push_work_onto_queue) {
+		global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_prettify, job);
+	} else {
+		thread_work_prettify(job);
+	}
+}
+
+//NOTE: Does the edits once they've been worked out, as one undo group. If the buffer got edited in the meantime the edits are for the old text, 
+//		so they're thrown away and it starts again from the text as it is now. It gets done once the user stops typing for long enough.
+static void update_prettify(WL_Open_Buffer *open_buffer) {
+	Prettify_Job *job = open_buffer->prettify_job;
+
+	if(job->finished) {
+		bool is_current = wl_buffer_snapshot_is_current(job->snapshot);
+
+		//NOTE: Let go of it first so the edits don't copy the text for it
+		wl_buffer_release_snapshot(job->snapshot);
+
+		if(is_current && job->transaction.edit_count > 0) {
+			wl_buffer_commit_transaction(&open_buffer->buffer, &job->transaction);
+			open_buffer->is_up_to_date = false;
+		} else {
+			wl_buffer_free_transaction(&job->transaction);
+		}
+
+		if(job->tabs) {
+			easyPlatform_freeMemory(job->tabs);
+		}
+
+		platform_free_memory(job);
+		open_buffer->prettify_job = 0;
+
+		if(!is_current) {
+			begin_prettify(open_buffer);
+		}
+	}
+}
+
+//NOTE: Once a file's loaded, puts back the history & edits from its journal if it has one, then starts writing the history out. See wl_undo_journal.cpp
+static void start_undo_journal(WL_Open_Buffer *open_buffer) {
+	WL_Buffer *b = &open_buffer->buffer;
+	open_buffer->wants_undo_journal = false;
+
+	char *path = concat(open_buffer->file_name_utf8, UNDO_JOURNAL_EXTENSION);
+	WL_Undo_Journal *journal = undoJournal_create(path);
+
+	u8 *records = 0;
+	WL_Undo_Journal_Replay replay = {};
+
+	//NOTE: Only if nothing's been typed while it loaded, otherwise we'd lose it
+	if(b->undo_redo_state.block_count == 0) {
+		size_t journal_size = 0;
+		u64 journal_time_stamp = 0;
+		Platform_File_Handle file = platform_begin_file_read_wideChar(platform_utf8_to_wide_char(path, &globalPerFrameArena), &journal_size, &journal_time_stamp);
+
+		if(!file.has_errors) {
+			if(journal_size > 0) {
+				records = (u8 *)platform_alloc_memory(journal_size, false);
+				s64 records_size = platform_read_file_data(file, records, journal_size, 0);
+
+				replay = undoJournal_replay(b, records, records_size, wl_buffer_get_size_in_bytes(b), open_buffer->last_time_stamp);
+			}
+			platform_close_file(file);
+		}
+	}
+
+	if(replay.replayed) {
+		open_buffer->current_save_undo_redo_id = replay.base_undo_redo_id;
+		open_buffer->is_up_to_date = replay.matches_base;
+
+		undoJournal_start(journal, &b->undo_redo_state, wl_buffer_get_size_in_bytes(b), open_buffer->last_time_stamp, records, replay.good_size_in_bytes);
+	} else {
+		undoJournal_start(journal, &b->undo_redo_state, wl_buffer_get_size_in_bytes(b), open_buffer->last_time_stamp, 0, 0);
+	}
+
+	if(records) {
+		platform_free_memory(records);
+	}
+}
+
 enum Open_File_Into_Buffer_Type {
 	OPEN_FILE_INTO_NEW_WINDOW,
 	OPEN_FILE_INTO_CURRENT_WINDOW,
@@ -376,9 +836,31 @@ static WL_Open_Buffer *open_file_and_add_to_window(EditorState *editorState, cha
 	WL_Open_Buffer *result = 0;
 
 	size_t data_size = 0;
-	void *data = 0;
 	u64 timeStamp;
-	if(Platform_LoadEntireFile_wideChar(file_name_wide_char, &data, &data_size, &timeStamp)) {
+
+	//NOTE: Really big files get memory mapped instead of loaded, so we don't read the whole file before the first frame
+	Platform_File_Map file_map = {};
+	bool use_file_map = false;
+	s64 file_map_bom_size = 0;
+	if(platform_map_file_read_only_wideChar(file_name_wide_char, &file_map)) {
+		//NOTE: The buffer reads straight out of the mapped file, so it has to be utf8 already. Anything else gets loaded & turned into utf8.
+		//		Checking the whole file is utf8 would stall the frame, so that happens on the loading thread. See thread_work_check_file_map
+		if(bufferStorage_pick_type(file_map.size_in_bytes, 0, true) == WL_BUFFER_STORAGE_PIECE_TABLE && 
+			encoding_detect((u8 *)file_map.memory, file_map.size_in_bytes, &file_map_bom_size) == WL_TEXT_ENCODING_UTF8) {
+			use_file_map = true;
+			timeStamp = file_map.time_stamp;
+		} else {
+			platform_unmap_file(&file_map);
+		}
+	}
+
+	//NOTE: Everything else gets read on another thread, and shows up in the buffer as it arrives
+	Platform_File_Handle file_handle = {};
+	if(!use_file_map) {
+		file_handle = platform_begin_file_read_wideChar(file_name_wide_char, &data_size, &timeStamp);
+	}
+
+	if(use_file_map || !file_handle.has_errors) {
 
 		WL_Window *w = 0;
 		if(open_type == OPEN_FILE_INTO_NEW_WINDOW) {
@@ -397,18 +879,46 @@ static WL_Open_Buffer *open_file_and_add_to_window(EditorState *editorState, cha
 
 		WL_Buffer *b = &open_buffer->buffer;
 
-		char *start_of_text = (char *)data;
+		File_Load *load = (File_Load *)platform_alloc_memory(sizeof(File_Load), true);
+		open_buffer->file_load = load;
 
-		if(data_size > 3 && has_utf8_BOM((u8 *)start_of_text)) {
-			start_of_text += 3;
-			//NOTE: Is utf8 
-		} 
-		//TODO: eventually we'll want to check all different encodings
+		if(use_file_map) {
+			//NOTE: The buffer owns the file map now. It gets the text as the loading thread finds it's utf8
+			wl_buffer_init_from_file_map(b, file_map, file_map_bom_size);
 
-		bool should_add_to_history = false; //NOTE: Shouldn't add this to the history since we are opening a file, and don't want to undo this from the buffer
-		addTextToBuffer(b, start_of_text, b->cursorAt_inBytes, should_add_to_history);
+			load->memory = (u8 *)file_map.memory;
+			load->file_size_in_bytes = file_map.size_in_bytes;
+			load->is_mapped = true;
+			load->bom_size_in_bytes = file_map_bom_size;
 
-		b->cursorAt_inBytes = 0;
+			//NOTE: We already know it's utf8 & the storage type
+			load->started = true;
+			load->encoding = WL_TEXT_ENCODING_UTF8;
+			load->bytes_added = file_map_bom_size;
+			load->bytes_read = load->valid_utf8_size = file_map_bom_size;
+
+			if(global_platform.push_work_onto_queue) {
+				global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_check_file_map, load);
+			} else {
+				thread_work_check_file_map(load);
+			}
+		} else {
+			load->file = file_handle;
+			load->file_size_in_bytes = data_size;
+			load->memory = (u8 *)platform_alloc_memory(data_size, false);
+
+			if(global_platform.push_work_onto_queue) {
+				global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_load_file, load);
+			} else {
+				//NOTE: No threads to load on, so just load it now
+				thread_work_load_file(load);
+			}
+		}
+
+		//NOTE: Show the first screen straight away if it's already arrived
+		update_file_load(open_buffer);
+
+		wl_buffer_set_cursor(b, 0);
 
 		open_buffer->is_up_to_date = true;
 		open_buffer->current_time_stamp = open_buffer->last_time_stamp = timeStamp;
@@ -418,11 +928,11 @@ static WL_Open_Buffer *open_file_and_add_to_window(EditorState *editorState, cha
 
 		open_buffer->type = OPEN_BUFFER_TEXT_EDITOR;
 
-		platform_free_memory(data);
+		open_buffer->wants_undo_journal = true;
 
 		result = open_buffer;
 
-		// open_buffer->ast = easyAst_generateAst((char *)b->bufferMemory, &global_long_term_arena);
+		// open_buffer->ast = easyAst_generateAst((char *)b->storage.gap_buffer.memory, &global_long_term_arena);
 
 	} else {
 		// assert(!"Couldn't open file");
@@ -466,6 +976,10 @@ static void DEBUG_draw_stats(EditorState *editorState, Renderer *renderer, Font
 	DEBUG_draw_stats_MACRO("Draw Count", global_debug_stats.draw_call_count, false);
 	DEBUG_draw_stats_MACRO("Heap Block Count ", global_debug_stats.memory_block_count, false);
 	DEBUG_draw_stats_MACRO("Per Frame Arena Total Size", DEBUG_get_total_arena_size(&globalPerFrameArena), true);
+	DEBUG_draw_stats_MACRO("Undo Text In Memory", global_debug_stats.undo_bytes_uncompressed, true);
+	DEBUG_draw_stats_MACRO("Undo Text Compressed", global_debug_stats.undo_bytes_compressed_from, true);
+	DEBUG_draw_stats_MACRO("Undo Text Compressed Size", global_debug_stats.undo_bytes_compressed, true);
+	DEBUG_draw_stats_MACRO("Undo Text Spilled To File", global_debug_stats.undo_bytes_spilled, true);
 
 	// WL_Window *w = &editorState->windows[editorState->active_window_index];
 	// DEBUG_draw_stats_FLOAT_MACRO("Start at: ", editorState->selectable_state.start_pos.x, editorState->selectable_state.start_pos.y);
@@ -533,6 +1047,9 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 		DEBUG_runUnitTestForLookBackTokens();
 		DEBUG_runUnitTestForLookForwardTokens();
 		DEBUG_runUnitTests();
+#if DEBUG_LARGE_FILE_TESTS
+		DEBUG_runLargeFileTests("woodland_large_file_test.txt");
+#endif
 #endif
 		
 
@@ -566,6 +1083,58 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 	//NOTE: Clear the renderer out so we can start again
 	clearRenderer(renderer);
 
+#if DEBUG_BUILD
+	//NOTE: undoRedo_update adds on each buffer's
+	global_debug_stats.undo_bytes_uncompressed = 0;
+	global_debug_stats.undo_bytes_compressed_from = 0;
+	global_debug_stats.undo_bytes_compressed = 0;
+	global_debug_stats.undo_bytes_spilled = 0;
+#endif
+
+	//NOTE: Add the text that's arrived for any files still loading, & finish any saves
+	for(int i = 0; i < editorState->buffer_count_used; ++i) {
+		WL_Open_Buffer *open_buffer = &editorState->buffers_loaded[i];
+		if(open_buffer->file_save) {
+			update_file_save(open_buffer);
+		}
+
+		if(open_buffer->prettify_job) {
+			update_prettify(open_buffer);
+		}
+
+		if(open_buffer->file_load) {
+			update_file_load(open_buffer);
+
+			//NOTE: The buffer is getting longer so the windows need to work out their bounds again
+			for(int j = 0; j < editorState->window_count_used; ++j) {
+				if(editorState->windows[j].buffer_index == i) {
+					editorState->windows[j].needToGetTotalBounds = true;
+				}
+			}
+		}
+
+		if(open_buffer->wants_undo_journal && !open_buffer->file_load) {
+			start_undo_journal(open_buffer);
+		}
+
+		//NOTE: Write last frame's undo history out on another thread
+		if(open_buffer->buffer.undo_redo_state.journal) {
+			undoJournal_update(open_buffer->buffer.undo_redo_state.journal);
+		}
+
+		//NOTE: Compress the old undo text that's over the budget
+		undoRedo_update(&open_buffer->buffer.undo_redo_state);
+
+		//NOTE: Keep the undo checkpoints that have finished compressing & let go of their snapshots
+		wl_buffer_update_undo_checkpoints(&open_buffer->buffer);
+	}
+
+	//NOTE: Free the snapshots the other threads have finished with
+	wl_buffer_free_released_snapshots();
+
+	//NOTE: Typing pauses start new undo blocks
+	undoRedo_advance_time(dt);
+
 	/////////KEYBOARD COMMANDS BELOW /////////////
 
 	if(global_platformInput.drop_file_name_wide_char_need_to_free != 0) {
@@ -659,12 +1228,6 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 
 		WL_Open_Buffer *open_buffer = &editorState->buffers_loaded[w->buffer_index];
 
-		WL_Buffer *b = &open_buffer->buffer;
-
-		#if 1
-		prettify_buffer(b);
-		#else 
-
 		if(!open_buffer->file_name_utf8) {
 			//NOTE: Open a Save Dialog window
 			u16 *fileNameToOpen_utf16 = (u16 *)Platform_SaveFile_withDialog_wideChar(&globalPerFrameArena);
@@ -677,25 +1240,23 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 
 		}
 
-		if(open_buffer->file_name_utf8) { //NOTE: If the user cancels the save dialog box
-
-			Compiled_Buffer_For_Save compiled_buffer = compile_buffer_to_save_format(b, &globalPerFrameArena);
-			
-			Platform_File_Handle handle = platform_begin_file_write_utf8_file_path (open_buffer->file_name_utf8);
-			assert(!handle.has_errors);
-			platform_write_file_data(handle, compiled_buffer.memory, compiled_buffer.size_in_bytes, 0);
+		//NOTE: Don't save a file that hasn't finished loading, it would cut the end off the file. 
+		//		If the last save is still being written, wait for it to finish.
+		if(open_buffer->file_name_utf8 && !open_buffer->file_load && !open_buffer->file_save) { //NOTE: If the user cancels the save dialog box
+			begin_file_save(open_buffer);
+		}
+	}
 
-			platform_close_file(handle);
+	//NOTE: Ctrl + P -> prettify the file
+	if(global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && global_platformInput.keyStates[PLATFORM_KEY_P].pressedCount > 0) 
+	{	
+		WL_Window *w = &editorState->windows[editorState->active_window_index];
 
-			open_buffer->name = getFileLastPortion(open_buffer->file_name_utf8);
-			open_buffer->is_up_to_date = true;
+		WL_Open_Buffer *open_buffer = &editorState->buffers_loaded[w->buffer_index];
 
-			//NOTE: Update the save position in the redo buffer so we know when we're back to a save position
-			open_buffer->current_save_undo_redo_id = open_buffer->buffer.undo_redo_state.idAt;
+		if(!open_buffer->prettify_job && !open_buffer->file_load) {
+			begin_prettify(open_buffer);
 		}
-
-		prettify_buffer(b);
-		#endif
 	}
 
 
@@ -719,6 +1280,15 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 	switch(editorState->mode_) {
 		case MODE_EDIT_BUFFER: {	
 
+			//NOTE: Escape stops loading the file. Keep what's loaded so far, but it isn't the file anymore so we don't want to save over it.
+			if(open_buffer->file_load && !open_buffer->file_load->cancelled && global_platformInput.keyStates[PLATFORM_KEY_ESCAPE].pressedCount > 0) {
+				open_buffer->file_load->cancelled = true;
+
+				//NOTE: Don't free the name since the file stamp thread might be using it
+				open_buffer->file_name_utf8 = 0;
+				open_buffer->is_up_to_date = false;
+			}
+
 			if(is_interaction_active(&editorState->ui_state, WL_INTERACTION_RESIZE_WINDOW)) {
 				if(global_platformInput.keyStates[PLATFORM_MOUSE_LEFT_BUTTON].isDown) {
 					WL_Window *w = &editorState->windows[editorState->ui_state.id.id];
@@ -813,40 +1383,17 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 			//NOTE: User wants to jump to a new line
 			if(global_platformInput.keyStates[PLATFORM_KEY_ENTER].pressedCount > 0 && str[0] != '\0') {
 
-				endGapBuffer(b);
-
-				//TODO: Not 64 bit - should be a size_t 
 				//NOTE: Get the line number to jump to
-				int lineNumber = atoi(str);
-
-				//NOTE: Immediate mode - go through text and find the line number, instead of storing a map of line numbers to byte offsets
-				
-				char *str = (char *)b->bufferMemory; 
-				char *start = str;
-
-				size_t offset = 0;
+				s64 lineNumber = strtoll(str, 0, 10);
 
-				int lineNumberAt = 0;
-				if(lineNumber == lineNumberAt) {
-					//NOTE: On first line
-				} else {
-					while(*str) {
-						if(*str == '\n') {
-							lineNumberAt++;
-						}
-
-						//NOTE: See if we found the line
-						if(lineNumber == lineNumberAt) {
-							offset = (str - start);
-							break;
-						}
-						
-						str++;
-					}
+				//NOTE: Line numbers start at 1 for the user
+				s64 offset = 0;
+				if(lineNumber > 0) {
+					offset = wl_buffer_get_offset_of_line(b, lineNumber - 1);
 				}
 
 				//NOTE: Set the cursor to the new offset
-				b->cursorAt_inBytes = offset;
+				wl_buffer_set_cursor(b, offset);
 				open_buffer->should_scroll_to = true;
 
 				//NOTE: Exit GO TO mode
@@ -861,10 +1408,17 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 
 			WL_Buffer *b = &open_buffer->buffer;
 
+			update_search_results(editorState);
 
-			if(global_platformInput.keyStates[PLATFORM_KEY_ENTER].pressedCount > 0) {
+			if(global_platformInput.keyStates[PLATFORM_KEY_ENTER].pressedCount > 0 && global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown) {
+				//NOTE: Ctrl Enter -> a cursor on every match & go back to editing
+				if(editorState->current_search_reults.byteOffsetCount > 0) {
+					multiCursor_select_matches(&open_buffer->selectable_state, b, editorState->current_search_reults.byteOffsets, editorState->current_search_reults.byteOffsetCount, easyString_getSizeInBytes_utf8(editorState->lastQueryString));
+					open_buffer->should_scroll_to = true;
+				}
 
-				endGapBuffer(b);
+				set_editor_mode(editorState, MODE_EDIT_BUFFER);
+			} else if(global_platformInput.keyStates[PLATFORM_KEY_ENTER].pressedCount > 0) {
 
 				if(editorState->current_search_reults.byteOffsetCount > 0) {
 					//NOTE: Jump to next query point
@@ -874,9 +1428,9 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 						editorState->searchIndexAt = 0;
 					}
 
-					int offset = editorState->current_search_reults.byteOffsets[editorState->searchIndexAt];
+					s64 offset = editorState->current_search_reults.byteOffsets[editorState->searchIndexAt];
 
-					b->cursorAt_inBytes = offset;
+					wl_buffer_set_cursor(b, offset);
 					open_buffer->should_scroll_to = true;
 				}
 
@@ -909,16 +1463,17 @@ static EditorState *updateEditor(float dt, float windowWidth, float windowHeight
 					if(editorState->lastQueryString) {
 						easyPlatform_freeMemory(editorState->lastQueryString);
 					}
-					Compiled_Buffer_For_Drawing buffer_to_draw = compileBuffer_toDraw(b, &globalPerFrameArena, &open_buffer->selectable_state);
+					WL_Buffer_View buffer_view = wl_buffer_get_view(b, &globalPerFrameArena);
 					//NOTE: Cache the query string
 					editorState->lastQueryString = easyPlatform_allocateStringOnHeap_nullTerminated(queryString);
-					editorState->current_search_reults = string_utf8_find_sub_string((char *)buffer_to_draw.memory, editorState->lastQueryString);
+					String_Query_Search_Results results = wl_buffer_view_find_sub_string(&buffer_view, editorState->lastQueryString, &globalPerFrameArena);
+					set_search_results(editorState, b, &results);
 					if(editorState->current_search_reults.byteOffsetCount > 0) {
 						editorState->current_search_reults.sub_string_width = font_getStringDimensions(renderer, &editorState->font, editorState->lastQueryString, editorState->fontScale);
 					}
 				}
 			} else {
-				editorState->current_search_reults.byteOffsetCount = 0;
+				clear_search_results(editorState);
 			}
 		} break;
 		case MODE_BUFFER_SELECT: {
@@ -184,11 +184,165 @@ static MemoryArenaMark global_perFrameArenaMark;
 
 static Memory_Arena global_long_term_arena = {0};
 
+/*
+Scratch arenas are for temporary memory on any thread, like a job on the thread queue. Every thread has its own ones so they don't 
+need a lock, and they work like a stack: take one, push onto it, then release it and everything pushed since is gone.
 
-char *nullTerminateBuffer(char *result, char *string, int length) {
-    for(int i = 0; i < length; ++i) {
-        result[i]= string[i];
+Scratch_Arena scratch = getScratchArena();
+char *temp = pushArray(scratch.arena, 100, char);
+releaseScratchArena(&scratch);
+
+A function that's handed an arena to put its result in might get that same scratch arena back, and releasing it would throw away 
+the result too. So it passes the arenas it was handed in as conflicts and gets a different one.
+
+Scratch_Arena scratch = getScratchArena(&result_arena, 1);
+*/
+
+//NOTE: One more than the most conflicts anyone passes in
+#define SCRATCH_ARENA_COUNT_PER_THREAD 2
+
+static thread_local Memory_Arena global_thread_scratch_arenas[SCRATCH_ARENA_COUNT_PER_THREAD];
+
+typedef struct {
+    Memory_Arena *arena;
+    MemoryArenaMark mark;
+} Scratch_Arena;
+
+static Scratch_Arena getScratchArena(Memory_Arena **conflicts = 0, int conflict_count = 0) {
+    Scratch_Arena result = {};
+
+    for(int i = 0; i < SCRATCH_ARENA_COUNT_PER_THREAD && !result.arena; ++i) {
+        Memory_Arena *arena = &global_thread_scratch_arenas[i];
+
+        bool is_conflict = false;
+        for(int j = 0; j < conflict_count; ++j) {
+            if(conflicts[j] == arena) {
+                is_conflict = true;
+            }
+        }
+
+        if(!is_conflict) {
+            result.arena = arena;
+        }
+    }
+    assert(result.arena);
+
+    //NOTE: The thread hasn't used it yet
+    if(!result.arena->pieces) {
+        *result.arena = initMemoryArena(Kilobytes(64));
+    }
+
+    result.mark = takeMemoryMark(result.arena);
+    return result;
+}
+
+static void releaseScratchArena(Scratch_Arena *scratch) {
+    releaseMemoryMark(&scratch->mark);
+}
+
+//NOTE: So the thread queue can check a job didn't keep hold of one
+static bool scratchArenasAreReleased() {
+    bool result = true;
+    for(int i = 0; i < SCRATCH_ARENA_COUNT_PER_THREAD; ++i) {
+        result &= (global_thread_scratch_arenas[i].markCount == 0);
+    }
+    return result;
+}
+
+static void freeMemoryPieces(MemoryPiece *piece) {
+    while(piece) {
+        MemoryPiece *next = piece->next;
+        platform_free_memory_pages(piece, piece->totalSize + sizeof(MemoryPiece));
+        piece = next;
+    }
+}
+
+//NOTE: Call on a thread that's about to end, otherwise its scratch memory never goes back
+static void freeThreadScratchArenas() {
+    assert(scratchArenasAreReleased());
+
+    for(int i = 0; i < SCRATCH_ARENA_COUNT_PER_THREAD; ++i) {
+        Memory_Arena *arena = &global_thread_scratch_arenas[i];
+        freeMemoryPieces(arena->pieces);
+        freeMemoryPieces(arena->piecesFreeList);
+        memset(arena, 0, sizeof(Memory_Arena));
     }
+}
+
+/*
+The atomic arena is a bump arena any thread can push onto at the same time without a lock, for memory that's shared between threads
+and lives as long as the arena does. A push is one atomic add on how much of the block is used. The push that goes past the end of 
+the block makes a new one and swaps it in with a compare exchange. If another thread swapped its one in first, it frees its own and 
+pushes onto that one instead. Nothing gets freed till the whole arena does, when no threads are using it.
+*/
+
+#define ATOMIC_ARENA_BLOCK_SIZE Megabytes(1)
+
+//NOTE: Everything pushed is this aligned so it's fine to share between threads
+#define ATOMIC_ARENA_ALIGNMENT 16
+
+typedef struct Atomic_Arena_Block Atomic_Arena_Block;
+typedef struct Atomic_Arena_Block {
+    Atomic_Arena_Block *next; //NOTE: The block that was full before this one
+
+    u8 *memory;
+    s64 totalSize;
+    volatile s64 used; //NOTE: Goes past totalSize once it's full
+} Atomic_Arena_Block;
+
+typedef struct {
+    Atomic_Arena_Block *volatile current;
+} Atomic_Arena;
+
+static void *pushSizeAtomic(Atomic_Arena *arena, size_t size) {
+    s64 aligned_size = (s64)((size + (ATOMIC_ARENA_ALIGNMENT - 1)) & ~(size_t)(ATOMIC_ARENA_ALIGNMENT - 1));
+
+    for(;;) {
+        Atomic_Arena_Block *block = arena->current;
+
+        if(block) {
+            s64 end = platform_atomic_add_s64(&block->used, aligned_size);
+            if(end <= block->totalSize) {
+                //NOTE: Already zeroed, blocks come from the OS zeroed and nothing in them gets used twice
+                return block->memory + (end - aligned_size);
+            }
+        }
+
+        //NOTE: Full, so swap in a new block with this push already in it
+        s64 block_size = (aligned_size > (s64)ATOMIC_ARENA_BLOCK_SIZE) ? aligned_size : (s64)ATOMIC_ARENA_BLOCK_SIZE;
+        u8 *memory_u8 = (u8 *)platform_alloc_memory_pages(block_size + sizeof(Atomic_Arena_Block) + ATOMIC_ARENA_ALIGNMENT);
+
+        Atomic_Arena_Block *new_block = (Atomic_Arena_Block *)memory_u8;
+        new_block->next = block;
+        new_block->memory = memory_u8 + ((sizeof(Atomic_Arena_Block) + (ATOMIC_ARENA_ALIGNMENT - 1)) & ~(size_t)(ATOMIC_ARENA_ALIGNMENT - 1));
+        new_block->totalSize = block_size;
+        new_block->used = aligned_size;
+
+        if(platform_atomic_compare_exchange_pointer((void *volatile *)&arena->current, new_block, block) == block) {
+            return new_block->memory;
+        }
+
+        //NOTE: Another thread got there first
+        platform_free_memory_pages(memory_u8, block_size + sizeof(Atomic_Arena_Block) + ATOMIC_ARENA_ALIGNMENT);
+    }
+}
+
+#define pushArrayAtomic(arena, size, type) (type *)pushSizeAtomic(arena, sizeof(type)*(size))
+
+//NOTE: Only when no other threads are using it
+static void freeAtomicArena(Atomic_Arena *arena) {
+    Atomic_Arena_Block *block = arena->current;
+    while(block) {
+        Atomic_Arena_Block *next = block->next;
+        platform_free_memory_pages(block, block->totalSize + sizeof(Atomic_Arena_Block) + ATOMIC_ARENA_ALIGNMENT);
+        block = next;
+    }
+    arena->current = 0;
+}
+
+
+char *nullTerminateBuffer(char *result, char *string, s64 length) {
+    memcpy(result, string, length);
     result[length] = '\0';
     return result;
 }
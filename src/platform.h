@@ -37,12 +37,24 @@ typedef intptr_t intprt;
 #define ENUM(value) value,
 #define STRING(value) #value,
 
+#define THREAD_WORK_FUNCTION(name) void name(void *Data)
+typedef THREAD_WORK_FUNCTION(thread_work_function);
+
+struct thread_info;
+
+#define PLATFORM_PUSH_WORK_ONTO_QUEUE(name) void name(thread_info *Info, thread_work_function *WorkFunction, void *Data)
+typedef PLATFORM_PUSH_WORK_ONTO_QUEUE(platform_push_work_onto_queue);
+
 typedef struct {
 	size_t permanent_storage_size;
 	size_t scratch_storage_size;
 
 	void *permanent_storage;
 	void *scratch_storage;
+
+	//NOTE: For running work on the other threads, set up by the platform when it starts the threads
+	thread_info *work_queue;
+	platform_push_work_onto_queue *push_work_onto_queue;
 } PlatformLayer; 
 
 struct Platform_File_Handle {
@@ -50,6 +62,16 @@ struct Platform_File_Handle {
     bool has_errors;
 };
 
+//NOTE: A file mapped into memory read only
+struct Platform_File_Map {
+    void *memory;
+    size_t size_in_bytes;
+    u64 time_stamp;
+
+    void *file_handle;
+    void *mapping_handle;
+};
+
 enum PlatformKeyType {
     PLATFORM_KEY_NULL,
     PLATFORM_KEY_UP,
@@ -68,6 +90,7 @@ enum PlatformKeyType {
     PLATFORM_KEY_F5,
     PLATFORM_KEY_F,
     PLATFORM_KEY_G,
+    PLATFORM_KEY_L,
 
     PLATFORM_KEY_ENTER,
     PLATFORM_KEY_ESCAPE,
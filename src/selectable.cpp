@@ -1,16 +1,29 @@
+//NOTE: A cursor on top of the buffer's own one, see the multiCursor_ functions in bufferInputController.cpp
+struct Selectable_Cursor {
+	s32 cursor; //NOTE: WL_Anchor, it's declared after this file
+	s32 select_start; //NOTE: The other end of what it's got selected, the same as the cursor if nothing's selected
+};
+
 //NOTE: This is what stores the selectable text
 struct Selectable_State {
-	//TODO: This should be size_t values 
-	s32 start_offset_in_bytes;
-	s32 end_offset_in_bytes;
+	s64 start_offset_in_bytes;
+	s64 end_offset_in_bytes;
 
 	bool is_active;
 
+	//NOTE: The extra cursors. The buffer's cursor & the selection above are always the main one
+	Selectable_Cursor *cursors;
+	s32 cursor_count;
+	s32 cursor_total;
+
+	//NOTE: Where the mouse went down for dragging a column of cursors
+	bool is_column_select;
+	s64 column_start_offset_in_bytes;
 };
 
 struct Selectable_Diff
 {
-	s32 start;
+	s64 start;
 	s64 size;
 };
 
@@ -6,10 +6,14 @@ static void init_single_search(Single_Search *search) {
 
 static void  refresh_buffer(Single_Search *search) {
     wl_emptyBuffer(&search->buffer);
+    initBuffer(&search->buffer);
 }
 
 static char *draw_single_search(Single_Search *search, Renderer *renderer, Font *font, float fontScale, float4 color, float xAt, float yAt, float4 cursorColor, char *extraWord) {
-    Compiled_Buffer_For_Drawing buffer_to_draw = compileBuffer_toDraw(&search->buffer, &globalPerFrameArena, &search->selectable_state);
+    WL_Buffer_View buffer_to_draw = wl_buffer_get_view(&search->buffer, &globalPerFrameArena, &search->selectable_state);
+
+    //NOTE: The search bar is tiny so just get it as one string
+    char *str = wl_buffer_view_copy_to_arena(&buffer_to_draw, 0, buffer_to_draw.size_in_bytes, &globalPerFrameArena);
 
     pushShader(renderer, &sdfFontShader);
     
@@ -18,7 +22,6 @@ static char *draw_single_search(Single_Search *search, Renderer *renderer, Font
         xAt += draw_text(renderer, font, extraWord, xAt, yAt, fontScale, color, 0).size.x;
     }
 
-    char *str = (char *)buffer_to_draw.memory;
     float2 cursor_pos = draw_text(renderer, font, str, xAt, yAt, fontScale, color, buffer_to_draw.cursor_at).cursorP;
 
     //NOTE: Draw the cursor now
@@ -32,6 +35,6 @@ static char *draw_single_search(Single_Search *search, Renderer *renderer, Font
     pushTexture(renderer, global_white_texture, make_float3(cursor_pos.x, cursor_pos.y + 0.25f*font->fontHeight*fontScale, 1.0f), scale, cursorColor, make_float4(0, 1, 0, 1));
 
     //NOTE: Return the query string
-    return (char *)buffer_to_draw.memory;
+    return str;
 
 }
\ No newline at end of file
@@ -14,4 +14,204 @@ static void thread_work_check_file_stamps(EditorState *editorState) {
         }
         
     }
-}
\ No newline at end of file
+}
+//NOTE: Finds the lines of the whole file on all the cores once it's all there, instead of the main thread doing it a chunk at a time 
+//      as it adds the text. From start to end in the file's memory, start is after the BOM. See update_file_load
+static void file_load_build_line_index(File_Load *load, s64 start, s64 end) {
+    load->line_index_start = start;
+    lineIndex_build(&load->line_index, load->memory + start, end - start);
+    load->line_index_built = true;
+}
+
+//NOTE: Reads a file a chunk at a time so the main thread can show it as it arrives. See update_file_load
+static THREAD_WORK_FUNCTION(thread_work_load_file) {
+    File_Load *load = (File_Load *)Data;
+
+    s64 bytes_read = 0;
+    while(bytes_read < load->file_size_in_bytes && !load->cancelled) {
+        s64 size_to_read = load->file_size_in_bytes - bytes_read;
+        if(size_to_read > FILE_LOAD_CHUNK_SIZE_IN_BYTES) {
+            size_to_read = FILE_LOAD_CHUNK_SIZE_IN_BYTES;
+        }
+
+        size_t size = platform_read_file_data(load->file, load->memory + bytes_read, size_to_read, bytes_read);
+
+        if(size == 0) {
+            //NOTE: Couldn't read anymore, the file might have got smaller since we opened it
+            break;
+        }
+
+        bytes_read += size;
+        load->bytes_read = bytes_read;
+    }
+
+    platform_close_file(load->file);
+
+    //NOTE: Only if it's utf8, otherwise the text in the buffer won't be the file's bytes. The bigger files go in a rope, which finds its own lines.
+    if(!load->cancelled && bytes_read > 0 && bytes_read < WL_BUFFER_ROPE_MIN_FILE_SIZE) {
+        s64 bom_size = 0;
+        bool is_utf8 = (encoding_detect(load->memory, bytes_read, &bom_size) == WL_TEXT_ENCODING_UTF8);
+        if(is_utf8 && bytes_read > bom_size && encoding_is_valid_utf8(load->memory + bom_size, bytes_read - bom_size)) {
+            file_load_build_line_index(load, bom_size, bytes_read);
+        }
+    }
+
+    load->finished = true;
+}
+
+//NOTE: Goes through a memory mapped file a chunk at a time checking it's utf8, which also gets its pages read in before the main thread 
+//      looks at them. The main thread adds what's been checked to the buffer straight out of the map, see update_file_load. 
+//      Once a chunk isn't utf8 the rest gets turned into utf8 as it's added, so we stop checking.
+static THREAD_WORK_FUNCTION(thread_work_check_file_map) {
+    File_Load *load = (File_Load *)Data;
+
+    s64 at = load->bytes_read;
+    bool is_valid = true;
+    while(at < load->file_size_in_bytes && is_valid && !load->cancelled) {
+        s64 end = load->file_size_in_bytes;
+        if(end - at > FILE_LOAD_CHUNK_SIZE_IN_BYTES) {
+            //NOTE: Don't split a codepoint between chunks
+            end = encoding_get_chunk_end(WL_TEXT_ENCODING_UTF8, load->memory, at, at + FILE_LOAD_CHUNK_SIZE_IN_BYTES);
+        }
+
+        is_valid = encoding_is_valid_utf8(load->memory + at, end - at);
+        if(is_valid) {
+            load->valid_utf8_size = end;
+            at = end;
+            load->bytes_read = at;
+        }
+    }
+
+    //NOTE: It's all utf8 so the buffer's going to be the file's text as it is
+    if(!load->cancelled && load->valid_utf8_size == load->file_size_in_bytes && load->file_size_in_bytes > load->bom_size_in_bytes) {
+        file_load_build_line_index(load, load->bom_size_in_bytes, load->file_size_in_bytes);
+    }
+
+    //NOTE: The rest is all there to be read, it's the file
+    load->bytes_read = load->file_size_in_bytes;
+
+    load->finished = true;
+}
+
+//NOTE: Writes the snapshot straight out of the buffer's memory to the temp file. See begin_file_save
+static THREAD_WORK_FUNCTION(thread_work_save_file) {
+    File_Save *save = (File_Save *)Data;
+    WL_Buffer_Snapshot *snapshot = save->snapshot;
+
+    bool written = true;
+    s64 offset = 0;
+    u8 *span = 0;
+    s64 span_size = 0;
+    WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+    while(written && (span = wl_buffer_snapshot_next_span(&it, &span_size))) {
+        written = platform_write_file_data(save->file, span, span_size, offset);
+        offset += span_size;
+    }
+    assert(!written || offset == snapshot->size_in_bytes);
+
+    //NOTE: Make sure it's all on the disk before it replaces the real file
+    if(written) {
+        written = platform_flush_file(save->file);
+    }
+    platform_close_file(save->file);
+
+    //NOTE: The main thread won't replace the real file with half of it, see update_file_save
+    save->write_failed = !written;
+
+    //NOTE: The main thread still holds its own reference, see update_file_save
+    wl_buffer_release_snapshot(snapshot);
+
+    save->finished = true;
+}
+
+//NOTE: Works out prettify's edits from the snapshot, see update_prettify
+static THREAD_WORK_FUNCTION(thread_work_prettify) {
+    Prettify_Job *job = (Prettify_Job *)Data;
+
+    job->tabs = wl_buffer_prettify_snapshot(job->snapshot, &job->transaction);
+
+    job->finished = true;
+}
+
+//NOTE: Writes the records the main thread has handed over to the journal file, see undoJournal_update
+static THREAD_WORK_FUNCTION(thread_work_write_undo_journal) {
+    WL_Undo_Journal *journal = (WL_Undo_Journal *)Data;
+
+    //NOTE: undoJournal_update opens the file on the main thread, opening it here would race on the per frame arena
+    if(!journal->file.has_errors) {
+        platform_write_file_data(journal->file, journal->writing.memory, journal->writing.size_in_bytes, journal->size_on_disk);
+
+        //NOTE: Make sure it's on the disk, it's no good for getting back from a crash otherwise
+        platform_flush_file(journal->file);
+        journal->size_on_disk += journal->writing.size_in_bytes;
+    }
+
+    journal->is_writing = false;
+}
+
+//NOTE: Compresses an undo chunk into the memory the main thread gave it, see undoRedo_update. Keeps it as it is if it doesn't get smaller.
+static THREAD_WORK_FUNCTION(thread_work_compress_undo_chunk) {
+    UndoRedoChunk *chunk = (UndoRedoChunk *)Data;
+
+    s64 compressed_size = lz_compress(chunk->memory, chunk->used_in_bytes, chunk->compressing_into, lz_get_max_compressed_size(chunk->used_in_bytes));
+    if(compressed_size < 0 || compressed_size >= chunk->used_in_bytes) {
+        memcpy(chunk->compressing_into, chunk->memory, chunk->used_in_bytes);
+        compressed_size = chunk->used_in_bytes;
+    }
+
+    chunk->compressed_size_in_bytes = compressed_size;
+
+    chunk->is_compressing = false;
+}
+
+//NOTE: Compresses an undo checkpoint's snapshot a piece at a time into the memory the main thread gave it, see wl_buffer_add_undo_checkpoint. 
+//      Each piece gets copied out of the spans into the end of that memory first, the spans aren't one block of text.
+static THREAD_WORK_FUNCTION(thread_work_compress_undo_checkpoint) {
+    UndoRedoCheckpoint *checkpoint = (UndoRedoCheckpoint *)Data;
+    s64 size = checkpoint->size_in_bytes;
+
+    u8 *out = checkpoint->compressing_into;
+    u8 *piece = checkpoint->compressing_into + undoRedo_get_max_checkpoint_size(size);
+
+    u8 *span = 0;
+    s64 span_size = 0;
+    s64 span_at = 0;
+    WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(checkpoint->snapshot, 0);
+
+    for(s64 offset = 0; offset < size; ) {
+        s64 piece_size = size - offset;
+        if(piece_size > UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES) { piece_size = UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES; }
+
+        for(s64 filled = 0; filled < piece_size; ) {
+            if(span_at == span_size) {
+                span = wl_buffer_snapshot_next_span(&it, &span_size);
+                span_at = 0;
+                assert(span);
+            }
+
+            s64 bytes = span_size - span_at;
+            if(bytes > piece_size - filled) { bytes = piece_size - filled; }
+
+            memcpy(piece + filled, span + span_at, bytes);
+            filled += bytes;
+            span_at += bytes;
+        }
+
+        u8 *compressed = out + sizeof(u32);
+        s64 compressed_size = lz_compress(piece, piece_size, compressed, lz_get_max_compressed_size(piece_size));
+        if(compressed_size < 0 || compressed_size >= piece_size) {
+            memcpy(compressed, piece, piece_size);
+            compressed_size = piece_size;
+        }
+
+        u32 compressed_size_u32 = (u32)compressed_size;
+        memcpy(out, &compressed_size_u32, sizeof(u32));
+
+        out = compressed + compressed_size;
+        offset += piece_size;
+    }
+
+    checkpoint->compressed_size_in_bytes = out - checkpoint->compressing_into;
+
+    checkpoint->is_compressing = false;
+}
@@ -3,82 +3,748 @@ enum UndoRedo_BlockType {
     UNDO_REDO_DELETE
 };
 
+/*
+The history is a tree, not a list. Every block is an edit done to the text its parent left, so undoing then making a new
+edit starts another branch off the parent instead of throwing the redo blocks away. current is the block whose text
+we're at, -1 for the text before any of them. Undo moves to the parent, redo moves to the child it came from last 
+(redo_child), undoRedo_next_redo_branch picks another one.
+
+The blocks are never dropped, so they're kept in the order they were made in the history array & their text lives in
+chunks we only ever append to. So the history doesn't use up all the memory, once there's more than memory_budget_in_bytes 
+of text the oldest chunks nobody's used for a bit get compressed on another thread & their memory is let go (see 
+undoRedo_update). Past compressed_budget_in_bytes the oldest compressed ones get written out to a temp file. When undo
+or redo gets to a block in one of them, it gets decompressed again (see undoRedo_load_block).
+
+Every block also has a jump pointer to one of its ancestors (skew binary, see undoRedo_set_jump), so finding an ancestor
+at any depth or where two revisions branched off is O(log n). Every UNDO_REDO_CHECKPOINT_INTERVAL deep there's a 
+compressed copy of the text as well, so wl_buffer_jump_to_revision doesn't have to go through thousands of blocks one at a time.
+*/
+#define UNDO_REDO_CHUNK_SIZE_IN_BYTES Kilobytes(64)
+
+//NOTE: How deep in the tree the checkpoints are apart, and how much text they can hold onto between them all
+#define UNDO_REDO_CHECKPOINT_INTERVAL 256
+#define UNDO_REDO_CHECKPOINT_BUDGET_IN_BYTES Megabytes(64)
+
+//NOTE: Checkpoints get compressed in pieces this big, so restoring one doesn't need all the text in one go
+#define UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES (Kilobytes(64))
+
+//NOTE: The default budgets, they can be changed on each UndoRedoState
+#define UNDO_REDO_MEMORY_BUDGET_IN_BYTES Megabytes(32)
+#define UNDO_REDO_COMPRESSED_BUDGET_IN_BYTES Megabytes(32)
+
+//NOTE: Chunks that have been used in the last few seconds don't get compressed, so undoing through old history doesn't keep decompressing it
+#define UNDO_REDO_COLD_SECONDS 10.0f
+
+//NOTE: Typing that pauses for longer than this starts a new undo block
+#define UNDO_REDO_COALESCE_SECONDS 1.0f
+
+//NOTE: Moved on every frame by undoRedo_advance_time
+static float global_undo_redo_time_in_seconds = 0.0f;
+
+struct WL_Undo_Journal;
+struct WL_Buffer_Snapshot;
+
+struct UndoRedoChunk {
+    s64 size_in_bytes;
+    s64 used_in_bytes;
+
+    u8 *memory; //NOTE: Null once it's been compressed & let go of, see undoRedo_load_chunk
+
+    //NOTE: The compressed text, either in memory or in the spill file. It's the same as the text if it didn't get any smaller.
+    u8 *compressed;
+    s64 compressed_size_in_bytes;
+    s64 spill_offset; //NOTE: -1 if it isn't in the spill file
+
+    s32 first_block; //NOTE: The blocks with their text in here all come one after the other from this one
+    float last_used_in_seconds;
+
+    //NOTE: Another thread is compressing it into compressing_into, the main thread only reads the chunk till it's finished
+    volatile bool is_compressing;
+    u8 *compressing_into;
+
+    UndoRedoChunk *next;
+};
+
+//NOTE: The text at a block, see wl_buffer_add_undo_checkpoint. The snapshot is held till another thread has compressed it, 
+//      then it's let go of & only the compressed text is kept, see wl_buffer_update_undo_checkpoints
+struct UndoRedoCheckpoint {
+    s64 size_in_bytes;
+    s64 stringLength; //NOTE: How long the block was when it was taken, typing can carry on onto it after
+
+    WL_Buffer_Snapshot *snapshot;
+
+    //NOTE: Another thread is compressing the snapshot into compressing_into, the main thread leaves it alone till it's finished
+    volatile bool is_compressing;
+    u8 *compressing_into;
+
+    //NOTE: The text in UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES pieces, each one is a u32 size then the LZ compressed bytes. 
+    //      A piece that didn't get any smaller is kept as it is.
+    u8 *compressed;
+    s64 compressed_size_in_bytes;
+
+    UndoRedoCheckpoint *next_compressing;
+};
+
 struct UndoRedoBlock {
     UndoRedo_BlockType type;
 
-    size_t byteAt;
-    char *string;
-    int stringLength;
+    s64 byteAt;
+    char *string; //NOTE: Null terminated, points into one of the chunks. Null while the chunk's compressed, see undoRedo_load_block
+    s64 stringLength;
+    s64 stringOffset; //NOTE: Where the string is in the chunk
 
     u32 id; //id auto increment for every block
     s32 groupId; //NOTE: If undo redo operations should be batched together 
 
-    size_t cursorAt; //NOTE: Save the cursor position
+    s64 cursorAt; //NOTE: Save the cursor position
+
+    UndoRedoChunk *chunk; //NOTE: The chunk the string is in
+
+    //NOTE: Where it is in the tree, indexes into the history. -1 is the text before any blocks
+    s32 parent;
+    s32 first_child;
+    s32 next_sibling;
+    s32 redo_child; //NOTE: The child redo goes to, the one we came back from last
+    s32 depth; //NOTE: 1 for the blocks done to the original text
+    s32 jump; //NOTE: An ancestor further up, see undoRedo_set_jump
+
+    float time_in_seconds; //NOTE: When it was last changed, goes up with the index
 
+    //NOTE: The text after this block was done. Only every UNDO_REDO_CHECKPOINT_INTERVAL deep, see wl_buffer_add_undo_checkpoint
+    UndoRedoCheckpoint *checkpoint;
 };
 
 struct UndoRedoState {
-    int at_in_history; //NOTE where we are in the history array - index
+    s32 current; //NOTE: The block whose text we're at, -1 for the text before any blocks
     int block_count;
     int total_block_count;
     UndoRedoBlock *history;
 
+    UndoRedoChunk *first_chunk;
+    UndoRedoChunk *current_chunk; //NOTE: The chunk we're writing to, every chunk after it is empty
+
+    //NOTE: The blocks done to the original text, since it doesn't have a block of its own
+    s32 root_first_child;
+    s32 root_redo_child;
+
+    //NOTE: How much text the checkpoints are holding, and the oldest block that might have one
+    s64 checkpoint_bytes;
+    s32 oldest_checkpoint;
+    UndoRedoCheckpoint *compressing_checkpoints; //NOTE: The ones still holding their snapshot
+
     u32 idAt; //id to give to blocks, increments each block, must start at 1 not 0
 
+    u32 coalesce_block_id; //NOTE: The typed block that more typing can join onto, 0 for none
+    float coalesce_time_in_seconds; //NOTE: When it was last added to
+
     s32 groupIdAt; //id to give to blocks if they are grouped, increments each block so can start at 0
     //NOTE: -1 for no group
+
+    WL_Undo_Journal *journal; //NOTE: Not null if the history gets written out to a journal file
+
+    //NOTE: How much text can be kept as it is, and compressed, before the oldest gets compressed or spilled. See undoRedo_update
+    s64 memory_budget_in_bytes;
+    s64 compressed_budget_in_bytes;
+    bool can_spill_to_file;
+
+    s64 uncompressed_bytes; //NOTE: The chunks' memory that's there
+    s64 compressed_bytes; //NOTE: The compressed text that's in memory
+    s64 cold_bytes; //NOTE: How much text the chunks that are only compressed would be
+    s64 compressing_bytes; //NOTE: How much the other threads are compressing now
+
+    char *spill_path_utf8;
+    Platform_File_Handle spill_file;
+    s64 spill_size_in_bytes;
 };
 
+//NOTE: Writes the history out as it changes so it survives a crash, see wl_undo_journal.cpp
+static void undoJournal_log_push(WL_Undo_Journal *journal, UndoRedoBlock *block);
+static void undoJournal_log_extend(WL_Undo_Journal *journal, s64 byteAt, char *string, s64 stringLength);
+static void undoJournal_log_move(WL_Undo_Journal *journal, bool is_redo, s32 redo_child);
+static void undoJournal_log_jump(WL_Undo_Journal *journal, s32 target);
+
+static THREAD_WORK_FUNCTION(thread_work_compress_undo_chunk);
+static THREAD_WORK_FUNCTION(thread_work_compress_undo_checkpoint);
+
+//NOTE: The most a checkpoint's compressed pieces can take up, see thread_work_compress_undo_checkpoint
+static inline s64 undoRedo_get_max_checkpoint_size(s64 size_in_bytes) {
+    s64 piece_count = (size_in_bytes + UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES - 1) / UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES;
+    return piece_count*(sizeof(u32) + lz_get_max_compressed_size(UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES));
+}
+
+//NOTE: What it counts against UNDO_REDO_CHECKPOINT_BUDGET_IN_BYTES, all of the text till it's been compressed
+static inline s64 undoRedo_get_checkpoint_bytes(UndoRedoCheckpoint *checkpoint) {
+    return (checkpoint->compressed) ? checkpoint->compressed_size_in_bytes : checkpoint->size_in_bytes;
+}
+
+static inline u8 *undoRedo_get_chunk_memory(UndoRedoChunk *chunk) {
+    assert(chunk->memory);
+    return chunk->memory;
+}
+
 static void init_undo_redo_state(UndoRedoState *state) {
     state->idAt = 0;
     state->groupIdAt = 0;
-    state->at_in_history = 0;
+    state->current = -1;
     state->block_count = 0;
     state->total_block_count = 64;
     state->history = (UndoRedoBlock *)easyPlatform_allocateMemory(state->total_block_count*sizeof(UndoRedoBlock), EASY_PLATFORM_MEMORY_ZERO);
+    state->first_chunk = 0;
+    state->current_chunk = 0;
+    state->root_first_child = -1;
+    state->root_redo_child = -1;
+    state->checkpoint_bytes = 0;
+    state->oldest_checkpoint = 0;
+    state->compressing_checkpoints = 0;
+    state->coalesce_block_id = 0;
+    state->coalesce_time_in_seconds = 0;
+    state->journal = 0;
+    state->memory_budget_in_bytes = UNDO_REDO_MEMORY_BUDGET_IN_BYTES;
+    state->compressed_budget_in_bytes = UNDO_REDO_COMPRESSED_BUDGET_IN_BYTES;
+    state->can_spill_to_file = true;
+    state->uncompressed_bytes = 0;
+    state->compressed_bytes = 0;
+    state->cold_bytes = 0;
+    state->compressing_bytes = 0;
+    state->spill_path_utf8 = 0;
+    state->spill_file = {};
+    state->spill_size_in_bytes = 0;
 }
 
-static void push_block(UndoRedoState *state, UndoRedo_BlockType type, size_t byteAt, char *string, int stringLength, size_t cursorAt, s32 groupId = -1) {
-    
-    //NOTE: Free strings if the blocks ahead are getting deleted 
-    for(int i = state->at_in_history; i < state->block_count; ++i) {
-        UndoRedoBlock *block = &state->history[i];
-        easyPlatform_freeMemory(block->string);
+static void undoRedo_advance_time(float dt) {
+    global_undo_redo_time_in_seconds += dt;
+}
+
+//NOTE: The next typed text starts its own block, i.e. when the buffer gets saved so the save id still matches the text
+static void undoRedo_stop_coalescing(UndoRedoState *state) {
+    state->coalesce_block_id = 0;
+}
+
+static void free_undo_redo_state(UndoRedoState *state) {
+    UndoRedoChunk *chunk = state->first_chunk;
+    while(chunk) {
+        //NOTE: Compressing a chunk doesn't take long, wait for it to finish so the thread isn't reading freed memory. 
+        //      It might not have started yet, so help with the queue till it's done
+        while(chunk->is_compressing) {
+            platform_help_with_queued_work();
+        }
+
+        UndoRedoChunk *next = chunk->next;
+        if(chunk->memory) { easyPlatform_freeMemory(chunk->memory); }
+        if(chunk->compressed) { easyPlatform_freeMemory(chunk->compressed); }
+        if(chunk->compressing_into) { easyPlatform_freeMemory(chunk->compressing_into); }
+        easyPlatform_freeMemory(chunk);
+        chunk = next;
     }
 
-    state->block_count = state->at_in_history;
+    if(state->history) {
+        easyPlatform_freeMemory(state->history);
+    }
+
+    if(state->spill_path_utf8) {
+        if(!state->spill_file.has_errors) {
+            platform_close_file(state->spill_file);
+        }
+        platform_delete_file_utf8(state->spill_path_utf8);
+        platform_free_memory(state->spill_path_utf8);
+    }
 
-    //NOTE: If the block history is full, realloc memory
+    memset(state, 0, sizeof(UndoRedoState));
+}
+
+static UndoRedoChunk *undoRedo_allocate_chunk(UndoRedoState *state, s64 size_in_bytes) {
+    UndoRedoChunk *chunk = (UndoRedoChunk *)easyPlatform_allocateMemory(sizeof(UndoRedoChunk), EASY_PLATFORM_MEMORY_ZERO);
+    chunk->memory = (u8 *)easyPlatform_allocateMemory(size_in_bytes, EASY_PLATFORM_MEMORY_NONE);
+    chunk->size_in_bytes = size_in_bytes;
+    chunk->spill_offset = -1;
+    chunk->first_block = -1;
+    chunk->last_used_in_seconds = global_undo_redo_time_in_seconds;
+
+    state->uncompressed_bytes += size_in_bytes;
+    return chunk;
+}
+
+//NOTE: Returns room for size_in_bytes in the chunks for the block at block_index. Starts a new chunk if it doesn't fit in the current one.
+static char *undoRedo_push_string_memory(UndoRedoState *state, s64 size_in_bytes, s32 block_index, UndoRedoChunk **chunk_result) {
+    UndoRedoChunk *chunk = state->current_chunk;
+
+    if(!chunk || (chunk->used_in_bytes + size_in_bytes) > chunk->size_in_bytes) {
+        s64 chunk_size = UNDO_REDO_CHUNK_SIZE_IN_BYTES;
+        if(chunk_size < size_in_bytes) { chunk_size = size_in_bytes; }
+
+        UndoRedoChunk *new_chunk = undoRedo_allocate_chunk(state, chunk_size);
+        if(chunk) {
+            chunk->next = new_chunk;
+        } else {
+            state->first_chunk = new_chunk;
+        }
+
+        chunk = new_chunk;
+        state->current_chunk = chunk;
+    }
+
+    if(chunk->first_block < 0) {
+        chunk->first_block = block_index;
+    }
+
+    char *result = (char *)(undoRedo_get_chunk_memory(chunk) + chunk->used_in_bytes);
+    chunk->used_in_bytes += size_in_bytes;
+    *chunk_result = chunk;
+
+    return result;
+}
+
+//NOTE: Gets the chunk's text out of the compressed text in memory, or the spill file
+static void undoRedo_decompress_chunk(UndoRedoState *state, UndoRedoChunk *chunk, u8 *dest) {
+    u8 *compressed = chunk->compressed;
+    if(!compressed) {
+        assert(chunk->spill_offset >= 0);
+        compressed = (u8 *)easyPlatform_allocateMemory(chunk->compressed_size_in_bytes, EASY_PLATFORM_MEMORY_NONE);
+        size_t bytes_read = platform_read_file_data(state->spill_file, compressed, chunk->compressed_size_in_bytes, chunk->spill_offset);
+        assert(bytes_read == chunk->compressed_size_in_bytes);
+    }
+
+    if(chunk->compressed_size_in_bytes == chunk->used_in_bytes) {
+        //NOTE: Didn't get any smaller so it's kept as it is
+        memcpy(dest, compressed, chunk->used_in_bytes);
+    } else {
+        bool decompressed = lz_decompress(compressed, chunk->compressed_size_in_bytes, dest, chunk->used_in_bytes);
+        assert(decompressed);
+    }
+
+    if(compressed != chunk->compressed) {
+        easyPlatform_freeMemory(compressed);
+    }
+}
+
+//NOTE: Puts a compressed chunk's text back in memory & points its blocks at it again
+static void undoRedo_load_chunk(UndoRedoState *state, UndoRedoChunk *chunk) {
+    chunk->last_used_in_seconds = global_undo_redo_time_in_seconds;
+
+    if(!chunk->memory) {
+        chunk->memory = (u8 *)easyPlatform_allocateMemory(chunk->size_in_bytes, EASY_PLATFORM_MEMORY_NONE);
+        undoRedo_decompress_chunk(state, chunk, chunk->memory);
+
+        state->uncompressed_bytes += chunk->size_in_bytes;
+        state->cold_bytes -= chunk->size_in_bytes;
+
+        for(int i = chunk->first_block; i >= 0 && i < state->block_count && state->history[i].chunk == chunk; ++i) {
+            state->history[i].string = (char *)chunk->memory + state->history[i].stringOffset;
+        }
+    }
+}
+
+//NOTE: Makes sure the block's string is there before it gets used
+static inline UndoRedoBlock *undoRedo_load_block(UndoRedoState *state, UndoRedoBlock *block) {
+    if(block && block->chunk) {
+        undoRedo_load_chunk(state, block->chunk);
+    }
+    return block;
+}
+
+//NOTE: For going through all the blocks' text without the chunks taking up memory again, it keeps the last chunk it decompressed
+struct UndoRedo_Chunk_Reader {
+    UndoRedoChunk *chunk;
+    u8 *memory;
+    s64 total_size_in_bytes;
+};
+
+static char *undoRedo_read_block_string(UndoRedoState *state, UndoRedoBlock *block, UndoRedo_Chunk_Reader *reader) {
+    UndoRedoChunk *chunk = block->chunk;
+    if(chunk->memory) {
+        return block->string;
+    }
+
+    if(reader->chunk != chunk) {
+        if(reader->total_size_in_bytes < chunk->used_in_bytes) {
+            if(reader->memory) { easyPlatform_freeMemory(reader->memory); }
+            reader->memory = (u8 *)easyPlatform_allocateMemory(chunk->used_in_bytes, EASY_PLATFORM_MEMORY_NONE);
+            reader->total_size_in_bytes = chunk->used_in_bytes;
+        }
+
+        undoRedo_decompress_chunk(state, chunk, reader->memory);
+        reader->chunk = chunk;
+    }
+
+    return (char *)reader->memory + block->stringOffset;
+}
+
+static void undoRedo_end_reading(UndoRedo_Chunk_Reader *reader) {
+    if(reader->memory) {
+        easyPlatform_freeMemory(reader->memory);
+    }
+    memset(reader, 0, sizeof(UndoRedo_Chunk_Reader));
+}
+
+//NOTE: Writes the compressed text out to the end of the spill file & lets go of it. False if we can't make the file.
+static bool undoRedo_spill_chunk(UndoRedoState *state, UndoRedoChunk *chunk) {
+    if(!state->spill_path_utf8) {
+        state->spill_path_utf8 = platform_make_temp_file_utf8();
+        state->spill_file = (state->spill_path_utf8) ? platform_begin_file_write_utf8_file_path(state->spill_path_utf8) : Platform_File_Handle{};
+        if(!state->spill_path_utf8) {
+            state->spill_file.has_errors = true;
+        }
+    }
+
+    bool result = false;
+    if(!state->spill_file.has_errors) {
+        platform_write_file_data(state->spill_file, chunk->compressed, chunk->compressed_size_in_bytes, state->spill_size_in_bytes);
+
+        chunk->spill_offset = state->spill_size_in_bytes;
+        state->spill_size_in_bytes += chunk->compressed_size_in_bytes;
+
+        state->compressed_bytes -= chunk->compressed_size_in_bytes;
+        easyPlatform_freeMemory(chunk->compressed);
+        chunk->compressed = 0;
+        result = true;
+    }
+    return result;
+}
+
+//NOTE: Called every frame. Keeps the text under the budgets, oldest chunks first, but never the one we're writing to or ones used in the 
+//      last UNDO_REDO_COLD_SECONDS. Over memory_budget_in_bytes they get compressed on another thread, then their memory's let go of once it's
+//      finished. Over compressed_budget_in_bytes the compressed text goes to the spill file.
+static void undoRedo_update(UndoRedoState *state) {
+    for(UndoRedoChunk *chunk = state->first_chunk; chunk; chunk = chunk->next) {
+        bool over_memory_budget = (state->uncompressed_bytes - state->compressing_bytes) > state->memory_budget_in_bytes;
+        bool over_compressed_budget = state->can_spill_to_file && state->compressed_bytes > state->compressed_budget_in_bytes;
+
+        if(!over_memory_budget && !over_compressed_budget && state->compressing_bytes == 0) {
+            break;
+        }
+
+        bool is_cold = (chunk != state->current_chunk) && (global_undo_redo_time_in_seconds - chunk->last_used_in_seconds) >= UNDO_REDO_COLD_SECONDS;
+
+        if(over_memory_budget && is_cold && chunk->memory && !chunk->compressed && chunk->spill_offset < 0 && !chunk->compressing_into) {
+            //NOTE: The main thread gives the thread the memory to compress into, so the thread doesn't allocate anything
+            chunk->compressing_into = (u8 *)easyPlatform_allocateMemory(lz_get_max_compressed_size(chunk->used_in_bytes), EASY_PLATFORM_MEMORY_NONE);
+            chunk->is_compressing = true;
+            state->compressing_bytes += chunk->size_in_bytes;
+
+            if(global_platform.push_work_onto_queue) {
+                global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_compress_undo_chunk, chunk);
+            } else {
+                thread_work_compress_undo_chunk(chunk);
+            }
+        }
+
+        if(chunk->compressing_into && !chunk->is_compressing) {
+            //NOTE: It's finished, keep a copy that's only as big as it needs to be
+            chunk->compressed = (u8 *)easyPlatform_allocateMemory(chunk->compressed_size_in_bytes, EASY_PLATFORM_MEMORY_NONE);
+            memcpy(chunk->compressed, chunk->compressing_into, chunk->compressed_size_in_bytes);
+            easyPlatform_freeMemory(chunk->compressing_into);
+            chunk->compressing_into = 0;
+
+            state->compressing_bytes -= chunk->size_in_bytes;
+            state->compressed_bytes += chunk->compressed_size_in_bytes;
+            over_memory_budget = (state->uncompressed_bytes - state->compressing_bytes) > state->memory_budget_in_bytes;
+        }
+
+        if(over_memory_budget && is_cold && chunk->memory && !chunk->compressing_into && (chunk->compressed || chunk->spill_offset >= 0)) {
+            //NOTE: Let go of the text, undoRedo_load_chunk gets it back
+            for(int i = chunk->first_block; i >= 0 && i < state->block_count && state->history[i].chunk == chunk; ++i) {
+                state->history[i].string = 0;
+            }
+
+            easyPlatform_freeMemory(chunk->memory);
+            chunk->memory = 0;
+            state->uncompressed_bytes -= chunk->size_in_bytes;
+            state->cold_bytes += chunk->size_in_bytes;
+        }
+
+        over_compressed_budget = state->can_spill_to_file && state->compressed_bytes > state->compressed_budget_in_bytes;
+        if(over_compressed_budget && chunk->compressed && chunk->spill_offset < 0) {
+            state->can_spill_to_file = undoRedo_spill_chunk(state, chunk);
+        }
+    }
+
+#if DEBUG_BUILD
+    global_debug_stats.undo_bytes_uncompressed += state->uncompressed_bytes;
+    global_debug_stats.undo_bytes_compressed_from += state->cold_bytes;
+    global_debug_stats.undo_bytes_compressed += state->compressed_bytes;
+    global_debug_stats.undo_bytes_spilled += state->spill_size_in_bytes;
+#endif
+}
+
+//NOTE: The root (-1) doesn't have a block, so these look after it
+static inline s32 *undoRedo_get_redo_child(UndoRedoState *state, s32 index) {
+    return (index < 0) ? &state->root_redo_child : &state->history[index].redo_child;
+}
+
+static inline s32 *undoRedo_get_first_child(UndoRedoState *state, s32 index) {
+    return (index < 0) ? &state->root_first_child : &state->history[index].first_child;
+}
+
+static inline s32 undoRedo_get_depth(UndoRedoState *state, s32 index) {
+    return (index < 0) ? 0 : state->history[index].depth;
+}
+
+static inline s32 undoRedo_get_parent(UndoRedoState *state, s32 index) {
+    return (index < 0) ? -1 : state->history[index].parent;
+}
+
+static inline s32 undoRedo_get_jump(UndoRedoState *state, s32 index) {
+    return (index < 0) ? -1 : state->history[index].jump;
+}
+
+//NOTE: The id of the block we're at, 0 for the original text. What the buffer's save id gets checked against
+static inline u32 undoRedo_get_current_id(UndoRedoState *state) {
+    return (state->current < 0) ? 0 : state->history[state->current].id;
+}
+
+//NOTE: Skew binary jump pointers. If the parent's jump & its jump's jump are the same distance apart, skip over both,
+//      otherwise jump to the parent. The jumps only depend on the depth, and any ancestor is O(log n) jumps away.
+static void undoRedo_set_jump(UndoRedoState *state, UndoRedoBlock *block) {
+    s32 parent = block->parent;
+    s32 parent_jump = undoRedo_get_jump(state, parent);
+
+    block->jump = parent;
+    if(parent >= 0) {
+        s32 parent_jump_jump = undoRedo_get_jump(state, parent_jump);
+        s32 parent_depth = undoRedo_get_depth(state, parent);
+        s32 parent_jump_depth = undoRedo_get_depth(state, parent_jump);
+
+        if(parent_depth - parent_jump_depth == parent_jump_depth - undoRedo_get_depth(state, parent_jump_jump)) {
+            block->jump = parent_jump_jump;
+        }
+    }
+}
+
+//NOTE: The ancestor of the block at the depth, O(log n)
+static s32 undoRedo_get_ancestor_at_depth(UndoRedoState *state, s32 index, s32 depth) {
+    assert(depth >= 0 && depth <= undoRedo_get_depth(state, index));
+
+    while(undoRedo_get_depth(state, index) > depth) {
+        s32 jump = undoRedo_get_jump(state, index);
+        if(undoRedo_get_depth(state, jump) >= depth) {
+            index = jump;
+        } else {
+            index = undoRedo_get_parent(state, index);
+        }
+    }
+    return index;
+}
+
+//NOTE: Where the two revisions branched off from each other, O(log n)
+static s32 undoRedo_get_common_ancestor(UndoRedoState *state, s32 a, s32 b) {
+    s32 depth_a = undoRedo_get_depth(state, a);
+    s32 depth_b = undoRedo_get_depth(state, b);
+    if(depth_a > depth_b) {
+        a = undoRedo_get_ancestor_at_depth(state, a, depth_b);
+    } else {
+        b = undoRedo_get_ancestor_at_depth(state, b, depth_a);
+    }
+
+    //NOTE: Both at the same depth have their jumps at the same depths, so we can jump both while it doesn't skip past where they meet
+    while(a != b) {
+        s32 jump_a = undoRedo_get_jump(state, a);
+        s32 jump_b = undoRedo_get_jump(state, b);
+        if(jump_a != jump_b) {
+            a = jump_a;
+            b = jump_b;
+        } else {
+            a = undoRedo_get_parent(state, a);
+            b = undoRedo_get_parent(state, b);
+        }
+    }
+    return a;
+}
+
+//NOTE: The last block made at or before the time, -1 if there weren't any yet. The blocks are in the order they were made, so it's a binary search
+static s32 undoRedo_find_revision_at_time(UndoRedoState *state, float time_in_seconds) {
+    s32 result = -1;
+
+    s32 low = 0;
+    s32 high = state->block_count;
+    while(low < high) {
+        s32 middle = low + (high - low) / 2;
+        if(state->history[middle].time_in_seconds <= time_in_seconds) {
+            result = middle;
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return result;
+}
+
+//NOTE: Pushes a block and returns the memory for its text so the caller can copy straight into it. 
+//      The null terminator is already set.
+static char *push_block_reserve(UndoRedoState *state, UndoRedo_BlockType type, s64 byteAt, s64 stringLength, s64 cursorAt, s32 groupId = -1) {
+    
+    state->coalesce_block_id = 0;
+
+    //NOTE: If the block history is full, grow it geometrically so it isn't a full copy every few blocks
     if(state->block_count >= state->total_block_count) {
-        state->total_block_count += 32;
-        state->history =(UndoRedoBlock *)easyPlatform_reallocMemory(state->history, state->block_count*sizeof(UndoRedoBlock), state->total_block_count*sizeof(UndoRedoBlock));
+        int new_total = 2*state->total_block_count;
+        state->history = (UndoRedoBlock *)easyPlatform_reallocMemory(state->history, state->block_count*sizeof(UndoRedoBlock), new_total*sizeof(UndoRedoBlock));
+        state->total_block_count = new_total;
     }
 
     UndoRedoBlock block = {};
     block.type = type;
     block.byteAt = byteAt;
-    block.string = string;
+    block.string = undoRedo_push_string_memory(state, stringLength + 1, state->block_count, &block.chunk);
+    block.stringOffset = (u8 *)block.string - block.chunk->memory;
+    block.string[stringLength] = '\0';
     block.stringLength = stringLength;
     block.id = ++state->idAt; //NOTE: Increment before so it starts at 1
     block.groupId = groupId;
     block.cursorAt = cursorAt;
+    block.time_in_seconds = global_undo_redo_time_in_seconds;
+
+    //NOTE: Goes onto the block we're at, as the child redo will go to
+    s32 index = state->block_count;
+    block.parent = state->current;
+    block.depth = undoRedo_get_depth(state, block.parent) + 1;
+    block.first_child = -1;
+    block.redo_child = -1;
+    undoRedo_set_jump(state, &block);
+
+    s32 *first_child = undoRedo_get_first_child(state, block.parent);
+    block.next_sibling = *first_child;
+    *first_child = index;
+    *undoRedo_get_redo_child(state, block.parent) = index;
 
     state->history[state->block_count++] = block;
-    state->at_in_history = state->block_count;
+    state->current = index;
+
+    return block.string;
 }
 
-static UndoRedoBlock *get_undo_block(UndoRedoState *state) {
+//NOTE: Call once the text of a push_block_reserve block has been written
+static void push_block_finish(UndoRedoState *state) {
+    if(state->journal) {
+        undoJournal_log_push(state->journal, &state->history[state->current]);
+    }
+}
+
+static void push_block(UndoRedoState *state, UndoRedo_BlockType type, s64 byteAt, char *string, s64 stringLength, s64 cursorAt, s32 groupId = -1) {
+    char *dest = push_block_reserve(state, type, byteAt, stringLength, cursorAt, groupId);
+    memcpy(dest, string, stringLength);
+    push_block_finish(state);
+}
+
+static inline bool undoRedo_is_space(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+//NOTE: Going from a space to the start of a word starts a new block, so undo takes back a word at a time
+static inline bool undoRedo_is_word_break(char before, char after) {
+    return undoRedo_is_space(before) && !undoRedo_is_space(after);
+}
+
+//NOTE: Adds text onto the last block. Inserts go on the end, deletes go on the front since they got backspaced.
+//      Grows in place if its text is the last thing in its chunk, otherwise it gets copied to the end of the chunks.
+static void undoRedo_extend_last_block(UndoRedoState *state, s64 byteAt, char *string, s64 stringLength) {
+    assert(state->block_count > 0 && state->current == state->block_count - 1);
+    UndoRedoBlock *block = &state->history[state->block_count - 1];
+    UndoRedoChunk *chunk = block->chunk;
+
+    bool is_last_in_chunk = ((u8 *)block->string + block->stringLength + 1) == (undoRedo_get_chunk_memory(chunk) + chunk->used_in_bytes);
+    bool has_room = (chunk->used_in_bytes + stringLength) <= chunk->size_in_bytes;
+
+    if(is_last_in_chunk && has_room) {
+        chunk->used_in_bytes += stringLength;
+    } else {
+        //NOTE: The old text gets left where it is
+        char *new_string = undoRedo_push_string_memory(state, block->stringLength + stringLength + 1, state->current, &block->chunk);
+        memcpy(new_string, block->string, block->stringLength);
+        block->string = new_string;
+        block->stringOffset = (u8 *)new_string - block->chunk->memory;
+    }
+
+    if(block->type == UNDO_REDO_INSERT) {
+        assert(block->byteAt + block->stringLength == byteAt);
+        memcpy(block->string + block->stringLength, string, stringLength);
+    } else {
+        assert(block->type == UNDO_REDO_DELETE);
+        assert(byteAt + stringLength == block->byteAt);
+        memmove(block->string + stringLength, block->string, block->stringLength);
+        memcpy(block->string, string, stringLength);
+        block->byteAt = byteAt;
+    }
+
+    block->stringLength += stringLength;
+    block->string[block->stringLength] = '\0';
+    block->time_in_seconds = global_undo_redo_time_in_seconds;
+
+    if(state->journal) {
+        undoJournal_log_extend(state->journal, byteAt, string, stringLength);
+    }
+}
+
+//NOTE: For typing & backspacing at the cursor. If the text carries on from the last typed block it gets added to that block, 
+//      otherwise it's a new block. Returns true if it's a new block.
+static bool push_block_coalesced(UndoRedoState *state, UndoRedo_BlockType type, s64 byteAt, char *string, s64 stringLength, s64 cursorAt) {
+    bool extended = false;
+
+    float time_since_last = global_undo_redo_time_in_seconds - state->coalesce_time_in_seconds;
+
+    if(state->coalesce_block_id != 0 && state->block_count > 0 && state->current == state->block_count - 1 && 
+       stringLength > 0 && time_since_last < UNDO_REDO_COALESCE_SECONDS) {
+        UndoRedoBlock *block = &state->history[state->block_count - 1];
+
+        if(block->id == state->coalesce_block_id && block->type == type) {
+            if(type == UNDO_REDO_INSERT) {
+                //NOTE: Typing straight after the end of the block
+                extended = (block->byteAt + block->stringLength == byteAt && !undoRedo_is_word_break(block->string[block->stringLength - 1], string[0]));
+            } else {
+                assert(type == UNDO_REDO_DELETE);
+                //NOTE: Backspacing the text straight before the block
+                extended = (byteAt + stringLength == block->byteAt && !undoRedo_is_word_break(string[stringLength - 1], block->string[0]));
+            }
+
+            if(extended) {
+                undoRedo_extend_last_block(state, byteAt, string, stringLength);
+            }
+        }
+    }
+
+    if(!extended) {
+        push_block(state, type, byteAt, string, stringLength, cursorAt);
+        state->coalesce_block_id = state->idAt;
+    }
+
+    state->coalesce_time_in_seconds = global_undo_redo_time_in_seconds;
+
+    return !extended;
+}
+
+//NOTE: Moves without writing it to the journal, for going through a lot of them at once. Undo leaves the parent's redo pointing back at where we were.
+static UndoRedoBlock *undoRedo_move_to_parent(UndoRedoState *state) {
     UndoRedoBlock *result = NULL;
-    if(state->at_in_history > 0) {
-        result = &state->history[--state->at_in_history];
+    if(state->current >= 0) {
+        result = undoRedo_load_block(state, &state->history[state->current]);
+        *undoRedo_get_redo_child(state, result->parent) = state->current;
+        state->current = result->parent;
+    }
+    return result;
+}
+
+static UndoRedoBlock *undoRedo_move_to_redo_child(UndoRedoState *state) {
+    UndoRedoBlock *result = NULL;
+    s32 child = *undoRedo_get_redo_child(state, state->current);
+    if(child >= 0) {
+        result = undoRedo_load_block(state, &state->history[child]);
+        state->current = child;
+    }
+    return result;
+}
+
+static UndoRedoBlock *get_undo_block(UndoRedoState *state) {
+    state->coalesce_block_id = 0;
+    UndoRedoBlock *result = undoRedo_move_to_parent(state);
+    if(result && state->journal) {
+        undoJournal_log_move(state->journal, false, -1);
     }
     return result;
 }
 
 static UndoRedoBlock *see_undo_block(UndoRedoState *state) {
     UndoRedoBlock *result = NULL;
-    if(state->at_in_history > 0) {
-        result = &state->history[state->at_in_history];
+    if(state->current >= 0) {
+        result = undoRedo_load_block(state, &state->history[state->current]);
     }
     return result;
 }
@@ -86,17 +752,36 @@ static UndoRedoBlock *see_undo_block(UndoRedoState *state) {
 static UndoRedoBlock *see_redo_block(UndoRedoState *state) {
     
     UndoRedoBlock *result = NULL;
-    if(state->at_in_history < state->block_count) {
-        result = &state->history[state->at_in_history];
+    s32 child = *undoRedo_get_redo_child(state, state->current);
+    if(child >= 0) {
+        result = undoRedo_load_block(state, &state->history[child]);
     }
     return result;
 }
 
 static UndoRedoBlock *get_redo_block(UndoRedoState *state) {
+    state->coalesce_block_id = 0;
     
-    UndoRedoBlock *result = NULL;
-    if(state->at_in_history < state->block_count) {
-        result = &state->history[state->at_in_history++];
+    UndoRedoBlock *result = undoRedo_move_to_redo_child(state);
+    if(result && state->journal) {
+        undoJournal_log_move(state->journal, true, state->current);
+    }
+    return result;
+}
+
+//NOTE: Redo goes down the next branch instead, wrapping around to the first. False if there's only one to choose from.
+static bool undoRedo_next_redo_branch(UndoRedoState *state) {
+    s32 *redo_child = undoRedo_get_redo_child(state, state->current);
+
+    bool result = false;
+    if(*redo_child >= 0) {
+        s32 next = state->history[*redo_child].next_sibling;
+        if(next < 0) {
+            next = *undoRedo_get_first_child(state, state->current);
+        }
+
+        result = (next != *redo_child);
+        *redo_child = next;
     }
     return result;
-}
\ No newline at end of file
+}
@@ -1,3 +1,40 @@
+//NOTE: For the scratch arena test, each thread uses its own scratch arenas & pushes onto the shared atomic arena at the same time
+struct DEBUG_Arena_Test_Work {
+    Atomic_Arena *shared;
+    s32 thread_index;
+    s32 push_count;
+    s32 **pushed;
+    bool scratch_ok;
+};
+
+static THREAD_WORK_FUNCTION(DEBUG_arena_test_work) {
+    DEBUG_Arena_Test_Work *work = (DEBUG_Arena_Test_Work *)Data;
+    work->scratch_ok = true;
+
+    for(int round = 0; round < 100; ++round) {
+        Scratch_Arena scratch = getScratchArena();
+        s32 *values = pushArray(scratch.arena, 1000, s32);
+        for(int i = 0; i < 1000; ++i) { values[i] = work->thread_index + i; }
+
+        //NOTE: Asking with the first one as a conflict gives the other one, so releasing it doesn't touch the values
+        Scratch_Arena inner = getScratchArena(&scratch.arena, 1);
+        work->scratch_ok &= (inner.arena != scratch.arena);
+        s32 *more = pushArray(inner.arena, 5000, s32);
+        memset(more, 0xFF, 5000*sizeof(s32));
+        releaseScratchArena(&inner);
+
+        for(int i = 0; i < 1000; ++i) { work->scratch_ok &= (values[i] == work->thread_index + i); }
+        releaseScratchArena(&scratch);
+    }
+
+    for(int i = 0; i < work->push_count; ++i) {
+        s32 *value = pushArrayAtomic(work->shared, (1 + (i % 7)), s32);
+        work->scratch_ok &= (value[0] == 0 && ((size_t)value % ATOMIC_ARENA_ALIGNMENT) == 0);
+        value[0] = work->thread_index*work->push_count + i;
+        work->pushed[i] = value;
+    }
+}
+
 static void DEBUG_runUnitTests() {
     assert(easyString_string_contains_utf8("Oliver", "iver"));
     assert(!easyString_string_contains_utf8("Olive", "iver"));
@@ -89,5 +126,2023 @@ static void DEBUG_runUnitTests() {
     a++;
     assert(size_of_last_utf8_codepoint_in_bytes(a, 2) == 1);
 
-    
-}
\ No newline at end of file
+    {
+        //NOTE: Both ways of storing a buffer should behave the same
+        WL_Buffer_Storage_Type storage_types[] = {WL_BUFFER_STORAGE_GAP_BUFFER, WL_BUFFER_STORAGE_LINES, WL_BUFFER_STORAGE_PIECE_TABLE, WL_BUFFER_STORAGE_ROPE};
+
+        for(int i = 0; i < arrayCount(storage_types); ++i) {
+            WL_Buffer buffer;
+            initBuffer(&buffer, storage_types[i]);
+            WL_Buffer *b = &buffer;
+
+            addTextToBuffer(b, "one\r\ntwo\nthree", 0);
+            assert(wl_buffer_get_size_in_bytes(b) == 14);
+            assert(wl_buffer_get_byte(b, 5) == 't');
+
+            assert(wl_buffer_get_line_start(b, 7) == 5);
+            assert(wl_buffer_get_line_end(b, 7) == 8);
+            assert(wl_buffer_get_line_end(b, 0) == 3);
+            assert(wl_buffer_get_line_start(b, 14) == 9);
+            assert(wl_buffer_get_offset_of_line(b, 2) == 9);
+            assert(wl_buffer_get_offset_of_line(b, 5) == 14);
+            assert(wl_buffer_get_line_count(b) == 3);
+            assert(wl_buffer_get_line_index(b, 4) == 0);
+
+            //NOTE: Walking the spans gets the same text back
+            for(s64 offset = 0; offset < wl_buffer_get_size_in_bytes(b); ) {
+                s64 size = 0;
+                u8 *span = wl_buffer_get_span(b, offset, &size);
+                assert(offset + size <= 14 && memcmp(span, "one\r\ntwo\nthree" + offset, size) == 0);
+                offset += size;
+            }
+
+            //NOTE: Join the first two lines then split the last one
+            removeTextFromBuffer(b, 3, 2);
+            addTextToBuffer(b, "\n", 10);
+            
+            WL_Buffer_View view = wl_buffer_get_view(b, &globalPerFrameArena);
+            assert(view.size_in_bytes == 13);
+            assert(easyString_stringsMatch_nullTerminated(wl_buffer_view_copy_to_arena(&view, 0, 13, &globalPerFrameArena), "onetwo\nthr\nee"));
+            assert(wl_buffer_get_offset_of_line(b, 2) == 11);
+
+            //NOTE: Undo both of them
+            UndoRedoBlock *block = get_undo_block(&b->undo_redo_state);
+            assert(block->type == UNDO_REDO_INSERT && block->byteAt == 10);
+            removeTextFromBuffer(b, block->byteAt, block->stringLength, false);
+
+            block = get_undo_block(&b->undo_redo_state);
+            assert(block->type == UNDO_REDO_DELETE && block->byteAt == 3);
+            addTextToBuffer(b, block->string, block->byteAt, false);
+
+            view = wl_buffer_get_view(b, &globalPerFrameArena);
+            assert(view.size_in_bytes == 14);
+            assert(easyString_stringsMatch_nullTerminated(wl_buffer_view_copy_to_arena(&view, 0, 14, &globalPerFrameArena), "one\r\ntwo\nthree"));
+
+            wl_emptyBuffer(b);
+        }
+    }
+
+    {
+        //NOTE: Picking the storage for a file by its size
+        assert(bufferStorage_pick_type(1024, 10, true) == WL_BUFFER_STORAGE_GAP_BUFFER);
+        assert(bufferStorage_pick_type(1024*1024, WL_BUFFER_LINE_STORAGE_MIN_LINE_COUNT, true) == WL_BUFFER_STORAGE_LINES);
+        assert(bufferStorage_pick_type(WL_BUFFER_ROPE_MIN_FILE_SIZE, 10, true) == WL_BUFFER_STORAGE_ROPE);
+        assert(bufferStorage_pick_type(WL_BUFFER_PIECE_TABLE_MIN_FILE_SIZE, 10, true) == WL_BUFFER_STORAGE_PIECE_TABLE);
+        assert(bufferStorage_pick_type(WL_BUFFER_PIECE_TABLE_MIN_FILE_SIZE, 10, false) == WL_BUFFER_STORAGE_ROPE);
+    }
+
+    {
+        //NOTE: Gap buffer keeps its gap open across edits in different places
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+
+        WL_Gap_Buffer *gb = &b->storage.gap_buffer;
+
+        addTextToBuffer(b, "abcdef", 0);
+        s64 sizeAfterFirstInsert = gb->size_in_bytes;
+
+        addTextToBuffer(b, "X", 2);
+        addTextToBuffer(b, "Y", 7);
+        removeTextFromBuffer(b, 0, 1);
+        assert(gb->size_in_bytes == sizeAfterFirstInsert); //NOTE: Shouldn't have needed to grow
+        assert(gb->gap_start == 0);
+
+        endGapBuffer(b);
+        assert(memcmp(gb->memory, "bXcdefY", 7) == 0);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: Reading the buffer through the view when the gap is in the middle of a string and a word
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+
+        addTextToBuffer(b, "x = \"hello\"; while", 0);
+        addTextToBuffer(b, "!", 8);
+
+        WL_Buffer_View view = wl_buffer_get_view(b, &globalPerFrameArena);
+        assert(view.span_sizes[0] == 9 && view.span_sizes[1] == 10);
+        assert(wl_buffer_view_get_byte(&view, 9) == 'l');
+        assert(wl_buffer_view_get_range(&view, 9, 3, &globalPerFrameArena) == view.spans[1]); //NOTE: Shouldn't copy
+
+        int count = 0;
+        for(WL_Buffer_View_Iterator it = wl_buffer_view_begin_iterator(&view, 7); wl_buffer_view_iterator_valid(&it); wl_buffer_view_iterator_next(&it)) {
+            if(*it.at == 'l') { count++; }
+        }
+        assert(count == 3);
+
+        //NOTE: The string crosses the gap so should still be one token
+        WL_Buffer_View_Tokenizer tokenizer = wl_buffer_view_begin_lexing(&view, &globalPerFrameArena);
+        EasyToken token = {};
+        do {
+            token = wl_buffer_view_get_next_token(&tokenizer);
+        } while(token.type != TOKEN_STRING);
+        assert(wl_buffer_view_get_token_offset(&tokenizer, token.at) == 4 && token.size == 8);
+
+        //NOTE: Move the gap into the keyword
+        removeTextFromBuffer(b, 16, 1);
+        addTextToBuffer(b, "i", 16);
+        view = wl_buffer_get_view(b, &globalPerFrameArena);
+        tokenizer = wl_buffer_view_begin_lexing(&view, &globalPerFrameArena);
+        do {
+            token = wl_buffer_view_get_next_token(&tokenizer);
+        } while(token.type != TOKEN_NULL_TERMINATOR && token.type != TOKEN_WHILE_KEYWORD);
+        assert(token.type == TOKEN_WHILE_KEYWORD && wl_buffer_view_get_token_offset(&tokenizer, token.at) == 14);
+
+        String_Query_Search_Results results = wl_buffer_view_find_sub_string(&view, "hel!lo", &globalPerFrameArena);
+        assert(results.byteOffsetCount == 1 && results.byteOffsets[0] == 5);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: Piece table reading out of the original text, without copying it
+        char *original = "hello\nworld";
+        
+        WL_Piece_Table table;
+        pieceTable_init(&table, (u8 *)original, 11);
+
+        pieceTable_insert(&table, 5, (u8 *)" there", 6);
+        pieceTable_insert(&table, 11, (u8 *)"!", 1); //NOTE: Should grow the last piece instead of making a new one
+        assert(table.piece_count == 3);
+
+        pieceTable_remove(&table, 3, 12); //NOTE: Across all three pieces
+        assert(pieceTable_get_size_in_bytes(&table) == 6);
+
+        char text[7] = {};
+        pieceTable_copy_bytes(&table, 0, 6, (u8 *)text);
+        assert(easyString_stringsMatch_nullTerminated(text, "helrld"));
+        assert(pieceTable_get_byte(&table, 3) == 'r');
+
+        pieceTable_free(&table);
+    }
+
+    {
+        //NOTE: After a save the pieces from the original file get pointed at where their text is in the saved file, without copying any of it
+        char *original = "one two three four five six";
+        s64 original_size = easyString_getSizeInBytes_utf8(original);
+
+        WL_Piece_Table table;
+        pieceTable_init(&table, (u8 *)original, original_size);
+        pieceTable_insert(&table, 4, (u8 *)"2 ", 2);
+        pieceTable_remove(&table, 16, 5); //NOTE: "four "
+
+        //NOTE: The snapshot that gets saved
+        s64 saved_piece_count = table.piece_count;
+        WL_Piece *saved_pieces = pushArray(&globalPerFrameArena, saved_piece_count, WL_Piece);
+        memcpy(saved_pieces, table.pieces, saved_piece_count*sizeof(WL_Piece));
+        s64 saved_size = pieceTable_get_size_in_bytes(&table);
+        char *saved = pushArray(&globalPerFrameArena, (saved_size + 1), char);
+        pieceTable_copy_bytes(&table, 0, saved_size, (u8 *)saved);
+        saved[saved_size] = '\0';
+        assert(easyString_stringsMatch_nullTerminated(saved, "one 2 two three five six"));
+
+        //NOTE: Keep editing while it saves
+        pieceTable_remove(&table, 0, 6);
+        pieceTable_insert(&table, 12, (u8 *)"!", 1);
+        s64 add_size = table.add_size_in_bytes;
+
+        s64 piece_count = 0;
+        WL_Piece *pieces = pieceTable_rebase_pieces(&table, saved_pieces, saved_piece_count, &piece_count);
+        pieceTable_set_original(&table, (u8 *)saved, saved_size, pieces, piece_count);
+        platform_free_memory(pieces);
+
+        assert(table.add_size_in_bytes == add_size);
+        char text[32] = {};
+        pieceTable_copy_bytes(&table, 0, pieceTable_get_size_in_bytes(&table), (u8 *)text);
+        assert(easyString_stringsMatch_nullTerminated(text, "two three fi!ve six"));
+        for(s64 i = 0; i < table.piece_count; ++i) {
+            if(table.pieces[i].source == WL_PIECE_SOURCE_ORIGINAL) {
+                assert(table.pieces[i].start + table.pieces[i].size_in_bytes <= saved_size);
+            }
+        }
+
+        pieceTable_free(&table);
+    }
+
+    {
+        //NOTE: Rope with enough text to need more than one level
+        WL_Rope rope;
+        rope_init(&rope);
+
+        char *line = "გთხოვთ line\n"; //NOTE: 24 bytes, 12 codepoints
+        for(int i = 0; i < 1000; ++i) {
+            rope_insert(&rope, rope_get_size_in_bytes(&rope), (u8 *)line, 24);
+        }
+        assert(!rope.root->is_leaf);
+        assert(rope_get_size_in_bytes(&rope) == 24000);
+        assert(rope_get_line_count(&rope) == 1001);
+
+        assert(rope_get_offset_of_line(&rope, 500) == 500*24);
+        assert(rope_get_line_at_offset(&rope, 500*24 + 5) == 500);
+        assert(rope_get_codepoints_at_offset(&rope, 500*24 + 19) == 500*12 + 7);
+        assert(rope_get_byte(&rope, 500*24 + 19) == 'l');
+
+        //NOTE: Remove most of it from the middle, the tree should shrink back down
+        rope_remove(&rope, 24, 998*24);
+        assert(rope_get_size_in_bytes(&rope) == 48);
+        assert(rope_get_line_count(&rope) == 3);
+        assert(rope.root->is_leaf);
+
+        rope_free(&rope);
+    }
+
+    {
+        //NOTE: Line index with enough lines to need more than one level
+        WL_Line_Index index;
+        lineIndex_init(&index);
+
+        char *line = "some text\r\n"; //NOTE: 11 bytes
+        for(int i = 0; i < 2000; ++i) {
+            lineIndex_insert(&index, lineIndex_get_size_in_bytes(&index), (u8 *)line, 11);
+        }
+        assert(!index.root->is_leaf);
+        assert(lineIndex_get_line_count(&index) == 2001);
+        assert(lineIndex_get_offset_of_line(&index, 1000) == 1000*11);
+        assert(lineIndex_get_line_at_offset(&index, 1000*11 + 10) == 1000); //NOTE: On the \n
+        assert(lineIndex_get_line_at_offset(&index, 1000*11 + 11) == 1001);
+
+        //NOTE: Split a line by typing a newline into the middle of it
+        lineIndex_insert(&index, 500*11 + 4, (u8 *)"\n", 1);
+        assert(lineIndex_get_line_count(&index) == 2002);
+        assert(lineIndex_get_offset_of_line(&index, 501) == 500*11 + 5);
+        assert(lineIndex_get_offset_of_line(&index, 502) == 501*11 + 1);
+
+        //NOTE: Remove from the middle of one line to the middle of another, the lines either side get joined
+        lineIndex_remove(&index, 3*11 + 2, 1990*11);
+        assert(lineIndex_get_line_count(&index) == 11);
+        assert(lineIndex_get_offset_of_line(&index, 4) == 4*11 + 1);
+        assert(index.root->is_leaf);
+
+        lineIndex_free(&index);
+    }
+
+    {
+        //NOTE: Anchor set with enough anchors to need more than one level
+        WL_Anchor_Set set;
+        anchorSet_init(&set);
+
+        WL_Anchor anchors[3000];
+        for(int i = 0; i < arrayCount(anchors); ++i) {
+            anchors[i] = anchorSet_add(&set, 10*i, (i % 2) ? WL_ANCHOR_MOVES_WITH_INSERT : WL_ANCHOR_STAYS_BEFORE_INSERT);
+        }
+        assert(!set.root->is_leaf);
+        assert(anchorSet_get_offset(&set, anchors[1500]) == 15000);
+
+        //NOTE: Text inserted at an anchor only moves it if it moves with inserts
+        anchorSet_insert_text(&set, 15000, 5);
+        assert(anchorSet_get_offset(&set, anchors[1500]) == 15000);
+        assert(anchorSet_get_offset(&set, anchors[1501]) == 15015);
+        anchorSet_insert_text(&set, 15015, 5);
+        assert(anchorSet_get_offset(&set, anchors[1501]) == 15020);
+        assert(anchorSet_get_offset(&set, anchors[2999]) == 29990 + 10);
+        assert(anchorSet_get_offset(&set, anchors[1499]) == 14990);
+
+        //NOTE: Anchors in removed text end up at its start, the ones after move back
+        anchorSet_remove_text(&set, 100, 20000);
+        assert(anchorSet_get_offset(&set, anchors[10]) == 100);
+        assert(anchorSet_get_offset(&set, anchors[11]) == 100);
+        assert(anchorSet_get_offset(&set, anchors[2000]) == 100);
+        assert(anchorSet_get_offset(&set, anchors[2011]) == 20110 + 10 - 20000);
+
+        //NOTE: The ones that stay still end up in front of the ones that move, so typing at 100 leaves them all on the right side
+        anchorSet_insert_text(&set, 100, 3);
+        assert(anchorSet_get_offset(&set, anchors[10]) == 100 && anchorSet_get_offset(&set, anchors[1500]) == 100);
+        assert(anchorSet_get_offset(&set, anchors[11]) == 103 && anchorSet_get_offset(&set, anchors[1501]) == 103);
+        assert(anchorSet_get_offset(&set, anchors[9]) == 90);
+
+        //NOTE: Removing most of them should shrink the tree back down without moving the rest
+        for(int i = 0; i < arrayCount(anchors); ++i) {
+            if(i % 100 != 0) {
+                anchorSet_remove(&set, anchors[i]);
+            }
+        }
+        assert(anchorSet_get_anchor_count(&set) == 30);
+        assert(set.root->is_leaf);
+        assert(anchorSet_get_offset(&set, anchors[2900]) == 29000 + 13 - 20000);
+
+        //NOTE: Handles get used again, & moving one keeps it
+        WL_Anchor reused = anchorSet_add(&set, 7, WL_ANCHOR_STAYS_BEFORE_INSERT);
+        assert(reused == anchors[2999]);
+        anchorSet_set_offset(&set, anchors[0], 8);
+        assert(anchorSet_get_offset(&set, anchors[0]) == 8 && anchorSet_get_offset(&set, reused) == 7);
+        assert(anchorSet_get_index(&set, reused) == 0);
+
+        anchorSet_free(&set);
+    }
+
+    {
+        //NOTE: The cursor is an anchor, text loading in after it or edits before it don't lose its place
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+
+        addTextToBuffer(b, "hello world", 0, false);
+        wl_buffer_set_cursor(b, 6);
+
+        wl_buffer_insert_bytes(b, wl_buffer_get_size_in_bytes(b), (u8 *)"!", 1);
+        assert(wl_buffer_get_cursor(b) == 6);
+
+        wl_buffer_insert_bytes(b, 0, (u8 *)">> ", 3);
+        assert(wl_buffer_get_cursor(b) == 9);
+
+        wl_buffer_remove_bytes(b, 0, 5);
+        assert(wl_buffer_get_cursor(b) == 4 && wl_buffer_get_byte(b, 4) == 'w');
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: Building the line index a chunk per thread should give the same lines as adding the text a bit at a time
+        char text[1000];
+        int text_size = 0;
+        for(int i = 0; text_size + 3 < arrayCount(text); ++i) {
+            //NOTE: Lots of \r\n so some of them get split across chunks
+            text[text_size++] = (i % 3 == 0) ? '\r' : 'a';
+            if(i % 3 == 0 || i % 7 == 0) { text[text_size++] = '\n'; }
+        }
+
+        assert(lineIndex_count_newlines_sse2((u8 *)text, text_size) == lineIndex_count_newlines_scalar((u8 *)text, text_size));
+        if(platform_cpu_has_avx2()) {
+            assert(lineIndex_count_newlines_avx2((u8 *)text, text_size) == lineIndex_count_newlines_scalar((u8 *)text, text_size));
+        }
+
+        WL_Line_Index added;
+        lineIndex_init(&added);
+        for(int i = 0; i < text_size; i += 10) {
+            int size = (text_size - i < 10) ? (text_size - i) : 10;
+            lineIndex_insert(&added, i, (u8 *)text + i, size);
+        }
+
+        for(u32 chunk_count = 1; chunk_count < 12; ++chunk_count) {
+            WL_Line_Index built;
+            lineIndex_init(&built);
+            lineIndex_build_(&built, (u8 *)text, text_size, chunk_count);
+
+            assert(lineIndex_get_line_count(&built) == lineIndex_get_line_count(&added));
+            for(s64 line = 0; line < lineIndex_get_line_count(&added); ++line) {
+                assert(lineIndex_get_offset_of_line(&built, line) == lineIndex_get_offset_of_line(&added, line));
+            }
+
+            lineIndex_free(&built);
+        }
+
+        lineIndex_free(&added);
+    }
+
+    {
+        //NOTE: Lexing from a checkpoint in the middle of the buffer, through a view of just that part
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_PIECE_TABLE);
+        WL_Buffer *b = &buffer;
+
+        for(int i = 0; i < 1000; ++i) {
+            addTextToBuffer(b, "/* one */ two2;\n", (int)wl_buffer_get_size_in_bytes(b), false); //NOTE: 16 bytes, 4 tokens
+        }
+
+        WL_Buffer_View view = wl_buffer_get_view(b, &globalPerFrameArena);
+        WL_Buffer_View_Tokenizer tokenizer = wl_buffer_view_begin_lexing(&view, &globalPerFrameArena);
+        for(EasyToken token = wl_buffer_view_get_next_token(&tokenizer); token.type != TOKEN_NULL_TERMINATOR; token = wl_buffer_view_get_next_token(&tokenizer)) {
+            wl_buffer_add_lex_checkpoint(b, wl_buffer_view_get_token_offset(&tokenizer, token.at), token.lineNumber);
+        }
+        assert(b->lex_checkpoint_count == (16000 / WL_BUFFER_LEX_CHECKPOINT_SPACING_IN_BYTES));
+
+        WL_Lex_Checkpoint checkpoint = wl_buffer_get_lex_checkpoint(b, 10000);
+        assert(checkpoint.offset <= 10000 && checkpoint.offset > 10000 - WL_BUFFER_LEX_CHECKPOINT_SPACING_IN_BYTES);
+        assert((checkpoint.offset % 16) == 0); //NOTE: The comments are the only tokens that start on a multiple of 16
+
+        view = wl_buffer_get_view_of_range(b, &globalPerFrameArena, 0, checkpoint.offset, checkpoint.offset + 32);
+        assert(view.start == checkpoint.offset && view.size_in_bytes == 32);
+        assert(wl_buffer_view_get_byte(&view, checkpoint.offset + 10) == 't');
+
+        tokenizer = wl_buffer_view_begin_lexing(&view, &globalPerFrameArena, checkpoint.offset, checkpoint.lineNumber);
+        EasyToken token = wl_buffer_view_get_next_token(&tokenizer);
+        assert(token.type == TOKEN_COMMENT && wl_buffer_view_get_token_offset(&tokenizer, token.at) == checkpoint.offset);
+
+        //NOTE: Starting a comment further up could change every token after it
+        addTextToBuffer(b, "/*", 20, false);
+        assert(b->lex_checkpoint_count == 0);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: The rows the wrapped lines took, so drawing can start at the first line on the screen
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_PIECE_TABLE);
+        WL_Buffer *b = &buffer;
+
+        for(int i = 0; i < 100; ++i) {
+            addTextToBuffer(b, "line\n", (int)wl_buffer_get_size_in_bytes(b), false); //NOTE: 5 bytes
+        }
+
+        wl_buffer_set_wrap_width(b, 100);
+
+        //NOTE: Lines that haven't been drawn are a row each
+        assert(wl_buffer_get_wrapped_row_of_line(b, 50) == 50);
+
+        assert(wl_buffer_set_wrapped_rows(b, 10*5, 10*5 + 4, 3) == 3);
+        assert(wl_buffer_set_wrapped_rows(b, 20*5, 20*5 + 4, 2) == 2);
+        assert(wl_buffer_set_wrapped_rows(b, 20*5, 20*5 + 4, 2) == 0);
+        assert(wl_buffer_set_wrapped_rows(b, 30*5, 30*5 + 4, 0) == 0);
+        assert(b->wrapped_line_count == 2);
+
+        assert(wl_buffer_get_wrapped_row_of_line(b, 10) == 10);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 11) == 14);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 50) == 55);
+
+        s64 row_in_line = 0;
+        assert(wl_buffer_get_line_of_wrapped_row(b, 9, &row_in_line) == 9 && row_in_line == 0);
+        assert(wl_buffer_get_line_of_wrapped_row(b, 12, &row_in_line) == 10 && row_in_line == 2);
+        assert(wl_buffer_get_line_of_wrapped_row(b, 14, &row_in_line) == 11 && row_in_line == 0);
+        assert(wl_buffer_get_line_of_wrapped_row(b, 25, &row_in_line) == 20 && row_in_line == 2);
+        assert(wl_buffer_get_line_of_wrapped_row(b, 26, &row_in_line) == 21 && row_in_line == 0);
+        assert(wl_buffer_get_line_of_wrapped_row(b, 1000, &row_in_line) == wl_buffer_get_line_count(b) - 1 && row_in_line == 0);
+
+        //NOTE: New lines above move the wrapped lines down with them
+        addTextToBuffer(b, "a\nb\n", 0, false);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 12) == 12);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 13) == 16);
+
+        //NOTE: Joining a wrapped line onto the one above leaves its rows on that line until it gets drawn again
+        removeTextFromBuffer(b, 4 + 10*5 - 1, 1, false);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 12) == 15);
+        assert(wl_buffer_set_wrapped_rows(b, 4 + 9*5, 4 + 9*5 + 8, 1) == -2);
+        assert(b->wrapped_line_count == 2);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 12) == 13);
+
+        //NOTE: They don't fit a different width
+        wl_buffer_set_wrap_width(b, 50);
+        assert(b->wrapped_line_count == 0);
+        assert(wl_buffer_get_wrapped_row_of_line(b, 50) == 50);
+        assert(anchorSet_get_anchor_count(&b->anchors) == 2); //NOTE: Just the cursor & the mark
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: A file arriving a few bytes at a time shouldn't have its BOM or codepoints that get split in half end up in the buffer
+        char *file = "\xEF\xBB\xBFh\xC3\xA9llo\r\n\xE2\x82\xAC\xF0\x9F\x98\x80 w\xC3\xB6rld\n";
+        s64 file_size = easyString_getSizeInBytes_utf8(file);
+
+        for(int step = 1; step < 6; ++step) {
+            WL_Open_Buffer open_buffer = {};
+            initBuffer(&open_buffer.buffer);
+
+            File_Load *load = (File_Load *)platform_alloc_memory(sizeof(File_Load), true);
+            load->file_size_in_bytes = file_size;
+            load->memory = (u8 *)platform_alloc_memory(file_size, false);
+            open_buffer.file_load = load;
+
+            //NOTE: Pretend to be the loading thread
+            s64 bytes_read = 0;
+            while(open_buffer.file_load) {
+                if(bytes_read < file_size) {
+                    s64 size = (file_size - bytes_read < step) ? (file_size - bytes_read) : step;
+                    memcpy(load->memory + bytes_read, file + bytes_read, size);
+                    bytes_read += size;
+                    load->bytes_read = bytes_read;
+                    load->finished = (bytes_read == file_size);
+                }
+
+                update_file_load(&open_buffer);
+
+                //NOTE: Only whole codepoints get added
+                s64 size_added = wl_buffer_get_size_in_bytes(&open_buffer.buffer);
+                if(size_added > 0) {
+                    int rune_size = wl_buffer_get_size_of_rune_before(&open_buffer.buffer, size_added);
+                    assert(easyUnicode_unicodeLength(wl_buffer_get_byte(&open_buffer.buffer, size_added - rune_size)) == rune_size);
+                }
+            }
+
+            WL_Buffer *b = &open_buffer.buffer;
+            assert(wl_buffer_get_size_in_bytes(b) == file_size - 3);
+            assert(wl_buffer_get_line_count(b) == 3);
+
+            char *text = wl_buffer_copy_to_arena(b, 0, file_size - 3, &globalPerFrameArena);
+            assert(easyString_stringsMatch_nullTerminated(text, file + 3));
+
+            wl_emptyBuffer(b);
+        }
+    }
+
+    {
+        //NOTE: The rest of a file goes in at once with the lines the loading thread found, unless the buffer got typed in while it was loading
+        s64 file_size = 6*1000*1000;
+        s64 first_size = 1000*1000;
+        u8 *file = (u8 *)platform_alloc_memory(file_size, false);
+        for(s64 i = 0; i < file_size; ++i) {
+            file[i] = ((i % 1000) == 999) ? '\n' : 'a' + (i % 26); //NOTE: Few enough lines to go in a gap buffer
+        }
+
+        for(int typed = 0; typed < 2; ++typed) {
+            WL_Open_Buffer open_buffer = {};
+            initBuffer(&open_buffer.buffer);
+            WL_Buffer *b = &open_buffer.buffer;
+
+            File_Load *load = (File_Load *)platform_alloc_memory(sizeof(File_Load), true);
+            load->file_size_in_bytes = file_size;
+            load->memory = (u8 *)platform_alloc_memory(file_size, false);
+            open_buffer.file_load = load;
+
+            //NOTE: Pretend to be the loading thread
+            memcpy(load->memory, file, first_size);
+            load->bytes_read = first_size;
+            update_file_load(&open_buffer);
+            assert(b->storage.type == WL_BUFFER_STORAGE_GAP_BUFFER && wl_buffer_get_size_in_bytes(b) == first_size);
+
+            if(typed) {
+                addTextToBuffer(b, "typed\n", 0);
+            }
+
+            memcpy(load->memory + first_size, file + first_size, file_size - first_size);
+            load->bytes_read = file_size;
+            file_load_build_line_index(load, 0, file_size);
+            load->finished = true;
+
+            update_file_load(&open_buffer);
+
+            if(!typed) {
+                assert(!open_buffer.file_load);
+                assert(wl_buffer_get_size_in_bytes(b) == file_size);
+                assert(wl_buffer_get_line_count(b) == 6001);
+                assert(wl_buffer_get_offset_of_line(b, 3000) == 3000*1000);
+            } else {
+                //NOTE: The lines are 6 bytes further on than the index has them, so the rest goes in a chunk at a time like normal
+                assert(open_buffer.file_load && wl_buffer_get_size_in_bytes(b) == 6 + first_size + FILE_LOAD_MAX_BYTES_ADDED_PER_FRAME);
+                while(open_buffer.file_load) {
+                    update_file_load(&open_buffer);
+                }
+                assert(wl_buffer_get_size_in_bytes(b) == 6 + file_size);
+                assert(wl_buffer_get_line_count(b) == 6002);
+                assert(wl_buffer_get_offset_of_line(b, 3001) == 6 + 3000*1000);
+            }
+
+            wl_emptyBuffer(b);
+        }
+
+        platform_free_memory(file);
+    }
+
+    {
+        //NOTE: Saving writes the text a span at a time to the temp file, then it replaces the real file. Edits after the save started don't end up in it.
+        char *path = "woodland_save_test.txt";
+        char *temp_path = concatInArena(path, FILE_SAVE_TEMP_EXTENSION, &globalPerFrameArena);
+
+        Platform_File_Handle old_file = platform_begin_file_write_utf8_file_path(path);
+        assert(!old_file.has_errors);
+        platform_write_file_data(old_file, "old text", 8, 0);
+        platform_close_file(old_file);
+
+        WL_Open_Buffer open_buffer = {};
+        initBuffer(&open_buffer.buffer, WL_BUFFER_STORAGE_PIECE_TABLE);
+        WL_Buffer *b = &open_buffer.buffer;
+        open_buffer.file_name_utf8 = path;
+
+        //NOTE: Every other insert goes in the middle, so the text is in lots of pieces
+        for(int i = 0; i < 100; ++i) {
+            addTextToBuffer(b, "line\n", (i & 1) ? (wl_buffer_get_size_in_bytes(b) / 10)*5 : wl_buffer_get_size_in_bytes(b));
+        }
+        assert(b->storage.piece_table.piece_count > 2);
+
+        s64 saved_size = wl_buffer_get_size_in_bytes(b);
+        char *saved_text = wl_buffer_copy_to_arena(b, 0, saved_size, &globalPerFrameArena);
+        s32 saved_id = undoRedo_get_current_id(&b->undo_redo_state);
+
+        begin_file_save(&open_buffer);
+        assert(open_buffer.file_save);
+
+        addTextToBuffer(b, "after the save", 0);
+
+        //NOTE: Wait for the saving thread
+        while(open_buffer.file_save) {
+            update_file_save(&open_buffer);
+        }
+        assert(!open_buffer.save_failed);
+        assert(!open_buffer.is_up_to_date);
+        assert(open_buffer.current_save_undo_redo_id == saved_id);
+
+        size_t file_size = 0;
+        u64 time_stamp = 0;
+        Platform_File_Handle file = platform_begin_file_read_wideChar(platform_utf8_to_wide_char(path, &globalPerFrameArena), &file_size, &time_stamp);
+        assert(!file.has_errors && (s64)file_size == saved_size);
+
+        char *file_text = (char *)pushSize(&globalPerFrameArena, file_size + 1);
+        assert(platform_read_file_data(file, file_text, file_size, 0) == file_size);
+        file_text[file_size] = '\0';
+        platform_close_file(file);
+        assert(easyString_stringsMatch_nullTerminated(file_text, saved_text));
+
+        //NOTE: The temp file got moved over the real one
+        assert(!platform_delete_file_utf8(temp_path));
+
+        wl_emptyBuffer(b);
+        wl_buffer_free_released_snapshots();
+
+        bool deleted = platform_delete_file_utf8(path);
+        assert(deleted);
+    }
+
+    {
+        //NOTE: A snapshot keeps the text it had when it was taken, even after the buffer gets edited
+        WL_Buffer_Storage_Type storage_types[] = { WL_BUFFER_STORAGE_GAP_BUFFER, WL_BUFFER_STORAGE_LINES, WL_BUFFER_STORAGE_PIECE_TABLE, WL_BUFFER_STORAGE_ROPE };
+
+        for(int i = 0; i < arrayCount(storage_types); ++i) {
+            WL_Buffer buffer;
+            initBuffer(&buffer, storage_types[i]);
+            WL_Buffer *b = &buffer;
+
+            addTextToBuffer(b, "hello\nworld", 0, false);
+            addTextToBuffer(b, " there", 5, false);
+
+            //NOTE: Taking another one before the buffer changes gives back the same snapshot
+            WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(b);
+            WL_Buffer_Snapshot *same_snapshot = wl_buffer_take_snapshot(b);
+            assert(snapshot == same_snapshot && snapshot->ref_count == 2);
+            assert(wl_buffer_snapshot_is_current(snapshot));
+            wl_buffer_retain_snapshot(snapshot);
+
+            //NOTE: Move the gap & grow the buffer while the snapshot is sharing it
+            removeTextFromBuffer(b, 0, 6, false);
+            for(int j = 0; j < 100; ++j) {
+                addTextToBuffer(b, "0123456789", 0, false);
+            }
+            assert(!wl_buffer_snapshot_is_current(snapshot));
+            assert(!b->current_snapshot);
+
+            //NOTE: A new snapshot now the buffer has changed
+            WL_Buffer_Snapshot *new_snapshot = wl_buffer_take_snapshot(b);
+            assert(new_snapshot != snapshot && new_snapshot->size_in_bytes == 1000 + 11);
+
+            char text[64] = {};
+            s64 at = 0;
+            s64 span_size = 0;
+            WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+            while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+                memcpy(text + at, span, span_size);
+                at += span_size;
+            }
+            assert(at == snapshot->size_in_bytes);
+            assert(easyString_stringsMatch_nullTerminated(text, "hello there\nworld"));
+
+            //NOTE: Starting part way through
+            it = wl_buffer_snapshot_begin_iterator(snapshot, 12);
+            u8 *span = wl_buffer_snapshot_next_span(&it, &span_size);
+            assert(span && span[0] == 'w');
+
+            //NOTE: Still held, so it doesn't get freed
+            wl_buffer_release_snapshot(snapshot);
+            wl_buffer_release_snapshot(snapshot);
+            wl_buffer_free_released_snapshots();
+            assert(global_wl_buffer_snapshots == new_snapshot && new_snapshot->next == snapshot);
+            assert(snapshot->ref_count == 1);
+
+            wl_buffer_release_snapshot(snapshot);
+            wl_buffer_release_snapshot(new_snapshot);
+            wl_buffer_free_released_snapshots();
+            assert(!global_wl_buffer_snapshots);
+            assert(!b->current_snapshot);
+
+            assert(wl_buffer_get_size_in_bytes(b) == 1000 + 11);
+            assert(wl_buffer_get_byte(b, 1000) == 't');
+
+            wl_emptyBuffer(b);
+        }
+    }
+
+    {
+        //NOTE: A rope snapshot shares the nodes, an edit only copies the path down to the leaf it changes
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_ROPE);
+        WL_Buffer *b = &buffer;
+
+        char *line = "a line of text\n"; //NOTE: 15 bytes
+        for(int i = 0; i < 1000; ++i) {
+            addTextToBuffer(b, line, wl_buffer_get_size_in_bytes(b), false);
+        }
+        WL_Rope *rope = &b->storage.rope;
+        assert(!rope->root->is_leaf);
+
+        WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(b);
+        WL_Rope_Node *old_root = rope->root;
+        WL_Rope_Node *last_child = old_root->children[old_root->count - 1];
+        assert(snapshot->storage.rope_root == old_root && old_root->ref_count == 2);
+
+        addTextToBuffer(b, "x", 0, false);
+        assert(rope->root != old_root && snapshot->storage.rope_root == old_root);
+        assert(rope->root->children[rope->root->count - 1] == last_child && last_child->ref_count == 2);
+
+        assert(wl_buffer_get_byte(b, 0) == 'x');
+        s64 at = 0;
+        s64 span_size = 0;
+        WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+        while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+            for(s64 j = 0; j < span_size; ++j) {
+                assert(span[j] == line[(at + j) % 15]);
+            }
+            at += span_size;
+        }
+        assert(at == 15000);
+
+        wl_buffer_release_snapshot(snapshot);
+        wl_buffer_free_released_snapshots();
+        assert(last_child->ref_count == 1);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: The line buffer & piece table snapshots share the memory till an edit, and the piece table's add buffer stays shared after it
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_LINES);
+        WL_Buffer *b = &buffer;
+
+        char *line = "a line of text\n"; //NOTE: 15 bytes
+        for(int i = 0; i < 1000; ++i) {
+            addTextToBuffer(b, line, wl_buffer_get_size_in_bytes(b), false);
+        }
+
+        WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(b);
+        assert(snapshot->storage.lines == b->storage.line_buffer.lines && !snapshot->storage.line_buffer_to_free);
+
+        addTextToBuffer(b, "x", 15*500, false);
+        assert(snapshot->storage.line_buffer_to_free && snapshot->storage.lines != b->storage.line_buffer.lines);
+        assert(wl_buffer_get_byte(b, 15*500) == 'x' && wl_buffer_get_line_count(b) == 1001);
+        assert(wl_buffer_get_offset_of_line(b, 501) == 15*501 + 1);
+
+        s64 at = 0;
+        s64 span_size = 0;
+        WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+        while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+            for(s64 j = 0; j < span_size; ++j) {
+                assert(span[j] == line[(at + j) % 15]);
+            }
+            at += span_size;
+        }
+        assert(at == 15000);
+
+        wl_buffer_release_snapshot(snapshot);
+        wl_buffer_free_released_snapshots();
+        wl_emptyBuffer(b);
+
+        initBuffer(&buffer, WL_BUFFER_STORAGE_PIECE_TABLE);
+        addTextToBuffer(b, "hello", 0, false);
+
+        snapshot = wl_buffer_take_snapshot(b);
+        WL_Piece_Table_Add_Buffer *add_buffer = b->storage.piece_table.add_buffer;
+        assert(snapshot->storage.add_buffer == add_buffer && add_buffer->ref_count == 2);
+
+        //NOTE: Typing doesn't copy the add buffer, and growing it leaves the old one with the snapshot
+        addTextToBuffer(b, " world", 5, false);
+        assert(b->storage.piece_table.add_buffer == add_buffer);
+
+        for(int i = 0; i < PIECE_TABLE_ADD_BUFFER_START_SIZE / 15; ++i) {
+            addTextToBuffer(b, line, wl_buffer_get_size_in_bytes(b), false);
+        }
+        assert(b->storage.piece_table.add_buffer != add_buffer && add_buffer->ref_count == 1);
+
+        it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+        u8 *span = wl_buffer_snapshot_next_span(&it, &span_size);
+        assert(span_size == 5 && memcmp(span, "hello", 5) == 0 && !wl_buffer_snapshot_next_span(&it, &span_size));
+
+        wl_buffer_release_snapshot(snapshot);
+        wl_buffer_free_released_snapshots();
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: A big gap buffer isn't copied for a snapshot, it turns into a piece table reading the memory the snapshot has
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_GAP_BUFFER);
+        WL_Buffer *b = &buffer;
+
+        s64 size = 2*WL_BUFFER_SNAPSHOT_MAX_COPY_SIZE + 10;
+        u8 *text = (u8 *)platform_alloc_memory(size, false);
+        for(s64 i = 0; i < size; ++i) {
+            text[i] = ((i % 64) == 63) ? '\n' : (u8)('a' + (i % 26));
+        }
+        wl_buffer_insert_bytes(b, 0, text, size);
+        wl_buffer_insert_bytes(b, 1000, (u8 *)"gap", 3);
+        s64 line_count = wl_buffer_get_line_count(b);
+
+        WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(b);
+        u8 *memory = b->storage.gap_buffer.memory;
+        wl_buffer_insert_bytes(b, 100, (u8 *)"x", 1);
+
+        //NOTE: Both sides of the gap are still in the same memory
+        WL_Piece_Table *pt = &b->storage.piece_table;
+        assert(b->storage.type == WL_BUFFER_STORAGE_PIECE_TABLE && !wl_buffer_is_file_mapped(b));
+        assert(pt->original == memory && pt->original_memory->ref_count == 2 && pt->piece_count == 4);
+        assert(wl_buffer_get_size_in_bytes(b) == size + 4 && wl_buffer_get_line_count(b) == line_count);
+        assert(wl_buffer_get_byte(b, 100) == 'x' && wl_buffer_get_byte(b, 1001) == 'g' && wl_buffer_get_byte(b, size + 3) == text[size - 1]);
+        assert(memcmp(wl_buffer_copy_to_arena(b, 0, 100, &globalPerFrameArena), text, 100) == 0);
+
+        s64 at = 0;
+        s64 span_size = 0;
+        WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+        while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+            for(s64 i = 0; i < span_size; ++i, ++at) {
+                u8 expected = (at < 1000) ? text[at] : (at < 1003) ? "gap"[at - 1000] : text[at - 3];
+                assert(span[i] == expected);
+            }
+        }
+        assert(at == size + 3);
+
+        //NOTE: The buffer keeps the memory after the snapshot's gone
+        wl_buffer_release_snapshot(snapshot);
+        wl_buffer_free_released_snapshots();
+        assert(pt->original_memory->ref_count == 1);
+
+        //NOTE: The next snapshot shares it too
+        snapshot = wl_buffer_take_snapshot(b);
+        assert(pt->original_memory->ref_count == 2);
+        wl_buffer_remove_bytes(b, 0, 101);
+        assert(wl_buffer_get_size_in_bytes(b) == size + 4 - 101 && wl_buffer_get_byte(b, 0) == text[100]);
+
+        wl_buffer_release_snapshot(snapshot);
+        wl_buffer_free_released_snapshots();
+        wl_emptyBuffer(b);
+        platform_free_memory(text);
+    }
+
+    {
+        //NOTE: A line buffer that's been typed into past the rope size turns into a rope instead of being copied for a snapshot
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_LINES);
+        WL_Buffer *b = &buffer;
+
+        s64 size = WL_BUFFER_ROPE_MIN_FILE_SIZE + 10;
+        u8 *text = (u8 *)platform_alloc_memory(size, false);
+        for(s64 i = 0; i < size; ++i) {
+            text[i] = ((i % 64) == 63) ? '\n' : (u8)('a' + (i % 26));
+        }
+        wl_buffer_insert_bytes(b, 0, text, size);
+        s64 line_count = wl_buffer_get_line_count(b);
+
+        WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(b);
+        wl_buffer_insert_bytes(b, 100, (u8 *)"x", 1);
+
+        assert(b->storage.type == WL_BUFFER_STORAGE_ROPE);
+        assert(wl_buffer_get_size_in_bytes(b) == size + 1 && wl_buffer_get_line_count(b) == line_count);
+        assert(wl_buffer_get_byte(b, 100) == 'x' && wl_buffer_get_byte(b, size) == text[size - 1]);
+        assert(memcmp(wl_buffer_copy_to_arena(b, 0, 100, &globalPerFrameArena), text, 100) == 0);
+
+        s64 at = 0;
+        s64 span_size = 0;
+        WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+        while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+            assert(memcmp(span, text + at, span_size) == 0);
+            at += span_size;
+        }
+        assert(at == size);
+
+        wl_buffer_release_snapshot(snapshot);
+        wl_buffer_free_released_snapshots();
+        wl_emptyBuffer(b);
+        platform_free_memory(text);
+    }
+
+    {
+        //NOTE: Working out the encoding of a file & turning it into utf8
+        s64 bom = 0;
+        u8 utf8_bom[] = {0xEF, 0xBB, 0xBF, 'h', 'i'};
+        assert(encoding_detect(utf8_bom, sizeof(utf8_bom), &bom) == WL_TEXT_ENCODING_UTF8 && bom == 3);
+
+        u8 utf16_le_bom[] = {0xFF, 0xFE, 'h', 0, 'i', 0};
+        assert(encoding_detect(utf16_le_bom, sizeof(utf16_le_bom), &bom) == WL_TEXT_ENCODING_UTF16_LE && bom == 2);
+
+        u8 utf16_be_bom[] = {0xFE, 0xFF, 0, 'h', 0, 'i'};
+        assert(encoding_detect(utf16_be_bom, sizeof(utf16_be_bom), &bom) == WL_TEXT_ENCODING_UTF16_BE && bom == 2);
+
+        //NOTE: No BOM
+        u8 utf16_le[] = {'h', 0, 'e', 0, 'l', 0, 'l', 0, 'o', 0, '\n', 0};
+        assert(encoding_detect(utf16_le, sizeof(utf16_le), &bom) == WL_TEXT_ENCODING_UTF16_LE && bom == 0);
+        assert(encoding_detect(utf16_le + 1, sizeof(utf16_le) - 1, &bom) == WL_TEXT_ENCODING_UTF16_BE && bom == 0);
+
+        u8 latin1[] = {'c', 'a', 'f', 0xE9, '\n'};
+        assert(encoding_detect(latin1, sizeof(latin1), &bom) == WL_TEXT_ENCODING_LATIN1 && bom == 0);
+
+        char *utf8 = "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80";
+        assert(encoding_detect((u8 *)utf8, easyString_getSizeInBytes_utf8(utf8), &bom) == WL_TEXT_ENCODING_UTF8 && bom == 0);
+
+        //NOTE: Every way of checking has to agree, with the bad bytes both in the first block and after it
+        char *tests[] = {
+            "ascii only", "caf\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBF", "\xEF\xBF\xBF",
+            "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xF0\x80\x80\xAF", //NOTE: Overlong
+            "\xED\xA0\x80", "\xED\xBF\xBF", //NOTE: Surrogates
+            "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF", //NOTE: Past 0x10FFFF
+            "\xC3", "\xE2\x82", "\xF0\x9F\x98", "\x80", "\xC3\xA9\xA9", "\xE2\x82\xAC\x80", //NOTE: Too short & too long
+        };
+
+        for(int i = 0; i < arrayCount(tests); ++i) {
+            for(int offset = 0; offset < 70; ++offset) {
+                u8 text[128];
+                memset(text, 'a', sizeof(text));
+                s64 size = easyString_getSizeInBytes_utf8(tests[i]);
+                memcpy(text + offset, tests[i], size);
+                size += offset;
+
+                bool is_valid = encoding_is_valid_utf8_scalar(text, size);
+                assert(is_valid == (i < 6));
+                assert(encoding_is_valid_utf8_sse2(text, size) == is_valid);
+                assert(encoding_is_valid_utf8(text, size) == is_valid);
+                if(platform_cpu_has_avx2()) {
+                    assert(encoding_is_valid_utf8_avx2(text, size) == is_valid);
+                }
+            }
+        }
+
+        u8 out[64];
+        //NOTE: Surrogate pair, then a lone surrogate and an odd byte which both become the replacement character
+        u8 utf16[] = {'a', 0, 0xE9, 0, 0xAC, 0x20, 0x3D, 0xD8, 0x00, 0xDE, 0x00, 0xD8, 'b', 0, 'c'};
+        s64 out_size = encoding_transcode_to_utf8(WL_TEXT_ENCODING_UTF16_LE, utf16, sizeof(utf16), out);
+        assert(out_size <= encoding_get_max_utf8_size(WL_TEXT_ENCODING_UTF16_LE, sizeof(utf16)));
+        out[out_size] = '\0';
+        assert(easyString_stringsMatch_nullTerminated((char *)out, "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xEF\xBF\xBD" "b\xEF\xBF\xBD"));
+
+        //NOTE: Long enough to go through the ascii fast path
+        u8 utf16_be_long[40];
+        for(int i = 0; i < 20; ++i) {
+            utf16_be_long[2*i] = 0;
+            utf16_be_long[2*i + 1] = (u8)('a' + i);
+        }
+        out_size = encoding_transcode_to_utf8(WL_TEXT_ENCODING_UTF16_BE, utf16_be_long, sizeof(utf16_be_long), out);
+        out[out_size] = '\0';
+        assert(easyString_stringsMatch_nullTerminated((char *)out, "abcdefghijklmnopqrst"));
+
+        out_size = encoding_transcode_to_utf8(WL_TEXT_ENCODING_LATIN1, latin1, sizeof(latin1), out);
+        out[out_size] = '\0';
+        assert(easyString_stringsMatch_nullTerminated((char *)out, "caf\xC3\xA9\n"));
+
+        //NOTE: Bad bytes in a utf8 file get read as Latin-1
+        char *bad_utf8 = "\xC3\xA9\xE9";
+        out_size = encoding_transcode_to_utf8(WL_TEXT_ENCODING_UTF8, (u8 *)bad_utf8, 3, out);
+        out[out_size] = '\0';
+        assert(easyString_stringsMatch_nullTerminated((char *)out, "\xC3\xA9\xC3\xA9"));
+
+        //NOTE: Don't cut a surrogate pair or a codepoint in half
+        assert(encoding_get_chunk_end(WL_TEXT_ENCODING_UTF16_LE, utf16, 0, 9) == 6);
+        assert(encoding_get_chunk_end(WL_TEXT_ENCODING_UTF16_LE, utf16, 0, 10) == 10);
+        assert(encoding_get_chunk_end(WL_TEXT_ENCODING_UTF8, (u8 *)utf8, 0, 13) == 10);
+    }
+
+    {
+        //NOTE: The SSE2 string functions have to give the same answers as the scalar ones, wherever the string starts in its 16 byte block
+        char *pieces[] = {"a", "word ", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\n", "0123456789abcdefghij"};
+        
+        u32 codepoint_test_seed = 1;
+        for(int test = 0; test < 200; ++test) {
+            char text[256];
+            int offset = test % 16;
+            int size = 0;
+            int max_size = test % 200;
+            while(size < max_size) {
+                codepoint_test_seed = codepoint_test_seed*1103515245 + 12345;
+                char *piece = pieces[(codepoint_test_seed >> 16) % arrayCount(pieces)];
+                int piece_size = easyString_getSizeInBytes_utf8_scalar(piece);
+                memcpy(text + offset + size, piece, piece_size);
+                size += piece_size;
+            }
+            text[offset + size] = '\0';
+            char *str = text + offset;
+
+            assert(easyString_getSizeInBytes_utf8(str) == size);
+            assert(easyString_getStringLength_utf8(str) == easyString_getStringLength_utf8_scalar(str));
+
+            for(int start = 0; start < size; start += 7) {
+                assert(easyString_getAsciiRunLength_utf8(str + start, size - start) == easyString_getAsciiRunLength_utf8_scalar(str + start, size - start));
+            }
+
+            u32 runes[256];
+            u32 runes_scalar[256];
+            int rune_count = easyUnicode_utf8StreamToUtf32Stream(str, size, runes);
+            assert(rune_count == easyUnicode_utf8StreamToUtf32Stream_scalar(str, size, runes_scalar));
+            assert(rune_count == easyString_getStringLength_utf8(str));
+            for(int i = 0; i < rune_count; ++i) {
+                assert(runes[i] == runes_scalar[i]);
+            }
+        }
+
+        char *str = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+        u32 *runes = easyUnicode_utf8StreamToUtf32Stream_allocates(str);
+        assert(runes[0] == 'a' && runes[1] == 0xE9 && runes[2] == 0x20AC && runes[3] == 0x1F600 && runes[4] == 0);
+        easyString_free_Utf32_string((char *)runes);
+    }
+
+    {
+        //NOTE: The undo text lives in chunks that only get added to, undoing then typing something new keeps the redo blocks
+        UndoRedoState state = {};
+        init_undo_redo_state(&state);
+
+        for(int i = 0; i < 1000; ++i) {
+            push_block(&state, UNDO_REDO_INSERT, i, "abc", 3, i);
+        }
+        assert(state.block_count == 1000 && state.total_block_count >= 1000);
+        assert(state.first_chunk == state.current_chunk); //NOTE: All fit in the first chunk
+        assert(state.first_chunk->used_in_bytes == 4*1000); //NOTE: Plus one for the null terminators
+
+        for(int i = 0; i < 500; ++i) {
+            UndoRedoBlock *block = get_undo_block(&state);
+            assert(block->byteAt == 999 - i && easyString_stringsMatch_nullTerminated(block->string, "abc"));
+        }
+
+        //NOTE: A new branch off the block we undid back to, the text goes on the end
+        char *removed = push_block_reserve(&state, UNDO_REDO_DELETE, 10, 2, 10);
+        memcpy(removed, "xy", 2);
+        assert(state.block_count == 1001 && state.first_chunk->used_in_bytes == 4*1000 + 3);
+        assert(removed == (char *)undoRedo_get_chunk_memory(state.first_chunk) + 4*1000);
+        assert(state.current == 1000 && state.history[1000].parent == 499 && state.history[1000].depth == 501);
+        assert(easyString_stringsMatch_nullTerminated(state.history[500].string, "abc"));
+
+        UndoRedoBlock *block = get_undo_block(&state);
+        assert(block->type == UNDO_REDO_DELETE && easyString_stringsMatch_nullTerminated(block->string, "xy"));
+        block = get_redo_block(&state);
+        assert(block->id == state.idAt);
+
+        //NOTE: Too big for a normal chunk gets its own one
+        s64 big_size = UNDO_REDO_CHUNK_SIZE_IN_BYTES + 100;
+        char *big = push_block_reserve(&state, UNDO_REDO_INSERT, 0, big_size, 0);
+        memset(big, 'b', big_size);
+        assert(state.current_chunk != state.first_chunk && state.current_chunk->size_in_bytes >= big_size + 1);
+        UndoRedoChunk *big_chunk = state.current_chunk;
+
+        push_block(&state, UNDO_REDO_INSERT, 0, "after", 5, 0);
+        assert(state.current_chunk != big_chunk);
+        assert(easyString_stringsMatch_nullTerminated(state.history[state.block_count - 1].string, "after"));
+
+        UndoRedoChunk *after_chunk = state.current_chunk;
+
+        get_undo_block(&state);
+        get_undo_block(&state);
+        push_block(&state, UNDO_REDO_INSERT, 0, "small", 5, 0);
+        assert(state.current_chunk == after_chunk && after_chunk->used_in_bytes == 12 && big_chunk->used_in_bytes == big_size + 1);
+        assert(state.history[state.current].parent == 1000);
+
+        free_undo_redo_state(&state);
+        assert(!state.first_chunk && !state.history);
+    }
+
+    {
+        //NOTE: Typing joins onto one undo block until a word starts after a space, the typing pauses or the cursor moves somewhere else
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_GAP_BUFFER);
+        WL_Buffer *b = &buffer;
+        UndoRedoState *state = &b->undo_redo_state;
+
+        char *typing = "hello world";
+        for(int i = 0; typing[i]; ++i) {
+            addTypedTextToBuffer(b, typing + i, 1, wl_buffer_get_cursor(b));
+        }
+        assert(state->block_count == 2);
+        assert(easyString_stringsMatch_nullTerminated(state->history[0].string, "hello "));
+        assert(easyString_stringsMatch_nullTerminated(state->history[1].string, "world") && state->history[1].byteAt == 6);
+
+        //NOTE: Backspacing "rld" is one block at the front of where it was
+        for(int i = 0; i < 3; ++i) {
+            s64 cursor = wl_buffer_get_cursor(b);
+            removeTypedTextFromBuffer(b, cursor - 1, 1);
+        }
+        assert(state->block_count == 3);
+        assert(state->history[2].type == UNDO_REDO_DELETE && state->history[2].byteAt == 8);
+        assert(easyString_stringsMatch_nullTerminated(state->history[2].string, "rld"));
+
+        //NOTE: A pause starts a new block
+        undoRedo_advance_time(2*UNDO_REDO_COALESCE_SECONDS);
+        removeTypedTextFromBuffer(b, 7, 1);
+        assert(state->block_count == 4);
+
+        //NOTE: Typing somewhere else
+        addTypedTextToBuffer(b, "x", 1, 0);
+        addTypedTextToBuffer(b, "y", 1, 5);
+        assert(state->block_count == 6);
+
+        //NOTE: Undo takes the whole block back
+        UndoRedoBlock *block = get_undo_block(state);
+        removeTextFromBuffer(b, block->byteAt, block->stringLength, false);
+        block = get_undo_block(state);
+        removeTextFromBuffer(b, block->byteAt, block->stringLength, false);
+        block = get_undo_block(state);
+        addTextToBuffer_withSize(b, block->string, block->stringLength, block->byteAt, false);
+        block = get_undo_block(state);
+        addTextToBuffer_withSize(b, block->string, block->stringLength, block->byteAt, false);
+        assert(wl_buffer_get_size_in_bytes(b) == 11);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, 11, &globalPerFrameArena), "hello world"));
+
+        //NOTE: Typing after an undo doesn't join onto the block before it
+        addTypedTextToBuffer(b, "!", 1, 11);
+        assert(state->block_count == 7 && state->history[6].parent == 1);
+
+        //NOTE: Nor after a save
+        undoRedo_stop_coalescing(state);
+        addTypedTextToBuffer(b, "!", 1, 12);
+        assert(state->block_count == 8);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: Replaying the undo journal on top of the same text gets back the same text & history
+        char *file_text = "int main() {\n}\n";
+        s64 file_size = easyString_getSizeInBytes_utf8(file_text);
+
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+        addTextToBuffer(b, file_text, 0, false);
+
+        WL_Undo_Journal *journal = undoJournal_create(0);
+        undoJournal_start(journal, &b->undo_redo_state, wl_buffer_get_size_in_bytes(b), 1234, 0, 0);
+
+        char *typing = "return 0;";
+        for(int i = 0; typing[i]; ++i) {
+            addTypedTextToBuffer(b, typing + i, 1, 13 + i);
+        }
+        removeTypedTextFromBuffer(b, 21, 1);
+        addTextToBuffer(b, "\n\t", 13);
+        removeTextFromBuffer(b, 0, 4);
+
+        //NOTE: Undo the last two, redo one
+        UndoRedoBlock *block = get_undo_block(&b->undo_redo_state);
+        addTextToBuffer_withSize(b, block->string, block->stringLength, block->byteAt, false);
+        block = get_undo_block(&b->undo_redo_state);
+        removeTextFromBuffer(b, block->byteAt, block->stringLength, false);
+        block = get_redo_block(&b->undo_redo_state);
+        addTextToBuffer_withSize(b, block->string, block->stringLength, block->byteAt, false);
+
+        s64 size = wl_buffer_get_size_in_bytes(b);
+        char *text = wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena);
+        assert(easyString_stringsMatch_nullTerminated(text, "int main() {\n\n\treturn 0}\n"));
+
+        WL_Buffer replayed_buffer;
+        initBuffer(&replayed_buffer);
+        WL_Buffer *r = &replayed_buffer;
+        addTextToBuffer(r, file_text, 0, false);
+
+        //NOTE: Not the same file
+        WL_Undo_Journal_Replay replay = undoJournal_replay(r, journal->pending.memory, journal->pending.size_in_bytes, file_size, 999);
+        assert(!replay.replayed && wl_buffer_get_size_in_bytes(r) == file_size);
+
+        replay = undoJournal_replay(r, journal->pending.memory, journal->pending.size_in_bytes, file_size, 1234);
+        assert(replay.replayed && replay.good_size_in_bytes == journal->pending.size_in_bytes && !replay.matches_base);
+        assert(wl_buffer_get_size_in_bytes(r) == size);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(r, 0, size, &globalPerFrameArena), text));
+
+        UndoRedoState *a_state = &b->undo_redo_state;
+        UndoRedoState *r_state = &r->undo_redo_state;
+        assert(a_state->block_count == r_state->block_count && a_state->current == r_state->current && a_state->idAt == r_state->idAt);
+        for(int i = 0; i < a_state->block_count; ++i) {
+            UndoRedoBlock *x = &a_state->history[i];
+            UndoRedoBlock *y = &r_state->history[i];
+            assert(x->type == y->type && x->byteAt == y->byteAt && x->stringLength == y->stringLength && x->id == y->id && x->groupId == y->groupId);
+            assert(x->parent == y->parent && x->redo_child == y->redo_child && x->depth == y->depth && x->jump == y->jump);
+            assert(easyString_stringsMatch_nullTerminated(x->string, y->string));
+        }
+
+        //NOTE: Undoing it all from the replayed history gets back to the file
+        while(UndoRedoBlock *undo = get_undo_block(r_state)) {
+            wl_buffer_apply_undo_block(r, undo, false);
+        }
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(r, 0, file_size, &globalPerFrameArena), file_text));
+        wl_emptyBuffer(r);
+
+        //NOTE: Crashed halfway through writing a record, we get everything before it. The last three are the undo, undo & redo, 
+        //      so this cuts the record removing "int " in half.
+        initBuffer(r);
+        addTextToBuffer(r, file_text, 0, false);
+        s64 cut_size = journal->pending.size_in_bytes - 7 - 5;
+        replay = undoJournal_replay(r, journal->pending.memory, cut_size, file_size, 1234);
+        assert(replay.replayed && replay.good_size_in_bytes < cut_size);
+        assert(r->undo_redo_state.block_count == a_state->block_count - 1 && r->undo_redo_state.current == r->undo_redo_state.block_count - 1);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(r, 0, size, &globalPerFrameArena), text));
+        wl_emptyBuffer(r);
+
+        //NOTE: Saving starts the journal again from the saved text, the edits while it saves go in both
+        undoJournal_begin_rebase(journal, a_state, size, a_state->idAt);
+        addTypedTextToBuffer(b, "x", 1, 0);
+        undoJournal_end_rebase(journal, true, 5678);
+        assert(journal->rebase_ready && journal->pending.size_in_bytes == 0);
+
+        initBuffer(r);
+        addTextToBuffer(r, text, 0, false);
+        replay = undoJournal_replay(r, journal->rebase.memory, journal->rebase.size_in_bytes, size, 5678);
+        assert(replay.replayed && !replay.matches_base && replay.base_undo_redo_id == a_state->idAt - 1);
+        assert(wl_buffer_get_size_in_bytes(r) == size + 1 && wl_buffer_get_byte(r, 0) == 'x');
+        assert(r->undo_redo_state.block_count == a_state->block_count);
+
+        //NOTE: Undoing the x gets back to the saved text
+        block = get_undo_block(&r->undo_redo_state);
+        wl_buffer_apply_undo_block(r, block, false);
+        assert(wl_buffer_get_size_in_bytes(r) == size && wl_buffer_get_byte(r, 0) == 'i');
+
+        wl_emptyBuffer(r);
+
+        b->undo_redo_state.journal = 0;
+        undoJournal_free(journal);
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: Undoing then making a new edit keeps the redo blocks as another branch of the undo tree
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+        UndoRedoState *state = &b->undo_redo_state;
+
+        WL_Undo_Journal *journal = undoJournal_create(0);
+        undoJournal_start(journal, state, 0, 1, 0, 0);
+
+        addTextToBuffer(b, "one", 0);
+        addTextToBuffer(b, " two", 3);
+        wl_buffer_apply_undo_block(b, get_undo_block(state), false);
+        addTextToBuffer(b, " three", 3);
+        assert(state->block_count == 3 && state->current == 2 && state->history[2].parent == 0 && !see_redo_block(state));
+        assert(state->history[0].first_child == 2 && state->history[2].next_sibling == 1);
+
+        //NOTE: Redo goes back down the branch we came from, the next branch goes down the other one
+        wl_buffer_apply_undo_block(b, get_undo_block(state), false);
+        assert(see_redo_block(state) == &state->history[2]);
+        assert(undoRedo_next_redo_branch(state));
+        UndoRedoBlock *block = get_redo_block(state);
+        wl_buffer_apply_undo_block(b, block, true);
+        assert(block == &state->history[1] && undoRedo_get_current_id(state) == block->id);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, 7, &globalPerFrameArena), "one two"));
+
+        //NOTE: Jumping across to the other branch, back to before any edits, then back again
+        wl_buffer_jump_to_revision(b, 2);
+        assert(state->current == 2 && wl_buffer_get_size_in_bytes(b) == 9);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, 9, &globalPerFrameArena), "one three"));
+        wl_buffer_jump_to_revision(b, -1);
+        assert(state->current == -1 && wl_buffer_get_size_in_bytes(b) == 0 && see_redo_block(state) == &state->history[0]);
+        wl_buffer_jump_to_revision(b, 1);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, 7, &globalPerFrameArena), "one two"));
+
+        //NOTE: The journal gets back the same tree & where we were in it
+        WL_Buffer replayed_buffer;
+        initBuffer(&replayed_buffer);
+        WL_Buffer *r = &replayed_buffer;
+        WL_Undo_Journal_Replay replay = undoJournal_replay(r, journal->pending.memory, journal->pending.size_in_bytes, 0, 1);
+        assert(replay.replayed && replay.good_size_in_bytes == journal->pending.size_in_bytes);
+        assert(r->undo_redo_state.block_count == 3 && r->undo_redo_state.current == 1 && r->undo_redo_state.history[2].parent == 0);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(r, 0, 7, &globalPerFrameArena), "one two"));
+        wl_emptyBuffer(r);
+
+        b->undo_redo_state.journal = 0;
+        undoJournal_free(journal);
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: Jumping a long way through the undo tree starts from a checkpoint, and gets the same text as going a block at a time
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+        UndoRedoState *state = &b->undo_redo_state;
+
+        int count = 3*UNDO_REDO_CHECKPOINT_INTERVAL + 10;
+        for(int i = 0; i < count; ++i) {
+            char letter[2] = { (char)('a' + (i % 26)), 0 };
+            addTextToBuffer(b, letter, wl_buffer_get_cursor(b));
+        }
+        s32 first_tip = state->current;
+        char *first_text = wl_buffer_copy_to_arena(b, 0, count, &globalPerFrameArena);
+        float first_time = global_undo_redo_time_in_seconds;
+        assert(state->history[UNDO_REDO_CHECKPOINT_INTERVAL - 1].checkpoint && state->history[2*UNDO_REDO_CHECKPOINT_INTERVAL - 1].checkpoint);
+        assert(!state->history[UNDO_REDO_CHECKPOINT_INTERVAL].checkpoint && state->checkpoint_bytes > 0);
+
+        //NOTE: Once they're compressed they let go of their snapshots, the text repeats so they're a lot smaller
+        wl_buffer_update_undo_checkpoints(b, true);
+        UndoRedoCheckpoint *second_checkpoint = state->history[2*UNDO_REDO_CHECKPOINT_INTERVAL - 1].checkpoint;
+        assert(!state->compressing_checkpoints && !second_checkpoint->snapshot && second_checkpoint->compressed);
+        assert(second_checkpoint->size_in_bytes == 2*UNDO_REDO_CHECKPOINT_INTERVAL && second_checkpoint->compressed_size_in_bytes < second_checkpoint->size_in_bytes);
+        assert(state->checkpoint_bytes < 3*UNDO_REDO_CHECKPOINT_INTERVAL);
+
+        //NOTE: Undo most of it and make another long branch
+        for(int i = 0; i < count - 20; ++i) {
+            wl_buffer_apply_undo_block(b, get_undo_block(state), false);
+        }
+        undoRedo_advance_time(10.0f);
+        for(int i = 0; i < count; ++i) {
+            char digit[2] = { (char)('0' + (i % 10)), 0 };
+            addTextToBuffer(b, digit, wl_buffer_get_cursor(b));
+        }
+        s32 second_tip = state->current;
+        s64 second_size = wl_buffer_get_size_in_bytes(b);
+        char *second_text = wl_buffer_copy_to_arena(b, 0, second_size, &globalPerFrameArena);
+
+        assert(undoRedo_get_common_ancestor(state, first_tip, second_tip) == 19);
+        assert(undoRedo_get_common_ancestor(state, first_tip, 500) == 500 && undoRedo_get_common_ancestor(state, -1, second_tip) == -1);
+        for(s32 depth = 0; depth <= count; depth += 37) {
+            s32 at = first_tip;
+            while(undoRedo_get_depth(state, at) > depth) { at = state->history[at].parent; }
+            assert(undoRedo_get_ancestor_at_depth(state, first_tip, depth) == at);
+        }
+
+        wl_buffer_jump_to_revision(b, first_tip);
+        assert(state->current == first_tip && wl_buffer_get_size_in_bytes(b) == count);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, count, &globalPerFrameArena), first_text));
+
+        wl_buffer_jump_to_revision(b, second_tip);
+        assert(state->current == second_tip && wl_buffer_get_size_in_bytes(b) == second_size);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, second_size, &globalPerFrameArena), second_text));
+
+        //NOTE: Going a block at a time gets the same
+        bool walked = wl_buffer_walk_to_revision(b, first_tip);
+        assert(walked && easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, count, &globalPerFrameArena), first_text));
+
+        //NOTE: Back to how it was before the second branch was made
+        wl_buffer_jump_to_revision(b, second_tip);
+        assert(undoRedo_find_revision_at_time(state, first_time) == first_tip);
+        wl_buffer_jump_to_time(b, first_time);
+        assert(state->current == first_tip && easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, count, &globalPerFrameArena), first_text));
+
+        wl_emptyBuffer(b);
+        wl_buffer_free_released_snapshots();
+    }
+
+    {
+        //NOTE: The checkpoint's taken after its block's edit so it shares the buffer's text. Typing or backspacing that carries on 
+        //      onto the block after that still gets put back when jumping to it from the checkpoint.
+        for(int kind = 0; kind < 2; ++kind) {
+            WL_Buffer buffer;
+            initBuffer(&buffer);
+            WL_Buffer *b = &buffer;
+            UndoRedoState *state = &b->undo_redo_state;
+
+            //NOTE: Big enough for a few pieces, some that compress & some that don't
+            s64 start_size = 200000;
+            char *start = (char *)pushArray(&globalPerFrameArena, start_size, char);
+            u32 random = 12345;
+            for(s64 i = 0; i < start_size; ++i) {
+                random = random*1103515245 + 12345;
+                start[i] = (i < start_size / 2) ? (char)('a' + ((random >> 16) % 26)) : (char)('a' + (i % 26));
+            }
+            addTextToBuffer_withSize(b, start, start_size, 0);
+
+            for(int i = 1; i < UNDO_REDO_CHECKPOINT_INTERVAL - 1; ++i) {
+                addTextToBuffer(b, "x", wl_buffer_get_cursor(b));
+            }
+
+            for(int i = 0; i < 3; ++i) {
+                if(kind == 0) {
+                    addTypedTextToBuffer(b, "a", 1, wl_buffer_get_cursor(b));
+                } else {
+                    removeTypedTextFromBuffer(b, wl_buffer_get_cursor(b) - 1, 1);
+                }
+
+                if(i == 0) {
+                    UndoRedoCheckpoint *checkpoint = state->history[state->current].checkpoint;
+                    assert(checkpoint && checkpoint->snapshot == b->current_snapshot && checkpoint->stringLength == 1);
+                }
+            }
+
+            s32 typed = state->current;
+            assert(undoRedo_get_depth(state, typed) == UNDO_REDO_CHECKPOINT_INTERVAL && state->history[typed].stringLength == 3);
+            s64 typed_size = wl_buffer_get_size_in_bytes(b);
+            char *typed_text = wl_buffer_copy_to_arena(b, 0, typed_size, &globalPerFrameArena);
+
+            for(int i = 0; i < UNDO_REDO_CHECKPOINT_INTERVAL + 10; ++i) {
+                addTextToBuffer(b, "y", wl_buffer_get_cursor(b));
+            }
+            wl_buffer_update_undo_checkpoints(b, true);
+
+            wl_buffer_jump_to_revision(b, typed);
+            assert(state->current == typed && wl_buffer_get_size_in_bytes(b) == typed_size);
+            assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, typed_size, &globalPerFrameArena), typed_text));
+
+            wl_emptyBuffer(b);
+            wl_buffer_free_released_snapshots();
+        }
+    }
+
+    {
+        //NOTE: The LZ codec gets back what it was given, for text that repeats, bytes that don't & ones too small to have a match
+        s64 size = 200000;
+        u8 *text = (u8 *)platform_alloc_memory(size, false);
+        u8 *compressed = (u8 *)platform_alloc_memory(lz_get_max_compressed_size(size), false);
+        u8 *back = (u8 *)platform_alloc_memory(size, false);
+
+        u32 random = 12345;
+        for(int kind = 0; kind < 3; ++kind) {
+            for(s64 i = 0; i < size; ++i) {
+                random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+                if(kind == 0) {
+                    text[i] = "static void undo(int at) {\n"[i % 27] + ((i / 1000) % 3);
+                } else if(kind == 1) {
+                    text[i] = (u8)random;
+                } else {
+                    text[i] = 'a';
+                }
+            }
+
+            s64 compressed_size = lz_compress(text, size, compressed, lz_get_max_compressed_size(size));
+            assert(compressed_size > 0 && compressed_size <= lz_get_max_compressed_size(size));
+            if(kind != 1) {
+                assert(compressed_size < size / 10);
+            }
+
+            assert(lz_decompress(compressed, compressed_size, back, size));
+            assert(memcmp(text, back, size) == 0);
+
+            //NOTE: Cut short or not enough room isn't good data
+            assert(!lz_decompress(compressed, compressed_size - 1, back, size));
+            assert(!lz_decompress(compressed, compressed_size, back, size - 1));
+
+            //NOTE: Doesn't write past the end if there isn't enough room
+            assert(lz_compress(text, size, compressed, (kind == 1) ? size / 2 : 4) == -1);
+        }
+
+        for(s64 small_size = 0; small_size < 40; ++small_size) {
+            s64 compressed_size = lz_compress(text, small_size, compressed, lz_get_max_compressed_size(small_size));
+            assert(compressed_size > 0);
+            assert(lz_decompress(compressed, compressed_size, back, small_size));
+            assert(memcmp(text, back, small_size) == 0);
+        }
+
+        platform_free_memory(text);
+        platform_free_memory(compressed);
+        platform_free_memory(back);
+    }
+
+    {
+        //NOTE: Over the budget the old undo text gets compressed, then spilled to a file, and undo & redo still get it all back
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_GAP_BUFFER);
+        WL_Buffer *b = &buffer;
+        UndoRedoState *state = &b->undo_redo_state;
+
+        state->memory_budget_in_bytes = UNDO_REDO_CHUNK_SIZE_IN_BYTES;
+        state->can_spill_to_file = false;
+
+        int block_count = 400;
+        s64 line_size = 1000;
+        char *line = (char *)pushArray(&globalPerFrameArena, line_size + 1, char);
+        for(int i = 0; i < block_count; ++i) {
+            for(s64 j = 0; j < line_size; ++j) {
+                line[j] = 'a' + ((i + j) % 26);
+            }
+            line[line_size] = '\0';
+            addTextToBuffer(b, line, wl_buffer_get_size_in_bytes(b));
+        }
+
+        s64 size = wl_buffer_get_size_in_bytes(b);
+        char *text = wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena);
+        assert(size == block_count*line_size && state->uncompressed_bytes > 5*UNDO_REDO_CHUNK_SIZE_IN_BYTES);
+
+        //NOTE: Nothing happens till the chunks haven't been used for a bit
+        undoRedo_update(state);
+        while(state->compressing_bytes > 0) { undoRedo_update(state); }
+        assert(state->cold_bytes == 0 && !state->history[0].chunk->compressing_into);
+
+        undoRedo_advance_time(UNDO_REDO_COLD_SECONDS);
+        undoRedo_update(state);
+        while(state->compressing_bytes > 0) { undoRedo_update(state); }
+
+        assert(state->uncompressed_bytes <= state->memory_budget_in_bytes && state->cold_bytes > 0);
+        assert(state->compressed_bytes < state->cold_bytes / 4 && state->spill_size_in_bytes == 0);
+        assert(!state->history[0].string && !state->history[0].chunk->memory && state->history[block_count - 1].string);
+
+        //NOTE: Reading the history without it going back in memory, like the journal does
+        UndoRedo_Chunk_Reader reader = {};
+        for(int i = 0; i < block_count; ++i) {
+            char *string = undoRedo_read_block_string(state, &state->history[i], &reader);
+            assert(memcmp(string, text + i*line_size, line_size) == 0 && string[line_size] == '\0');
+        }
+        undoRedo_end_reading(&reader);
+        assert(!state->history[0].string);
+
+        for(int i = 0; i < block_count; ++i) {
+            wl_buffer_apply_undo_block(b, get_undo_block(state), false);
+        }
+        assert(wl_buffer_get_size_in_bytes(b) == 0 && state->cold_bytes == 0 && state->history[0].string);
+
+        //NOTE: The compressed copy gets kept, so letting go of them again doesn't compress again
+        s64 compressed_bytes = state->compressed_bytes;
+        undoRedo_advance_time(UNDO_REDO_COLD_SECONDS);
+        undoRedo_update(state);
+        assert(state->compressing_bytes == 0 && state->compressed_bytes == compressed_bytes && state->cold_bytes > 0);
+
+        //NOTE: Now they go out to the spill file
+        state->can_spill_to_file = true;
+        state->compressed_budget_in_bytes = 0;
+        undoRedo_update(state);
+        assert(state->spill_size_in_bytes == compressed_bytes && state->compressed_bytes == 0 && state->history[0].chunk->spill_offset == 0);
+
+        for(int i = 0; i < block_count; ++i) {
+            wl_buffer_apply_undo_block(b, get_redo_block(state), true);
+        }
+        assert(wl_buffer_get_size_in_bytes(b) == size);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena), text));
+
+        //NOTE: Jumping back through the checkpoints works on the spilled text too
+        undoRedo_advance_time(UNDO_REDO_COLD_SECONDS);
+        undoRedo_update(state);
+        while(state->compressing_bytes > 0) { undoRedo_update(state); }
+        wl_buffer_jump_to_revision(b, 9);
+        assert(wl_buffer_get_size_in_bytes(b) == 10*line_size);
+        assert(memcmp(wl_buffer_copy_to_arena(b, 0, 10*line_size, &globalPerFrameArena), text, 10*line_size) == 0);
+
+        wl_emptyBuffer(b);
+        wl_buffer_free_released_snapshots();
+    }
+
+    {
+        //NOTE: A transaction does all its edits at once, the same in every storage type, and undoes & redoes as one group
+        WL_Buffer_Storage_Type types[] = { WL_BUFFER_STORAGE_GAP_BUFFER, WL_BUFFER_STORAGE_LINES, WL_BUFFER_STORAGE_PIECE_TABLE, WL_BUFFER_STORAGE_ROPE };
+        for(int type_index = 0; type_index < arrayCount(types); ++type_index) {
+            //NOTE: Fewer edits than WL_BUFFER_STORAGE_REBUILD_MIN_EDIT_COUNT get done one at a time in the gap buffer too
+            int line_counts[] = { 10, 2000 };
+            for(int count_index = 0; count_index < arrayCount(line_counts); ++count_index) {
+                int line_count = line_counts[count_index];
+
+                WL_Buffer buffer;
+                initBuffer(&buffer, types[type_index]);
+                WL_Buffer *b = &buffer;
+
+                //NOTE: "  foo bar\n" on every line, then the foos get replaced & the indent gets swapped for a tab
+                for(int i = 0; i < line_count; ++i) {
+                    addTextToBuffer(b, "  foo bar\n", wl_buffer_get_size_in_bytes(b), false);
+                }
+                s64 size = wl_buffer_get_size_in_bytes(b);
+                char *before = wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena);
+
+                s64 line_size = 10;
+                WL_Anchor middle = anchorSet_add(&b->anchors, (line_count / 2)*line_size + 6, WL_ANCHOR_MOVES_WITH_INSERT);
+                wl_buffer_set_cursor(b, 0);
+
+                WL_Buffer_Transaction transaction = {};
+                for(int i = 0; i < line_count; ++i) {
+                    wl_buffer_transaction_add(&transaction, i*line_size, 2, "\t", 1);
+                    wl_buffer_transaction_add(&transaction, i*line_size + 2, 3, "quuux", 5);
+                }
+                wl_buffer_transaction_add(&transaction, size, 0, "end", 3);
+
+                u32 id_before = undoRedo_get_current_id(&b->undo_redo_state);
+                wl_buffer_commit_transaction(b, &transaction);
+                assert(!transaction.edits && transaction.edit_count == 0);
+
+                s64 new_line_size = 11;
+                s64 new_size = line_count*new_line_size + 3;
+                assert(wl_buffer_get_size_in_bytes(b) == new_size);
+                assert(wl_buffer_get_line_count(b) == line_count + 1);
+                for(int i = 0; i < line_count; i += 7) {
+                    assert(wl_buffer_get_offset_of_line(b, i) == i*new_line_size);
+                    char *line = wl_buffer_copy_to_arena(b, i*new_line_size, new_line_size, &globalPerFrameArena);
+                    assert(easyString_stringsMatch_nullTerminated(line, "\tquuux bar\n"));
+                }
+                char *after = wl_buffer_copy_to_arena(b, 0, new_size, &globalPerFrameArena);
+                assert(easyString_stringsMatch_nullTerminated(after + new_size - 4, "\nend"));
+
+                //NOTE: The anchor was on "bar" so it's still on it
+                assert(anchorSet_get_offset(&b->anchors, middle) == (line_count / 2)*new_line_size + 7);
+                assert(wl_buffer_get_cursor(b) == 0);
+
+                //NOTE: One undo takes it all back & one redo does it all again
+                UndoRedoBlock *block = wl_buffer_undo(b);
+                assert(block && undoRedo_get_current_id(&b->undo_redo_state) == id_before);
+                assert(wl_buffer_get_size_in_bytes(b) == size && wl_buffer_get_line_count(b) == line_count + 1);
+                assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena), before));
+                assert(anchorSet_get_offset(&b->anchors, middle) == (line_count / 2)*line_size + 6);
+                assert(!wl_buffer_undo(b));
+
+                block = wl_buffer_redo(b);
+                assert(block && !see_redo_block(&b->undo_redo_state));
+                assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, new_size, &globalPerFrameArena), after));
+                assert(wl_buffer_get_cursor(b) == new_size);
+
+                //NOTE: Going back through the tree a block at a time gets the same
+                bool walked = wl_buffer_walk_to_revision(b, -1);
+                assert(walked && easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena), before));
+
+                wl_emptyBuffer(b);
+            }
+        }
+        wl_buffer_free_released_snapshots();
+    }
+
+    {
+        //NOTE: Prettify swaps the indent at the start of each line for tabs, as one undo group
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_GAP_BUFFER);
+        WL_Buffer *b = &buffer;
+
+        char *text = "a {\n  b;\n\n\tc {\n\t\td;\n }\n}\n  ";
+        addTextToBuffer(b, text, 0);
+        u32 id_before = undoRedo_get_current_id(&b->undo_redo_state);
+
+        prettify_buffer(b);
+        char *pretty = "a {\n\tb;\n\t\n\tc {\n\t\td;\n\t}\n}\n";
+        s64 pretty_size = easyString_getSizeInBytes_utf8(pretty);
+        assert(wl_buffer_get_size_in_bytes(b) == pretty_size);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, pretty_size, &globalPerFrameArena), pretty));
+
+        //NOTE: Nothing to change the second time
+        u32 id_pretty = undoRedo_get_current_id(&b->undo_redo_state);
+        prettify_buffer(b);
+        assert(undoRedo_get_current_id(&b->undo_redo_state) == id_pretty);
+
+        wl_buffer_undo(b);
+        assert(undoRedo_get_current_id(&b->undo_redo_state) == id_before);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, wl_buffer_get_size_in_bytes(b), &globalPerFrameArena), text));
+
+        //NOTE: Worked out from a snapshot like the prettify thread does. The rope's snapshot is in lots of spans
+        WL_Buffer rope_buffer;
+        initBuffer(&rope_buffer, WL_BUFFER_STORAGE_ROPE);
+        WL_Buffer *r = &rope_buffer;
+        addTextToBuffer(r, text, 0, false);
+        for(int i = 0; i < 5000; ++i) {
+            addTextToBuffer(r, text, wl_buffer_get_size_in_bytes(r), false);
+            addTextToBuffer(b, text, wl_buffer_get_size_in_bytes(b), false);
+        }
+        prettify_buffer(b);
+        s64 size = wl_buffer_get_size_in_bytes(b);
+
+        WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(r);
+        WL_Buffer_Transaction transaction = {};
+        char *tabs = wl_buffer_prettify_snapshot(snapshot, &transaction);
+        assert(transaction.edit_count > 5000 && wl_buffer_snapshot_is_current(snapshot));
+        wl_buffer_release_snapshot(snapshot);
+
+        wl_buffer_commit_transaction(r, &transaction);
+        easyPlatform_freeMemory(tabs);
+
+        assert(wl_buffer_get_size_in_bytes(r) == size);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(r, 0, size, &globalPerFrameArena), wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena)));
+        assert(wl_buffer_get_line_count(r) == wl_buffer_get_line_count(b));
+
+        wl_emptyBuffer(r);
+        wl_emptyBuffer(b);
+        wl_buffer_free_released_snapshots();
+
+        //NOTE: Typing while the prettify job is working makes it start again from the new text, instead of losing it
+        WL_Open_Buffer open_buffer = {};
+        initBuffer(&open_buffer.buffer, WL_BUFFER_STORAGE_GAP_BUFFER);
+        b = &open_buffer.buffer;
+        addTextToBuffer(b, text, 0);
+
+        begin_prettify(&open_buffer);
+        addTextToBuffer(b, "  e;\n", 4);
+
+        while(!open_buffer.prettify_job->finished) {
+            platform_help_with_queued_work();
+        }
+        update_prettify(&open_buffer);
+        assert(open_buffer.prettify_job); //NOTE: Started again
+        assert(wl_buffer_get_size_in_bytes(b) == easyString_getSizeInBytes_utf8(text) + 5);
+
+        while(!open_buffer.prettify_job->finished) {
+            platform_help_with_queued_work();
+        }
+        update_prettify(&open_buffer);
+        assert(!open_buffer.prettify_job && !open_buffer.is_up_to_date);
+
+        char *pretty_typed = "a {\n\te;\n\tb;\n\t\n\tc {\n\t\td;\n\t}\n}\n";
+        s64 pretty_typed_size = easyString_getSizeInBytes_utf8(pretty_typed);
+        assert(wl_buffer_get_size_in_bytes(b) == pretty_typed_size);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, pretty_typed_size, &globalPerFrameArena), pretty_typed));
+
+        wl_emptyBuffer(b);
+        wl_buffer_free_released_snapshots();
+    }
+
+    {
+        //NOTE: Typing with lots of cursors is one edit at each of them & one undo group, and the cursors end up after what they typed
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_GAP_BUFFER);
+        WL_Buffer *b = &buffer;
+
+        Selectable_State state = {};
+
+        int line_count = 10000;
+        s64 line_size = 5;
+        for(int i = 0; i < line_count; ++i) {
+            addTextToBuffer(b, "line\n", wl_buffer_get_size_in_bytes(b), false);
+        }
+        s64 size = wl_buffer_get_size_in_bytes(b);
+        char *before = wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena);
+
+        //NOTE: Added backwards so they have to get sorted
+        wl_buffer_set_cursor(b, 0);
+        for(int i = line_count - 1; i > 0; --i) {
+            multiCursor_add(&state, b, i*line_size, i*line_size);
+        }
+
+        u32 id_before = undoRedo_get_current_id(&b->undo_redo_state);
+        multiCursor_replace_text(&state, b, "ab", 2, false);
+
+        s64 new_line_size = line_size + 2;
+        assert(wl_buffer_get_size_in_bytes(b) == line_count*new_line_size);
+        assert(wl_buffer_get_line_count(b) == line_count + 1);
+        assert(state.cursor_count == line_count - 1);
+        assert(wl_buffer_get_cursor(b) == 2);
+        for(int i = 0; i < state.cursor_count; ++i) {
+            assert(anchorSet_get_offset(&b->anchors, state.cursors[i].cursor) == (i + 1)*new_line_size + 2);
+            assert(anchorSet_get_offset(&b->anchors, state.cursors[i].select_start) == (i + 1)*new_line_size + 2);
+        }
+        char *line = wl_buffer_copy_to_arena(b, 500*new_line_size, new_line_size, &globalPerFrameArena);
+        assert(easyString_stringsMatch_nullTerminated(line, "abline\n"));
+
+        //NOTE: Backspace takes a rune out before each of them
+        multiCursor_replace_text(&state, b, 0, 0, true);
+        assert(wl_buffer_get_size_in_bytes(b) == line_count*(line_size + 1));
+        assert(wl_buffer_get_cursor(b) == 1);
+        assert(anchorSet_get_offset(&b->anchors, state.cursors[0].cursor) == (line_size + 1) + 1);
+
+        //NOTE: One undo for each key
+        wl_buffer_undo(b);
+        assert(wl_buffer_get_size_in_bytes(b) == line_count*new_line_size);
+        wl_buffer_undo(b);
+        assert(undoRedo_get_current_id(&b->undo_redo_state) == id_before);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena), before));
+
+        //NOTE: END moves them all to the end of their line, & cursors on the same place get merged into one
+        wl_buffer_set_cursor(b, 0);
+        for(int i = 0; i < state.cursor_count; ++i) {
+            anchorSet_set_offset(&b->anchors, state.cursors[i].cursor, (i + 1)*line_size);
+            anchorSet_set_offset(&b->anchors, state.cursors[i].select_start, (i + 1)*line_size);
+        }
+        multiCursor_move(&state, b, PLATFORM_KEY_END, false, false, 0, 0);
+        multiCursor_add(&state, b, 2*line_size + 4, 2*line_size + 4);
+        multiCursor_replace_text(&state, b, ";", 1, false);
+        assert(state.cursor_count == line_count - 1);
+        line = wl_buffer_copy_to_arena(b, 2*(line_size + 1), line_size + 1, &globalPerFrameArena);
+        assert(easyString_stringsMatch_nullTerminated(line, "line;\n"));
+        assert(wl_buffer_get_size_in_bytes(b) == size + line_count);
+        wl_buffer_undo(b);
+
+        //NOTE: A cursor for each line of the selection replaces just that line's bit of it
+        multiCursor_clear(&state, b);
+        end_select(&state);
+        update_select(&state, 2);
+        update_select(&state, 3*line_size + 2);
+        multiCursor_split_selection_into_lines(&state, b);
+        assert(state.cursor_count == 3);
+        multiCursor_replace_text(&state, b, "X", 1, false);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, 4*line_size - 8, &globalPerFrameArena), "liX\nX\nX\nXne\n"));
+        assert(wl_buffer_get_cursor(b) == 9 && !state.is_active);
+        wl_buffer_undo(b);
+
+        //NOTE: A cursor on each match with the match selected
+        size_t matches[3] = {0, 2*line_size, 7*line_size};
+        multiCursor_select_matches(&state, b, matches, 3, 4);
+        assert(state.cursor_count == 2);
+        multiCursor_replace_text(&state, b, "LINE!", 5, false);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, 4*line_size + 2, &globalPerFrameArena), "LINE!\nline\nLINE!\nline\n"));
+        assert(wl_buffer_get_cursor(b) == 5);
+        assert(anchorSet_get_offset(&b->anchors, state.cursors[1].cursor) == 7*line_size + 2 + 5);
+        wl_buffer_undo(b);
+        assert(easyString_stringsMatch_nullTerminated(wl_buffer_copy_to_arena(b, 0, size, &globalPerFrameArena), before));
+
+        multiCursor_free(&state, b);
+        wl_emptyBuffer(b);
+        wl_buffer_free_released_snapshots();
+    }
+
+    {
+        //NOTE: Threads get their own scratch arenas, and can all push onto an atomic arena at once without getting the same memory
+        Atomic_Arena shared = {};
+
+        s32 thread_count = 8;
+        s32 push_count = 100000;
+        DEBUG_Arena_Test_Work work[8];
+        for(int i = 0; i < thread_count; ++i) {
+            work[i].shared = &shared;
+            work[i].thread_index = i;
+            work[i].push_count = push_count;
+            work[i].pushed = (s32 **)platform_alloc_memory(push_count*sizeof(s32 *), false);
+        }
+
+        platform_do_work_in_parallel(DEBUG_arena_test_work, work, sizeof(DEBUG_Arena_Test_Work), thread_count);
+
+        for(int i = 0; i < thread_count; ++i) {
+            assert(work[i].scratch_ok);
+            for(int j = 0; j < push_count; ++j) {
+                assert(*work[i].pushed[j] == i*push_count + j);
+            }
+            platform_free_memory(work[i].pushed);
+        }
+
+        //NOTE: More than a block's worth in one push gets a block to itself
+        u8 *big = (u8 *)pushSizeAtomic(&shared, ATOMIC_ARENA_BLOCK_SIZE + 1);
+        big[ATOMIC_ARENA_BLOCK_SIZE] = 1;
+        assert(pushSizeAtomic(&shared, 1) != 0);
+
+        freeAtomicArena(&shared);
+        assert(!shared.current);
+
+        //NOTE: The calling thread does some of them too, so its scratch arenas are all let go
+        assert(scratchArenasAreReleased());
+    }
+
+    {
+        //NOTE: The line buffer finds rows through its line index, so they're right straight after an edit at the top of a big file
+        WL_Buffer buffer;
+        initBuffer(&buffer, WL_BUFFER_STORAGE_LINES);
+        WL_Buffer *b = &buffer;
+
+        s64 line_count = 20000;
+        char *text = (char *)pushArray(&globalPerFrameArena, (5*line_count + 1), char);
+        for(s64 i = 0; i < line_count; ++i) {
+            memcpy(text + 5*i, "line\n", 5);
+        }
+        text[5*line_count] = '\0';
+        addTextToBuffer(b, text, 0, false);
+
+        addTextToBuffer(b, "x\ny", 0, false);
+        assert(wl_buffer_get_line_count(b) == line_count + 2);
+        assert(wl_buffer_get_offset_of_line(b, line_count) == 8 + (line_count - 2)*5);
+        assert(wl_buffer_get_line_index(b, wl_buffer_get_size_in_bytes(b) - 1) == line_count);
+        assert(wl_buffer_get_line_start(b, wl_buffer_get_size_in_bytes(b) - 3) == 8 + (line_count - 2)*5);
+
+        removeTextFromBuffer(b, 0, 2, false);
+        assert(wl_buffer_get_line_count(b) == line_count + 1);
+        assert(wl_buffer_get_offset_of_line(b, line_count / 2) == 6 + (line_count / 2 - 1)*5);
+        assert(wl_buffer_get_line_index(b, 6 + (line_count / 2 - 1)*5 + 4) == line_count / 2);
+        assert(!b->storage.line_buffer.line_index.root->is_leaf);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: A multibyte sub string is found once whether it crosses the gap or sits right up against it
+        WL_Buffer buffer;
+        initBuffer(&buffer);
+        WL_Buffer *b = &buffer;
+
+        addTextToBuffer(b, "a\xC3\xA9" "b\xC3\xA9" "c\xC3\xA9", 0, false);
+        addTextToBuffer(b, "x", 3, false);
+        removeTextFromBuffer(b, 3, 1, false);
+
+        WL_Buffer_View view = wl_buffer_get_view(b, &globalPerFrameArena);
+        assert(view.span_sizes[0] == 3);
+
+        String_Query_Search_Results results = wl_buffer_view_find_sub_string(&view, "\xC3\xA9", &globalPerFrameArena);
+        assert(results.byteOffsetCount == 3 && results.byteOffsets[0] == 1 && results.byteOffsets[1] == 4 && results.byteOffsets[2] == 7);
+
+        results = wl_buffer_view_find_sub_string(&view, "\xC3\xA9" "b\xC3\xA9", &globalPerFrameArena);
+        assert(results.byteOffsetCount == 1 && results.byteOffsets[0] == 1);
+
+        results = wl_buffer_view_find_sub_string(&view, "b\xC3\xA9", &globalPerFrameArena);
+        assert(results.byteOffsetCount == 1 && results.byteOffsets[0] == 3);
+
+        wl_emptyBuffer(b);
+    }
+
+    {
+        //NOTE: A zero byte in the middle of a file doesn't cut off the rest of the chunk it arrives in
+        char file[] = "first line\n\0second line\nthird line\n";
+        s64 file_size = sizeof(file) - 1;
+
+        for(int step = 2; step < 40; step += 7) {
+            WL_Open_Buffer open_buffer = {};
+            initBuffer(&open_buffer.buffer);
+
+            File_Load *load = (File_Load *)platform_alloc_memory(sizeof(File_Load), true);
+            load->file_size_in_bytes = file_size;
+            load->memory = (u8 *)platform_alloc_memory(file_size, false);
+            open_buffer.file_load = load;
+
+            s64 bytes_read = 0;
+            while(open_buffer.file_load) {
+                if(bytes_read < file_size) {
+                    s64 size = (file_size - bytes_read < step) ? (file_size - bytes_read) : step;
+                    memcpy(load->memory + bytes_read, file + bytes_read, size);
+                    bytes_read += size;
+                    load->bytes_read = bytes_read;
+                    load->finished = (bytes_read == file_size);
+                }
+
+                update_file_load(&open_buffer);
+            }
+
+            WL_Buffer *b = &open_buffer.buffer;
+            assert(wl_buffer_get_size_in_bytes(b) == file_size);
+            assert(wl_buffer_get_line_count(b) == 4);
+            assert(memcmp(wl_buffer_copy_to_arena(b, 0, file_size, &globalPerFrameArena), file, file_size) == 0);
+
+            wl_emptyBuffer(b);
+        }
+    }
+
+    {
+        //NOTE: The debug heap tracking grows past its first table and finds every block again after others get removed
+        DEBUG_stats stats = {};
+        u8 memory[4000];
+        for(int i = 0; i < 4000; ++i) {
+            DEBUG_add_memory_block_size(&stats, memory + i, 1);
+        }
+        assert(stats.memory_block_count == 4000 && stats.total_heap_allocated == 4000);
+
+        for(int i = 0; i < 4000; i += 2) {
+            DEUBG_remove_memory_block_size(&stats, memory + i);
+        }
+        assert(stats.memory_block_count == 2000 && stats.total_heap_allocated == 2000);
+
+        for(int i = 1; i < 4000; i += 2) {
+            DEUBG_remove_memory_block_size(&stats, memory + i);
+        }
+        assert(stats.memory_block_count == 0 && stats.total_heap_allocated == 0);
+
+        HeapFree(GetProcessHeap(), 0, stats.memory_blocks);
+    }
+}
+//NOTE: Big enough that every offset past the 4GB mark needs 64 bits
+#define DEBUG_LARGE_FILE_SIZE_IN_BYTES (5LL*1024*1024*1024)
+
+//NOTE: Makes a 5GB file at path_utf8 and opens it like a big file gets opened. Only the text at the start, across the 4GB mark and at the end 
+//      gets written, and the file is made sparse first so on NTFS the rest hardly takes up any disk. The file gets deleted at the end. 
+//      Set DEBUG_LARGE_FILE_TESTS to run it.
+static void DEBUG_runLargeFileTests(char *path_utf8) {
+    char *marker = "int four_gigabytes = 1;\n";
+    s64 marker_size = easyString_getSizeInBytes_utf8(marker);
+    s64 file_size = DEBUG_LARGE_FILE_SIZE_IN_BYTES;
+    s64 offsets[] = {0, (1LL << 32) - 8, file_size - marker_size};
+
+    Platform_File_Handle handle = platform_begin_file_write_utf8_file_path(path_utf8);
+    assert(!handle.has_errors);
+    bool sparse = platform_set_file_sparse(handle);
+    assert(sparse);
+    for(int i = 0; i < arrayCount(offsets); ++i) {
+        platform_write_file_data(handle, marker, marker_size, offsets[i]);
+    }
+    platform_close_file(handle);
+
+    Platform_File_Map file_map;
+    bool mapped = platform_map_file_read_only_wideChar(platform_utf8_to_wide_char(path_utf8, &globalPerFrameArena), &file_map);
+    assert(mapped);
+    assert((s64)file_map.size_in_bytes == file_size);
+
+    WL_Buffer buffer;
+    initBuffer(&buffer);
+    WL_Buffer *b = &buffer;
+    wl_buffer_init_from_file_map(b, file_map, 0);
+    wl_buffer_add_file_map_text(b, 0, file_size);
+
+    assert(wl_buffer_get_size_in_bytes(b) == file_size);
+    assert(wl_buffer_get_line_count(b) == arrayCount(offsets) + 1);
+
+    for(int i = 0; i < arrayCount(offsets); ++i) {
+        assert(wl_buffer_get_byte(b, offsets[i]) == 'i');
+        assert(wl_buffer_get_line_index(b, offsets[i]) == i);
+        assert(wl_buffer_get_offset_of_line(b, i + 1) == offsets[i] + marker_size);
+    }
+
+    {
+        //NOTE: Lexing & searching across the 4GB mark
+        s64 start = offsets[1];
+        WL_Buffer_View view = wl_buffer_get_view_of_range(b, &globalPerFrameArena, 0, start, start + marker_size);
+        WL_Buffer_View_Tokenizer tokenizer = wl_buffer_view_begin_lexing(&view, &globalPerFrameArena, start);
+
+        EasyToken token = wl_buffer_view_get_next_token(&tokenizer);
+        assert(wl_buffer_view_get_token_offset(&tokenizer, token.at) == start);
+        while(token.type != TOKEN_NULL_TERMINATOR && !(token.size == 14 && token.at[0] == 'f')) {
+            token = wl_buffer_view_get_next_token(&tokenizer);
+        }
+        assert(wl_buffer_view_get_token_offset(&tokenizer, token.at) == start + 4);
+
+        String_Query_Search_Results results = wl_buffer_view_find_sub_string(&view, "four_gigabytes", &globalPerFrameArena);
+        assert(results.byteOffsetCount == 1);
+        assert((s64)results.byteOffsets[0] == start + 4);
+    }
+
+    {
+        //NOTE: Editing, selecting & undoing past the 4GB mark
+        s64 at = offsets[2];
+        addTextToBuffer(b, "hello", at);
+        assert(wl_buffer_get_size_in_bytes(b) == file_size + 5);
+        assert(wl_buffer_get_byte(b, at) == 'h' && wl_buffer_get_byte(b, at + 5) == 'i');
+        assert(wl_buffer_get_cursor(b) == at + 5);
+
+        Selectable_State select = {};
+        update_select(&select, at + 5);
+        update_select(&select, at);
+        Selectable_Diff diff = selectable_get_bytes_diff(&select);
+        assert(diff.start == at && diff.size == 5);
+
+        removeTextFromBuffer(b, diff.start, diff.size);
+        assert(wl_buffer_get_size_in_bytes(b) == file_size);
+
+        UndoRedoBlock *block = wl_buffer_undo(b);
+        assert(block && block->type == UNDO_REDO_DELETE && block->byteAt == at && block->stringLength == 5);
+        assert(wl_buffer_get_size_in_bytes(b) == file_size + 5);
+        assert(wl_buffer_get_byte(b, at) == 'h' && wl_buffer_get_byte(b, at + 4) == 'o');
+
+        block = wl_buffer_undo(b);
+        assert(block && block->type == UNDO_REDO_INSERT && block->byteAt == at && block->stringLength == 5);
+        assert(wl_buffer_get_size_in_bytes(b) == file_size);
+        assert(wl_buffer_get_byte(b, at) == 'i');
+
+        block = wl_buffer_redo(b);
+        assert(block && block->type == UNDO_REDO_INSERT);
+        assert(wl_buffer_get_size_in_bytes(b) == file_size + 5);
+        assert(wl_buffer_get_byte(b, at) == 'h');
+    }
+
+    //NOTE: Unmaps the file so it can be deleted
+    wl_emptyBuffer(b);
+
+    bool deleted = platform_delete_file_utf8(path_utf8);
+    assert(deleted);
+}
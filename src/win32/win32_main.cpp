@@ -8,6 +8,7 @@
 #include <Shlobj.h>
 #include <shlwapi.h>
 #include <wchar.h>
+#include <intrin.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../libs/stb_image.h"
@@ -117,7 +118,24 @@ static void *platform_alloc_memory_pages(size_t size) {
 
 }
 
-static u8 *platform_realloc_memory(void *src, u32 bytesToMove, size_t sizeToAlloc) {
+//NOTE: Used by the game layer. Size is the same size that was passed to platform_alloc_memory_pages
+static void platform_free_memory_pages(void *memory, size_t size) {
+    if(memory) {
+#if DEBUG_BUILD
+        u64 page_size = platform_get_memory_page_size();
+
+        size_t size_to_free = size + (page_size - 1);
+
+        size_to_free -= size_to_free % page_size; 
+
+        global_debug_stats.total_virtual_alloc -= size_to_free;
+#endif
+
+        VirtualFree(memory, 0, MEM_RELEASE);
+    }
+}
+
+static u8 *platform_realloc_memory(void *src, size_t bytesToMove, size_t sizeToAlloc) {
     u8 *result = (u8 *)platform_alloc_memory(sizeToAlloc, true);
 
     memmove(result, src, bytesToMove);
@@ -376,6 +394,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
             keyType = PLATFORM_KEY_F;
         } else if(vk_code == 'G') {
             keyType = PLATFORM_KEY_G;
+        } else if(vk_code == 'L') {
+            keyType = PLATFORM_KEY_L;
         } else if(vk_code == VK_SHIFT) {
             keyType = PLATFORM_KEY_SHIFT;
         } else if(vk_code == VK_F5) {
@@ -427,6 +447,21 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     return result;
 } 
 
+//NOTE: Adds to the value so every thread sees it, and returns what it is after the add
+static s32 platform_atomic_add(volatile s32 *value, s32 amount) {
+    return (s32)InterlockedExchangeAdd((volatile LONG *)value, amount) + amount;
+}
+
+static s64 platform_atomic_add_s64(volatile s64 *value, s64 amount) {
+    return (s64)InterlockedExchangeAdd64((volatile LONG64 *)value, amount) + amount;
+}
+
+//NOTE: Sets it to new_value if it's still expected, and returns what it was before. So it worked if that's expected.
+static void *platform_atomic_compare_exchange_pointer(void *volatile *value, void *new_value, void *expected) {
+    return InterlockedCompareExchangePointer(value, new_value, expected);
+}
+
+//NOTE: The atomics are before this since the atomic arena uses them
 #include "../memory_arena.cpp"
 
 //TODO: I don't know if this is meant to be WCHAR or can do straight utf8
@@ -485,7 +520,7 @@ static u16 *platform_utf8_to_wide_char(char *string_utf8, Memory_Arena *arena) {
 
     size_t bufferSize_inBytes = (characterCount + 1)*sizeof(u16);
 
-    result = (WCHAR *)pushSize(&globalPerFrameArena, bufferSize_inBytes);
+    result = (WCHAR *)pushSize(arena, bufferSize_inBytes);
 
     size_t bytesWritten = MultiByteToWideChar(CP_UTF8, 0, string_utf8, -1, (LPWSTR)result, characterCount);
 
@@ -497,13 +532,14 @@ static u64 platform_get_file_time_utf8_filename(char *utf8_file_name) {
     u64 result = 0;
 
     DWORD desired_access = GENERIC_READ;
-    DWORD share_mode = 0;
+    DWORD share_mode = FILE_SHARE_READ | FILE_SHARE_WRITE; //NOTE: Just getting the time, so don't fail if the file is mapped or open somewhere else
     SECURITY_ATTRIBUTES security_attributes = { (DWORD)sizeof(SECURITY_ATTRIBUTES) };
     DWORD creation_disposition = OPEN_EXISTING;
     DWORD flags_and_attributes = 0;
     HANDLE template_file = 0;
     
-    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(utf8_file_name, &globalPerFrameArena);
+    Scratch_Arena scratch = getScratchArena();
+    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(utf8_file_name, scratch.arena);
 
     HANDLE FileHandle = CreateFileW((WCHAR*)path16,
                            desired_access,
@@ -512,6 +548,7 @@ static u64 platform_get_file_time_utf8_filename(char *utf8_file_name) {
                            creation_disposition,
                            flags_and_attributes,
                            template_file);
+    releaseScratchArena(&scratch);
     
     if(FileHandle != INVALID_HANDLE_VALUE) {
         FILETIME creationTime;
@@ -524,6 +561,8 @@ static u64 platform_get_file_time_utf8_filename(char *utf8_file_name) {
             result = writeTime.dwLowDateTime;
             result = result | (((u64)writeTime.dwHighDateTime) << 32);
         }
+
+        CloseHandle(FileHandle);
     }
 
     return result;
@@ -666,7 +705,8 @@ static Platform_File_Handle platform_begin_file_write_utf8_file_path (char *path
     DWORD flags_and_attributes = 0;
     HANDLE template_file = 0;
     
-    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(path_utf8, &globalPerFrameArena);
+    Scratch_Arena scratch = getScratchArena();
+    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(path_utf8, scratch.arena);
 
     HANDLE FileHandle = CreateFileW((WCHAR*)path16,
                            desired_access,
@@ -675,6 +715,7 @@ static Platform_File_Handle platform_begin_file_write_utf8_file_path (char *path
                            creation_disposition,
                            flags_and_attributes,
                            template_file);
+    releaseScratchArena(&scratch);
     
     if(FileHandle != INVALID_HANDLE_VALUE)
     {
@@ -698,31 +739,67 @@ static void platform_close_file(Platform_File_Handle handle)
     }
 }
 
-static void platform_write_file_data(Platform_File_Handle handle, void *memory, size_t size_to_write, size_t offset)
+//NOTE: False if any of it didn't get written, like when the disk is full
+static bool platform_write_file_data(Platform_File_Handle handle, void *memory, size_t size_to_write, size_t offset)
 {
-    if(!handle.has_errors) {
-        HANDLE FileHandle = (HANDLE)handle.data;
-        if(FileHandle)
-        {
-            if(SetFilePointer(FileHandle, offset, 0, FILE_BEGIN) !=  INVALID_SET_FILE_POINTER)
-            {
-                DWORD BytesWritten;
-                if(WriteFile(FileHandle, memory, (DWORD)size_to_write, &BytesWritten, 0))
-                {
-                    if(BytesWritten == size_to_write) {
-                    } else {
-                        assert(!"soemthing went wrong");
-                    } 
-                }
-                else
-                {
-                    assert(!"Read file did not succeed");
-                }
+    bool result = false;
+    HANDLE FileHandle = (HANDLE)handle.data;
+    if(!handle.has_errors && FileHandle) {
+        result = true;
+
+        //NOTE: WriteFile only takes a 32bit size, so write really big spans a bit at a time
+        size_t max_write_size = 1 << 30;
+
+        u8 *at = (u8 *)memory;
+        while(size_to_write > 0 && result) {
+            DWORD size = (DWORD)((size_to_write < max_write_size) ? size_to_write : max_write_size);
+
+            //NOTE: Write at an offset instead of using SetFilePointer so files bigger than 4GB work
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)(((u64)offset) >> 32);
+
+            DWORD BytesWritten;
+            if(!WriteFile(FileHandle, at, size, &BytesWritten, &overlapped) || BytesWritten != size) {
+                result = false;
             }
+
+            at += size;
+            offset += size;
+            size_to_write -= size;
         }
-    } else {
-        assert(!"File handle not correct");
     }
+    return result;
+}
+
+//NOTE: Waits till everything written to the file is actually on the disk. False if it couldn't be
+static bool platform_flush_file(Platform_File_Handle handle) {
+    bool result = false;
+    if(!handle.has_errors && handle.data) {
+        result = (FlushFileBuffers((HANDLE)handle.data) != 0);
+    }
+    return result;
+}
+
+//NOTE: The parts of the file that never get written don't take up any disk. Has to be set before writing past the end
+static bool platform_set_file_sparse(Platform_File_Handle handle) {
+    bool result = false;
+    if(!handle.has_errors && handle.data) {
+        DWORD bytes_returned = 0;
+        result = (DeviceIoControl((HANDLE)handle.data, FSCTL_SET_SPARSE, 0, 0, 0, 0, &bytes_returned, 0) != 0);
+    }
+    return result;
+}
+
+//NOTE: Moves the file over the top of another one in one go, so the other file is either all the old file or all the new one, even if we crash
+static bool platform_replace_file_utf8(char *from_path_utf8, char *to_path_utf8) {
+    Scratch_Arena scratch = getScratchArena();
+    WCHAR *from_path16 = (WCHAR *)platform_utf8_to_wide_char(from_path_utf8, scratch.arena);
+    WCHAR *to_path16 = (WCHAR *)platform_utf8_to_wide_char(to_path_utf8, scratch.arena);
+
+    bool result = MoveFileExW(from_path16, to_path16, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+    releaseScratchArena(&scratch);
+    return result;
 }
 
 static char *platform_get_save_file_location_utf8(Memory_Arena *arena) {
@@ -747,8 +824,9 @@ static char *platform_get_save_file_location_utf8(Memory_Arena *arena) {
 
     size_t str_size_in_bytes = easyString_getSizeInBytes_utf16((u16 *)win32_wideString_utf16) + easyString_getSizeInBytes_utf16((u16 *)append_str);
 
-    //TODO: Remove max path - get actual string length and put it in a tmep arena
-    WCHAR *buffer = (WCHAR *)pushSize(&globalPerFrameArena, str_size_in_bytes + sizeof(u16));
+    //NOTE: The result goes in the arena we were given, so the wide string needs a different one
+    Scratch_Arena scratch = getScratchArena(&arena, 1);
+    WCHAR *buffer = (WCHAR *)pushSize(scratch.arena, str_size_in_bytes + sizeof(u16));
 
     memcpy(buffer, win32_wideString_utf16, easyString_getSizeInBytes_utf16((u16 *)win32_wideString_utf16)); 
 
@@ -789,6 +867,7 @@ static char *platform_get_save_file_location_utf8(Memory_Arena *arena) {
 
     //NOTE(ollie): Free the string
     CoTaskMemFree(win32_wideString_utf16);
+    releaseScratchArena(&scratch);
 
     return result;
 }
@@ -814,9 +893,12 @@ inline char *easy_createString_printf(Memory_Arena *arena, char *formatString, .
 static Platform_Directory_Item *platform_build_tree_of_directory(char *uft8_top_folder, Memory_Arena *arena) {
     Platform_Directory_Item *result = 0;
 
+    //NOTE: The items go in the arena we were given, the rest is only needed while we look through the folder
+    Scratch_Arena scratch = getScratchArena(&arena, 1);
+
     //NOTE: Build the write string for wildcard
-    char *folder_with_wildcard = easy_createString_printf(&globalPerFrameArena, "%s%s", uft8_top_folder, "\\*");
-    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(folder_with_wildcard, &globalPerFrameArena);
+    char *folder_with_wildcard = easy_createString_printf(scratch.arena, "%s%s", uft8_top_folder, "\\*");
+    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(folder_with_wildcard, scratch.arena);
 
     WIN32_FIND_DATAW fileFindData;
 
@@ -844,7 +926,7 @@ static Platform_Directory_Item *platform_build_tree_of_directory(char *uft8_top_
                 WCHAR *name = fileFindData.cFileName;
 
                 //NOTE: Convert the utf16 string to utf8 and assign it
-                u8 *file_short_name_utf8 = platform_wide_char_to_utf8_null_terminate(name, &globalPerFrameArena);
+                u8 *file_short_name_utf8 = platform_wide_char_to_utf8_null_terminate(name, scratch.arena);
                 
 
                 //NOTE: DOn't show . folders or .. folders 
@@ -862,7 +944,7 @@ static Platform_Directory_Item *platform_build_tree_of_directory(char *uft8_top_
 
                     //NOTE: Put it in a long term arena
                     item->display_name = (u8 *)nullTerminateArena((char *)file_short_name_utf8, easyString_getSizeInBytes_utf8((char *)file_short_name_utf8), arena);
-                    item->item_name_utf8_null_terminated = (u8 *)easy_createString_printf(&globalPerFrameArena, "%s\\%s", uft8_top_folder, file_short_name_utf8);
+                    item->item_name_utf8_null_terminated = (u8 *)easy_createString_printf(arena, "%s\\%s", uft8_top_folder, file_short_name_utf8);
 
                     //NOTE: See if it is a folder
                     if(fileFindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
@@ -892,6 +974,30 @@ static Platform_Directory_Item *platform_build_tree_of_directory(char *uft8_top_
         FindClose(dirHandle);
     }
 
+    releaseScratchArena(&scratch);
+
+    return result;
+}
+
+//NOTE: Makes a new empty file in the temp folder & returns its path, allocated on the heap so free it with platform_free_memory. Null if it couldn't.
+static char *platform_make_temp_file_utf8() {
+    char *result = 0;
+
+    WCHAR folder[MAX_PATH + 1];
+    WCHAR path[MAX_PATH + 1];
+
+    DWORD folder_size = GetTempPathW(MAX_PATH + 1, folder);
+    if(folder_size > 0 && folder_size <= MAX_PATH && GetTempFileNameW(folder, L"wl", 0, path) != 0) {
+        result = (char *)platform_wide_char_to_utf8_null_terminate(path);
+    }
+    return result;
+}
+
+static bool platform_delete_file_utf8(char *path_utf8) {
+    Scratch_Arena scratch = getScratchArena();
+    WCHAR *path16 = (WCHAR *)platform_utf8_to_wide_char(path_utf8, scratch.arena);
+    bool result = DeleteFileW(path16);
+    releaseScratchArena(&scratch);
     return result;
 }
 
@@ -924,6 +1030,72 @@ static bool platform_does_file_exist(u16 *wide_file_name) {
 
 
 
+//NOTE: Opens the file to read a bit at a time with platform_read_file_data, instead of all at once like Platform_LoadEntireFile_wideChar. 
+//      It's ok to read it on a different thread to the one that opened it.
+static Platform_File_Handle platform_begin_file_read_wideChar(void *filename_wideChar_, size_t *file_size, u64 *timeStamp) {
+    LPWSTR filename_wideChar = (LPWSTR)filename_wideChar_;
+
+    Platform_File_Handle Result = {};
+    *file_size = 0;
+
+    HANDLE file = CreateFileW(filename_wideChar, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+
+    if(file != INVALID_HANDLE_VALUE) {
+        FILETIME creationTime;
+        FILETIME accessTime;
+        FILETIME writeTime;
+
+        //NOTE: Get the file time for the file
+        if(GetFileTime(file, &creationTime, &accessTime, &writeTime)) {
+            *timeStamp = writeTime.dwLowDateTime;
+            *timeStamp = *timeStamp | (((u64)writeTime.dwHighDateTime) << 32);
+        }
+
+        LARGE_INTEGER size;
+        if(GetFileSizeEx(file, &size)) {
+            *file_size = (size_t)size.QuadPart;
+        }
+
+        Result.data = file;
+    } else {
+        Result.has_errors = true;
+    }
+
+    return Result;
+}
+
+//NOTE: Returns how many bytes it read, 0 if it couldn't read any
+static size_t platform_read_file_data(Platform_File_Handle handle, void *memory, size_t size_to_read, size_t offset) {
+    size_t result = 0;
+
+    if(!handle.has_errors && handle.data) {
+        //NOTE: ReadFile only takes a 32bit size, so read really big sizes a bit at a time
+        size_t max_read_size = 1 << 30;
+
+        u8 *at = (u8 *)memory;
+        while(size_to_read > 0) {
+            DWORD size = (DWORD)((size_to_read < max_read_size) ? size_to_read : max_read_size);
+
+            //NOTE: Reading with an offset doesn't use the file pointer
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)(((u64)offset) >> 32);
+
+            DWORD bytes_read = 0;
+            if(!ReadFile((HANDLE)handle.data, at, size, &bytes_read, &overlapped) || bytes_read == 0) {
+                break;
+            }
+
+            result += bytes_read;
+            at += bytes_read;
+            offset += bytes_read;
+            size_to_read -= bytes_read;
+        }
+    }
+
+    return result;
+}
+
 static bool Platform_LoadEntireFile_wideChar(void *filename_wideChar_, void **data, size_t *data_size, u64 *timeStamp) {
 
     LPWSTR filename_wideChar = (LPWSTR)filename_wideChar_;
@@ -960,14 +1132,17 @@ static bool Platform_LoadEntireFile_wideChar(void *filename_wideChar_, void **da
                 *timeStamp = *timeStamp | (((u64)writeTime.dwHighDateTime) << 32);
             }
 
-            DWORD read_bytes = GetFileSize(file, 0);
+            LARGE_INTEGER file_size = {};
+            GetFileSizeEx(file, &file_size);
+
+            size_t read_bytes = (size_t)file_size.QuadPart;
             if(read_bytes)
             {
                 void *read_data = platform_alloc_memory(read_bytes+1, false);
-                DWORD bytes_read = 0;
-                OVERLAPPED overlapped = {0};
-                
-                ReadFile(file, read_data, read_bytes, &bytes_read, &overlapped);
+
+                Platform_File_Handle handle = {};
+                handle.data = file;
+                size_t bytes_read = platform_read_file_data(handle, read_data, read_bytes, 0);
                 
                 ((u8 *)read_data)[read_bytes] = 0;
                 
@@ -985,6 +1160,172 @@ static bool Platform_LoadEntireFile_wideChar(void *filename_wideChar_, void **da
 
 
 
+//NOTE: Maps the whole file into memory read only. Other programs can still read the file but can't write to it while it's mapped, so the memory stays valid.
+//      Empty files can't be mapped so this returns false for them.
+static bool platform_map_file_read_only_wideChar(void *filename_wideChar_, Platform_File_Map *map) {
+    LPWSTR filename_wideChar = (LPWSTR)filename_wideChar_;
+
+    bool successful = false;
+    memset(map, 0, sizeof(Platform_File_Map));
+
+    HANDLE file = CreateFileW(filename_wideChar, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+    if(file != INVALID_HANDLE_VALUE) {
+        FILETIME creationTime;
+        FILETIME accessTime;
+        FILETIME writeTime;
+
+        //NOTE: Get the file time for the file
+        if(GetFileTime(file, &creationTime, &accessTime, &writeTime)) {
+            map->time_stamp = writeTime.dwLowDateTime;
+            map->time_stamp = map->time_stamp | (((u64)writeTime.dwHighDateTime) << 32);
+        }
+
+        LARGE_INTEGER file_size;
+        if(GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+            
+            if(mapping) {
+                void *memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+                if(memory) {
+                    map->memory = memory;
+                    map->size_in_bytes = (size_t)file_size.QuadPart;
+                    map->file_handle = file;
+                    map->mapping_handle = mapping;
+
+                    successful = true;
+                } else {
+                    CloseHandle(mapping);
+                }
+            }
+        }
+
+        if(!successful) {
+            CloseHandle(file);
+        }
+    }
+
+    return successful;
+}
+
+static void platform_unmap_file(Platform_File_Map *map) {
+    if(map->memory) {
+        UnmapViewOfFile(map->memory);
+    }
+
+    if(map->mapping_handle) {
+        CloseHandle((HANDLE)map->mapping_handle);
+    }
+
+    if(map->file_handle) {
+        CloseHandle((HANDLE)map->file_handle);
+    }
+
+    memset(map, 0, sizeof(Platform_File_Map));
+}
+
+static u32 platform_get_processor_count() {
+    SYSTEM_INFO SystemInfo;
+    GetSystemInfo(&SystemInfo);
+    
+    return SystemInfo.dwNumberOfProcessors;
+}
+
+//NOTE: If we can use the 256 bit instructions. The cpu has to have them and the OS has to save the registers
+static bool platform_cpu_has_avx2() {
+    bool result = false;
+
+    int info[4];
+    __cpuid(info, 0);
+
+    if(info[0] >= 7) {
+        __cpuid(info, 1);
+        bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+
+        __cpuidex(info, 7, 0);
+        result = os_saves_ymm && (info[1] & (1 << 5));
+    }
+
+    return result;
+}
+
+//NOTE: Shared by the jobs of one platform_do_work_in_parallel. It's on the heap since a job can still be waiting in the queue after 
+//      the caller has finished, the last one to let go of it frees it.
+struct Win32_Parallel_Work {
+    thread_work_function *function;
+    u8 *items;
+    size_t size_of_item;
+    s32 count;
+
+    volatile s32 next_item; //NOTE: Whoever gets it first does it
+    volatile s32 items_done;
+    volatile s32 ref_count;
+
+    HANDLE finished_event; //NOTE: Set once items_done gets to count
+};
+
+static void win32_release_parallel_work(Win32_Parallel_Work *work) {
+    if(platform_atomic_add(&work->ref_count, -1) == 0) {
+        CloseHandle(work->finished_event);
+        HeapFree(GetProcessHeap(), 0, work);
+    }
+}
+
+//NOTE: Takes items till there aren't any left
+static void win32_do_parallel_work_items(Win32_Parallel_Work *work) {
+    for(;;) {
+        s32 item = platform_atomic_add(&work->next_item, 1) - 1;
+        if(item >= work->count) {
+            break;
+        }
+
+        work->function(work->items + item*work->size_of_item);
+
+        if(platform_atomic_add(&work->items_done, 1) == work->count) {
+            SetEvent(work->finished_event);
+        }
+    }
+}
+
+static THREAD_WORK_FUNCTION(win32_parallel_work_job) {
+    Win32_Parallel_Work *work = (Win32_Parallel_Work *)Data;
+    win32_do_parallel_work_items(work);
+    win32_release_parallel_work(work);
+}
+
+//NOTE: Runs the function on each of the items on the work queue's threads, and waits till they're all done. The calling thread takes 
+//      items too, so it never waits on a job that's stuck behind others in the queue, only on items another thread is already doing.
+//      For big one off jobs like scanning a file when it's opened.
+static void platform_do_work_in_parallel(thread_work_function *function, void *items, size_t size_of_item, u32 count) {
+    if(count <= 1 || !global_platform.push_work_onto_queue) {
+        for(u32 i = 0; i < count; ++i) {
+            function(((u8 *)items) + i*size_of_item);
+        }
+        return;
+    }
+
+    //NOTE: Straight from the heap, not platform_alloc_memory, since another thread might free it & the debug stats aren't thread safe
+    Win32_Parallel_Work *work = (Win32_Parallel_Work *)HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(Win32_Parallel_Work));
+    work->function = function;
+    work->items = (u8 *)items;
+    work->size_of_item = size_of_item;
+    work->count = (s32)count;
+    work->finished_event = CreateEventW(0, TRUE, FALSE, 0);
+
+    //NOTE: One for each job & one for us
+    work->ref_count = (s32)count;
+
+    for(u32 i = 0; (i + 1) < count; ++i) {
+        global_platform.push_work_onto_queue(global_platform.work_queue, win32_parallel_work_job, work);
+    }
+
+    win32_do_parallel_work_items(work);
+    WaitForSingleObject(work->finished_event, INFINITE);
+
+    win32_release_parallel_work(work);
+}
+
 static void *Platform_loadTextureToGPU(void *data, u32 texWidth, u32 texHeight, u32 bytesPerPixel) {
     // Create Texture
     D3D11_TEXTURE2D_DESC textureDesc = {};
@@ -1053,6 +1394,9 @@ static float2 platform_get_window_xy_pos() {
 
 #include "../render_backend/d3d_render.cpp"
 
+//NOTE: In win32_threads.cpp since it needs the work queue
+static void platform_help_with_queued_work();
+
 #include "../main.cpp"
 
 EditorState *global_editorState; //NOTE: FOr threads to access
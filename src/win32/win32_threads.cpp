@@ -1,7 +1,4 @@
 
-#define THREAD_WORK_FUNCTION(name) void name(void *Data)
-typedef THREAD_WORK_FUNCTION(thread_work_function);
-
 struct thread_work
 {
     thread_work_function *FunctionPtr;
@@ -20,6 +17,7 @@ struct thread_info
     SDL_GLContext ContextForThread;
 #else 
     HANDLE Semaphore;
+    SRWLOCK AddLock; //NOTE: More than one thread can add work, see platform_do_work_in_parallel
     LPVOID WindowHandle;
     thread_work WorkQueue[256];
     volatile u32 IndexToTakeFrom;
@@ -29,13 +27,15 @@ struct thread_info
 #endif
 };
 
-#define PLATFORM_PUSH_WORK_ONTO_QUEUE(name) void name(thread_info *Info, thread_work_function *WorkFunction, void *Data)
-typedef PLATFORM_PUSH_WORK_ONTO_QUEUE(platform_push_work_onto_queue);
+//NOTE: The threads keep a pointer to this so it can't be on the stack
+static thread_info global_threadInfo = {};
 
 
 
-//TODO(ollie): Make safe for threads other than the main thread to add stuff
+//NOTE: Any thread can add work, the lock keeps them from taking the same slot
 PLATFORM_PUSH_WORK_ONTO_QUEUE(Win32PushWorkOntoQueue) {
+    AcquireSRWLockExclusive(&Info->AddLock);
+
     for(;;)
     {
         u32 OnePastTheHead = (Info->IndexToAddTo + 1) % arrayCount(Info->WorkQueue);
@@ -63,7 +63,8 @@ PLATFORM_PUSH_WORK_ONTO_QUEUE(Win32PushWorkOntoQueue) {
             //NOTE(ollie): Queue is full
         }
     }
-    
+
+    ReleaseSRWLockExclusive(&Info->AddLock);
 }
 
 static thread_work *
@@ -91,6 +92,9 @@ Win32DoThreadWork(thread_info *Info)
     {
         Work->FunctionPtr(Work->Data);
         assert(!Work->Finished);
+
+        //NOTE: Jobs can use the thread's scratch arenas, but have to let them go before they finish
+        assert(scratchArenasAreReleased());
         
         MemoryBarrier();
         _ReadWriteBarrier();
@@ -100,6 +104,25 @@ Win32DoThreadWork(thread_info *Info)
     }
 }
 
+//NOTE: For when the main thread has to wait on a job. Does a job off the queue instead of spinning, since the one we're waiting on 
+//      might be stuck behind it. If there's nothing to take, gives the rest of our time slice to the threads doing the work.
+static void platform_help_with_queued_work() {
+    thread_work *Work;
+    if(GetWorkOffQueue(&global_threadInfo, &Work))
+    {
+        Work->FunctionPtr(Work->Data);
+        assert(!Work->Finished);
+
+        MemoryBarrier();
+        _ReadWriteBarrier();
+
+        Work->Finished = true;
+    }
+    else
+    {
+        SwitchToThread();
+    }
+}
 
 static DWORD Win32_fileStampCheckerThreaded(LPVOID Info_)
 {
@@ -169,9 +192,10 @@ static void win32_init_threads(LPVOID windowHandle) {
     
     u32 NumberOfUnusedProcessors = (NumberOfProcessors - 1); //NOTE(oliver): minus one to account for the one we are on
     
-    thread_info ThreadInfo = {};
+    thread_info &ThreadInfo = global_threadInfo;
     ThreadInfo.Semaphore = CreateSemaphore(0, 0, NumberOfUnusedProcessors, 0);
     ThreadInfo.IndexToTakeFrom = ThreadInfo.IndexToAddTo = 0;
+    InitializeSRWLock(&ThreadInfo.AddLock);
     ThreadInfo.WindowHandle = windowHandle;
 
     // ThreadInfo.WindowDC = windowDC;
@@ -186,8 +210,10 @@ static void win32_init_threads(LPVOID windowHandle) {
     HANDLE Threads[12];
     u32 ThreadCount = 0;
     
-    s32 CoreCount = min(NumberOfUnusedProcessors - 1, arrayCount(Threads));
-    #if 0
+    //NOTE: Leave room for the file stamp thread
+    s32 CoreCount = (NumberOfUnusedProcessors > 1) ? (s32)(NumberOfUnusedProcessors - 1) : 1;
+    if(CoreCount > (s32)(arrayCount(Threads) - 1)) { CoreCount = arrayCount(Threads) - 1; }
+
     for(u32 CoreIndex = 0;
         CoreIndex < (u32)CoreCount;
         ++CoreIndex)
@@ -198,7 +224,10 @@ static void win32_init_threads(LPVOID windowHandle) {
         assert(ThreadCount < arrayCount(Threads));
         Threads[ThreadCount++] = CreateThread(0, 0, Win32ThreadEntryPoint, &ThreadInfo, 0, 0);
     }
-    #endif
+
+    //NOTE: So the platform independent code can push work onto the threads
+    global_platform.work_queue = &ThreadInfo;
+    global_platform.push_work_onto_queue = Win32PushWorkOntoQueue;
 
     //NOTE: We create just one thread for file stamps
     assert(ThreadCount < arrayCount(Threads));
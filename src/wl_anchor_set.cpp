@@ -0,0 +1,632 @@
+/*
+Anchors are offsets in a buffer that stay on the same text while the buffer gets edited, like the cursor & the search matches.
+
+A B-tree like the line index (see wl_line_index.cpp). The leaves hold the anchors in order with the gap in bytes from the anchor
+before them, and every node keeps how many anchors and bytes are under it. An edit only changes the gap of the first anchor after it
+and the nodes above that one, so it's O(log n) however many anchors there are. Anchors in text that gets removed all end up where
+the text was, those are the only ones that have to be touched one at a time.
+
+Anchors are handles so they stay the same while they move around the tree. 0 is never an anchor, so it can mean no anchor.
+
+Text inserted exactly at an anchor goes after it, unless the anchor is WL_ANCHOR_MOVES_WITH_INSERT. Anchors at the same offset
+always have the ones that stay before the ones that move, so an insert still only changes one gap.
+
+Functions to use:
+
+anchorSet_insert_text(set, byteOffset, size); //NOTE: Call these with the text as it's added & removed from the buffer
+anchorSet_remove_text(set, byteOffset, size);
+
+anchorSet_add(set, byteOffset, gravity);
+anchorSet_remove(set, anchor);
+
+anchorSet_get_offset(set, anchor);
+anchorSet_set_offset(set, anchor, byteOffset);
+
+*/
+
+#define ANCHOR_SET_LEAF_COUNT 64
+#define ANCHOR_SET_MAX_CHILDREN 16
+
+#define ANCHOR_SET_POOL_PAGE_SIZE (64*1024)
+
+typedef s32 WL_Anchor;
+
+enum WL_Anchor_Gravity {
+	WL_ANCHOR_STAYS_BEFORE_INSERT, //NOTE: Like the cursor while a file is loading in after it
+	WL_ANCHOR_MOVES_WITH_INSERT, //NOTE: Like the start of a search match, text put in front of it pushes it along
+};
+
+struct WL_Anchor_Entry {
+	s64 gap; //NOTE: Bytes from the anchor before it, or the start of the buffer for the first one
+	WL_Anchor anchor;
+};
+
+struct WL_Anchor_Node {
+	WL_Anchor_Node *parent;
+
+	s64 anchor_count;
+	s64 size_in_bytes; //NOTE: All the gaps under the node added up
+
+	bool is_leaf;
+	u32 count; //NOTE: Anchors used if it's a leaf, children used if it isn't
+
+	union {
+		WL_Anchor_Node *children[ANCHOR_SET_MAX_CHILDREN];
+		WL_Anchor_Entry entries[ANCHOR_SET_LEAF_COUNT];
+	};
+};
+
+struct WL_Anchor_Info {
+	WL_Anchor_Node *leaf; //NOTE: Null if the anchor isn't being used
+	WL_Anchor_Gravity gravity;
+	WL_Anchor next_free;
+};
+
+struct WL_Anchor_Pool_Page {
+	WL_Anchor_Pool_Page *next;
+};
+
+struct WL_Anchor_Set {
+	WL_Anchor_Node *root;
+
+	//NOTE: Which leaf each anchor is in, indexed by the anchor
+	WL_Anchor_Info *infos;
+	s32 info_count;
+	s32 info_total;
+	WL_Anchor free_anchors;
+
+	//NOTE: All the nodes are the same size, so they come out of pages with a free list
+	WL_Anchor_Node *free_list;
+	WL_Anchor_Pool_Page *pages;
+	u8 *page_at;
+	size_t page_bytes_left;
+};
+
+static WL_Anchor_Node *anchorSet_alloc_node(WL_Anchor_Set *set, bool is_leaf) {
+	WL_Anchor_Node *result = 0;
+
+	if(set->free_list) {
+		result = set->free_list;
+		set->free_list = *((WL_Anchor_Node **)result);
+	} else {
+		if(set->page_bytes_left < sizeof(WL_Anchor_Node)) {
+			WL_Anchor_Pool_Page *page = (WL_Anchor_Pool_Page *)platform_alloc_memory_pages(ANCHOR_SET_POOL_PAGE_SIZE);
+			page->next = set->pages;
+			set->pages = page;
+
+			set->page_at = ((u8 *)page) + 16;
+			set->page_bytes_left = ANCHOR_SET_POOL_PAGE_SIZE - 16;
+		}
+
+		result = (WL_Anchor_Node *)set->page_at;
+		set->page_at += sizeof(WL_Anchor_Node);
+		set->page_bytes_left -= sizeof(WL_Anchor_Node);
+	}
+
+	memset(result, 0, sizeof(WL_Anchor_Node));
+	result->is_leaf = is_leaf;
+
+	return result;
+}
+
+static void anchorSet_free_node(WL_Anchor_Set *set, WL_Anchor_Node *node) {
+	*((WL_Anchor_Node **)node) = set->free_list;
+	set->free_list = node;
+}
+
+//NOTE: Also points the children back at the node, since they might have just moved into it
+static void anchorSet_update_summary(WL_Anchor_Set *set, WL_Anchor_Node *node) {
+	node->anchor_count = 0;
+	node->size_in_bytes = 0;
+
+	if(node->is_leaf) {
+		node->anchor_count = node->count;
+		for(u32 i = 0; i < node->count; ++i) {
+			node->size_in_bytes += node->entries[i].gap;
+			set->infos[node->entries[i].anchor].leaf = node;
+		}
+	} else {
+		for(u32 i = 0; i < node->count; ++i) {
+			WL_Anchor_Node *child = node->children[i];
+			child->parent = node;
+			node->anchor_count += child->anchor_count;
+			node->size_in_bytes += child->size_in_bytes;
+		}
+	}
+}
+
+static void anchorSet_init(WL_Anchor_Set *set) {
+	memset(set, 0, sizeof(WL_Anchor_Set));
+	set->root = anchorSet_alloc_node(set, true);
+
+	set->info_total = 64;
+	set->infos = (WL_Anchor_Info *)platform_alloc_memory(set->info_total*sizeof(WL_Anchor_Info), true);
+
+	//NOTE: 0 isn't an anchor
+	set->info_count = 1;
+}
+
+static void anchorSet_free(WL_Anchor_Set *set) {
+	//NOTE: Nodes get freed with their page
+	WL_Anchor_Pool_Page *page = set->pages;
+	while(page) {
+		WL_Anchor_Pool_Page *next = page->next;
+		platform_free_memory_pages(page, ANCHOR_SET_POOL_PAGE_SIZE);
+		page = next;
+	}
+
+	if(set->infos) { platform_free_memory(set->infos); }
+
+	memset(set, 0, sizeof(WL_Anchor_Set));
+}
+
+static inline s64 anchorSet_get_anchor_count(WL_Anchor_Set *set) {
+	return set->root->anchor_count;
+}
+
+static inline bool anchorSet_is_before(s64 anchor_offset, s64 byte_offset, bool include_offset) {
+	return (anchor_offset < byte_offset) || (include_offset && anchor_offset == byte_offset);
+}
+
+//NOTE: How many anchors are before the offset, which is also the index of the first one after it. With include_offset the anchors at the offset count as before it.
+//		offset_before gets the offset of the last anchor before it, or 0 if there isn't one.
+static s64 anchorSet_count_before(WL_Anchor_Set *set, s64 byte_offset, bool include_offset, s64 *offset_before = 0) {
+	s64 result = 0;
+	s64 at = 0;
+
+	WL_Anchor_Node *node = set->root;
+	while(node && !node->is_leaf) {
+		u32 i = 0;
+		while(i < node->count && anchorSet_is_before(at + node->children[i]->size_in_bytes, byte_offset, include_offset)) {
+			at += node->children[i]->size_in_bytes;
+			result += node->children[i]->anchor_count;
+			i++;
+		}
+		//NOTE: If every child is before it, so are all the anchors
+		node = (i < node->count) ? node->children[i] : 0;
+	}
+
+	if(node) {
+		u32 i = 0;
+		while(i < node->count && anchorSet_is_before(at + node->entries[i].gap, byte_offset, include_offset)) {
+			at += node->entries[i].gap;
+			result++;
+			i++;
+		}
+	}
+
+	if(offset_before) { *offset_before = at; }
+
+	return result;
+}
+
+//NOTE: The leaf the anchor at the index is in, and where it is in the leaf
+static WL_Anchor_Node *anchorSet_find_index(WL_Anchor_Set *set, s64 index, u32 *slot) {
+	assert(index >= 0 && index < anchorSet_get_anchor_count(set));
+
+	WL_Anchor_Node *node = set->root;
+	while(!node->is_leaf) {
+		u32 i = 0;
+		while(index >= node->children[i]->anchor_count) {
+			index -= node->children[i]->anchor_count;
+			i++;
+		}
+		node = node->children[i];
+	}
+
+	*slot = (u32)index;
+	return node;
+}
+
+//NOTE: Walks up from the anchor's leaf, so it doesn't matter how many anchors there are
+static s64 anchorSet_get_index(WL_Anchor_Set *set, WL_Anchor anchor, s64 *byte_offset = 0) {
+	assert(anchor > 0 && anchor < set->info_count && set->infos[anchor].leaf);
+
+	WL_Anchor_Node *node = set->infos[anchor].leaf;
+	s64 index = 0;
+	s64 offset = 0;
+
+	u32 i = 0;
+	while(node->entries[i].anchor != anchor) {
+		offset += node->entries[i].gap;
+		index++;
+		i++;
+		assert(i < node->count);
+	}
+	offset += node->entries[i].gap;
+
+	while(node->parent) {
+		WL_Anchor_Node *parent = node->parent;
+		for(u32 j = 0; parent->children[j] != node; ++j) {
+			offset += parent->children[j]->size_in_bytes;
+			index += parent->children[j]->anchor_count;
+		}
+		node = parent;
+	}
+
+	if(byte_offset) { *byte_offset = offset; }
+
+	return index;
+}
+
+static s64 anchorSet_get_offset(WL_Anchor_Set *set, WL_Anchor anchor) {
+	s64 result = 0;
+	anchorSet_get_index(set, anchor, &result);
+	return result;
+}
+
+static void anchorSet_add_to_gap(WL_Anchor_Set *set, s64 index, s64 size_in_bytes) {
+	u32 slot = 0;
+	WL_Anchor_Node *node = anchorSet_find_index(set, index, &slot);
+
+	node->entries[slot].gap += size_in_bytes;
+	assert(node->entries[slot].gap >= 0);
+
+	while(node) {
+		node->size_in_bytes += size_in_bytes;
+		node = node->parent;
+	}
+}
+
+//NOTE: Put the child in at position, splitting the node if it's full. Returns the new right half if it split.
+static WL_Anchor_Node *anchorSet_add_child(WL_Anchor_Set *set, WL_Anchor_Node *node, u32 position, WL_Anchor_Node *child) {
+	WL_Anchor_Node *split = 0;
+
+	WL_Anchor_Node *children[ANCHOR_SET_MAX_CHILDREN + 1];
+	u32 count = 0;
+	for(u32 i = 0; i < node->count; ++i) {
+		if(i == position) { children[count++] = child; }
+		children[count++] = node->children[i];
+	}
+	if(position == node->count) { children[count++] = child; }
+
+	if(count <= ANCHOR_SET_MAX_CHILDREN) {
+		memcpy(node->children, children, count*sizeof(WL_Anchor_Node *));
+		node->count = count;
+	} else {
+		split = anchorSet_alloc_node(set, false);
+
+		u32 left_count = count / 2;
+		memcpy(node->children, children, left_count*sizeof(WL_Anchor_Node *));
+		node->count = left_count;
+
+		memcpy(split->children, children + left_count, (count - left_count)*sizeof(WL_Anchor_Node *));
+		split->count = count - left_count;
+
+		anchorSet_update_summary(set, split);
+	}
+
+	anchorSet_update_summary(set, node);
+
+	return split;
+}
+
+//NOTE: Returns the new right half if the node split
+static WL_Anchor_Node *anchorSet_insert_entry_(WL_Anchor_Set *set, WL_Anchor_Node *node, s64 index, WL_Anchor_Entry entry) {
+	WL_Anchor_Node *split = 0;
+
+	if(node->is_leaf) {
+		u32 at = (u32)index;
+
+		if(node->count < ANCHOR_SET_LEAF_COUNT) {
+			memmove(node->entries + at + 1, node->entries + at, (node->count - at)*sizeof(WL_Anchor_Entry));
+			node->entries[at] = entry;
+			node->count++;
+		} else {
+			//NOTE: Doesn't fit, split the leaf in half
+			WL_Anchor_Entry temp[ANCHOR_SET_LEAF_COUNT + 1];
+			u32 total = node->count + 1;
+
+			memcpy(temp, node->entries, at*sizeof(WL_Anchor_Entry));
+			temp[at] = entry;
+			memcpy(temp + at + 1, node->entries + at, (node->count - at)*sizeof(WL_Anchor_Entry));
+
+			u32 left_count = total / 2;
+
+			split = anchorSet_alloc_node(set, true);
+			memcpy(split->entries, temp + left_count, (total - left_count)*sizeof(WL_Anchor_Entry));
+			split->count = total - left_count;
+			anchorSet_update_summary(set, split);
+
+			memcpy(node->entries, temp, left_count*sizeof(WL_Anchor_Entry));
+			node->count = left_count;
+		}
+
+		anchorSet_update_summary(set, node);
+	} else {
+		//NOTE: Find the child it goes in. Anchors on the end of a child go on the end of that child
+		u32 i = 0;
+		while(i < (node->count - 1) && index > node->children[i]->anchor_count) {
+			index -= node->children[i]->anchor_count;
+			i++;
+		}
+
+		WL_Anchor_Node *new_child = anchorSet_insert_entry_(set, node->children[i], index, entry);
+
+		if(new_child) {
+			split = anchorSet_add_child(set, node, i + 1, new_child);
+		} else {
+			anchorSet_update_summary(set, node);
+		}
+	}
+
+	return split;
+}
+
+static void anchorSet_insert_entry(WL_Anchor_Set *set, s64 index, WL_Anchor_Entry entry) {
+	WL_Anchor_Node *split = anchorSet_insert_entry_(set, set->root, index, entry);
+
+	if(split) {
+		//NOTE: The root split so the tree gets one level deeper
+		WL_Anchor_Node *new_root = anchorSet_alloc_node(set, false);
+		new_root->children[0] = set->root;
+		new_root->children[1] = split;
+		new_root->count = 2;
+		anchorSet_update_summary(set, new_root);
+
+		set->root = new_root;
+	}
+	set->root->parent = 0;
+}
+
+static void anchorSet_remove_child(WL_Anchor_Node *node, u32 position) {
+	memmove(&node->children[position], &node->children[position + 1], (node->count - position - 1)*sizeof(WL_Anchor_Node *));
+	node->count--;
+}
+
+//NOTE: Join neighbours back together if one of them has got small, so the tree doesn't fill up with nearly empty nodes
+static void anchorSet_merge_small_children(WL_Anchor_Set *set, WL_Anchor_Node *node) {
+	u32 i = 0;
+	while(i + 1 < node->count) {
+		WL_Anchor_Node *a = node->children[i];
+		WL_Anchor_Node *b = node->children[i + 1];
+
+		bool merged = false;
+
+		if(a->is_leaf) {
+			bool is_small = (a->count < ANCHOR_SET_LEAF_COUNT / 4) || (b->count < ANCHOR_SET_LEAF_COUNT / 4);
+			if(is_small && (a->count + b->count) <= ANCHOR_SET_LEAF_COUNT) {
+				memcpy(a->entries + a->count, b->entries, b->count*sizeof(WL_Anchor_Entry));
+				a->count += b->count;
+				merged = true;
+			}
+		} else {
+			bool is_small = (a->count < ANCHOR_SET_MAX_CHILDREN / 4) || (b->count < ANCHOR_SET_MAX_CHILDREN / 4);
+			if(is_small && (a->count + b->count) <= ANCHOR_SET_MAX_CHILDREN) {
+				memcpy(a->children + a->count, b->children, b->count*sizeof(WL_Anchor_Node *));
+				a->count += b->count;
+				merged = true;
+
+				//NOTE: Point the children that moved at a before merging any of them
+				anchorSet_update_summary(set, a);
+
+				//NOTE: The children where the two nodes joined might be small now too
+				anchorSet_merge_small_children(set, a);
+			}
+		}
+
+		if(merged) {
+			anchorSet_update_summary(set, a);
+			anchorSet_free_node(set, b);
+			anchorSet_remove_child(node, i + 1);
+		} else {
+			i++;
+		}
+	}
+}
+
+static void anchorSet_remove_entry_(WL_Anchor_Set *set, WL_Anchor_Node *node, s64 index) {
+	if(node->is_leaf) {
+		u32 at = (u32)index;
+		memmove(node->entries + at, node->entries + at + 1, (node->count - (at + 1))*sizeof(WL_Anchor_Entry));
+		node->count--;
+		anchorSet_update_summary(set, node);
+	} else {
+		u32 i = 0;
+		while(index >= node->children[i]->anchor_count) {
+			index -= node->children[i]->anchor_count;
+			i++;
+		}
+
+		WL_Anchor_Node *child = node->children[i];
+		if(child->anchor_count == 1) {
+			//NOTE: Only the one anchor is under it, so the whole child goes
+			while(!child->is_leaf) {
+				WL_Anchor_Node *only_child = child->children[0];
+				anchorSet_free_node(set, child);
+				child = only_child;
+			}
+			anchorSet_free_node(set, child);
+			anchorSet_remove_child(node, i);
+		} else {
+			anchorSet_remove_entry_(set, child, index);
+		}
+
+		anchorSet_merge_small_children(set, node);
+		anchorSet_update_summary(set, node);
+	}
+}
+
+static void anchorSet_remove_entry(WL_Anchor_Set *set, s64 index) {
+	anchorSet_remove_entry_(set, set->root, index);
+
+	//NOTE: Make the tree shallower if the root only has one child left
+	while(!set->root->is_leaf && set->root->count == 1) {
+		WL_Anchor_Node *old_root = set->root;
+		set->root = old_root->children[0];
+		anchorSet_free_node(set, old_root);
+	}
+	set->root->parent = 0;
+}
+
+//NOTE: Puts an anchor that isn't in the tree at the offset
+static void anchorSet_place(WL_Anchor_Set *set, WL_Anchor anchor, s64 byte_offset) {
+	assert(byte_offset >= 0);
+
+	//NOTE: Anchors that stay go before the ones that move at the same offset
+	bool moves = (set->infos[anchor].gravity == WL_ANCHOR_MOVES_WITH_INSERT);
+
+	s64 offset_before = 0;
+	s64 index = anchorSet_count_before(set, byte_offset, moves, &offset_before);
+
+	WL_Anchor_Entry entry = {};
+	entry.gap = byte_offset - offset_before;
+	entry.anchor = anchor;
+
+	//NOTE: The anchor after it is measured from this one now
+	if(index < anchorSet_get_anchor_count(set)) {
+		anchorSet_add_to_gap(set, index, -entry.gap);
+	}
+
+	anchorSet_insert_entry(set, index, entry);
+}
+
+//NOTE: Takes an anchor out of the tree without letting go of the handle
+static void anchorSet_take_out(WL_Anchor_Set *set, WL_Anchor anchor) {
+	s64 index = anchorSet_get_index(set, anchor);
+
+	u32 slot = 0;
+	WL_Anchor_Node *leaf = anchorSet_find_index(set, index, &slot);
+	s64 gap = leaf->entries[slot].gap;
+
+	anchorSet_remove_entry(set, index);
+	set->infos[anchor].leaf = 0;
+
+	//NOTE: The anchor after it is measured from the one before now
+	if(index < anchorSet_get_anchor_count(set)) {
+		anchorSet_add_to_gap(set, index, gap);
+	}
+}
+
+static WL_Anchor anchorSet_add(WL_Anchor_Set *set, s64 byte_offset, WL_Anchor_Gravity gravity) {
+	WL_Anchor anchor = set->free_anchors;
+
+	if(anchor) {
+		set->free_anchors = set->infos[anchor].next_free;
+	} else {
+		if(set->info_count >= set->info_total) {
+			s32 new_total = 2*set->info_total;
+			WL_Anchor_Info *infos = (WL_Anchor_Info *)platform_alloc_memory(new_total*sizeof(WL_Anchor_Info), true);
+			memcpy(infos, set->infos, set->info_count*sizeof(WL_Anchor_Info));
+			platform_free_memory(set->infos);
+
+			set->infos = infos;
+			set->info_total = new_total;
+		}
+
+		anchor = set->info_count++;
+	}
+
+	WL_Anchor_Info *info = &set->infos[anchor];
+	info->gravity = gravity;
+	info->next_free = 0;
+
+	anchorSet_place(set, anchor, byte_offset);
+
+	return anchor;
+}
+
+static void anchorSet_remove(WL_Anchor_Set *set, WL_Anchor anchor) {
+	anchorSet_take_out(set, anchor);
+
+	set->infos[anchor].next_free = set->free_anchors;
+	set->free_anchors = anchor;
+}
+
+static void anchorSet_set_offset(WL_Anchor_Set *set, WL_Anchor anchor, s64 byte_offset) {
+	anchorSet_take_out(set, anchor);
+	anchorSet_place(set, anchor, byte_offset);
+}
+
+static inline WL_Anchor_Gravity anchorSet_get_gravity_at_index(WL_Anchor_Set *set, s64 index) {
+	u32 slot = 0;
+	WL_Anchor_Node *leaf = anchorSet_find_index(set, index, &slot);
+	return set->infos[leaf->entries[slot].anchor].gravity;
+}
+
+static void anchorSet_insert_text(WL_Anchor_Set *set, s64 byte_offset, s64 size_in_bytes) {
+	//NOTE: Skip the anchors at the offset that stay, the first one that moves & everything after it gets pushed along
+	s64 index = anchorSet_count_before(set, byte_offset, false);
+	s64 end = anchorSet_count_before(set, byte_offset, true);
+
+	while(index < end && anchorSet_get_gravity_at_index(set, index) == WL_ANCHOR_STAYS_BEFORE_INSERT) {
+		index++;
+	}
+
+	if(index < anchorSet_get_anchor_count(set)) {
+		anchorSet_add_to_gap(set, index, size_in_bytes);
+	}
+}
+
+//NOTE: After a remove, the anchors that ended up at the same offset might have ones that move in front of ones that stay. Put them back in order.
+static void anchorSet_sort_anchors_at(WL_Anchor_Set *set, s64 byte_offset) {
+	s64 start = anchorSet_count_before(set, byte_offset, false);
+	s64 end = anchorSet_count_before(set, byte_offset, true);
+
+	bool out_of_order = false;
+	bool seen_moves = false;
+	for(s64 i = start; i < end && !out_of_order; ++i) {
+		bool moves = (anchorSet_get_gravity_at_index(set, i) == WL_ANCHOR_MOVES_WITH_INSERT);
+		out_of_order = (seen_moves && !moves);
+		seen_moves |= moves;
+	}
+
+	if(out_of_order) {
+		s64 count = end - start;
+		WL_Anchor *anchors = (WL_Anchor *)platform_alloc_memory(count*sizeof(WL_Anchor), false);
+
+		//NOTE: They're all at the same offset so only the anchors swap places, the gaps stay where they are
+		s64 at = 0;
+		for(int pass = 0; pass < 2; ++pass) {
+			WL_Anchor_Gravity gravity = (pass == 0) ? WL_ANCHOR_STAYS_BEFORE_INSERT : WL_ANCHOR_MOVES_WITH_INSERT;
+			for(s64 i = start; i < end; ++i) {
+				u32 slot = 0;
+				WL_Anchor_Node *leaf = anchorSet_find_index(set, i, &slot);
+				WL_Anchor anchor = leaf->entries[slot].anchor;
+				if(set->infos[anchor].gravity == gravity) {
+					anchors[at++] = anchor;
+				}
+			}
+		}
+		assert(at == count);
+
+		for(s64 i = 0; i < count; ++i) {
+			u32 slot = 0;
+			WL_Anchor_Node *leaf = anchorSet_find_index(set, start + i, &slot);
+			leaf->entries[slot].anchor = anchors[i];
+			set->infos[anchors[i]].leaf = leaf;
+		}
+
+		platform_free_memory(anchors);
+	}
+}
+
+static void anchorSet_remove_text(WL_Anchor_Set *set, s64 byte_offset, s64 size_in_bytes) {
+	if(size_in_bytes > 0) {
+		//NOTE: The anchors in the removed text, anchors at the start of it stay where they are
+		s64 offset_before = 0;
+		s64 first = anchorSet_count_before(set, byte_offset, true, &offset_before);
+		s64 end = anchorSet_count_before(set, byte_offset + size_in_bytes, true);
+
+		//NOTE: They all end up at the start of the removed text
+		s64 at = offset_before;
+		for(s64 i = first; i < end; ++i) {
+			u32 slot = 0;
+			WL_Anchor_Node *leaf = anchorSet_find_index(set, i, &slot);
+			at += leaf->entries[slot].gap;
+
+			s64 new_gap = (i == first) ? (byte_offset - offset_before) : 0;
+			anchorSet_add_to_gap(set, i, new_gap - leaf->entries[slot].gap);
+		}
+
+		//NOTE: The first anchor after the removed text moves back by however much of its gap was removed
+		if(end < anchorSet_get_anchor_count(set)) {
+			s64 removed_from_gap = byte_offset + size_in_bytes - ((end > first) ? at : byte_offset);
+			anchorSet_add_to_gap(set, end, -removed_from_gap);
+		}
+
+		if(end > first) {
+			anchorSet_sort_anchors_at(set, byte_offset);
+		}
+	}
+}
@@ -3,219 +3,1321 @@ enum BufferControllerOption {
     BUFFER_SIMPLE //NOTE: Single line text box so you can't move up and down or add newline to buffer
 };
 
+//NOTE: Somewhere we know a token starts, so the lexer can start from there instead of the top of the file. 
+//		The lexer doesn't keep any state between tokens apart from the line number.
+struct WL_Lex_Checkpoint {
+	s64 offset;
+	int lineNumber;
+};
+
+//NOTE: How far apart the checkpoints are
+#define WL_BUFFER_LEX_CHECKPOINT_SPACING_IN_BYTES (4*1024)
+
+//NOTE: How far past the end of a token the lexer might look to decide where it ends, so an edit this close after a checkpoint might move it
+#define WL_BUFFER_LEX_LOOKAHEAD_IN_BYTES 16
+
+//NOTE: A line that took more than one row the last time it was drawn with the text wrapped
+struct WL_Wrapped_Line {
+	WL_Anchor line_start; //NOTE: An anchor so it stays on the line when the lines above it get edited
+	s64 extra_rows; //NOTE: Rows past the first one
+};
+
+struct WL_Buffer_Snapshot;
+
 typedef struct {
-	s64 cursorAt_inBytes;
-	s64 markAt_inBytes;
+	//NOTE: Anchors so they stay on the same text when the buffer gets edited somewhere else. Use wl_buffer_get_cursor & wl_buffer_set_cursor
+	WL_Anchor cursor;
+	WL_Anchor mark;
 	bool markActive;
 
-	u32 bufferSize_inUse_inBytes;
-	u32 bufferSize_inBytes;
-	//NOTE: This DOESN'T include a null terminator 
-	u8 *bufferMemory;
+	//NOTE: Offsets that move with the text as it's edited, see wl_anchor_set.cpp
+	WL_Anchor_Set anchors;
+
+	//NOTE: Only read & edit this through the functions below, so it doesn't matter how it's stored. See wl_buffer_storage.cpp
+	WL_Buffer_Storage storage;
 
+	//NOTE: Sorted by offset. They get made as the buffer is drawn & thrown away when the text before them changes. See wl_buffer_get_lex_checkpoint
+	WL_Lex_Checkpoint *lex_checkpoints;
+	s64 lex_checkpoint_count;
+	s64 lex_checkpoint_total;
 
-	//NOTE: Use a gap buffer for temporarily 
-	u32 gapBuffer_endAt;
-	u32 gapBuffer_startAt;
+	//NOTE: Sorted by offset. Lines that aren't in here are one row, they get added as the buffer is drawn wrapped. See wl_buffer_get_wrapped_row_of_line
+	WL_Wrapped_Line *wrapped_lines;
+	s64 *wrapped_rows_before; //NOTE: Extra rows of all the wrapped lines before each one, made again when one changes
+	s64 wrapped_line_count;
+	s64 wrapped_line_total;
+	s64 wrapped_extra_rows;
+	bool wrapped_rows_before_is_stale;
+	float wrap_width; //NOTE: What the rows were counted at, they all get thrown away if it changes
+
+	//NOTE: The snapshot of the buffer as it is now, it might be sharing the buffer's memory. See wl_buffer_unpin
+	WL_Buffer_Snapshot *current_snapshot;
 
 	UndoRedoState undo_redo_state;
 
 } WL_Buffer;
 
-#define GAP_BUFFER_SIZE_IN_BYTES 2
-
 /*
 Functions to use: 
 
 //NOTE: Whenever you want to add text to it
 addTextToBuffer(buffer, stringToAdd, start);
 
-//NOTE: Whenever you move the cursor, you'll want to end the gap buffer
+//NOTE: Only if you want the text contiguous in the gap buffer's memory, moving the cursor doesn't need it
 endGapBuffer(buffer); 
 
 //NOTE: Whenever you want to remove text from the buffer
 removeTextFromBuffer(buffer, bytesStart, toRemoveCount_inBytes)
 
+//NOTE: The cursor's an anchor, so it stays on the same text when the buffer's edited somewhere else
+wl_buffer_get_cursor(buffer);
+wl_buffer_set_cursor(buffer, offset);
+
+//NOTE: For offsets that should move with the text, like bookmarks or search matches
+anchorSet_add(&buffer->anchors, offset, gravity);
+
+//NOTE: To any revision in the undo tree, not just the ones undo & redo get to
+wl_buffer_jump_to_revision(buffer, index_in_history);
+
+//NOTE: Lots of edits at once, like replacing every match. One pass over the text & one undo group.
+WL_Buffer_Transaction transaction = {};
+wl_buffer_transaction_add(&transaction, offset, deleteSize, insert, insertSize); //NOTE: In order through the text
+wl_buffer_commit_transaction(buffer, &transaction);
+
+//NOTE: Undo & redo a block, or the whole group it's in
+wl_buffer_undo(buffer);
+wl_buffer_redo(buffer);
+
 */
 
-static void initBuffer(WL_Buffer *b) {
+static void initBuffer(WL_Buffer *b, WL_Buffer_Storage_Type storage_type = WL_BUFFER_STORAGE_GAP_BUFFER) {
 	memset(b, 0, sizeof(WL_Buffer));
 
+	bufferStorage_init(&b->storage, storage_type);
+
+	anchorSet_init(&b->anchors);
+	b->cursor = anchorSet_add(&b->anchors, 0, WL_ANCHOR_STAYS_BEFORE_INSERT);
+	b->mark = anchorSet_add(&b->anchors, 0, WL_ANCHOR_STAYS_BEFORE_INSERT);
+
 	init_undo_redo_state(&b->undo_redo_state);
 }
 
+static void wl_buffer_unpin(WL_Buffer *b, bool buffer_is_being_freed = false);
+static void wl_buffer_release_undo_checkpoints(WL_Buffer *b);
+
 static void wl_emptyBuffer(WL_Buffer *b) {
+	wl_buffer_unpin(b, true);
+	wl_buffer_release_undo_checkpoints(b);
+
+	bufferStorage_free(&b->storage);
+	anchorSet_free(&b->anchors);
+	free_undo_redo_state(&b->undo_redo_state);
 
-	platform_free_memory(b->bufferMemory);
+	if(b->lex_checkpoints) {
+		easyPlatform_freeMemory(b->lex_checkpoints);
+	}
+
+	if(b->wrapped_lines) {
+		easyPlatform_freeMemory(b->wrapped_lines);
+		easyPlatform_freeMemory(b->wrapped_rows_before);
+	}
 
 	memset(b, 0, sizeof(WL_Buffer));
 
 }
 
-static void makeGapBuffer_(WL_Buffer *b, int byteStart, int gapSize) {
+//NOTE: Only for empty buffers i.e. just before we load a file into it
+static void wl_buffer_change_storage_type(WL_Buffer *b, WL_Buffer_Storage_Type storage_type) {
+	if(b->storage.type != storage_type) {
+		wl_buffer_unpin(b, true);
+		assert(bufferStorage_get_size_in_bytes(&b->storage) == 0);
+
+		bufferStorage_free(&b->storage);
+		bufferStorage_init(&b->storage, storage_type);
+	}
+}
+
+//NOTE: Only for empty buffers. The buffer reads straight out of the mapped file, and unmaps it when it's emptied. 
+//		skip_in_bytes is for skipping a BOM at the start of the file. The buffer starts out empty, the text goes in a 
+//		bit at a time with wl_buffer_add_file_map_text as it gets checked, so a big file doesn't stall the frame.
+static void wl_buffer_init_from_file_map(WL_Buffer *b, Platform_File_Map file_map, s64 skip_in_bytes) {
+	wl_buffer_change_storage_type(b, WL_BUFFER_STORAGE_PIECE_TABLE);
+	WL_Piece_Table *pt = &b->storage.piece_table;
+	assert(pieceTable_get_size_in_bytes(pt) == 0);
+
+	pieceTable_free(pt);
+	pieceTable_init_from_file_map(pt, file_map, skip_in_bytes);
+}
+
+static inline bool wl_buffer_is_file_mapped(WL_Buffer *b) {
+	return (b->storage.type == WL_BUFFER_STORAGE_PIECE_TABLE && b->storage.piece_table.file_map);
+}
+
+//NOTE: The buffer & every snapshot still reading the mapped file. We can't save over the file till the snapshots have let go of it.
+static inline u32 wl_buffer_get_file_map_ref_count(WL_Buffer *b) {
+	assert(wl_buffer_is_file_mapped(b));
+	return b->storage.piece_table.file_map->ref_count;
+}
+
+//NOTE: Lets go of the mapped file so it can be saved over. Nothing can read the buffer till wl_buffer_map_file gives it a file again, 
+//		and no snapshots can be reading the file, see wl_buffer_get_file_map_ref_count. Returns the size of the BOM the text started after.
+static s64 wl_buffer_unmap_file(WL_Buffer *b) {
+	assert(wl_buffer_is_file_mapped(b));
+	assert(!b->current_snapshot);
+
+	return pieceTable_unmap_file(&b->storage.piece_table);
+}
+
+//NOTE: After wl_buffer_unmap_file. Either the same file again with pieces null, or the saved file with the pieces from wl_buffer_rebase_onto_saved_file. 
+//		The text doesn't change so the line index and lex checkpoints are still right.
+static void wl_buffer_map_file(WL_Buffer *b, Platform_File_Map file_map, s64 skip_in_bytes, WL_Piece *pieces = 0, s64 piece_count = 0) {
+	assert(b->storage.type == WL_BUFFER_STORAGE_PIECE_TABLE);
+	assert(!b->current_snapshot);
+
+	pieceTable_map_file(&b->storage.piece_table, file_map, skip_in_bytes, pieces, piece_count);
+}
+
+//NOTE: The file has the same text as the buffer, so read out of it instead of the old file & the add buffer. 
+//		The text doesn't change so the line index and lex checkpoints are still right.
+static void wl_buffer_swap_to_file_map(WL_Buffer *b, Platform_File_Map file_map) {
+	WL_Piece_Table *pt = &b->storage.piece_table;
+	assert(b->storage.type == WL_BUFFER_STORAGE_PIECE_TABLE);
+	assert((s64)file_map.size_in_bytes == pieceTable_get_size_in_bytes(pt));
+	assert(!b->current_snapshot);
+
+	pieceTable_free(pt);
+	pieceTable_init_from_file_map(pt, file_map, 0);
+	pieceTable_append_original(pt, 0, pt->original_size_in_bytes);
+}
+
+/*
+Functions to read the buffer without caring how it is stored. Offsets are in bytes from the start of the text, not counting the gap.
+
+*/
+
+static s64 wl_buffer_get_size_in_bytes(WL_Buffer *b) {
+	return bufferStorage_get_size_in_bytes(&b->storage);
+}
+
+static inline s64 wl_buffer_get_cursor(WL_Buffer *b) {
+	return anchorSet_get_offset(&b->anchors, b->cursor);
+}
+
+static inline void wl_buffer_set_cursor(WL_Buffer *b, s64 offset) {
+	anchorSet_set_offset(&b->anchors, b->cursor, offset);
+}
+
+//NOTE: Returns 0 if the offset is outside the buffer
+static u8 wl_buffer_get_byte(WL_Buffer *b, s64 offset) {
+	return bufferStorage_get_byte(&b->storage, offset);
+}
+
+static void wl_buffer_copy_bytes(WL_Buffer *b, s64 start, s64 size_in_bytes, u8 *dest) {
+	assert(start >= 0 && (start + size_in_bytes) <= wl_buffer_get_size_in_bytes(b));
+	bufferStorage_copy_bytes(&b->storage, start, size_in_bytes, dest);
+}
+
+//NOTE: The contiguous run of text at the offset, so you can walk the buffer without copying it. 
+//		Isn't null terminated & is only valid until the buffer gets edited.
+static u8 *wl_buffer_get_span(WL_Buffer *b, s64 offset, s64 *size_in_bytes) {
+	assert(offset >= 0 && offset < wl_buffer_get_size_in_bytes(b));
+	return bufferStorage_get_span(&b->storage, offset, size_in_bytes);
+}
+//NOTE: Copies the text into the arena and null terminates it
+static char *wl_buffer_copy_to_arena(WL_Buffer *b, s64 start, s64 size_in_bytes, Memory_Arena *arena) {
+	char *result = (char *)pushSize(arena, size_in_bytes + 1);
+	wl_buffer_copy_bytes(b, start, size_in_bytes, (u8 *)result);
+	result[size_in_bytes] = '\0';
+	return result;
+}
 
-	/*Gap Buffer always assumes the start of the gap buffer is at the cursor position
+//NOTE: Get the codepoint at the offset and advance the offset past it 
+static u32 wl_buffer_get_rune(WL_Buffer *b, s64 *offset) {
+	char bytes[5] = {};
 
-	*/
+	s64 count = wl_buffer_get_size_in_bytes(b) - *offset;
+	if(count > 4) { count = 4; }
 
-	if(!b->bufferMemory) {
-		b->bufferMemory = (u8 *)platform_alloc_memory(gapSize, true);
-		b->bufferSize_inBytes = gapSize;
+	u32 rune = 0;
+	if(count > 0) {
+		wl_buffer_copy_bytes(b, *offset, count, (u8 *)bytes);
+
+		char *at = bytes;
+		rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&at, true);
+		*offset += (at - bytes);
 	}
+	
+	return rune;
+}
 
-	//NOTE: Make total buffer bigger if full
-	if((b->bufferSize_inUse_inBytes + gapSize) > b->bufferSize_inBytes) {
+static int wl_buffer_get_size_of_rune_before(WL_Buffer *b, s64 offset) {
+	char bytes[4] = {};
 
-		b->bufferMemory = (u8 *)platform_realloc_memory(b->bufferMemory, b->bufferSize_inUse_inBytes, b->bufferSize_inBytes + gapSize);
-		b->bufferSize_inBytes += gapSize;
-		
-	} 
+	s64 count = (offset < 4) ? offset : 4;
+	wl_buffer_copy_bytes(b, offset - count, count, (u8 *)bytes);
+
+	return size_of_last_utf8_codepoint_in_bytes(bytes, (int)count);
+}
+
+static int wl_buffer_get_size_of_rune_at(WL_Buffer *b, s64 offset) {
+	char bytes[2] = {};
+	bytes[0] = wl_buffer_get_byte(b, offset);
+	return size_of_next_utf8_codepoint_in_bytes(bytes);
+}
+
+static inline bool wl_buffer_is_newline_byte(u8 byte) {
+	return (byte == '\n' || byte == '\r');
+}
+
+static s64 wl_buffer_get_line_count(WL_Buffer *b) {
+	return bufferStorage_get_line_count(&b->storage);
+}
+
+//NOTE: Which line the offset is on, lines start at 0. Multiply by the line height to get the y position
+static s64 wl_buffer_get_line_index(WL_Buffer *b, s64 offset) {
+	return bufferStorage_get_line_at_offset(&b->storage, offset);
+}
+
+//NOTE: Offset of the start of the line, lines start at 0. Returns the end of the buffer if there aren't that many lines
+static s64 wl_buffer_get_offset_of_line(WL_Buffer *b, s64 line_index) {
+	return bufferStorage_get_offset_of_line(&b->storage, line_index);
+}
+
+//NOTE: Offset of the first byte of the line that offset is on
+static s64 wl_buffer_get_line_start(WL_Buffer *b, s64 offset) {
+	return wl_buffer_get_offset_of_line(b, wl_buffer_get_line_index(b, offset));
+}
+
+//NOTE: Offset of the newline at the end of the line that offset is on, or the end of the buffer if it's the last line
+static s64 wl_buffer_get_line_end(WL_Buffer *b, s64 offset) {
+	//NOTE: The start of the next line, or the end of the buffer on the last line
+	s64 result = wl_buffer_get_offset_of_line(b, wl_buffer_get_line_index(b, offset) + 1);
+
+	//NOTE: Move back off the newline
+	if(result > 0 && wl_buffer_get_byte(b, result - 1) == '\n') { result--; }
+	if(result > 0 && wl_buffer_get_byte(b, result - 1) == '\r') { result--; }
+
+	//NOTE: Offset was already on the newline 
+	if(result < offset) { result = offset; }
+
+	return result;
+}
+
+#define WL_BUFFER_PEEK_WINDOW_IN_BYTES 256
+
+//NOTE: Look at the token behind the offset. The text is copied into a small window, so the token's 'at' pointer isn't into the buffer
+static EasyToken wl_buffer_peek_token_backwards(WL_Buffer *b, s64 offset) {
+	s64 start = offset - WL_BUFFER_PEEK_WINDOW_IN_BYTES;
+	if(start < 0) { start = 0; }
+
+	char *window = wl_buffer_copy_to_arena(b, start, offset - start, &globalPerFrameArena);
+	return peekTokenBackwards_tokenNotComplete(window + (offset - start) - 1, window);
+}
+
+static EasyToken wl_buffer_peek_token_forward(WL_Buffer *b, s64 offset) {
+	s64 end = offset + WL_BUFFER_PEEK_WINDOW_IN_BYTES;
+	s64 size = wl_buffer_get_size_in_bytes(b);
+	if(end > size) { end = size; }
+
+	char *window = wl_buffer_copy_to_arena(b, offset, end - offset, &globalPerFrameArena);
+	return peekTokenForward_tokenNotComplete(window, window + (end - offset));
+}
+
+/*
+Snapshots are the text of the buffer at one point in time, so jobs on other threads can read it while the user keeps editing.
+Taking one is O(1), it shares the buffer's memory & nothing gets copied unless the buffer gets edited while it's shared. See wl_buffer_storage.cpp
+Taking another one before the buffer changes gives you the same snapshot again.
+
+They're reference counted so they can be handed to more than one job. Any thread can let go of one with wl_buffer_release_snapshot,
+that's just an atomic decrement so readers never take a lock. The main thread frees the ones nobody's holding in wl_buffer_free_released_snapshots.
+
+Snapshots are taken & freed on the main thread, retaining, releasing & reading them is safe on any thread.
+*/
+struct WL_Buffer_Snapshot {
+	//NOTE: Only changed with platform_atomic_add
+	volatile s32 ref_count;
+
+	//NOTE: Null once the buffer has changed. Only the main thread looks at this
+	WL_Buffer *buffer;
+
+	WL_Buffer_Storage_Snapshot storage;
+	s64 size_in_bytes;
+
+	//NOTE: All the snapshots that haven't been freed yet, see global_wl_buffer_snapshots
+	WL_Buffer_Snapshot *next;
+};
+
+//NOTE: Only the main thread touches the list
+static WL_Buffer_Snapshot *global_wl_buffer_snapshots = 0;
+
+//NOTE: Call wl_buffer_release_snapshot when you're finished with it
+static WL_Buffer_Snapshot *wl_buffer_take_snapshot(WL_Buffer *b) {
+	WL_Buffer_Snapshot *snapshot = b->current_snapshot;
+
+	if(snapshot) {
+		//NOTE: Nothing's changed since the last one, so share it
+		platform_atomic_add(&snapshot->ref_count, 1);
+	} else {
+		snapshot = (WL_Buffer_Snapshot *)platform_alloc_memory(sizeof(WL_Buffer_Snapshot), true);
+		snapshot->ref_count = 1;
+		snapshot->buffer = b;
+
+		bufferStorage_take_snapshot(&b->storage, &snapshot->storage);
+		snapshot->size_in_bytes = snapshot->storage.size_in_bytes;
+
+		snapshot->next = global_wl_buffer_snapshots;
+		global_wl_buffer_snapshots = snapshot;
+
+		b->current_snapshot = snapshot;
+	}
+
+	return snapshot;
+}
+
+//NOTE: For handing the snapshot to another job. Only from a thread that's already holding it
+static inline void wl_buffer_retain_snapshot(WL_Buffer_Snapshot *snapshot) {
+	platform_atomic_add(&snapshot->ref_count, 1);
+}
+
+//NOTE: Safe on any thread, the snapshot gets freed on the main thread later
+static inline void wl_buffer_release_snapshot(WL_Buffer_Snapshot *snapshot) {
+	s32 ref_count = platform_atomic_add(&snapshot->ref_count, -1);
+	assert(ref_count >= 0);
+}
+
+//NOTE: True if the buffer hasn't changed since the snapshot was taken. Only on the main thread
+static inline bool wl_buffer_snapshot_is_current(WL_Buffer_Snapshot *snapshot) {
+	return (snapshot->buffer != 0);
+}
+
+//NOTE: Called before the buffer's memory changes. If a snapshot is sharing it, give the memory to the snapshot and keep going with a copy, 
+//		or with a storage type that can share it. The storage type can change, so check it after this.
+static void wl_buffer_unpin(WL_Buffer *b, bool buffer_is_being_freed) {
+	WL_Buffer_Snapshot *snapshot = b->current_snapshot;
 
-	//NOTE: Move everything down to make room in the buffer for the gap
-	for(int i = (b->bufferSize_inUse_inBytes - 1); i >= byteStart; i--) {
-		b->bufferMemory[i + gapSize] = b->bufferMemory[i];
+	if(snapshot) {
+		assert(snapshot->buffer == b);
+
+		//NOTE: Only the main thread can take a new reference to the current snapshot, so if no one's holding it no one's reading the memory
+		if(snapshot->ref_count > 0) {
+			bufferStorage_detach_snapshot(&b->storage, &snapshot->storage, buffer_is_being_freed);
+		}
+
+		snapshot->buffer = 0;
+		b->current_snapshot = 0;
 	}
-	b->gapBuffer_startAt = byteStart;
-	b->gapBuffer_endAt = b->gapBuffer_startAt + gapSize; 
+}
+
+//NOTE: Frees the snapshots that no thread is holding anymore. Called every frame on the main thread
+static void wl_buffer_free_released_snapshots() {
+	WL_Buffer_Snapshot **at = &global_wl_buffer_snapshots;
+
+	while(*at) {
+		WL_Buffer_Snapshot *snapshot = *at;
+
+		if(snapshot->ref_count == 0) {
+			if(snapshot->buffer) {
+				assert(snapshot->buffer->current_snapshot == snapshot);
+				snapshot->buffer->current_snapshot = 0;
+			}
 
-	b->bufferSize_inUse_inBytes += gapSize;
+			bufferStorage_free_snapshot(&snapshot->storage);
+
+			*at = snapshot->next;
+			platform_free_memory(snapshot);
+		} else {
+			at = &snapshot->next;
+		}
+	}
 }
 
+//NOTE: Walk the snapshot's text from the offset a contiguous run at a time, with wl_buffer_snapshot_next_span. Safe on any thread holding the snapshot.
+static inline WL_Buffer_Storage_Snapshot_Iterator wl_buffer_snapshot_begin_iterator(WL_Buffer_Snapshot *snapshot, s64 offset) {
+	return bufferStorage_snapshot_begin_iterator(&snapshot->storage, offset);
+}
+
+//NOTE: Returns null at the end. The run isn't null terminated
+static inline u8 *wl_buffer_snapshot_next_span(WL_Buffer_Storage_Snapshot_Iterator *it, s64 *size_in_bytes) {
+	return bufferStorage_snapshot_next_span(it, size_in_bytes);
+}
 
-//NOTE: We end the gap buffer whenever we move the cursor
+//NOTE: The snapshot's text has just been saved to a new file that's going to replace the mapped one. Works out where the buffer's text from 
+//		the mapped file is in the new one, for wl_buffer_map_file once it's there. Call it before the snapshot gets released. 
+//		Free the pieces with platform_free_memory
+static WL_Piece *wl_buffer_rebase_onto_saved_file(WL_Buffer *b, WL_Buffer_Snapshot *saved, s64 *piece_count) {
+	WL_Piece_Table *pt = &b->storage.piece_table;
+	assert(wl_buffer_is_file_mapped(b));
+	assert(saved->storage.type == WL_BUFFER_STORAGE_PIECE_TABLE && saved->storage.original == pt->original);
+
+	return pieceTable_rebase_pieces(pt, saved->storage.pieces, saved->storage.piece_count, piece_count);
+}
+
+//NOTE: Flattens the buffer so the text is one contiguous run at the start of the gap buffer's memory. 
+//		Moving the cursor doesn't need this anymore, only use it if you want to read the memory directly
 static void endGapBuffer(WL_Buffer *b) {
-	//NOTE: Remove gap that was open
-	if(b->gapBuffer_startAt < b->gapBuffer_endAt) {
-		int gapDiff = b->gapBuffer_endAt - b->gapBuffer_startAt;
+	wl_buffer_unpin(b);
+	//NOTE: A big gap buffer that a snapshot was reading carries on as a piece table. See bufferStorage_detach_snapshot
+	assert(b->storage.type == WL_BUFFER_STORAGE_GAP_BUFFER);
+	gapBuffer_flatten(&b->storage.gap_buffer);
+}
 
-		//NOTE: Move all memory down to fill the gap
-		for(int i = 0; i < (b->bufferSize_inUse_inBytes - b->gapBuffer_endAt); i++) {
-			b->bufferMemory[b->gapBuffer_startAt + i] = b->bufferMemory[b->gapBuffer_startAt + gapDiff + i];
+
+//NOTE: The last checkpoint at or before the offset, or the start of the buffer if there isn't one
+static WL_Lex_Checkpoint wl_buffer_get_lex_checkpoint(WL_Buffer *b, s64 offset) {
+	WL_Lex_Checkpoint result = {};
+
+	s64 low = 0;
+	s64 high = b->lex_checkpoint_count;
+	while(low < high) {
+		s64 middle = low + (high - low) / 2;
+		if(b->lex_checkpoints[middle].offset <= offset) {
+			result = b->lex_checkpoints[middle];
+			low = middle + 1;
+		} else {
+			high = middle;
 		}
+	}
 
-		//NOTE: remove empty room on buffer
-		b->bufferSize_inUse_inBytes -= gapDiff;
+	return result;
+}
 
-		b->gapBuffer_endAt = 0;
-		b->gapBuffer_startAt = 0;
+//NOTE: Call with the start of each token as you lex. Only keeps one every WL_BUFFER_LEX_CHECKPOINT_SPACING_IN_BYTES
+static void wl_buffer_add_lex_checkpoint(WL_Buffer *b, s64 offset, int lineNumber) {
+	s64 last_offset = (b->lex_checkpoint_count > 0) ? b->lex_checkpoints[b->lex_checkpoint_count - 1].offset : 0;
+
+	if(offset >= last_offset + WL_BUFFER_LEX_CHECKPOINT_SPACING_IN_BYTES) {
+		if(b->lex_checkpoint_count >= b->lex_checkpoint_total) {
+			s64 new_total = (b->lex_checkpoint_total > 0) ? 2*b->lex_checkpoint_total : 64;
+			if(b->lex_checkpoints) {
+				b->lex_checkpoints = (WL_Lex_Checkpoint *)easyPlatform_reallocMemory(b->lex_checkpoints, b->lex_checkpoint_total*sizeof(WL_Lex_Checkpoint), new_total*sizeof(WL_Lex_Checkpoint));
+			} else {
+				b->lex_checkpoints = (WL_Lex_Checkpoint *)easyPlatform_allocateMemory(new_total*sizeof(WL_Lex_Checkpoint), EASY_PLATFORM_MEMORY_NONE);
+			}
+			b->lex_checkpoint_total = new_total;
+		}
 
-	} else {
-		assert(b->gapBuffer_startAt == b->gapBuffer_endAt);
+		WL_Lex_Checkpoint *checkpoint = &b->lex_checkpoints[b->lex_checkpoint_count++];
+		checkpoint->offset = offset;
+		checkpoint->lineNumber = lineNumber;
+	}
+}
+
+//NOTE: Text changed at offset, so the tokens after it might start somewhere else now
+static void wl_buffer_invalidate_lex_checkpoints(WL_Buffer *b, s64 offset) {
+	while(b->lex_checkpoint_count > 0 && (b->lex_checkpoints[b->lex_checkpoint_count - 1].offset + WL_BUFFER_LEX_LOOKAHEAD_IN_BYTES) > offset) {
+		b->lex_checkpoint_count--;
 	}
+}
 
+static inline s64 wl_buffer_get_wrapped_line_offset(WL_Buffer *b, s64 index) {
+	return anchorSet_get_offset(&b->anchors, b->wrapped_lines[index].line_start);
 }
 
+//NOTE: Index of the first wrapped line at or after the offset. The anchors keep the same order as the text gets edited, so the offsets stay sorted.
+static s64 wl_buffer_find_wrapped_line(WL_Buffer *b, s64 offset) {
+	s64 low = 0;
+	s64 high = b->wrapped_line_count;
+	while(low < high) {
+		s64 middle = low + (high - low) / 2;
+		if(wl_buffer_get_wrapped_line_offset(b, middle) < offset) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
 
-static void addTextToBuffer(WL_Buffer *b, char *str, int indexStart, bool should_add_to_history = true, s32 groupId = -1) {
+static void wl_buffer_update_wrapped_rows_before(WL_Buffer *b) {
+	if(b->wrapped_rows_before_is_stale) {
+		s64 total = 0;
+		for(s64 i = 0; i < b->wrapped_line_count; ++i) {
+			b->wrapped_rows_before[i] = total;
+			total += b->wrapped_lines[i].extra_rows;
+		}
+		b->wrapped_extra_rows = total;
+		b->wrapped_rows_before_is_stale = false;
+	}
+}
 
-	//NOTE: Always make sure we end any gap buffers
-	if(indexStart != b->cursorAt_inBytes) {
-		endGapBuffer(b);
+//NOTE: The wrapped lines only fit the width they were drawn at, so they get thrown away when it changes
+static void wl_buffer_set_wrap_width(WL_Buffer *b, float wrap_width) {
+	if(b->wrap_width != wrap_width) {
+		for(s64 i = 0; i < b->wrapped_line_count; ++i) {
+			anchorSet_remove(&b->anchors, b->wrapped_lines[i].line_start);
+		}
+		b->wrapped_line_count = 0;
+		b->wrapped_extra_rows = 0;
+		b->wrapped_rows_before_is_stale = false;
+		b->wrap_width = wrap_width;
 	}
+}
 
-	u32 strSize_inBytes = easyString_getSizeInBytes_utf8(str); 
+//NOTE: Call with how many rows a line took to draw. line_end is the offset of its newline, or the end of the buffer. 
+//		Returns how many more rows the line takes than we thought it did.
+static s64 wl_buffer_set_wrapped_rows(WL_Buffer *b, s64 line_start, s64 line_end, s64 extra_rows) {
+	//NOTE: The lines that got joined onto this one might have left their anchors in it too
+	s64 first = wl_buffer_find_wrapped_line(b, line_start);
+	s64 end = wl_buffer_find_wrapped_line(b, line_end + 1);
 
-	if(strSize_inBytes > 0) {
+	s64 old_extra_rows = 0;
+	for(s64 i = first; i < end; ++i) {
+		old_extra_rows += b->wrapped_lines[i].extra_rows;
+	}
 
-		if(should_add_to_history) {
-			push_block(&b->undo_redo_state, UNDO_REDO_INSERT, b->cursorAt_inBytes, nullTerminate(str, strSize_inBytes), strSize_inBytes, b->cursorAt_inBytes, groupId);
+	bool already_there = (end - first == 1 && wl_buffer_get_wrapped_line_offset(b, first) == line_start && old_extra_rows == extra_rows);
+	if(!(already_there || (end == first && extra_rows == 0))) {
+		for(s64 i = first; i < end; ++i) {
+			anchorSet_remove(&b->anchors, b->wrapped_lines[i].line_start);
 		}
-		
-		int gapBufferSize = (int)b->gapBuffer_endAt - (int)b->gapBuffer_startAt;
 
-		if(gapBufferSize < strSize_inBytes) {
-			//NOTE: Make gap buffer bigger
-			makeGapBuffer_(b, indexStart, max(strSize_inBytes, 0)); //GAP_BUFFER_SIZE_IN_BYTES
-			assert((b->gapBuffer_endAt - b->gapBuffer_startAt) >= strSize_inBytes);
+		s64 keep = (extra_rows > 0) ? 1 : 0;
+		s64 new_count = b->wrapped_line_count - (end - first) + keep;
+		if(new_count > b->wrapped_line_total) {
+			s64 new_total = (b->wrapped_line_total > 0) ? 2*b->wrapped_line_total : 64;
+			if(b->wrapped_lines) {
+				b->wrapped_lines = (WL_Wrapped_Line *)easyPlatform_reallocMemory(b->wrapped_lines, b->wrapped_line_total*sizeof(WL_Wrapped_Line), new_total*sizeof(WL_Wrapped_Line));
+				b->wrapped_rows_before = (s64 *)easyPlatform_reallocMemory(b->wrapped_rows_before, b->wrapped_line_total*sizeof(s64), new_total*sizeof(s64));
+			} else {
+				b->wrapped_lines = (WL_Wrapped_Line *)easyPlatform_allocateMemory(new_total*sizeof(WL_Wrapped_Line), EASY_PLATFORM_MEMORY_NONE);
+				b->wrapped_rows_before = (s64 *)easyPlatform_allocateMemory(new_total*sizeof(s64), EASY_PLATFORM_MEMORY_NONE);
+			}
+			b->wrapped_line_total = new_total;
 		}
 
-		//NOTE: Now add the string to the buffer
-		for(int i = 0; i < strSize_inBytes; ++i) {
-			b->bufferMemory[b->gapBuffer_startAt + i] = str[i];
-			assert(b->gapBuffer_startAt + i < b->gapBuffer_endAt);
+		memmove(b->wrapped_lines + first + keep, b->wrapped_lines + end, (b->wrapped_line_count - end)*sizeof(WL_Wrapped_Line));
+		b->wrapped_line_count = new_count;
+
+		if(keep) {
+			b->wrapped_lines[first].line_start = anchorSet_add(&b->anchors, line_start, WL_ANCHOR_STAYS_BEFORE_INSERT);
+			b->wrapped_lines[first].extra_rows = extra_rows;
 		}
 
-		b->gapBuffer_startAt += strSize_inBytes;
-		b->cursorAt_inBytes = indexStart + strSize_inBytes;
-		
+		b->wrapped_rows_before_is_stale = true;
 	}
+
+	return extra_rows - old_extra_rows;
 }
 
+//NOTE: Which row the line starts on when the text's wrapped. Lines that haven't been drawn yet count as one row.
+static s64 wl_buffer_get_wrapped_row_of_line(WL_Buffer *b, s64 line_index) {
+	wl_buffer_update_wrapped_rows_before(b);
 
-static void removeTextFromBuffer(WL_Buffer *b, int bytesStart, int toRemoveCount_inBytes, bool should_add_to_history = true, s32 groupId = -1) {
-	
-	if(bytesStart != b->cursorAt_inBytes) {
-		endGapBuffer(b);
+	s64 index = wl_buffer_find_wrapped_line(b, wl_buffer_get_offset_of_line(b, line_index));
+	s64 extra_rows = (index < b->wrapped_line_count) ? b->wrapped_rows_before[index] : b->wrapped_extra_rows;
+
+	return line_index + extra_rows;
+}
+
+//NOTE: The line the row is on when the text's wrapped, and how many rows into that line it is
+static s64 wl_buffer_get_line_of_wrapped_row(WL_Buffer *b, s64 row, s64 *row_in_line) {
+	wl_buffer_update_wrapped_rows_before(b);
+
+	//NOTE: Find the last wrapped line that starts at or above the row
+	s64 low = 0;
+	s64 high = b->wrapped_line_count;
+	while(low < high) {
+		s64 middle = low + (high - low) / 2;
+		s64 start_row = wl_buffer_get_line_index(b, wl_buffer_get_wrapped_line_offset(b, middle)) + b->wrapped_rows_before[middle];
+		if(start_row <= row) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
 	}
 
-	//NOTE: See if has an active gap
-	int gapDiff = b->gapBuffer_endAt - b->gapBuffer_startAt;
-	
-	//NOTE: No active gap
-	if(gapDiff == 0) {
-		b->gapBuffer_startAt = bytesStart; 
-		b->gapBuffer_endAt = bytesStart + toRemoveCount_inBytes;
+	s64 line = row;
+	s64 rows_into_line = 0;
+	if(low > 0) {
+		WL_Wrapped_Line *wrapped = &b->wrapped_lines[low - 1];
+		s64 wrapped_line = wl_buffer_get_line_index(b, anchorSet_get_offset(&b->anchors, wrapped->line_start));
+		s64 start_row = wrapped_line + b->wrapped_rows_before[low - 1];
+
+		if(row <= start_row + wrapped->extra_rows) {
+			line = wrapped_line;
+			rows_into_line = row - start_row;
+		} else {
+			//NOTE: The lines after it are a row each
+			line = row - (b->wrapped_rows_before[low - 1] + wrapped->extra_rows);
+		}
+	}
+
+	s64 line_count = wl_buffer_get_line_count(b);
+	if(line > line_count - 1) { 
+		line = line_count - 1; 
+		rows_into_line = 0;
+	}
+	if(line < 0) { line = 0; }
+
+	if(row_in_line) { *row_in_line = rows_into_line; }
+	return line;
+}
+
+//NOTE: Adds the text without moving the cursor or adding it to the undo buffer. The anchors after it move along with the text.
+static void wl_buffer_insert_bytes(WL_Buffer *b, s64 offset, u8 *bytes, s64 size_in_bytes) {
+	wl_buffer_invalidate_lex_checkpoints(b, offset);
+	wl_buffer_unpin(b);
+
+	bufferStorage_insert(&b->storage, offset, bytes, size_in_bytes);
+	anchorSet_insert_text(&b->anchors, offset, size_in_bytes);
+}
+
+//NOTE: Puts the rest of a file on the end, with the line index the loading thread built for all of it. Takes the index. See update_file_load
+static void wl_buffer_append_with_line_index(WL_Buffer *b, u8 *bytes, s64 size_in_bytes, WL_Line_Index *line_index) {
+	s64 offset = wl_buffer_get_size_in_bytes(b);
+
+	wl_buffer_invalidate_lex_checkpoints(b, offset);
+	wl_buffer_unpin(b);
+
+	bufferStorage_append_with_line_index(&b->storage, bytes, size_in_bytes, line_index);
+	anchorSet_insert_text(&b->anchors, offset, size_in_bytes);
+}
+
+//NOTE: Puts the next bit of the mapped file on the end of the buffer, see wl_buffer_init_from_file_map. It has to be utf8 since it doesn't get copied.
+//		It's the start of the text in the file after the BOM, not the offset in the buffer. Pass the line index if the loading thread 
+//		built one for the whole file & this is the rest of it, the index gets taken instead of finding the lines here.
+static void wl_buffer_add_file_map_text(WL_Buffer *b, s64 original_start, s64 size_in_bytes, WL_Line_Index *line_index = 0) {
+	WL_Piece_Table *pt = &b->storage.piece_table;
+	assert(wl_buffer_is_file_mapped(b));
+	s64 offset = wl_buffer_get_size_in_bytes(b);
+
+	wl_buffer_invalidate_lex_checkpoints(b, offset);
+	wl_buffer_unpin(b);
+
+	pieceTable_append_original(pt, original_start, size_in_bytes);
+	if(line_index) {
+		lineIndex_free(&b->storage.line_index);
+		b->storage.line_index = *line_index;
+		memset(line_index, 0, sizeof(WL_Line_Index));
+		assert(lineIndex_get_size_in_bytes(&b->storage.line_index) == pieceTable_get_size_in_bytes(pt));
 	} else {
-		assert((b->gapBuffer_startAt - toRemoveCount_inBytes) >= 0);
-		b->gapBuffer_startAt -= toRemoveCount_inBytes;
+		lineIndex_insert(&b->storage.line_index, offset, pt->original + original_start, size_in_bytes);
+	}
+	anchorSet_insert_text(&b->anchors, offset, size_in_bytes);
+}
+
+//NOTE: Removes the text without moving the cursor or adding it to the undo buffer. Anchors in the text end up at offset.
+static void wl_buffer_remove_bytes(WL_Buffer *b, s64 offset, s64 size_in_bytes) {
+	wl_buffer_invalidate_lex_checkpoints(b, offset);
+	wl_buffer_unpin(b);
+
+	bufferStorage_remove(&b->storage, offset, size_in_bytes);
+	anchorSet_remove_text(&b->anchors, offset, size_in_bytes);
+}
+
+static void wl_buffer_free_undo_checkpoint(UndoRedoState *state, UndoRedoBlock *block) {
+	UndoRedoCheckpoint *checkpoint = block->checkpoint;
+	assert(!checkpoint->snapshot);
+
+	state->checkpoint_bytes -= undoRedo_get_checkpoint_bytes(checkpoint);
+	easyPlatform_freeMemory(checkpoint->compressed);
+	easyPlatform_freeMemory(checkpoint);
+	block->checkpoint = 0;
+}
+
+//NOTE: Lets go of the oldest checkpoints till they fit in the budget. They were made in order, so the oldest is the first one in the history.
+//		Stops at one that's still being compressed, it gets let go of once it's finished.
+static void wl_buffer_trim_undo_checkpoints(UndoRedoState *state, s64 budget_in_bytes) {
+	while(state->checkpoint_bytes > budget_in_bytes && state->oldest_checkpoint < state->block_count) {
+		UndoRedoBlock *block = &state->history[state->oldest_checkpoint];
+		if(block->checkpoint) {
+			if(block->checkpoint->snapshot) {
+				break;
+			}
+			wl_buffer_free_undo_checkpoint(state, block);
+		}
+		state->oldest_checkpoint++;
+	}
+}
+
+//NOTE: Once another thread has finished compressing them, keep the compressed text & let go of the snapshots. Called every frame,
+//		or with wait_for_them to finish them all now.
+static void wl_buffer_update_undo_checkpoints(WL_Buffer *b, bool wait_for_them = false) {
+	UndoRedoState *state = &b->undo_redo_state;
+
+	UndoRedoCheckpoint **at = &state->compressing_checkpoints;
+	while(*at) {
+		UndoRedoCheckpoint *checkpoint = *at;
+
+		//NOTE: Compressing one doesn't take long, but it might not have started yet so help with the queue till it's done
+		while(wait_for_them && checkpoint->is_compressing) {
+			platform_help_with_queued_work();
+		}
+
+		if(!checkpoint->is_compressing) {
+			//NOTE: Keep a copy that's only as big as it needs to be
+			checkpoint->compressed = (u8 *)easyPlatform_allocateMemory(checkpoint->compressed_size_in_bytes, EASY_PLATFORM_MEMORY_NONE);
+			memcpy(checkpoint->compressed, checkpoint->compressing_into, checkpoint->compressed_size_in_bytes);
+			easyPlatform_freeMemory(checkpoint->compressing_into);
+			checkpoint->compressing_into = 0;
+
+			wl_buffer_release_snapshot(checkpoint->snapshot);
+			checkpoint->snapshot = 0;
+
+			state->checkpoint_bytes += checkpoint->compressed_size_in_bytes - checkpoint->size_in_bytes;
+
+			*at = checkpoint->next_compressing;
+			checkpoint->next_compressing = 0;
+		} else {
+			at = &checkpoint->next_compressing;
+		}
+	}
+
+	//NOTE: They take up less now, and the ones that were being compressed can be let go of
+	wl_buffer_trim_undo_checkpoints(state, UNDO_REDO_CHECKPOINT_BUDGET_IN_BYTES);
+}
+
+static void wl_buffer_release_undo_checkpoints(WL_Buffer *b) {
+	UndoRedoState *state = &b->undo_redo_state;
+	wl_buffer_update_undo_checkpoints(b, true);
+
+	for(int i = state->oldest_checkpoint; i < state->block_count; ++i) {
+		if(state->history[i].checkpoint) {
+			wl_buffer_free_undo_checkpoint(state, &state->history[i]);
+		}
+	}
+	assert(state->checkpoint_bytes == 0);
+	state->oldest_checkpoint = state->block_count;
+}
+
+//NOTE: Call straight after the edit of a new block. Every UNDO_REDO_CHECKPOINT_INTERVAL deep we keep the text, so wl_buffer_jump_to_revision 
+//		can start from there. It's a snapshot that another thread compresses, it's taken after the edit so it shares the buffer's memory 
+//		till the next one, which is usually long enough for it to get compressed & let go of without being copied.
+static void wl_buffer_add_undo_checkpoint(WL_Buffer *b) {
+	UndoRedoState *state = &b->undo_redo_state;
+	UndoRedoBlock *block = &state->history[state->current];
+	s64 size = wl_buffer_get_size_in_bytes(b);
+
+	//NOTE: Not for mapped files, the snapshot would hold onto the map & we have to let go of it to save over the file
+	if((block->depth % UNDO_REDO_CHECKPOINT_INTERVAL) == 0 && !block->checkpoint && !wl_buffer_is_file_mapped(b) && size <= UNDO_REDO_CHECKPOINT_BUDGET_IN_BYTES / 4) {
+		UndoRedoCheckpoint *checkpoint = (UndoRedoCheckpoint *)easyPlatform_allocateMemory(sizeof(UndoRedoCheckpoint), EASY_PLATFORM_MEMORY_ZERO);
+		checkpoint->size_in_bytes = size;
+		checkpoint->stringLength = block->stringLength;
+		checkpoint->snapshot = wl_buffer_take_snapshot(b);
+
+		//NOTE: The main thread gives the thread the memory to compress into, with room for a piece of the text at the end to compress from
+		checkpoint->compressing_into = (u8 *)easyPlatform_allocateMemory(undoRedo_get_max_checkpoint_size(size) + UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES, EASY_PLATFORM_MEMORY_NONE);
+		checkpoint->is_compressing = true;
+
+		checkpoint->next_compressing = state->compressing_checkpoints;
+		state->compressing_checkpoints = checkpoint;
+
+		block->checkpoint = checkpoint;
+		state->checkpoint_bytes += size;
+
+		if(global_platform.push_work_onto_queue) {
+			global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_compress_undo_checkpoint, checkpoint);
+		} else {
+			thread_work_compress_undo_checkpoint(checkpoint);
+		}
+	}
+
+	wl_buffer_trim_undo_checkpoints(state, UNDO_REDO_CHECKPOINT_BUDGET_IN_BYTES);
+}
+
+//NOTE: Puts the text back to how it was at the checkpoint's block. From the snapshot if it's still got it, otherwise a piece at a time
+static void wl_buffer_restore_undo_checkpoint(WL_Buffer *b, s32 index) {
+	UndoRedoState *state = &b->undo_redo_state;
+	UndoRedoCheckpoint *checkpoint = state->history[index].checkpoint;
+
+	wl_buffer_remove_bytes(b, 0, wl_buffer_get_size_in_bytes(b));
+
+	s64 offset = 0;
+	if(checkpoint->snapshot) {
+		s64 span_size = 0;
+		WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(checkpoint->snapshot, 0);
+		while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+			wl_buffer_insert_bytes(b, offset, span, span_size);
+			offset += span_size;
+		}
+	} else {
+		u8 *piece = (u8 *)easyPlatform_allocateMemory(UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES, EASY_PLATFORM_MEMORY_NONE);
+		u8 *at = checkpoint->compressed;
+		while(offset < checkpoint->size_in_bytes) {
+			s64 piece_size = checkpoint->size_in_bytes - offset;
+			if(piece_size > UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES) { piece_size = UNDO_REDO_CHECKPOINT_PIECE_SIZE_IN_BYTES; }
+
+			u32 compressed_size = 0;
+			memcpy(&compressed_size, at, sizeof(u32));
+			at += sizeof(u32);
+
+			if(compressed_size == piece_size) {
+				wl_buffer_insert_bytes(b, offset, at, piece_size);
+			} else {
+				bool decompressed = lz_decompress(at, compressed_size, piece, piece_size);
+				assert(decompressed);
+				wl_buffer_insert_bytes(b, offset, piece, piece_size);
+			}
+
+			at += compressed_size;
+			offset += piece_size;
+		}
+		assert(at == checkpoint->compressed + checkpoint->compressed_size_in_bytes);
+		easyPlatform_freeMemory(piece);
+	}
+	assert(offset == checkpoint->size_in_bytes);
+
+	//NOTE: Typing carried on onto the block after it was taken, do the rest of it
+	UndoRedoBlock *block = undoRedo_load_block(state, &state->history[index]);
+	s64 rest = block->stringLength - checkpoint->stringLength;
+	if(rest > 0) {
+		if(block->type == UNDO_REDO_INSERT) {
+			wl_buffer_insert_bytes(b, block->byteAt + checkpoint->stringLength, (u8 *)block->string + checkpoint->stringLength, rest);
+		} else {
+			//NOTE: Backspacing adds onto the front of the block
+			wl_buffer_remove_bytes(b, block->byteAt, rest);
+		}
+	}
+
+	state->current = index;
+}
+
+//NOTE: For text that isn't null terminated, or is too big for easyString_getSizeInBytes_utf8 to count
+static void addTextToBuffer_withSize(WL_Buffer *b, char *str, s64 strSize_inBytes, s64 indexStart, bool should_add_to_history = true, s32 groupId = -1) {
+	if(strSize_inBytes <= 0) {
+		return;
 	}
 
+	if(should_add_to_history) {
+		push_block(&b->undo_redo_state, UNDO_REDO_INSERT, indexStart, str, strSize_inBytes, wl_buffer_get_cursor(b), groupId);
+	}
+
+	wl_buffer_insert_bytes(b, indexStart, (u8 *)str, strSize_inBytes);
+
+	if(should_add_to_history) {
+		wl_buffer_add_undo_checkpoint(b);
+	}
+
+	wl_buffer_set_cursor(b, indexStart + strSize_inBytes);
+}
+
+static void addTextToBuffer(WL_Buffer *b, char *str, s64 indexStart, bool should_add_to_history = true, s32 groupId = -1) {
+	addTextToBuffer_withSize(b, str, easyString_getSizeInBytes_utf8(str), indexStart, should_add_to_history, groupId);
+}
+
+
+static void removeTextFromBuffer(WL_Buffer *b, s64 bytesStart, s64 toRemoveCount_inBytes, bool should_add_to_history = true, s32 groupId = -1) {
 	if(should_add_to_history) {
 		//NOTE: only add if this is a new command, not a repeat of the text 
-		push_block(&b->undo_redo_state, UNDO_REDO_DELETE, b->gapBuffer_startAt, nullTerminate((char *)(b->bufferMemory + b->gapBuffer_startAt), toRemoveCount_inBytes), toRemoveCount_inBytes, b->cursorAt_inBytes, groupId);
+		//NOTE: Copy the text straight into the undo memory
+		char *removed = push_block_reserve(&b->undo_redo_state, UNDO_REDO_DELETE, bytesStart, toRemoveCount_inBytes, wl_buffer_get_cursor(b), groupId);
+		wl_buffer_copy_bytes(b, bytesStart, toRemoveCount_inBytes, (u8 *)removed);
+		push_block_finish(&b->undo_redo_state);
 	} 
 
-	 b->cursorAt_inBytes = bytesStart;
+	wl_buffer_remove_bytes(b, bytesStart, toRemoveCount_inBytes);
+
+	if(should_add_to_history) {
+		wl_buffer_add_undo_checkpoint(b);
+	}
+
+	wl_buffer_set_cursor(b, bytesStart);
 	
 }
 
-#define WRITE_GAP_BUFFER_AS_HASH 0
+//NOTE: Typing at the cursor. Joins onto the last undo block while the typing carries on from it, see push_block_coalesced
+static void addTypedTextToBuffer(WL_Buffer *b, char *str, s64 strSize_inBytes, s64 indexStart) {
+	if(strSize_inBytes <= 0) {
+		return;
+	}
+
+	bool is_new_block = push_block_coalesced(&b->undo_redo_state, UNDO_REDO_INSERT, indexStart, str, strSize_inBytes, wl_buffer_get_cursor(b));
 
-struct Compiled_Buffer_For_Drawing {
-	size_t size_in_bytes;
-	u8 *memory;
+	wl_buffer_insert_bytes(b, indexStart, (u8 *)str, strSize_inBytes);
 
-	size_t cursor_at;
-	size_t shift_begin;
-	size_t shift_end;
-};
+	if(is_new_block) {
+		wl_buffer_add_undo_checkpoint(b);
+	}
+
+	wl_buffer_set_cursor(b, indexStart + strSize_inBytes);
+}
+
+//NOTE: Backspacing at the cursor, joins onto the last undo block like addTypedTextToBuffer
+static void removeTypedTextFromBuffer(WL_Buffer *b, s64 bytesStart, s64 toRemoveCount_inBytes) {
+	if(toRemoveCount_inBytes <= 0) {
+		return;
+	}
 
+	char *removed = wl_buffer_copy_to_arena(b, bytesStart, toRemoveCount_inBytes, &globalPerFrameArena);
+	bool is_new_block = push_block_coalesced(&b->undo_redo_state, UNDO_REDO_DELETE, bytesStart, removed, toRemoveCount_inBytes, wl_buffer_get_cursor(b));
 
-static Compiled_Buffer_For_Drawing compileBuffer_toDraw(WL_Buffer *b, Memory_Arena *tempArena, Selectable_State *selectState) {
-	Compiled_Buffer_For_Drawing result = {};
+	wl_buffer_remove_bytes(b, bytesStart, toRemoveCount_inBytes);
 
-	bool wroteEndSelect = false;
-	bool wroteStartSelect = false;
+	if(is_new_block) {
+		wl_buffer_add_undo_checkpoint(b);
+	}
 
-	bool wroteCursor = false;
-	result.memory = (u8 *)pushSize(tempArena, b->bufferSize_inBytes + 1); //NOTE: For null terminator and cursor spot
-	int at = 0;
+	wl_buffer_set_cursor(b, bytesStart);
+}
 
-	for(int i = 0; i < b->bufferSize_inUse_inBytes; i++) {
-		
-		if(i == b->cursorAt_inBytes) { result.cursor_at = result.size_in_bytes; wroteCursor = true; }
+//NOTE: Does a block to the text, or the opposite of it if we're undoing. False if it doesn't fit the text, i.e. the history's from a journal that's no good.
+static bool wl_buffer_apply_undo_block(WL_Buffer *b, UndoRedoBlock *block, bool is_redo) {
+	undoRedo_load_block(&b->undo_redo_state, block);
 
-		if(i == selectState->start_offset_in_bytes) { result.shift_begin = result.size_in_bytes; wroteStartSelect = true; }
+	bool insert = (block->type == UNDO_REDO_INSERT) == is_redo;
+	s64 size = wl_buffer_get_size_in_bytes(b);
 
-		if(i == selectState->end_offset_in_bytes) { result.shift_end = result.size_in_bytes; wroteEndSelect = true; }
+	bool result = false;
+	if(insert) {
+		if(block->byteAt >= 0 && block->byteAt <= size) {
+			wl_buffer_insert_bytes(b, block->byteAt, (u8 *)block->string, block->stringLength);
+			wl_buffer_set_cursor(b, block->byteAt + block->stringLength);
+			result = true;
+		}
+	} else {
+		if(block->byteAt >= 0 && block->byteAt + block->stringLength <= size) {
+			wl_buffer_remove_bytes(b, block->byteAt, block->stringLength);
+			wl_buffer_set_cursor(b, block->byteAt);
+			result = true;
+		}
+	}
+	return result;
+}
+
+//NOTE: Edits that get done to the text all at once, see wl_buffer_commit_transaction
+struct WL_Buffer_Transaction {
+	WL_Buffer_Edit *edits;
+	s64 edit_count;
+	s64 edit_total;
+};
+
+//NOTE: Add them in order through the text. The offsets are in the text before any of the edits, and can't be inside the text an
+//		earlier one removes. The insert text isn't copied, so it has to stay around till the transaction's committed.
+static void wl_buffer_transaction_add(WL_Buffer_Transaction *t, s64 offset, s64 delete_size, char *insert, s64 insert_size) {
+	if(delete_size <= 0 && insert_size <= 0) {
+		return;
+	}
 
-		if(i >= b->gapBuffer_startAt && i < b->gapBuffer_endAt) {
-			//NOTE: In Gap Buffer
+	if(t->edit_count > 0) {
+		WL_Buffer_Edit *last = &t->edits[t->edit_count - 1];
+		assert(offset >= last->offset + last->delete_size);
+	}
+
+	if(t->edit_count >= t->edit_total) {
+		s64 new_total = (t->edit_total > 0) ? 2*t->edit_total : 64;
+		if(t->edits) {
+			t->edits = (WL_Buffer_Edit *)easyPlatform_reallocMemory(t->edits, t->edit_total*sizeof(WL_Buffer_Edit), new_total*sizeof(WL_Buffer_Edit));
 		} else {
-			result.memory[result.size_in_bytes++] = b->bufferMemory[i];
+			t->edits = (WL_Buffer_Edit *)easyPlatform_allocateMemory(new_total*sizeof(WL_Buffer_Edit), EASY_PLATFORM_MEMORY_NONE);
+		}
+		t->edit_total = new_total;
+	}
+
+	WL_Buffer_Edit *edit = &t->edits[t->edit_count++];
+	edit->offset = offset;
+	edit->delete_size = delete_size;
+	edit->insert = (u8 *)insert;
+	edit->insert_size = insert_size;
+}
+
+static void wl_buffer_free_transaction(WL_Buffer_Transaction *t) {
+	if(t->edits) {
+		easyPlatform_freeMemory(t->edits);
+	}
+	memset(t, 0, sizeof(WL_Buffer_Transaction));
+}
+
+//NOTE: Does the edits without adding them to the undo buffer. The anchors move like they would if the edits were done one at a time.
+static void wl_buffer_apply_edits(WL_Buffer *b, WL_Buffer_Edit *edits, s64 edit_count) {
+	if(edit_count <= 0) {
+		return;
+	}
+
+	wl_buffer_invalidate_lex_checkpoints(b, edits[0].offset);
+	wl_buffer_unpin(b);
+
+	bufferStorage_apply_edits(&b->storage, edits, edit_count);
+
+	s64 shift = 0;
+	for(s64 i = 0; i < edit_count; ++i) {
+		WL_Buffer_Edit *edit = &edits[i];
+		anchorSet_remove_text(&b->anchors, edit->offset + shift, edit->delete_size);
+		anchorSet_insert_text(&b->anchors, edit->offset + shift, edit->insert_size);
+		shift += edit->insert_size - edit->delete_size;
+	}
+}
+
+//NOTE: Does all the edits in one pass over the text & adds them to the undo buffer as one group, then frees the transaction. 
+//		The cursor moves with the text like the other anchors.
+static void wl_buffer_commit_transaction(WL_Buffer *b, WL_Buffer_Transaction *t, bool should_add_to_history = true) {
+	if(t->edit_count > 0 && should_add_to_history) {
+		UndoRedoState *state = &b->undo_redo_state;
+		s32 groupId = state->groupIdAt++;
+		s64 cursor = wl_buffer_get_cursor(b);
+
+		//NOTE: The blocks are the edits done one at a time, so their offsets are in the text after the ones before them
+		s64 shift = 0;
+		for(s64 i = 0; i < t->edit_count; ++i) {
+			WL_Buffer_Edit *edit = &t->edits[i];
+			s64 at = edit->offset + shift;
+
+			if(edit->delete_size > 0) {
+				char *removed = push_block_reserve(state, UNDO_REDO_DELETE, at, edit->delete_size, cursor, groupId);
+				wl_buffer_copy_bytes(b, edit->offset, edit->delete_size, (u8 *)removed);
+				push_block_finish(state);
+			}
+
+			if(edit->insert_size > 0) {
+				push_block(state, UNDO_REDO_INSERT, at, (char *)edit->insert, edit->insert_size, cursor, groupId);
+			}
+
+			shift += edit->insert_size - edit->delete_size;
+		}
+	}
+
+	wl_buffer_apply_edits(b, t->edits, t->edit_count);
+
+	//NOTE: Only the last one can have a checkpoint, the text in between the edits is never there to take a snapshot of
+	if(t->edit_count > 0 && should_add_to_history) {
+		wl_buffer_add_undo_checkpoint(b);
+	}
+	wl_buffer_free_transaction(t);
+}
+
+//NOTE: Where the cursor ends up after doing the block, or the opposite of it if we're undoing
+static inline s64 wl_buffer_get_cursor_after_undo_block(UndoRedoBlock *block, bool is_redo) {
+	bool insert = (block->type == UNDO_REDO_INSERT) == is_redo;
+	return (insert) ? block->byteAt + block->stringLength : block->byteAt;
+}
+
+//NOTE: Undoes the last block, or all of the blocks in its group. Returns the last one it undid, null if there wasn't one.
+//		A group whose blocks go forwards through the text without overlapping, like a transaction makes, gets undone in one pass.
+static UndoRedoBlock *wl_buffer_undo(WL_Buffer *b) {
+	UndoRedoState *state = &b->undo_redo_state;
+	UndoRedoBlock *result = see_undo_block(state);
+	if(!result) {
+		return result;
+	}
+
+	s32 groupId = result->groupId;
+
+	//NOTE: Going back up the group, each block has to start after the one before it ended
+	s64 count = 1;
+	bool is_in_order = true;
+	if(groupId >= 0) {
+		UndoRedoBlock *later = result;
+		for(s32 at = result->parent; at >= 0 && state->history[at].groupId == groupId; at = state->history[at].parent) {
+			UndoRedoBlock *block = &state->history[at];
+			s64 end = (block->type == UNDO_REDO_INSERT) ? block->byteAt + block->stringLength : block->byteAt;
+			if(later->byteAt < end) {
+				is_in_order = false;
+			}
+			later = block;
+			count++;
+		}
+	}
+
+	if(count > 1 && is_in_order) {
+		//NOTE: The blocks come out last first, the edits go in the other way around. They're all in the text as it is now.
+		WL_Buffer_Edit *edits = pushArray(&globalPerFrameArena, count, WL_Buffer_Edit);
+		for(s64 i = count - 1; i >= 0; --i) {
+			result = get_undo_block(state);
+
+			WL_Buffer_Edit *edit = &edits[i];
+			memset(edit, 0, sizeof(WL_Buffer_Edit));
+			edit->offset = result->byteAt;
+			if(result->type == UNDO_REDO_INSERT) {
+				edit->delete_size = result->stringLength;
+			} else {
+				edit->insert = (u8 *)result->string;
+				edit->insert_size = result->stringLength;
+			}
+		}
+
+		wl_buffer_apply_edits(b, edits, count);
+		wl_buffer_set_cursor(b, wl_buffer_get_cursor_after_undo_block(result, false));
+	} else {
+		for(s64 i = 0; i < count; ++i) {
+			result = get_undo_block(state);
+			wl_buffer_apply_undo_block(b, result, false);
+		}
+	}
+
+	return result;
+}
+
+//NOTE: Redoes the next block, or all of the blocks in its group, like wl_buffer_undo
+static UndoRedoBlock *wl_buffer_redo(WL_Buffer *b) {
+	UndoRedoState *state = &b->undo_redo_state;
+	UndoRedoBlock *result = see_redo_block(state);
+	if(!result) {
+		return result;
+	}
+
+	s32 groupId = result->groupId;
+
+	s64 count = 1;
+	bool is_in_order = true;
+	if(groupId >= 0) {
+		UndoRedoBlock *earlier = result;
+		for(s32 at = earlier->redo_child; at >= 0 && state->history[at].groupId == groupId; at = state->history[at].redo_child) {
+			UndoRedoBlock *block = &state->history[at];
+			s64 end = (earlier->type == UNDO_REDO_INSERT) ? earlier->byteAt + earlier->stringLength : earlier->byteAt;
+			if(block->byteAt < end) {
+				is_in_order = false;
+			}
+			earlier = block;
+			count++;
+		}
+	}
+
+	if(count > 1 && is_in_order) {
+		//NOTE: The blocks are in the text after the ones before them were done, the edits are all in the text as it is now
+		WL_Buffer_Edit *edits = pushArray(&globalPerFrameArena, count, WL_Buffer_Edit);
+		s64 shift = 0;
+		for(s64 i = 0; i < count; ++i) {
+			result = get_redo_block(state);
+
+			WL_Buffer_Edit *edit = &edits[i];
+			memset(edit, 0, sizeof(WL_Buffer_Edit));
+			edit->offset = result->byteAt - shift;
+			if(result->type == UNDO_REDO_INSERT) {
+				edit->insert = (u8 *)result->string;
+				edit->insert_size = result->stringLength;
+				shift += result->stringLength;
+			} else {
+				edit->delete_size = result->stringLength;
+				shift -= result->stringLength;
+			}
+		}
+
+		wl_buffer_apply_edits(b, edits, count);
+		wl_buffer_set_cursor(b, wl_buffer_get_cursor_after_undo_block(result, true));
+	} else {
+		for(s64 i = 0; i < count; ++i) {
+			result = get_redo_block(state);
+			wl_buffer_apply_undo_block(b, result, true);
+		}
+	}
+
+	return result;
+}
+
+//NOTE: Goes a block at a time up to where the two revisions branched off, then down to the target. Doesn't write to the journal.
+//		Stops at a block that doesn't fit the text & returns false, the history's at the last block that did.
+static bool wl_buffer_walk_to_revision(WL_Buffer *b, s32 target) {
+	UndoRedoState *state = &b->undo_redo_state;
+	s32 common = undoRedo_get_common_ancestor(state, state->current, target);
+
+	bool result = true;
+	while(result && state->current != common) {
+		result = wl_buffer_apply_undo_block(b, &state->history[state->current], false);
+		if(result) { undoRedo_move_to_parent(state); }
+	}
+
+	if(result) {
+		//NOTE: Point redo down the way to the target
+		for(s32 at = target; at != common; at = state->history[at].parent) {
+			*undoRedo_get_redo_child(state, state->history[at].parent) = at;
+		}
+	}
+
+	while(result && state->current != target) {
+		s32 child = *undoRedo_get_redo_child(state, state->current);
+		result = wl_buffer_apply_undo_block(b, &state->history[child], true);
+		if(result) { undoRedo_move_to_redo_child(state); }
+	}
+
+	return result;
+}
+
+//NOTE: Puts the text back to how it was at any revision in the undo tree, -1 for the text before any blocks. If a checkpoint at or above the 
+//		target is closer than where we are, the text gets put back from that first. So it's O(checkpoint distance + log n), not the whole way there.
+static void wl_buffer_jump_to_revision(WL_Buffer *b, s32 target) {
+	UndoRedoState *state = &b->undo_redo_state;
+	assert(target >= -1 && target < state->block_count);
+	state->coalesce_block_id = 0;
+
+	s32 common = undoRedo_get_common_ancestor(state, state->current, target);
+	s32 target_depth = undoRedo_get_depth(state, target);
+	s32 blocks_to_walk = undoRedo_get_depth(state, state->current) + target_depth - 2*undoRedo_get_depth(state, common);
+
+	//NOTE: Look for the nearest checkpoint above the target. Putting the text back from one costs about as much as a checkpoint interval of blocks.
+	s32 checkpoint = -1;
+	s32 depth = (target_depth / UNDO_REDO_CHECKPOINT_INTERVAL)*UNDO_REDO_CHECKPOINT_INTERVAL;
+	for(; depth > 0 && (target_depth - depth) + UNDO_REDO_CHECKPOINT_INTERVAL < blocks_to_walk; depth -= UNDO_REDO_CHECKPOINT_INTERVAL) {
+		s32 at = undoRedo_get_ancestor_at_depth(state, target, depth);
+		if(state->history[at].checkpoint) {
+			checkpoint = at;
+			break;
 		}
 	}
 
-	if(!wroteStartSelect) {
-		result.shift_begin = result.size_in_bytes;
+	if(checkpoint >= 0) {
+		wl_buffer_restore_undo_checkpoint(b, checkpoint);
 	}
 
-	if(!wroteEndSelect) {
-		result.shift_end = result.size_in_bytes;
+	bool walked = wl_buffer_walk_to_revision(b, target);
+	assert(walked);
+
+	if(state->journal) {
+		undoJournal_log_jump(state->journal, target);
 	}
+}
+
+//NOTE: Back to the last edit made at or before the time, see undoRedo_find_revision_at_time
+static void wl_buffer_jump_to_time(WL_Buffer *b, float time_in_seconds) {
+	wl_buffer_jump_to_revision(b, undoRedo_find_revision_at_time(&b->undo_redo_state, time_in_seconds));
+}
+
+//NOTE: A view of the buffer that doesn't copy it. For the gap buffer it's the text either side of the gap, 
+//		the other storage types get flattened into the first span. Both spans are null terminated so the lexer can read them directly.
+//		All the offsets passed to the view functions are buffer offsets, the view might only be part of the buffer (see wl_buffer_get_view_of_range).
+struct WL_Buffer_View {
+	u8 *spans[2];
+	s64 span_sizes[2];
+	s64 size_in_bytes;
+
+	//NOTE: Buffer offset of the first byte in spans[0]
+	s64 start;
+
+	size_t cursor_at;
+	size_t shift_begin;
+	size_t shift_end;
+};
+
+static u8 *global_wl_buffer_empty_span = (u8 *)"";
 
-	if(!wroteCursor) {
-		result.cursor_at = result.size_in_bytes;
+//NOTE: A view with at least the bytes from start to end in it. The gap buffer doesn't need copying so you get all of it, 
+//		the other storage types only copy that range, so drawing a big file only copies what's on the screen.
+//		The view is only valid until the buffer gets edited. The arena is only used if the storage type isn't a gap buffer.
+static WL_Buffer_View wl_buffer_get_view_of_range(WL_Buffer *b, Memory_Arena *tempArena, Selectable_State *selectState, s64 start, s64 end) {
+	WL_Buffer_View result = {};
+
+	result.spans[0] = global_wl_buffer_empty_span;
+	result.spans[1] = global_wl_buffer_empty_span;
+
+	s64 buffer_size = wl_buffer_get_size_in_bytes(b);
+	if(end > buffer_size) { end = buffer_size; }
+	if(start > end) { start = end; }
+
+	WL_Gap_Buffer *gb = &b->storage.gap_buffer;
+	if(b->storage.type != WL_BUFFER_STORAGE_GAP_BUFFER) {
+		result.start = start;
+		result.span_sizes[0] = end - start;
+		result.spans[0] = (u8 *)wl_buffer_copy_to_arena(b, start, result.span_sizes[0], tempArena);
+	} else if(gb->memory) {
+		result.spans[0] = gb->memory;
+		result.span_sizes[0] = gb->gap_start;
+
+		result.spans[1] = gb->memory + gb->gap_end;
+		result.span_sizes[1] = gb->size_in_bytes - gb->gap_end;
+
+		assert(result.spans[0][result.span_sizes[0]] == '\0');
+		assert(result.spans[1][result.span_sizes[1]] == '\0');
+	}
+
+	result.size_in_bytes = result.span_sizes[0] + result.span_sizes[1];
+
+	s64 cursor = wl_buffer_get_cursor(b);
+	result.cursor_at = (cursor < buffer_size) ? cursor : buffer_size;
+
+	result.shift_begin = buffer_size;
+	result.shift_end = buffer_size;
+
+	if(selectState) {
+		if(selectState->start_offset_in_bytes < buffer_size) { result.shift_begin = selectState->start_offset_in_bytes; }
+		if(selectState->end_offset_in_bytes < buffer_size) { result.shift_end = selectState->end_offset_in_bytes; }
 	}
 
 	//NOTE: make begin always first
@@ -225,145 +1327,343 @@ static Compiled_Buffer_For_Drawing compileBuffer_toDraw(WL_Buffer *b, Memory_Are
 		result.shift_end = temp;
 	}
 
-	result.memory[result.size_in_bytes] = '\0'; //null terminate the buffer
+	return result;
+}
+
+static inline WL_Buffer_View wl_buffer_get_view(WL_Buffer *b, Memory_Arena *tempArena, Selectable_State *selectState = 0) {
+	return wl_buffer_get_view_of_range(b, tempArena, selectState, 0, wl_buffer_get_size_in_bytes(b));
+}
 
+//NOTE: One past the buffer offset of the last byte in the view
+static inline s64 wl_buffer_view_get_end(WL_Buffer_View *view) {
+	return view->start + view->size_in_bytes;
+}
 
+//NOTE: Returns 0 if the offset is outside the view
+static inline u8 wl_buffer_view_get_byte(WL_Buffer_View *view, s64 offset) {
+	u8 result = 0;
+	offset -= view->start;
+	if(offset >= 0 && offset < view->span_sizes[0]) {
+		result = view->spans[0][offset];
+	} else if(offset >= view->span_sizes[0] && offset < view->size_in_bytes) {
+		result = view->spans[1][offset - view->span_sizes[0]];
+	}
 	return result;
 }
 
-struct Compiled_Buffer_For_Save {
-	size_t size_in_bytes;
-	u8 *memory;
-};
+static void wl_buffer_view_copy_bytes(WL_Buffer_View *view, s64 start, s64 size_in_bytes, u8 *dest) {
+	start -= view->start;
+	assert(start >= 0 && (start + size_in_bytes) <= view->size_in_bytes);
+	s64 end = start + size_in_bytes;
 
+	if(start < view->span_sizes[0]) {
+		s64 firstEnd = (end < view->span_sizes[0]) ? end : view->span_sizes[0];
+		memcpy(dest, view->spans[0] + start, firstEnd - start);
+		dest += (firstEnd - start);
+		start = firstEnd;
+	}
 
-static Compiled_Buffer_For_Save compile_buffer_to_save_format(WL_Buffer *b, Memory_Arena *temp_arena) {
-	Compiled_Buffer_For_Save result = {};
+	if(start < end) {
+		memcpy(dest, view->spans[1] + (start - view->span_sizes[0]), end - start);
+	}
+}
 
-	result.memory = (u8 *)pushSize(temp_arena, b->bufferSize_inBytes); //NOTE: Have to think about this more if using a chunked linked list format for the buffer 
+//NOTE: Copies the text into the arena and null terminates it
+static char *wl_buffer_view_copy_to_arena(WL_Buffer_View *view, s64 start, s64 size_in_bytes, Memory_Arena *arena) {
+	char *result = (char *)pushSize(arena, size_in_bytes + 1);
+	wl_buffer_view_copy_bytes(view, start, size_in_bytes, (u8 *)result);
+	result[size_in_bytes] = '\0';
+	return result;
+}
 
+//NOTE: Points straight into the buffer if the range doesn't cross the gap, otherwise copies just that range. 
+//		Isn't null terminated if it points into the buffer.
+static u8 *wl_buffer_view_get_range(WL_Buffer_View *view, s64 start, s64 size_in_bytes, Memory_Arena *arena) {
+	u8 *result = 0;
+	s64 local_start = start - view->start;
+	s64 end = local_start + size_in_bytes;
+	if(end <= view->span_sizes[0]) {
+		result = view->spans[0] + local_start;
+	} else if(local_start >= view->span_sizes[0]) {
+		result = view->spans[1] + (local_start - view->span_sizes[0]);
+	} else {
+		result = (u8 *)wl_buffer_view_copy_to_arena(view, start, size_in_bytes, arena);
+	}
+	return result;
+}
 
+struct WL_Buffer_View_Iterator {
+	WL_Buffer_View *view;
+	s64 offset;
 
-	for(int i = 0; i < b->bufferSize_inUse_inBytes; i++) {
-		
-		if(i >= b->gapBuffer_startAt && i < b->gapBuffer_endAt) {
-			//NOTE: In Gap Buffer, don't write 
-		} else {
-			result.memory[result.size_in_bytes++] = b->bufferMemory[i];
-		}
-	}
+	u8 *at;
+	u8 *span_end;
+	int span_index;
+};
 
+static WL_Buffer_View_Iterator wl_buffer_view_begin_iterator(WL_Buffer_View *view, s64 offset) {
+	WL_Buffer_View_Iterator result = {};
+	result.view = view;
+	result.offset = offset;
 
+	s64 local_offset = offset - view->start;
+	if(local_offset < view->span_sizes[0]) {
+		result.span_index = 0;
+		result.at = view->spans[0] + local_offset;
+	} else {
+		result.span_index = 1;
+		result.at = view->spans[1] + (local_offset - view->span_sizes[0]);
+	}
+	result.span_end = view->spans[result.span_index] + view->span_sizes[result.span_index];
 
 	return result;
 }
 
-static size_t convert_compiled_byte_point_to_buffer_byte_point(WL_Buffer *b, size_t cursor_byte_in_compiled) {
+static inline bool wl_buffer_view_iterator_valid(WL_Buffer_View_Iterator *it) {
+	return it->offset < wl_buffer_view_get_end(it->view);
+}
 
-	size_t result = 0;
+static inline void wl_buffer_view_iterator_next(WL_Buffer_View_Iterator *it) {
+	it->at++;
+	it->offset++;
 
-	bool found = false;
+	//NOTE: Jump over the gap
+	if(it->at >= it->span_end && it->span_index == 0) {
+		it->span_index = 1;
+		it->at = it->view->spans[1];
+		it->span_end = it->view->spans[1] + it->view->span_sizes[1];
+	}
+}
 
-	size_t byte_at = 0;
-	for(int i = 0; i <= b->bufferSize_inUse_inBytes && !found; i++) {
+//NOTE: Lexes the view a span at a time. A token that runs up to the gap might carry on after it, so it gets lexed again 
+//		out of a small copy that joins the two spans. Token pointers then point into that copy, so use wl_buffer_view_get_token_offset to get buffer offsets.
+struct WL_Buffer_View_Tokenizer {
+	WL_Buffer_View *view;
+	Memory_Arena *arena;
+	EasyTokenizer tokenizer;
+	int span_index;
+
+	//NOTE: What the last token points into and the buffer offset that memory starts at 
+	char *segment_memory;
+	s64 segment_offset;
+};
 
-		if(byte_at == cursor_byte_in_compiled) {
-			result = i;
-			found = true;
-			break;
-		}
-		
-		if(i >= b->gapBuffer_startAt && i < b->gapBuffer_endAt) {
-			//NOTE: In Gap Buffer, don't write 
-		} else {
-			byte_at++;
-		}
-	}
+//NOTE: The offset has to be the start of a token, like the start of the view or a lex checkpoint
+static WL_Buffer_View_Tokenizer wl_buffer_view_begin_lexing(WL_Buffer_View *view, Memory_Arena *arena, s64 offset = -1, int lineNumber = 0) {
+	WL_Buffer_View_Tokenizer result = {};
+	result.view = view;
+	result.arena = arena;
 
-	assert(result >= 0);
+	s64 local_offset = (offset < 0) ? 0 : (offset - view->start);
+	assert(local_offset >= 0 && local_offset <= view->size_in_bytes);
+
+	if(local_offset < view->span_sizes[0] || view->span_sizes[1] == 0) {
+		result.tokenizer = lexBeginParsing(view->spans[0] + local_offset, EASY_LEX_OPTION_NONE);
+		result.segment_memory = (char *)view->spans[0];
+		result.segment_offset = view->start;
+	} else {
+		result.span_index = 1;
+		result.tokenizer = lexBeginParsing(view->spans[1] + (local_offset - view->span_sizes[0]), EASY_LEX_OPTION_NONE);
+		result.segment_memory = (char *)view->spans[1];
+		result.segment_offset = view->start + view->span_sizes[0];
+	}
+	result.tokenizer.lineNumber = lineNumber;
 
 	return result;
 }
 
-//NOTE: To protect the integrity of the undo-redo buffer, we put this pretiffy into the undero-redo state aswell. 
-//		Except we group them as one contigous undo-redo 
-static void prettify_buffer(WL_Buffer *b) {
-	endGapBuffer(b);
+static inline s64 wl_buffer_view_get_token_offset(WL_Buffer_View_Tokenizer *t, char *at) {
+	return t->segment_offset + (at - t->segment_memory);
+}
 
-	//NOTE: Start the file with a new line
-	bool hitNewLine = true;
+static EasyToken wl_buffer_view_get_next_token(WL_Buffer_View_Tokenizer *t) {
+	WL_Buffer_View *view = t->view;
 
-	int byteAt = 0;
+	if(t->span_index == 1) {
+		t->segment_memory = (char *)view->spans[1];
+		t->segment_offset = view->start + view->span_sizes[0];
+		return lexGetNextToken(&t->tokenizer);
+	}
 
-	s32 currentGroupId = b->undo_redo_state.groupIdAt++;
+	EasyToken token = lexGetNextToken(&t->tokenizer);
 
-	int depthAt = 0;
+	char *spanEnd = (char *)view->spans[0] + view->span_sizes[0];
 
-	char *str = (char *)(b->bufferMemory);
+	if(view->span_sizes[1] > 0 && (token.type == TOKEN_NULL_TERMINATOR || (token.at + token.size) >= spanEnd)) {
+		s64 tokenStart = (token.type == TOKEN_NULL_TERMINATOR) ? view->span_sizes[0] : (token.at - (char *)view->spans[0]);
+		s64 copySize = WL_BUFFER_PEEK_WINDOW_IN_BYTES;
 
-	while (*str) {
-		u8 byte = str[0];
+		for(;;) {
+			s64 end = tokenStart + copySize;
+			if(end > view->size_in_bytes) { end = view->size_in_bytes; }
 
-		int incrementCount = 1;
+			char *joined = wl_buffer_view_copy_to_arena(view, view->start + tokenStart, end - tokenStart, t->arena);
 
-		if(hitNewLine && (byte == ' ' || byte == '\t')) {
-			//NOTE: We eat tabs and spaces if we are on a new line 
-			//		This removes them then we add tabs in when we hit a glyph 
-			char *temp = str;
+			EasyTokenizer tokenizer = lexBeginParsing(joined, EASY_LEX_OPTION_NONE);
+			tokenizer.lineNumber = t->tokenizer.lineNumber;
+			token = lexGetNextToken(&tokenizer);
 
-			while(*str && str[0] == ' ' || str[0] == '\t') { //NOTE: Find how much white space we had
-				str++;
+			//NOTE: If the token stopped before the end of the copy it wasn't cut off
+			if(end == view->size_in_bytes || ((token.at - joined) + token.size) < (end - tokenStart)) {
+				t->segment_memory = joined;
+				t->segment_offset = view->start + tokenStart;
+
+				//NOTE: Carry on after the gap
+				s64 tokenEnd = tokenStart + (tokenizer.src - joined);
+				assert(tokenEnd >= view->span_sizes[0]);
+
+				t->span_index = 1;
+				t->tokenizer.src = (char *)view->spans[1] + (tokenEnd - view->span_sizes[0]);
+				t->tokenizer.lineNumber = tokenizer.lineNumber;
+				break;
 			}
-			
-			char *start = (char *)(b->bufferMemory);
-			removeTextFromBuffer(b, temp - start, (str - temp));
 
-			endGapBuffer(b);
-			
-			//NOTE: because we modify the buffer we set rebase the pointer we're looping through
-			str = (char *)(b->bufferMemory + b->cursorAt_inBytes);
+			copySize *= 2;
+		}
+	}
 
-			incrementCount = 0;
-		} else {
-			if(byte == '{') {
-				depthAt++;
-			} else if(byte == '}') {
-				depthAt--;
-				if(depthAt < 0) { depthAt = 0; }
+	return token;
+}
+
+//NOTE: Searches either side of the gap, then a copy of the bytes around the gap for matches that cross it. The copy overlaps each side 
+//		by the size of the sub string less one, so only the matches that start before the gap & end after it get kept from it.
+static String_Query_Search_Results wl_buffer_view_find_sub_string(WL_Buffer_View *view, char *sub_string_utf8, Memory_Arena *tempArena) {
+	String_Query_Search_Results result = string_utf8_find_sub_string((char *)view->spans[0], sub_string_utf8);
+
+	s64 sub_string_size = easyString_getSizeInBytes_utf8(sub_string_utf8);
+
+	if(view->span_sizes[1] > 0 && sub_string_size > 0) {
+		String_Query_Search_Results parts[2] = {};
+		s64 partOffsets[2] = {};
+
+		//NOTE: Only matches that cross the gap can fit in here
+		s64 seamStart = view->span_sizes[0] - (sub_string_size - 1);
+		s64 seamEnd = view->span_sizes[0] + (sub_string_size - 1);
+		if(seamStart < 0) { seamStart = 0; }
+		if(seamEnd > view->size_in_bytes) { seamEnd = view->size_in_bytes; }
+
+		//NOTE: Don't cut a codepoint in half
+		while(seamStart > 0 && easyUnicode_isContinuationByte(wl_buffer_view_get_byte(view, view->start + seamStart))) { seamStart--; }
+		while(seamEnd < view->size_in_bytes && easyUnicode_isContinuationByte(wl_buffer_view_get_byte(view, view->start + seamEnd))) { seamEnd++; }
+
+		char *seam = wl_buffer_view_copy_to_arena(view, view->start + seamStart, seamEnd - seamStart, tempArena);
+		String_Query_Search_Results seam_results = string_utf8_find_sub_string(seam, sub_string_utf8);
+
+		//NOTE: Going out to whole codepoints can take in a match that's all on one side, the searches of the sides already found those
+		for(int j = 0; j < seam_results.byteOffsetCount; ++j) {
+			s64 match_start = seam_results.byteOffsets[j] + seamStart;
+			if(match_start < view->span_sizes[0] && match_start + sub_string_size > view->span_sizes[0]) {
+				parts[0].byteOffsets[parts[0].byteOffsetCount++] = seam_results.byteOffsets[j];
 			}
-			
-			if(hitNewLine) {
-				char *temp = 0;
-				for(int i = 0; i < depthAt; i++) {
-
-					if(!temp) {
-						temp = "\t";
-					} else {
-						//NOTE: Add in the tabs
-						temp = easy_createString_printf(&globalPerFrameArena, "%s%s", temp, "\t");
-					}
+		}
+		partOffsets[0] = seamStart;
+
+		parts[1] = string_utf8_find_sub_string((char *)view->spans[1], sub_string_utf8);
+		partOffsets[1] = view->span_sizes[0];
+
+		for(int i = 0; i < arrayCount(parts); ++i) {
+			for(int j = 0; j < parts[i].byteOffsetCount && result.byteOffsetCount < arrayCount(result.byteOffsets); ++j) {
+				result.byteOffsets[result.byteOffsetCount++] = parts[i].byteOffsets[j] + partOffsets[i];
+			}
+		}
+	}
+
+	//NOTE: Make them buffer offsets
+	for(int i = 0; i < result.byteOffsetCount; ++i) {
+		result.byteOffsets[i] += view->start;
+	}
+
+	return result;
+}
+
+//NOTE: Works out what prettify_buffer changes in one pass over a snapshot, so it can be done on another thread. Each line's white space at
+//		the start gets swapped for a tab per {} it's inside, the lines that already have that are left alone. The edits go in the transaction & 
+//		their text is the tabs that get returned, free them with easyPlatform_freeMemory once the transaction's been committed.
+static char *wl_buffer_prettify_snapshot(WL_Buffer_Snapshot *snapshot, WL_Buffer_Transaction *transaction) {
+	//NOTE: Start the file with a new line
+	bool hitNewLine = true;
+
+	int depthAt = 0;
+	int maxDepth = 0;
+
+	//NOTE: Where the white space at the start of this line started, and if it's all tabs
+	s64 lineStart = 0;
+	bool onlyTabs = true;
+
+	s64 offset = 0;
+	s64 span_size = 0;
+	WL_Buffer_Storage_Snapshot_Iterator it = wl_buffer_snapshot_begin_iterator(snapshot, 0);
+	while(u8 *span = wl_buffer_snapshot_next_span(&it, &span_size)) {
+		for(s64 i = 0; i < span_size; ++i, ++offset) {
+			u8 byte = span[i];
+
+			if(hitNewLine && (byte == ' ' || byte == '\t')) {
+				//NOTE: We eat tabs and spaces if we are on a new line 
+				//		This removes them then we add tabs in when we hit a glyph 
+				onlyTabs = onlyTabs && (byte == '\t');
+			} else {
+				if(byte == '{') {
+					depthAt++;
+				} else if(byte == '}') {
+					depthAt--;
+					if(depthAt < 0) { depthAt = 0; }
 				}
-				if(temp) {
-					char *start = (char *)(b->bufferMemory);
-					addTextToBuffer(b, temp, (str - start), true, currentGroupId);
-					endGapBuffer(b);
-			
-					//NOTE: because we modify the buffer we set rebase the pointer we're looping through
-					str = (char *)(b->bufferMemory + b->cursorAt_inBytes);
-
-					incrementCount = 0;
+
+				if(hitNewLine) {
+					s64 whiteSpaceSize = offset - lineStart;
+					if(!onlyTabs || whiteSpaceSize != depthAt) {
+						//NOTE: The tabs get filled in at the end once we know how many we need
+						wl_buffer_transaction_add(transaction, lineStart, whiteSpaceSize, 0, depthAt);
+						if(depthAt > maxDepth) { maxDepth = depthAt; }
+					}
 				}
-			}
 
-			hitNewLine = false;
+				hitNewLine = false;
 
-			if(byte == '\n' || byte == '\r') {
-				//NOTE: We're at a new line so we have to indent, but only if we hit some new text
-				hitNewLine = true;
-			} 
+				if(byte == '\n' || byte == '\r') {
+					//NOTE: We're at a new line so we have to indent, but only if we hit some new text
+					hitNewLine = true;
+					lineStart = offset + 1;
+					onlyTabs = true;
+				} 
+			}
 		}
+	}
+	assert(offset == snapshot->size_in_bytes);
 
-		str += incrementCount;
+	//NOTE: White space at the end of the file gets eaten too
+	if(hitNewLine && lineStart < offset) {
+		wl_buffer_transaction_add(transaction, lineStart, offset - lineStart, 0, 0);
 	}
 
-}
\ No newline at end of file
+	//NOTE: Every line's tabs are the start of the same run of them
+	char *tabs = 0;
+	if(maxDepth > 0) {
+		tabs = (char *)easyPlatform_allocateMemory(maxDepth, EASY_PLATFORM_MEMORY_NONE);
+		memset(tabs, '\t', maxDepth);
+	}
+
+	for(s64 i = 0; i < transaction->edit_count; ++i) {
+		transaction->edits[i].insert = (u8 *)tabs;
+	}
+
+	return tabs;
+}
+
+//NOTE: To protect the integrity of the undo-redo buffer, we put this pretiffy into the undero-redo state aswell. 
+//		Except we group them as one contigous undo-redo. See wl_buffer_prettify_snapshot for doing it on another thread.
+static void prettify_buffer(WL_Buffer *b) {
+	WL_Buffer_Snapshot *snapshot = wl_buffer_take_snapshot(b);
+
+	WL_Buffer_Transaction transaction = {};
+	char *tabs = wl_buffer_prettify_snapshot(snapshot, &transaction);
+
+	//NOTE: Let go of it first so the edits don't copy the text for it
+	wl_buffer_release_snapshot(snapshot);
+
+	wl_buffer_commit_transaction(b, &transaction);
+
+	if(tabs) {
+		easyPlatform_freeMemory(tabs);
+	}
+}
@@ -0,0 +1,664 @@
+/*
+The text storage behind a WL_Buffer. Everything outside wl_buffer.cpp reads and edits the text through the WL_Buffer
+functions, which come through here, so the editing code doesn't care how the text is stored.
+
+Each storage type is tuned for a different size of file, and we pick one per file when it's opened. See bufferStorage_pick_type
+
+Functions to use:
+
+bufferStorage_insert(s, byteOffset, bytes, size);
+bufferStorage_remove(s, byteOffset, size);
+bufferStorage_apply_edits(s, edits, editCount); //NOTE: Lots of edits in one go
+
+bufferStorage_get_byte(s, byteOffset);
+bufferStorage_copy_bytes(s, byteOffset, size, dest);
+bufferStorage_get_span(s, byteOffset, &size); //NOTE: Walk the text a contiguous run at a time without copying it
+
+bufferStorage_get_line_at_offset(s, byteOffset);
+bufferStorage_get_offset_of_line(s, line);
+
+bufferStorage_take_snapshot(s, snapshot); //NOTE: O(1), shares the memory with the storage
+bufferStorage_detach_snapshot(s, snapshot, storage_is_being_freed); //NOTE: Before the storage changes while the snapshot's still being read
+bufferStorage_free_snapshot(snapshot);
+
+*/
+
+//NOTE: How the text for the buffer is stored
+enum WL_Buffer_Storage_Type {
+	WL_BUFFER_STORAGE_GAP_BUFFER, //NOTE: One contiguous block with a gap at the cursor. See wl_gap_buffer.cpp
+	WL_BUFFER_STORAGE_LINES, //NOTE: A gap buffer per line. See wl_line_buffer.cpp
+	WL_BUFFER_STORAGE_PIECE_TABLE, //NOTE: Pieces of the memory mapped file & an add buffer. See wl_piece_table.cpp
+	WL_BUFFER_STORAGE_ROPE, //NOTE: B-tree of chunks that know their line & codepoint counts. See wl_rope.cpp
+};
+
+//NOTE: Files with more lines than this get the line storage so moving between lines doesn't walk the whole buffer
+#define WL_BUFFER_LINE_STORAGE_MIN_LINE_COUNT 10000
+
+//NOTE: Files bigger than this get the rope, so edits anywhere in them and finding lines are O(log n)
+#define WL_BUFFER_ROPE_MIN_FILE_SIZE (16*1024*1024)
+
+//NOTE: Files bigger than this get memory mapped into a piece table instead of being loaded
+#define WL_BUFFER_PIECE_TABLE_MIN_FILE_SIZE (64*1024*1024)
+
+//NOTE: A gap buffer bigger than this doesn't get copied when the first edit detaches a snapshot from it, it turns into a piece table 
+//		reading the same memory instead. See bufferStorage_detach_snapshot
+#define WL_BUFFER_SNAPSHOT_MAX_COPY_SIZE (1024*1024)
+
+struct WL_Buffer_Storage {
+	WL_Buffer_Storage_Type type;
+
+	//NOTE: Only the one for the type is used
+	WL_Gap_Buffer gap_buffer;
+	WL_Line_Buffer line_buffer;
+	WL_Piece_Table piece_table;
+	WL_Rope rope;
+
+	//NOTE: Where the lines start for the storage types that don't keep track of them themselves. See bufferStorage_uses_line_index
+	WL_Line_Index line_index;
+};
+
+//NOTE: Gap buffers with at least this many edits to do get built again in one pass instead of moving the gap for each one
+#define WL_BUFFER_STORAGE_REBUILD_MIN_EDIT_COUNT 64
+
+//NOTE: Removes delete_size bytes at offset then puts insert there
+struct WL_Buffer_Edit {
+	s64 offset;
+	s64 delete_size;
+
+	u8 *insert;
+	s64 insert_size;
+};
+
+//NOTE: The line buffer & rope already know where their lines are
+static inline bool bufferStorage_uses_line_index(WL_Buffer_Storage_Type type) {
+	return (type == WL_BUFFER_STORAGE_GAP_BUFFER || type == WL_BUFFER_STORAGE_PIECE_TABLE);
+}
+
+//NOTE: line_count can be a guess from the start of the file. can_map_file is if the file is utf8 that we can read straight out of a memory map.
+static WL_Buffer_Storage_Type bufferStorage_pick_type(s64 file_size_in_bytes, s64 line_count, bool can_map_file) {
+	WL_Buffer_Storage_Type result = WL_BUFFER_STORAGE_GAP_BUFFER;
+	if(can_map_file && file_size_in_bytes >= WL_BUFFER_PIECE_TABLE_MIN_FILE_SIZE) {
+		result = WL_BUFFER_STORAGE_PIECE_TABLE;
+	} else if(file_size_in_bytes >= WL_BUFFER_ROPE_MIN_FILE_SIZE) {
+		result = WL_BUFFER_STORAGE_ROPE;
+	} else if(line_count >= WL_BUFFER_LINE_STORAGE_MIN_LINE_COUNT) {
+		result = WL_BUFFER_STORAGE_LINES;
+	}
+	return result;
+}
+
+static void bufferStorage_init(WL_Buffer_Storage *s, WL_Buffer_Storage_Type type) {
+	memset(s, 0, sizeof(WL_Buffer_Storage));
+
+	s->type = type;
+
+	if(type == WL_BUFFER_STORAGE_GAP_BUFFER) {
+		gapBuffer_init(&s->gap_buffer);
+	} else if(type == WL_BUFFER_STORAGE_LINES) {
+		lineBuffer_init(&s->line_buffer);
+	} else if(type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		pieceTable_init(&s->piece_table, 0, 0);
+	} else if(type == WL_BUFFER_STORAGE_ROPE) {
+		rope_init(&s->rope);
+	}
+
+	if(bufferStorage_uses_line_index(type)) {
+		lineIndex_init(&s->line_index);
+	}
+}
+
+static void bufferStorage_free(WL_Buffer_Storage *s) {
+	if(s->type == WL_BUFFER_STORAGE_GAP_BUFFER) {
+		gapBuffer_free(&s->gap_buffer);
+	} else if(s->type == WL_BUFFER_STORAGE_LINES) {
+		lineBuffer_free(&s->line_buffer);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		pieceTable_free(&s->piece_table);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		rope_free(&s->rope);
+	}
+
+	if(bufferStorage_uses_line_index(s->type)) {
+		lineIndex_free(&s->line_index);
+	}
+
+	memset(s, 0, sizeof(WL_Buffer_Storage));
+}
+
+static s64 bufferStorage_get_size_in_bytes(WL_Buffer_Storage *s) {
+	s64 result = 0;
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		result = lineBuffer_get_size_in_bytes(&s->line_buffer);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		result = pieceTable_get_size_in_bytes(&s->piece_table);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_get_size_in_bytes(&s->rope);
+	} else {
+		result = gapBuffer_get_size_in_bytes(&s->gap_buffer);
+	}
+	return result;
+}
+
+//NOTE: Returns 0 if the offset is outside the text
+static u8 bufferStorage_get_byte(WL_Buffer_Storage *s, s64 byte_offset) {
+	u8 result = 0;
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		result = lineBuffer_get_byte(&s->line_buffer, byte_offset);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		result = pieceTable_get_byte(&s->piece_table, byte_offset);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_get_byte(&s->rope, byte_offset);
+	} else {
+		result = gapBuffer_get_byte(&s->gap_buffer, byte_offset);
+	}
+	return result;
+}
+
+static void bufferStorage_copy_bytes(WL_Buffer_Storage *s, s64 byte_offset, s64 size_in_bytes, u8 *dest) {
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		lineBuffer_copy_bytes(&s->line_buffer, byte_offset, size_in_bytes, dest);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		pieceTable_copy_bytes(&s->piece_table, byte_offset, size_in_bytes, dest);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		rope_copy_bytes(&s->rope, byte_offset, size_in_bytes, dest);
+	} else {
+		gapBuffer_copy_bytes(&s->gap_buffer, byte_offset, size_in_bytes, dest);
+	}
+}
+
+//NOTE: Pointer to the contiguous run of text starting at byte_offset, and how long the run is. Always at least one byte.
+//		Isn't null terminated, and is only valid until the next edit.
+static u8 *bufferStorage_get_span(WL_Buffer_Storage *s, s64 byte_offset, s64 *size_in_bytes) {
+	u8 *result = 0;
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		result = lineBuffer_get_span(&s->line_buffer, byte_offset, size_in_bytes);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		result = pieceTable_get_span(&s->piece_table, byte_offset, size_in_bytes);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_get_span(&s->rope, byte_offset, size_in_bytes);
+	} else {
+		result = gapBuffer_get_span(&s->gap_buffer, byte_offset, size_in_bytes);
+	}
+	assert(*size_in_bytes > 0);
+	return result;
+}
+
+static void bufferStorage_insert(WL_Buffer_Storage *s, s64 byte_offset, u8 *bytes, s64 size_in_bytes) {
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		lineBuffer_insert(&s->line_buffer, byte_offset, bytes, size_in_bytes);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		pieceTable_insert(&s->piece_table, byte_offset, bytes, size_in_bytes);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		rope_insert(&s->rope, byte_offset, bytes, size_in_bytes);
+	} else {
+		gapBuffer_insert(&s->gap_buffer, byte_offset, bytes, size_in_bytes);
+	}
+
+	if(bufferStorage_uses_line_index(s->type)) {
+		lineIndex_insert(&s->line_index, byte_offset, bytes, size_in_bytes);
+	}
+}
+
+//NOTE: Puts the text on the end with a line index that's already been built for all of the text after it's in, like the one 
+//		the loading thread makes for a whole file. Takes the index, so its lines don't have to be found again here.
+static void bufferStorage_append_with_line_index(WL_Buffer_Storage *s, u8 *bytes, s64 size_in_bytes, WL_Line_Index *line_index) {
+	assert(bufferStorage_uses_line_index(s->type));
+	s64 byte_offset = bufferStorage_get_size_in_bytes(s);
+
+	if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		pieceTable_insert(&s->piece_table, byte_offset, bytes, size_in_bytes);
+	} else {
+		gapBuffer_insert(&s->gap_buffer, byte_offset, bytes, size_in_bytes);
+	}
+
+	lineIndex_free(&s->line_index);
+	s->line_index = *line_index;
+	memset(line_index, 0, sizeof(WL_Line_Index));
+
+	assert(lineIndex_get_size_in_bytes(&s->line_index) == bufferStorage_get_size_in_bytes(s));
+}
+
+static void bufferStorage_remove(WL_Buffer_Storage *s, s64 byte_offset, s64 size_in_bytes) {
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		lineBuffer_remove(&s->line_buffer, byte_offset, size_in_bytes);
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		pieceTable_remove(&s->piece_table, byte_offset, size_in_bytes);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		rope_remove(&s->rope, byte_offset, size_in_bytes);
+	} else {
+		gapBuffer_remove(&s->gap_buffer, byte_offset, size_in_bytes);
+	}
+
+	if(bufferStorage_uses_line_index(s->type)) {
+		lineIndex_remove(&s->line_index, byte_offset, size_in_bytes);
+	}
+}
+
+//NOTE: The edits are in order through the text & their offsets are in the text before any of them, so none of them start inside the text 
+//		an earlier one removes. The gap buffer gets copied into new memory with all of them in it, that's one pass over the text instead 
+//		of moving the gap to every one of them. The others only change the bits of their memory around each edit, so they do them one at a time.
+static void bufferStorage_apply_edits(WL_Buffer_Storage *s, WL_Buffer_Edit *edits, s64 edit_count) {
+	s64 old_size = bufferStorage_get_size_in_bytes(s);
+
+	if(s->type == WL_BUFFER_STORAGE_GAP_BUFFER && edit_count >= WL_BUFFER_STORAGE_REBUILD_MIN_EDIT_COUNT) {
+		s64 new_size = old_size;
+		for(s64 i = 0; i < edit_count; ++i) {
+			new_size += edits[i].insert_size - edits[i].delete_size;
+		}
+
+		s64 total_size = new_size + GAP_BUFFER_SIZE_IN_BYTES;
+		u8 *memory = (u8 *)platform_alloc_memory(total_size + 1, false);
+		memory[total_size] = '\0';
+
+		u8 *out = memory;
+		s64 at = 0;
+		for(s64 i = 0; i < edit_count; ++i) {
+			WL_Buffer_Edit *edit = &edits[i];
+			assert(edit->offset >= at && edit->offset + edit->delete_size <= old_size);
+
+			bufferStorage_copy_bytes(s, at, edit->offset - at, out);
+			out += edit->offset - at;
+
+			memcpy(out, edit->insert, edit->insert_size);
+			out += edit->insert_size;
+
+			at = edit->offset + edit->delete_size;
+		}
+		bufferStorage_copy_bytes(s, at, old_size - at, out);
+		out += old_size - at;
+		assert(out == memory + new_size);
+
+		gapBuffer_take_memory(&s->gap_buffer, memory, total_size, new_size);
+
+		//NOTE: The text's all in one run now, so the lines can be counted on all the cores again
+		lineIndex_free(&s->line_index);
+		lineIndex_init(&s->line_index);
+		if(new_size > 0) {
+			lineIndex_build(&s->line_index, memory, new_size);
+		}
+	} else {
+		//NOTE: How much the edits before have moved the text
+		s64 shift = 0;
+		s64 at = 0;
+		for(s64 i = 0; i < edit_count; ++i) {
+			WL_Buffer_Edit *edit = &edits[i];
+			assert(edit->offset >= at && edit->offset + edit->delete_size <= old_size);
+
+			if(edit->delete_size > 0) {
+				bufferStorage_remove(s, edit->offset + shift, edit->delete_size);
+			}
+			if(edit->insert_size > 0) {
+				bufferStorage_insert(s, edit->offset + shift, edit->insert, edit->insert_size);
+			}
+
+			shift += edit->insert_size - edit->delete_size;
+			at = edit->offset + edit->delete_size;
+		}
+	}
+}
+
+static s64 bufferStorage_get_line_count(WL_Buffer_Storage *s) {
+	s64 result = 0;
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		result = lineBuffer_get_line_count(&s->line_buffer);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_get_line_count(&s->rope);
+	} else {
+		result = lineIndex_get_line_count(&s->line_index);
+	}
+	return result;
+}
+
+//NOTE: Which line the offset is on, lines start at 0
+static s64 bufferStorage_get_line_at_offset(WL_Buffer_Storage *s, s64 byte_offset) {
+	s64 result = 0;
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		result = lineBuffer_get_row_at_offset(&s->line_buffer, byte_offset);
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_get_line_at_offset(&s->rope, byte_offset);
+	} else {
+		result = lineIndex_get_line_at_offset(&s->line_index, byte_offset);
+	}
+	return result;
+}
+
+//NOTE: Offset of the start of the line, lines start at 0. Returns the end of the text if there aren't that many lines
+static s64 bufferStorage_get_offset_of_line(WL_Buffer_Storage *s, s64 line) {
+	s64 result = 0;
+	if(s->type == WL_BUFFER_STORAGE_LINES) {
+		WL_Line_Buffer *lb = &s->line_buffer;
+		if(line >= lineBuffer_get_line_count(lb)) {
+			result = lineBuffer_get_size_in_bytes(lb);
+		} else if(line > 0) {
+			result = lineBuffer_get_line_start(lb, line);
+		}
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_get_offset_of_line(&s->rope, line);
+	} else {
+		result = lineIndex_get_offset_of_line(&s->line_index, line);
+	}
+	return result;
+}
+
+/*
+A snapshot of the storage is the text at one point in time that's safe to read on any thread while the main thread keeps editing.
+Taking one is O(1), it shares the storage's memory instead of copying it:
+
+Gap buffer: points at the text either side of the gap. The first edit after that gives the memory to the snapshot & carries on with a copy. 
+			If it's bigger than WL_BUFFER_SNAPSHOT_MAX_COPY_SIZE it carries on as a piece table instead, with the memory as the original text 
+			shared with the snapshot. Then only the text that gets edited is copied, into the add buffer, and the line index stays as it is.
+Line buffer: points at the lines. The first edit gives the lines & their pool to the snapshot and carries on with a copy of the lines, 
+			 the line index moves over since the text is the same.
+Piece table: points at the pieces & holds references to the add buffer & the mapped file. The add buffer is append only and the 
+			 mapped file never changes, so they're shared for as long as the snapshot lives. The first edit gives the pieces to the 
+			 snapshot and carries on with a copy of them, that's O(piece count) which only grows with the edits, never with the file.
+Rope: holds a reference to the root. Edits copy the nodes they'd change that are shared, so the snapshot keeps the old tree 
+	  and only the nodes on the edit's path get copied. See rope_make_unique
+
+So the only copies of the text are small gap buffers' and line buffers'. Line buffers are only opened for files smaller than WL_BUFFER_ROPE_MIN_FILE_SIZE.
+If one has been typed into past that, the first edit under a snapshot moves it into a rope instead of copying it, so the copy on
+the main thread is never more than that size and the snapshots after it don't copy anything.
+
+Both of those change the storage type. Check s->type after bufferStorage_detach_snapshot if it matters.
+
+Snapshots are taken, detached and freed on the main thread, only reading them is safe on another thread.
+*/
+struct WL_Buffer_Storage_Snapshot {
+	WL_Buffer_Storage_Type type;
+	s64 size_in_bytes;
+
+	//NOTE: The gap buffer's text either side of the gap
+	u8 *spans[2];
+	s64 span_sizes[2];
+
+	WL_Line *lines;
+	s64 line_count;
+
+	WL_Piece *pieces;
+	s64 piece_count;
+	u8 *original;
+	WL_Piece_Table_Add_Buffer *add_buffer;
+	WL_Piece_Table_File_Map *file_map;
+	WL_Piece_Table_Memory *original_memory; //NOTE: Or a gap buffer's memory, when the storage carries on as a piece table reading it
+
+	WL_Rope_Node *rope_root;
+	WL_Rope_Pool *rope_pool;
+
+	//NOTE: The memory the storage gave us when it got edited
+	void *memory_to_free;
+	WL_Piece *pieces_to_free;
+	WL_Line_Buffer *line_buffer_to_free;
+};
+
+static void bufferStorage_take_snapshot(WL_Buffer_Storage *s, WL_Buffer_Storage_Snapshot *snapshot) {
+	memset(snapshot, 0, sizeof(WL_Buffer_Storage_Snapshot));
+	snapshot->type = s->type;
+	snapshot->size_in_bytes = bufferStorage_get_size_in_bytes(s);
+
+	if(s->type == WL_BUFFER_STORAGE_GAP_BUFFER) {
+		WL_Gap_Buffer *gb = &s->gap_buffer;
+		if(gb->memory) {
+			snapshot->spans[0] = gb->memory;
+			snapshot->span_sizes[0] = gb->gap_start;
+
+			snapshot->spans[1] = gb->memory + gb->gap_end;
+			snapshot->span_sizes[1] = gb->size_in_bytes - gb->gap_end;
+		}
+	} else if(s->type == WL_BUFFER_STORAGE_LINES) {
+		snapshot->lines = s->line_buffer.lines;
+		snapshot->line_count = s->line_buffer.line_count;
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		WL_Piece_Table *pt = &s->piece_table;
+		snapshot->pieces = pt->pieces;
+		snapshot->piece_count = pt->piece_count;
+		snapshot->original = pt->original;
+
+		snapshot->add_buffer = pt->add_buffer;
+		if(snapshot->add_buffer) {
+			snapshot->add_buffer->ref_count++;
+		}
+
+		snapshot->file_map = pt->file_map;
+		if(snapshot->file_map) {
+			snapshot->file_map->ref_count++;
+		}
+
+		snapshot->original_memory = pt->original_memory;
+		if(snapshot->original_memory) {
+			snapshot->original_memory->ref_count++;
+		}
+	} else if(s->type == WL_BUFFER_STORAGE_ROPE) {
+		snapshot->rope_root = s->rope.root;
+		snapshot->rope_root->ref_count++;
+
+		snapshot->rope_pool = s->rope.pool;
+		snapshot->rope_pool->ref_count++;
+	}
+}
+
+struct WL_Buffer_Storage_Snapshot_Iterator {
+	WL_Buffer_Storage_Snapshot *snapshot;
+
+	//NOTE: Which span we're on
+	s64 index;
+	s64 offset_in_span;
+
+	WL_Rope_Leaf_Iterator rope;
+};
+
+//NOTE: How many contiguous runs of text the snapshot is in, for the types that aren't a rope. Some of them can be empty.
+static inline s64 bufferStorage_snapshot_get_span_count(WL_Buffer_Storage_Snapshot *snapshot) {
+	s64 result = arrayCount(snapshot->spans);
+	if(snapshot->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		result = snapshot->piece_count;
+	} else if(snapshot->type == WL_BUFFER_STORAGE_LINES) {
+		//NOTE: The text either side of each line's gap
+		result = 2*snapshot->line_count;
+	}
+	return result;
+}
+
+static u8 *bufferStorage_snapshot_get_span(WL_Buffer_Storage_Snapshot *snapshot, s64 index, s64 *size_in_bytes) {
+	u8 *result = 0;
+	if(snapshot->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		WL_Piece *piece = &snapshot->pieces[index];
+		u8 *memory = (piece->source == WL_PIECE_SOURCE_ORIGINAL) ? snapshot->original : snapshot->add_buffer->memory;
+
+		result = memory + piece->start;
+		*size_in_bytes = piece->size_in_bytes;
+	} else if(snapshot->type == WL_BUFFER_STORAGE_LINES) {
+		WL_Line *line = &snapshot->lines[index / 2];
+		if((index % 2) == 0) {
+			result = line->memory;
+			*size_in_bytes = line->gap_start;
+		} else {
+			result = line->memory + line->gap_end;
+			*size_in_bytes = line->total_size_in_bytes - line->gap_end;
+		}
+	} else {
+		result = snapshot->spans[index];
+		*size_in_bytes = snapshot->span_sizes[index];
+	}
+	return result;
+}
+
+static WL_Buffer_Storage_Snapshot_Iterator bufferStorage_snapshot_begin_iterator(WL_Buffer_Storage_Snapshot *snapshot, s64 byte_offset) {
+	WL_Buffer_Storage_Snapshot_Iterator result = {};
+	result.snapshot = snapshot;
+
+	if(snapshot->type == WL_BUFFER_STORAGE_ROPE) {
+		rope_begin_leaf_iterator(&result.rope, snapshot->rope_root, byte_offset);
+	} else {
+		//NOTE: Walk along the spans to find where to start. The piece starts & line index belong to the main thread so we can't use them.
+		s64 count = bufferStorage_snapshot_get_span_count(snapshot);
+		while(result.index < count) {
+			s64 size = 0;
+			bufferStorage_snapshot_get_span(snapshot, result.index, &size);
+			if(byte_offset < size) {
+				break;
+			}
+			byte_offset -= size;
+			result.index++;
+		}
+		result.offset_in_span = byte_offset;
+	}
+
+	return result;
+}
+
+//NOTE: The next contiguous run of the snapshot's text, or null at the end. Isn't null terminated.
+static u8 *bufferStorage_snapshot_next_span(WL_Buffer_Storage_Snapshot_Iterator *it, s64 *size_in_bytes) {
+	WL_Buffer_Storage_Snapshot *snapshot = it->snapshot;
+	u8 *result = 0;
+	*size_in_bytes = 0;
+
+	if(snapshot->type == WL_BUFFER_STORAGE_ROPE) {
+		result = rope_next_leaf_span(&it->rope, size_in_bytes);
+	} else {
+		//NOTE: Skip the empty ones, like the empty side of a gap
+		s64 count = bufferStorage_snapshot_get_span_count(snapshot);
+		while(it->index < count && !result) {
+			s64 size = 0;
+			u8 *span = bufferStorage_snapshot_get_span(snapshot, it->index, &size);
+			if(it->offset_in_span < size) {
+				result = span + it->offset_in_span;
+				*size_in_bytes = size - it->offset_in_span;
+			}
+			it->index++;
+			it->offset_in_span = 0;
+		}
+	}
+
+	return result;
+}
+
+//NOTE: The storage has given its memory to the snapshot, so build a rope out of the snapshot's text for the storage to carry on with
+static void bufferStorage_move_to_rope(WL_Buffer_Storage *s, WL_Buffer_Storage_Snapshot *snapshot) {
+	u8 *text = (u8 *)platform_alloc_memory(snapshot->size_in_bytes, false);
+
+	s64 at = 0;
+	s64 size = 0;
+	WL_Buffer_Storage_Snapshot_Iterator it = bufferStorage_snapshot_begin_iterator(snapshot, 0);
+	while(u8 *span = bufferStorage_snapshot_next_span(&it, &size)) {
+		memcpy(text + at, span, size);
+		at += size;
+	}
+	assert(at == snapshot->size_in_bytes);
+
+	if(bufferStorage_uses_line_index(s->type)) {
+		lineIndex_free(&s->line_index);
+	}
+
+	s->type = WL_BUFFER_STORAGE_ROPE;
+	rope_init(&s->rope);
+	rope_build_from_text(&s->rope, text, snapshot->size_in_bytes);
+
+	platform_free_memory(text);
+}
+
+//NOTE: The gap buffer's memory gets shared between the snapshot & the storage, which carries on as a piece table reading the text either side of the gap. 
+//		Nothing gets copied and the line index is still right.
+static void bufferStorage_move_to_piece_table(WL_Buffer_Storage *s, WL_Buffer_Storage_Snapshot *snapshot) {
+	WL_Gap_Buffer *gb = &s->gap_buffer;
+
+	WL_Piece_Table_Memory *original_memory = (WL_Piece_Table_Memory *)platform_alloc_memory(sizeof(WL_Piece_Table_Memory), true);
+	original_memory->memory = gb->memory;
+	original_memory->ref_count = 1;
+	snapshot->original_memory = original_memory;
+
+	WL_Piece_Table *pt = &s->piece_table;
+	pieceTable_init_from_memory(pt, original_memory, gb->size_in_bytes);
+	pieceTable_append_original(pt, 0, gb->gap_start);
+	pieceTable_append_original(pt, gb->gap_end, gb->size_in_bytes - gb->gap_end);
+	assert(pieceTable_get_size_in_bytes(pt) == snapshot->size_in_bytes);
+
+	gapBuffer_init(gb);
+	s->type = WL_BUFFER_STORAGE_PIECE_TABLE;
+}
+
+//NOTE: The storage is about to change or be freed, and the snapshot is still reading its memory. Give the memory to the snapshot. 
+//		If the storage is carrying on it gets a copy, or for bigger buffers a different storage type that doesn't need one, so s->type can change. 
+//		See the comment above WL_Buffer_Storage_Snapshot
+static void bufferStorage_detach_snapshot(WL_Buffer_Storage *s, WL_Buffer_Storage_Snapshot *snapshot, bool storage_is_being_freed) {
+	assert(s->type == snapshot->type);
+	assert(!snapshot->memory_to_free && !snapshot->pieces_to_free && !snapshot->line_buffer_to_free);
+
+	bool move_to_rope = (!storage_is_being_freed && snapshot->size_in_bytes >= WL_BUFFER_ROPE_MIN_FILE_SIZE);
+
+	if(s->type == WL_BUFFER_STORAGE_GAP_BUFFER) {
+		WL_Gap_Buffer *gb = &s->gap_buffer;
+		if(gb->memory) {
+			if(storage_is_being_freed) {
+				snapshot->memory_to_free = gb->memory;
+				gb->memory = 0;
+			} else if(snapshot->size_in_bytes > WL_BUFFER_SNAPSHOT_MAX_COPY_SIZE) {
+				bufferStorage_move_to_piece_table(s, snapshot);
+			} else {
+				snapshot->memory_to_free = gb->memory;
+				//NOTE: Plus one for the null terminator after the text after the gap
+				gb->memory = (u8 *)platform_alloc_memory(gb->size_in_bytes + 1, false);
+				memcpy(gb->memory, snapshot->memory_to_free, gb->size_in_bytes + 1);
+			}
+		}
+	} else if(s->type == WL_BUFFER_STORAGE_LINES) {
+		WL_Line_Buffer *given = (WL_Line_Buffer *)platform_alloc_memory(sizeof(WL_Line_Buffer), false);
+		*given = s->line_buffer;
+		snapshot->line_buffer_to_free = given;
+
+		if(storage_is_being_freed) {
+			memset(&s->line_buffer, 0, sizeof(WL_Line_Buffer));
+		} else if(move_to_rope) {
+			memset(&s->line_buffer, 0, sizeof(WL_Line_Buffer));
+			bufferStorage_move_to_rope(s, snapshot);
+		} else {
+			lineBuffer_copy_from(&s->line_buffer, given);
+		}
+	} else if(s->type == WL_BUFFER_STORAGE_PIECE_TABLE) {
+		//NOTE: The snapshot holds references to the add buffer & mapped file, only the pieces can change under it
+		WL_Piece_Table *pt = &s->piece_table;
+		snapshot->pieces_to_free = pt->pieces;
+
+		if(storage_is_being_freed) {
+			pt->pieces = 0;
+		} else {
+			pt->pieces = (WL_Piece *)platform_alloc_memory(pt->total_piece_count*sizeof(WL_Piece), false);
+			memcpy(pt->pieces, snapshot->pieces_to_free, pt->piece_count*sizeof(WL_Piece));
+		}
+	}
+	//NOTE: The rope shares nodes with reference counts, so nothing to give it
+}
+
+static void bufferStorage_free_snapshot(WL_Buffer_Storage_Snapshot *snapshot) {
+	if(snapshot->memory_to_free) {
+		platform_free_memory(snapshot->memory_to_free);
+	}
+
+	if(snapshot->pieces_to_free) {
+		platform_free_memory(snapshot->pieces_to_free);
+	}
+
+	if(snapshot->line_buffer_to_free) {
+		lineBuffer_free(snapshot->line_buffer_to_free);
+		platform_free_memory(snapshot->line_buffer_to_free);
+	}
+
+	if(snapshot->add_buffer) {
+		pieceTable_release_add_buffer_ref(snapshot->add_buffer);
+	}
+
+	if(snapshot->file_map) {
+		pieceTable_release_file_map_ref(snapshot->file_map);
+	}
+
+	if(snapshot->original_memory) {
+		pieceTable_release_memory_ref(snapshot->original_memory);
+	}
+
+	if(snapshot->rope_root) {
+		rope_release_tree(snapshot->rope_pool, snapshot->rope_root);
+		rope_release_pool(snapshot->rope_pool);
+	}
+
+	memset(snapshot, 0, sizeof(WL_Buffer_Storage_Snapshot));
+}
+
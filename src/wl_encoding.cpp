@@ -0,0 +1,555 @@
+/*
+Working out what encoding a file is in when it's opened, and turning it into utf8. The buffer only ever has valid utf8 in it,
+so nothing after loading has to check for bad bytes.
+
+A BOM tells us straight away. Otherwise if lots of every second byte are zero it's utf16, since most text is ascii which has a
+zero high byte. Otherwise if it's mostly valid utf8 it's utf8, and if it's all valid we use it as is without copying it. If it isn't, it's probably
+an old 8 bit encoding and Latin-1 is the best guess, since its 256 characters are the first 256 codepoints.
+
+The utf8 check with AVX2 is the lookup table one from "Validating UTF-8 In Less Than One Instruction Per Byte" (Keiser & Lemire).
+The nibbles of each byte and the byte before it look up three 16 entry tables, and ANDing what they give leaves a bit set for
+anything that's wrong. The three and four byte codepoints also need the bytes 2 & 3 back checked, which is just a subtract.
+Without AVX2 it skips ascii 16 bytes at a time with SSE2 and checks the rest one codepoint at a time.
+
+Functions to use:
+
+encoding_detect(bytes, size, &bom_size);
+encoding_is_valid_utf8(bytes, size);
+encoding_transcode_to_utf8(encoding, bytes, size, dest); //NOTE: dest needs to be encoding_get_max_utf8_size big
+
+*/
+
+enum WL_Text_Encoding {
+	WL_TEXT_ENCODING_UTF8,
+	WL_TEXT_ENCODING_UTF16_LE,
+	WL_TEXT_ENCODING_UTF16_BE,
+	WL_TEXT_ENCODING_LATIN1,
+};
+
+//NOTE: How much of the start of the file we look at to guess the encoding
+#define ENCODING_DETECT_SAMPLE_SIZE_IN_BYTES 4096
+
+//NOTE: What bad utf16 gets turned into
+#define ENCODING_REPLACEMENT_CODEPOINT 0xFFFD
+
+//NOTE: The size of the utf8 codepoint starting at the byte, or 0 if it isn't a valid one. Catches overlong encodings, surrogates and codepoints past 0x10FFFF
+static inline s64 encoding_get_utf8_codepoint_size(u8 *bytes, s64 at, s64 size_in_bytes) {
+	u8 byte = bytes[at];
+
+	s64 result = 0;
+	u32 codepoint = 0;
+	u32 smallest_codepoint = 0;
+
+	if(byte < 0x80) {
+		return 1;
+	} else if((byte & 0xE0) == 0xC0) {
+		result = 2;
+		codepoint = byte & 0x1F;
+		smallest_codepoint = 0x80;
+	} else if((byte & 0xF0) == 0xE0) {
+		result = 3;
+		codepoint = byte & 0x0F;
+		smallest_codepoint = 0x800;
+	} else if((byte & 0xF8) == 0xF0) {
+		result = 4;
+		codepoint = byte & 0x07;
+		smallest_codepoint = 0x10000;
+	} else {
+		//NOTE: A continuation byte without a leading byte, or a byte that's never in utf8
+		return 0;
+	}
+
+	if(at + result > size_in_bytes) {
+		return 0;
+	}
+
+	for(s64 i = 1; i < result; ++i) {
+		u8 continuation = bytes[at + i];
+		if((continuation & 0xC0) != 0x80) {
+			return 0;
+		}
+		codepoint = (codepoint << 6) | (continuation & 0x3F);
+	}
+
+	if(codepoint < smallest_codepoint || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+		return 0;
+	}
+
+	return result;
+}
+
+//NOTE: How big the codepoint says it is from its first byte, without checking the rest of it
+static inline s64 encoding_get_utf8_lead_size(u8 byte) {
+	s64 result = 1;
+	if((byte & 0xE0) == 0xC0) {
+		result = 2;
+	} else if((byte & 0xF0) == 0xE0) {
+		result = 3;
+	} else if((byte & 0xF8) == 0xF0) {
+		result = 4;
+	}
+	return result;
+}
+
+static inline bool encoding_is_ascii_sse2(u8 *bytes) {
+	return (_mm_movemask_epi8(_mm_loadu_si128((__m128i *)bytes)) == 0);
+}
+
+static bool encoding_is_valid_utf8_scalar(u8 *bytes, s64 size_in_bytes) {
+	s64 at = 0;
+	while(at < size_in_bytes) {
+		s64 size = encoding_get_utf8_codepoint_size(bytes, at, size_in_bytes);
+		if(size == 0) {
+			return false;
+		}
+		at += size;
+	}
+	return true;
+}
+
+static bool encoding_is_valid_utf8_sse2(u8 *bytes, s64 size_in_bytes) {
+	s64 at = 0;
+	while(at < size_in_bytes) {
+		if(at + 16 <= size_in_bytes && encoding_is_ascii_sse2(bytes + at)) {
+			at += 16;
+		} else {
+			s64 size = encoding_get_utf8_codepoint_size(bytes, at, size_in_bytes);
+			if(size == 0) {
+				return false;
+			}
+			at += size;
+		}
+	}
+	return true;
+}
+
+//NOTE: The error bits for the lookup tables. A pair of bytes is wrong if a bit is set in all three tables.
+#define ENCODING_TOO_SHORT (1 << 0) //NOTE: 11______ 0_______ or 11______ 11______
+#define ENCODING_TOO_LONG (1 << 1) //NOTE: 0_______ 10______
+#define ENCODING_OVERLONG_3 (1 << 2) //NOTE: 11100000 100_____
+#define ENCODING_TOO_LARGE (1 << 3) //NOTE: 11110100 1001____ and anything after it that's past 0x10FFFF
+#define ENCODING_SURROGATE (1 << 4) //NOTE: 11101101 101_____
+#define ENCODING_OVERLONG_2 (1 << 5) //NOTE: 1100000_ 10______
+#define ENCODING_TOO_LARGE_1000 (1 << 6) //NOTE: 11110101 1000____ and up
+#define ENCODING_OVERLONG_4 (1 << 6) //NOTE: 11110000 1000____
+#define ENCODING_TWO_CONTINUATIONS (1 << 7) //NOTE: 10______ 10______
+
+//NOTE: Looked up by the high nibble of the first byte
+static u8 global_encoding_byte_1_high[16] = {
+	//NOTE: 0_______ ascii
+	ENCODING_TOO_LONG, ENCODING_TOO_LONG, ENCODING_TOO_LONG, ENCODING_TOO_LONG,
+	ENCODING_TOO_LONG, ENCODING_TOO_LONG, ENCODING_TOO_LONG, ENCODING_TOO_LONG,
+	//NOTE: 10______ continuation
+	ENCODING_TWO_CONTINUATIONS, ENCODING_TWO_CONTINUATIONS, ENCODING_TWO_CONTINUATIONS, ENCODING_TWO_CONTINUATIONS,
+	//NOTE: 1100____ two byte lead
+	ENCODING_TOO_SHORT | ENCODING_OVERLONG_2,
+	//NOTE: 1101____ two byte lead
+	ENCODING_TOO_SHORT,
+	//NOTE: 1110____ three byte lead
+	ENCODING_TOO_SHORT | ENCODING_OVERLONG_3 | ENCODING_SURROGATE,
+	//NOTE: 1111____ four byte lead
+	ENCODING_TOO_SHORT | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000 | ENCODING_OVERLONG_4,
+};
+
+#define ENCODING_CARRY (ENCODING_TOO_SHORT | ENCODING_TOO_LONG | ENCODING_TWO_CONTINUATIONS)
+
+//NOTE: Looked up by the low nibble of the first byte
+static u8 global_encoding_byte_1_low[16] = {
+	//NOTE: ____0000
+	ENCODING_CARRY | ENCODING_OVERLONG_3 | ENCODING_OVERLONG_2 | ENCODING_OVERLONG_4,
+	//NOTE: ____0001
+	ENCODING_CARRY | ENCODING_OVERLONG_2,
+	//NOTE: ____001_
+	ENCODING_CARRY,
+	ENCODING_CARRY,
+	//NOTE: ____0100
+	ENCODING_CARRY | ENCODING_TOO_LARGE,
+	//NOTE: ____0101 up to ____1100
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	//NOTE: ____1101
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000 | ENCODING_SURROGATE,
+	//NOTE: ____111_
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+	ENCODING_CARRY | ENCODING_TOO_LARGE | ENCODING_TOO_LARGE_1000,
+};
+
+//NOTE: Looked up by the high nibble of the second byte
+static u8 global_encoding_byte_2_high[16] = {
+	//NOTE: 0_______ ascii
+	ENCODING_TOO_SHORT, ENCODING_TOO_SHORT, ENCODING_TOO_SHORT, ENCODING_TOO_SHORT,
+	ENCODING_TOO_SHORT, ENCODING_TOO_SHORT, ENCODING_TOO_SHORT, ENCODING_TOO_SHORT,
+	//NOTE: 1000____
+	ENCODING_TOO_LONG | ENCODING_OVERLONG_2 | ENCODING_TWO_CONTINUATIONS | ENCODING_OVERLONG_3 | ENCODING_TOO_LARGE_1000 | ENCODING_OVERLONG_4,
+	//NOTE: 1001____
+	ENCODING_TOO_LONG | ENCODING_OVERLONG_2 | ENCODING_TWO_CONTINUATIONS | ENCODING_OVERLONG_3 | ENCODING_TOO_LARGE,
+	//NOTE: 101_____
+	ENCODING_TOO_LONG | ENCODING_OVERLONG_2 | ENCODING_TWO_CONTINUATIONS | ENCODING_SURROGATE | ENCODING_TOO_LARGE,
+	ENCODING_TOO_LONG | ENCODING_OVERLONG_2 | ENCODING_TWO_CONTINUATIONS | ENCODING_SURROGATE | ENCODING_TOO_LARGE,
+	//NOTE: 11______ lead
+	ENCODING_TOO_SHORT, ENCODING_TOO_SHORT, ENCODING_TOO_SHORT, ENCODING_TOO_SHORT,
+};
+
+static inline __m256i encoding_get_high_nibbles_avx2(__m256i bytes) {
+	return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F));
+}
+
+//NOTE: Gives the error bits for the 32 bytes, the bytes before them are at the end of previous
+static inline __m256i encoding_check_utf8_block_avx2(__m256i input, __m256i previous, __m256i byte_1_high, __m256i byte_1_low, __m256i byte_2_high) {
+	//NOTE: The bytes 1, 2 & 3 before each byte. alignr only works inside each 128 bit lane, so the lane before has to be put next to it first
+	__m256i lane_before = _mm256_permute2x128_si256(previous, input, 0x21);
+	__m256i prev1 = _mm256_alignr_epi8(input, lane_before, 16 - 1);
+	__m256i prev2 = _mm256_alignr_epi8(input, lane_before, 16 - 2);
+	__m256i prev3 = _mm256_alignr_epi8(input, lane_before, 16 - 3);
+
+	__m256i errors = _mm256_shuffle_epi8(byte_1_high, encoding_get_high_nibbles_avx2(prev1));
+	errors = _mm256_and_si256(errors, _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F))));
+	errors = _mm256_and_si256(errors, _mm256_shuffle_epi8(byte_2_high, encoding_get_high_nibbles_avx2(input)));
+
+	//NOTE: A byte 2 after a three byte lead or 3 after a four byte lead has to be a continuation.
+	//		The top bit is set after the subtract if it is one of those leads.
+	__m256i is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+	__m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+	__m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8((char)0x80));
+
+	//NOTE: The tables say a continuation after a continuation is an error, which is wrong for these ones & right for the rest
+	return _mm256_xor_si256(errors, must_be_continuation);
+}
+
+static bool encoding_is_valid_utf8_avx2(u8 *bytes, s64 size_in_bytes) {
+	__m256i byte_1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)global_encoding_byte_1_high));
+	__m256i byte_1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)global_encoding_byte_1_low));
+	__m256i byte_2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)global_encoding_byte_2_high));
+
+	//NOTE: Anything bigger than these in the last 3 bytes is a lead that needs more bytes than there are left in the block
+	__m256i max_complete = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+											-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+	__m256i errors = _mm256_setzero_si256();
+	__m256i previous = _mm256_setzero_si256();
+	__m256i previous_incomplete = _mm256_setzero_si256();
+
+	s64 at = 0;
+	while(at < size_in_bytes) {
+		__m256i input;
+		if(at + 32 <= size_in_bytes) {
+			input = _mm256_loadu_si256((__m256i *)(bytes + at));
+		} else {
+			//NOTE: Pad the last block with zeros, they're ascii so they don't change anything
+			u8 last_block[32] = {};
+			memcpy(last_block, bytes + at, size_in_bytes - at);
+			input = _mm256_loadu_si256((__m256i *)last_block);
+		}
+
+		if(_mm256_movemask_epi8(input) == 0) {
+			//NOTE: All ascii, so only need to check the block before didn't end halfway through a codepoint
+			errors = _mm256_or_si256(errors, previous_incomplete);
+		} else {
+			errors = _mm256_or_si256(errors, encoding_check_utf8_block_avx2(input, previous, byte_1_high, byte_1_low, byte_2_high));
+			previous_incomplete = _mm256_subs_epu8(input, max_complete);
+		}
+
+		previous = input;
+		at += 32;
+	}
+
+	errors = _mm256_or_si256(errors, previous_incomplete);
+
+	return _mm256_testz_si256(errors, errors);
+}
+
+struct WL_Encoding_Check_Chunk {
+	u8 *bytes;
+	s64 size_in_bytes;
+	bool use_avx2;
+
+	bool is_valid;
+};
+
+static THREAD_WORK_FUNCTION(encoding_check_utf8_work) {
+	WL_Encoding_Check_Chunk *chunk = (WL_Encoding_Check_Chunk *)Data;
+
+	if(chunk->use_avx2) {
+		chunk->is_valid = encoding_is_valid_utf8_avx2(chunk->bytes, chunk->size_in_bytes);
+	} else {
+		chunk->is_valid = encoding_is_valid_utf8_sse2(chunk->bytes, chunk->size_in_bytes);
+	}
+}
+
+//NOTE: Checks the text is all valid utf8 using all the cores
+static bool encoding_is_valid_utf8(u8 *bytes, s64 size_in_bytes) {
+	//NOTE: Split it up the same way as building the line index
+	WL_Encoding_Check_Chunk chunks[LINE_INDEX_MAX_THREADS];
+	u32 chunk_count = lineIndex_get_chunk_count(size_in_bytes);
+	bool use_avx2 = platform_cpu_has_avx2();
+
+	s64 chunk_size = size_in_bytes / chunk_count;
+	s64 start = 0;
+	for(u32 i = 0; i < chunk_count; ++i) {
+		s64 end = (i == (chunk_count - 1)) ? size_in_bytes : (i + 1)*chunk_size;
+
+		//NOTE: Don't split a codepoint between chunks. If there's more than 3 continuation bytes it's not valid anyway,
+		//		and the chunk starting with the 4th one will find that.
+		for(int j = 0; j < 3 && end < size_in_bytes && (bytes[end] & 0xC0) == 0x80; ++j) {
+			end++;
+		}
+		if(end < start) { end = start; }
+
+		chunks[i].bytes = bytes + start;
+		chunks[i].size_in_bytes = end - start;
+		chunks[i].use_avx2 = use_avx2;
+		chunks[i].is_valid = false;
+
+		start = end;
+	}
+
+	platform_do_work_in_parallel(encoding_check_utf8_work, chunks, sizeof(WL_Encoding_Check_Chunk), chunk_count);
+
+	bool result = true;
+	for(u32 i = 0; i < chunk_count; ++i) {
+		if(!chunks[i].is_valid) {
+			result = false;
+		}
+	}
+	return result;
+}
+
+//NOTE: Where to stop reading so the last codepoint isn't cut in half, for converting a file a bit at a time as it arrives.
+//		start has to be the start of a codepoint.
+static s64 encoding_get_chunk_end(WL_Text_Encoding encoding, u8 *bytes, s64 start, s64 end) {
+	if(encoding == WL_TEXT_ENCODING_UTF8) {
+		//NOTE: Leave the last codepoint for next time if it's not all here
+		s64 last_start = end - 1;
+		while(last_start > start && (bytes[last_start] & 0xC0) == 0x80 && (end - last_start) < 4) {
+			last_start--;
+		}
+
+		if(last_start >= start && (last_start + encoding_get_utf8_lead_size(bytes[last_start])) > end) {
+			end = last_start;
+		}
+	} else if(encoding == WL_TEXT_ENCODING_UTF16_LE || encoding == WL_TEXT_ENCODING_UTF16_BE) {
+		//NOTE: Whole 16 bit units, and don't split a surrogate pair
+		end = start + ((end - start) & ~1);
+
+		if(end - 2 >= start) {
+			u16 last = (encoding == WL_TEXT_ENCODING_UTF16_LE) ? (bytes[end - 2] | (bytes[end - 1] << 8)) : ((bytes[end - 2] << 8) | bytes[end - 1]);
+			if(last >= 0xD800 && last <= 0xDBFF) {
+				end -= 2;
+			}
+		}
+	}
+
+	return end;
+}
+
+//NOTE: Works out the encoding from the start of the text. bom_size_in_bytes is how much to skip.
+//		Only the start is checked for utf8, so a bad byte further on still needs encoding_transcode_to_utf8 to fix it.
+static WL_Text_Encoding encoding_detect(u8 *bytes, s64 size_in_bytes, s64 *bom_size_in_bytes) {
+	*bom_size_in_bytes = 0;
+
+	if(size_in_bytes >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+		*bom_size_in_bytes = 3;
+		return WL_TEXT_ENCODING_UTF8;
+	} else if(size_in_bytes >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+		*bom_size_in_bytes = 2;
+		return WL_TEXT_ENCODING_UTF16_LE;
+	} else if(size_in_bytes >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+		*bom_size_in_bytes = 2;
+		return WL_TEXT_ENCODING_UTF16_BE;
+	}
+
+	s64 sample_size = (size_in_bytes < ENCODING_DETECT_SAMPLE_SIZE_IN_BYTES) ? size_in_bytes : ENCODING_DETECT_SAMPLE_SIZE_IN_BYTES;
+
+	//NOTE: utf16 without a BOM. Ascii in utf16 has a zero in every second byte, the high byte is second for little endian
+	s64 zero_counts[2] = {};
+	for(s64 i = 0; i < sample_size; ++i) {
+		if(bytes[i] == 0) {
+			zero_counts[i & 1]++;
+		}
+	}
+
+	//NOTE: Text that isn't ascii can have zeros in the other byte too (like the low byte of U+4E00), so it just has to be the side with a lot more
+	s64 unit_count = sample_size / 2;
+	if(unit_count > 0) {
+		if(zero_counts[1] > unit_count / 4 && zero_counts[1] > 2*zero_counts[0]) {
+			return WL_TEXT_ENCODING_UTF16_LE;
+		} else if(zero_counts[0] > unit_count / 4 && zero_counts[0] > 2*zero_counts[1]) {
+			return WL_TEXT_ENCODING_UTF16_BE;
+		}
+	}
+
+	//NOTE: The sample might have cut the last codepoint in half
+	if(sample_size < size_in_bytes) {
+		sample_size = encoding_get_chunk_end(WL_TEXT_ENCODING_UTF8, bytes, 0, sample_size);
+	}
+
+	if(encoding_is_valid_utf8_sse2(bytes, sample_size)) {
+		return WL_TEXT_ENCODING_UTF8;
+	}
+
+	//NOTE: A utf8 file with the odd bad byte in it is still utf8. It's only Latin-1 if the bad bytes outnumber the good non-ascii codepoints.
+	s64 valid_count = 0;
+	s64 invalid_count = 0;
+	s64 at = 0;
+	while(at < sample_size) {
+		s64 size = encoding_get_utf8_codepoint_size(bytes, at, sample_size);
+		if(size == 0) {
+			invalid_count++;
+			at++;
+		} else {
+			valid_count += (size > 1);
+			at += size;
+		}
+	}
+
+	return (invalid_count > valid_count) ? WL_TEXT_ENCODING_LATIN1 : WL_TEXT_ENCODING_UTF8;
+}
+
+//NOTE: The most bytes the text could take up once it's utf8
+static s64 encoding_get_max_utf8_size(WL_Text_Encoding encoding, s64 size_in_bytes) {
+	s64 result = 0;
+	if(encoding == WL_TEXT_ENCODING_UTF16_LE || encoding == WL_TEXT_ENCODING_UTF16_BE) {
+		//NOTE: 16 bit units take up to 3 bytes, surrogate pairs take 4 for their 4. An odd byte on the end becomes a replacement character.
+		result = (size_in_bytes / 2)*3 + 3;
+	} else {
+		//NOTE: A Latin-1 byte, or a bad utf8 byte read as one, takes up to 2 bytes
+		result = size_in_bytes*2;
+	}
+	return result;
+}
+
+static inline s64 encoding_write_utf8_codepoint(u32 codepoint, u8 *dest) {
+	if(codepoint < 0x80) {
+		dest[0] = (u8)codepoint;
+		return 1;
+	} else if(codepoint < 0x800) {
+		dest[0] = (u8)(0xC0 | (codepoint >> 6));
+		dest[1] = (u8)(0x80 | (codepoint & 0x3F));
+		return 2;
+	} else if(codepoint < 0x10000) {
+		dest[0] = (u8)(0xE0 | (codepoint >> 12));
+		dest[1] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+		dest[2] = (u8)(0x80 | (codepoint & 0x3F));
+		return 3;
+	} else {
+		dest[0] = (u8)(0xF0 | (codepoint >> 18));
+		dest[1] = (u8)(0x80 | ((codepoint >> 12) & 0x3F));
+		dest[2] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+		dest[3] = (u8)(0x80 | (codepoint & 0x3F));
+		return 4;
+	}
+}
+
+//NOTE: Latin-1 is just the first 256 codepoints
+static s64 encoding_latin1_to_utf8(u8 *bytes, s64 size_in_bytes, u8 *dest) {
+	u8 *dest_at = dest;
+	s64 at = 0;
+	while(at < size_in_bytes) {
+		if(at + 16 <= size_in_bytes && encoding_is_ascii_sse2(bytes + at)) {
+			_mm_storeu_si128((__m128i *)dest_at, _mm_loadu_si128((__m128i *)(bytes + at)));
+			dest_at += 16;
+			at += 16;
+		} else {
+			dest_at += encoding_write_utf8_codepoint(bytes[at], dest_at);
+			at++;
+		}
+	}
+	return dest_at - dest;
+}
+
+//NOTE: Copies the valid utf8 and reads any bytes that aren't as Latin-1
+static s64 encoding_repair_utf8(u8 *bytes, s64 size_in_bytes, u8 *dest) {
+	u8 *dest_at = dest;
+	s64 at = 0;
+	while(at < size_in_bytes) {
+		if(at + 16 <= size_in_bytes && encoding_is_ascii_sse2(bytes + at)) {
+			_mm_storeu_si128((__m128i *)dest_at, _mm_loadu_si128((__m128i *)(bytes + at)));
+			dest_at += 16;
+			at += 16;
+		} else {
+			s64 size = encoding_get_utf8_codepoint_size(bytes, at, size_in_bytes);
+			if(size > 0) {
+				memcpy(dest_at, bytes + at, size);
+				dest_at += size;
+				at += size;
+			} else {
+				dest_at += encoding_write_utf8_codepoint(bytes[at], dest_at);
+				at++;
+			}
+		}
+	}
+	return dest_at - dest;
+}
+
+static s64 encoding_utf16_to_utf8(u8 *bytes, s64 size_in_bytes, u8 *dest, bool is_big_endian) {
+	u8 *dest_at = dest;
+	s64 unit_count = size_in_bytes / 2;
+	s64 at = 0;
+
+	while(at < unit_count) {
+		//NOTE: Ascii 8 units at a time
+		if(at + 8 <= unit_count) {
+			__m128i units = _mm_loadu_si128((__m128i *)(bytes + 2*at));
+			if(is_big_endian) {
+				units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+			}
+
+			__m128i not_ascii = _mm_and_si128(units, _mm_set1_epi16((short)0xFF80));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi16(not_ascii, _mm_setzero_si128())) == 0xFFFF) {
+				_mm_storel_epi64((__m128i *)dest_at, _mm_packus_epi16(units, units));
+				dest_at += 8;
+				at += 8;
+				continue;
+			}
+		}
+
+		u8 *unit_bytes = bytes + 2*at;
+		u32 unit = is_big_endian ? ((unit_bytes[0] << 8) | unit_bytes[1]) : (unit_bytes[0] | (unit_bytes[1] << 8));
+		at++;
+
+		u32 codepoint = unit;
+		if(unit >= 0xD800 && unit <= 0xDBFF) {
+			codepoint = ENCODING_REPLACEMENT_CODEPOINT;
+
+			if(at < unit_count) {
+				u8 *next_bytes = bytes + 2*at;
+				u32 next = is_big_endian ? ((next_bytes[0] << 8) | next_bytes[1]) : (next_bytes[0] | (next_bytes[1] << 8));
+				if(next >= 0xDC00 && next <= 0xDFFF) {
+					codepoint = 0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00);
+					at++;
+				}
+			}
+		} else if(unit >= 0xDC00 && unit <= 0xDFFF) {
+			//NOTE: Second half of a surrogate pair without the first half
+			codepoint = ENCODING_REPLACEMENT_CODEPOINT;
+		}
+
+		dest_at += encoding_write_utf8_codepoint(codepoint, dest_at);
+	}
+
+	if(size_in_bytes & 1) {
+		dest_at += encoding_write_utf8_codepoint(ENCODING_REPLACEMENT_CODEPOINT, dest_at);
+	}
+
+	return dest_at - dest;
+}
+
+//NOTE: Returns the size of the utf8. dest has to be at least encoding_get_max_utf8_size big. The utf8 is always valid,
+//		bad utf8 bytes get read as Latin-1 & bad utf16 becomes the replacement character.
+static s64 encoding_transcode_to_utf8(WL_Text_Encoding encoding, u8 *bytes, s64 size_in_bytes, u8 *dest) {
+	s64 result = 0;
+	if(encoding == WL_TEXT_ENCODING_UTF8) {
+		result = encoding_repair_utf8(bytes, size_in_bytes, dest);
+	} else if(encoding == WL_TEXT_ENCODING_LATIN1) {
+		result = encoding_latin1_to_utf8(bytes, size_in_bytes, dest);
+	} else {
+		result = encoding_utf16_to_utf8(bytes, size_in_bytes, dest, (encoding == WL_TEXT_ENCODING_UTF16_BE));
+	}
+	return result;
+}
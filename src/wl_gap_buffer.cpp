@@ -0,0 +1,188 @@
+/*
+Gap buffer storage for a WL_Buffer. Used for small files and new buffers.
+
+The text is one block of memory with a gap in it where the last edit was. Typing at the same place just fills the gap,
+an edit somewhere else moves the gap there first, which only moves the bytes between the old and new position.
+
+The text after the gap always lives at the end of the memory, so size_in_bytes is the whole allocation.
+The gap stays open when the cursor moves, we only move it when an edit happens somewhere else.
+
+Functions to use:
+
+gapBuffer_insert(gb, byteOffset, bytes, size);
+gapBuffer_remove(gb, byteOffset, size);
+
+gapBuffer_get_byte(gb, byteOffset);
+gapBuffer_copy_bytes(gb, byteOffset, size, dest);
+
+gapBuffer_flatten(gb); //NOTE: Only if you want the text contiguous in memory
+
+gapBuffer_take_memory(gb, memory, size, text_size); //NOTE: For text that's been built somewhere else, like bufferStorage_apply_edits
+
+*/
+
+//NOTE: The smallest gap we leave after growing the buffer
+#define GAP_BUFFER_SIZE_IN_BYTES 64
+
+struct WL_Gap_Buffer {
+	//NOTE: This DOESN'T include the null terminator at the end
+	u8 *memory;
+	s64 size_in_bytes;
+
+	s64 gap_start;
+	s64 gap_end;
+};
+
+static void gapBuffer_init(WL_Gap_Buffer *gb) {
+	memset(gb, 0, sizeof(WL_Gap_Buffer));
+}
+
+static void gapBuffer_free(WL_Gap_Buffer *gb) {
+	if(gb->memory) { platform_free_memory(gb->memory); }
+	memset(gb, 0, sizeof(WL_Gap_Buffer));
+}
+
+static inline s64 gapBuffer_get_size_in_bytes(WL_Gap_Buffer *gb) {
+	return gb->size_in_bytes - (gb->gap_end - gb->gap_start);
+}
+
+static u8 gapBuffer_get_byte(WL_Gap_Buffer *gb, s64 byte_offset) {
+	u8 result = 0;
+	if(byte_offset >= 0 && byte_offset < gapBuffer_get_size_in_bytes(gb)) {
+		if(byte_offset >= gb->gap_start) {
+			byte_offset += (gb->gap_end - gb->gap_start);
+		}
+		result = gb->memory[byte_offset];
+	}
+	return result;
+}
+
+static void gapBuffer_copy_bytes(WL_Gap_Buffer *gb, s64 byte_offset, s64 size_in_bytes, u8 *dest) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= gapBuffer_get_size_in_bytes(gb));
+	s64 end = byte_offset + size_in_bytes;
+	s64 gap_size = gb->gap_end - gb->gap_start;
+
+	//NOTE: Copy the part before the gap, then the part after the gap
+	if(byte_offset < gb->gap_start) {
+		s64 pre_end = (end < gb->gap_start) ? end : gb->gap_start;
+		memcpy(dest, gb->memory + byte_offset, pre_end - byte_offset);
+		dest += (pre_end - byte_offset);
+		byte_offset = pre_end;
+	}
+
+	if(byte_offset < end) {
+		memcpy(dest, gb->memory + byte_offset + gap_size, end - byte_offset);
+	}
+}
+
+//NOTE: The bytes from byte_offset up to the gap or the end of the text, whichever comes first
+static u8 *gapBuffer_get_span(WL_Gap_Buffer *gb, s64 byte_offset, s64 *size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset < gapBuffer_get_size_in_bytes(gb));
+	u8 *result = 0;
+	if(byte_offset < gb->gap_start) {
+		result = gb->memory + byte_offset;
+		*size_in_bytes = gb->gap_start - byte_offset;
+	} else {
+		result = gb->memory + byte_offset + (gb->gap_end - gb->gap_start);
+		*size_in_bytes = gb->size_in_bytes - (byte_offset + (gb->gap_end - gb->gap_start));
+	}
+	return result;
+}
+
+//NOTE: The first byte of the gap is always a null terminator so the text before the gap can be read as a null terminated string.
+//		The text after the gap has one at the end of the allocation.
+static void gapBuffer_terminate_gap(WL_Gap_Buffer *gb) {
+	if(gb->gap_start < gb->gap_end) {
+		gb->memory[gb->gap_start] = '\0';
+	}
+}
+
+//NOTE: Only moves the bytes between the old gap position and the new one
+static void gapBuffer_move_gap(WL_Gap_Buffer *gb, s64 byte_offset) {
+	s64 gap_size = gb->gap_end - gb->gap_start;
+	assert(byte_offset <= (gb->size_in_bytes - gap_size));
+
+	if(gap_size > 0) {
+		if(byte_offset < gb->gap_start) {
+			//NOTE: Text before the gap moves to after it
+			s64 count = gb->gap_start - byte_offset;
+			memmove(gb->memory + gb->gap_end - count, gb->memory + byte_offset, count);
+		} else if(byte_offset > gb->gap_start) {
+			//NOTE: Text after the gap moves to before it
+			s64 count = byte_offset - gb->gap_start;
+			memmove(gb->memory + gb->gap_start, gb->memory + gb->gap_end, count);
+		}
+	}
+
+	gb->gap_start = byte_offset;
+	gb->gap_end = byte_offset + gap_size;
+
+	gapBuffer_terminate_gap(gb);
+}
+
+//NOTE: Grows the buffer geometrically so typing doesn't reallocate on every key press
+static void gapBuffer_ensure_gap(WL_Gap_Buffer *gb, s64 size_needed) {
+	s64 gap_size = gb->gap_end - gb->gap_start;
+
+	if(gap_size < size_needed) {
+		s64 text_size = gb->size_in_bytes - gap_size;
+		s64 after_gap_size = gb->size_in_bytes - gb->gap_end;
+
+		s64 new_size = 2*gb->size_in_bytes;
+		s64 min_size = text_size + size_needed + GAP_BUFFER_SIZE_IN_BYTES;
+		if(new_size < min_size) { new_size = min_size; }
+
+		//NOTE: One extra for the null terminator after the text after the gap
+		u8 *new_memory = (u8 *)platform_alloc_memory(new_size + 1, false);
+		new_memory[new_size] = '\0';
+
+		if(gb->memory) {
+			memcpy(new_memory, gb->memory, gb->gap_start);
+			memcpy(new_memory + new_size - after_gap_size, gb->memory + gb->gap_end, after_gap_size);
+			platform_free_memory(gb->memory);
+		}
+
+		gb->memory = new_memory;
+		gb->size_in_bytes = new_size;
+		gb->gap_end = new_size - after_gap_size;
+	}
+
+	assert((gb->gap_end - gb->gap_start) >= size_needed);
+}
+
+static void gapBuffer_insert(WL_Gap_Buffer *gb, s64 byte_offset, u8 *bytes, s64 size_in_bytes) {
+	gapBuffer_move_gap(gb, byte_offset);
+	gapBuffer_ensure_gap(gb, size_in_bytes + 1); //NOTE: Plus one to keep room for the null terminator
+
+	memcpy(gb->memory + gb->gap_start, bytes, size_in_bytes);
+
+	gb->gap_start += size_in_bytes;
+	gapBuffer_terminate_gap(gb);
+}
+
+//NOTE: Removing is just growing the gap over the text
+static void gapBuffer_remove(WL_Gap_Buffer *gb, s64 byte_offset, s64 size_in_bytes) {
+	gapBuffer_move_gap(gb, byte_offset);
+	gb->gap_end += size_in_bytes;
+	assert(gb->gap_end <= gb->size_in_bytes);
+	gapBuffer_terminate_gap(gb);
+}
+
+//NOTE: Uses memory instead of what it had. The text is at the start of it & the gap's the rest. 
+//		It has to be size_in_bytes + 1 from platform_alloc_memory, with a null terminator at the end like gapBuffer_ensure_gap makes.
+static void gapBuffer_take_memory(WL_Gap_Buffer *gb, u8 *memory, s64 size_in_bytes, s64 text_size_in_bytes) {
+	assert(text_size_in_bytes <= size_in_bytes && memory[size_in_bytes] == '\0');
+	if(gb->memory) { platform_free_memory(gb->memory); }
+
+	gb->memory = memory;
+	gb->size_in_bytes = size_in_bytes;
+	gb->gap_start = text_size_in_bytes;
+	gb->gap_end = size_in_bytes;
+
+	gapBuffer_terminate_gap(gb);
+}
+
+//NOTE: Moves the gap to the end so the text is one contiguous run at the start of memory
+static void gapBuffer_flatten(WL_Gap_Buffer *gb) {
+	gapBuffer_move_gap(gb, gapBuffer_get_size_in_bytes(gb));
+}
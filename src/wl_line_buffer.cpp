@@ -0,0 +1,495 @@
+/*
+Line partitioned storage for a WL_Buffer (the 'Version 2' layout from the README).
+
+Every line of text lives in it's own small gap buffer, and the lines live in one array.
+A line owns it's newline bytes (\n or \r\n), so the last line is the only one that doesn't end in a '\n'.
+
+This means getting a row's text is just indexing the array, instead of walking the whole buffer counting '\n' characters.
+How long each line is goes in a WL_Line_Index as well, so going between a byte offset and a row is O(log n) however many
+lines there are, and an edit at the top of the file doesn't make the next lookup walk every line below it.
+
+Functions to use:
+
+lineBuffer_insert(lb, byteOffset, bytes, size);
+lineBuffer_remove(lb, byteOffset, size);
+
+lineBuffer_get_row_at_offset(lb, byteOffset); //NOTE: Which line the byte is on
+lineBuffer_get_line_start(lb, row); //NOTE: The byte offset where the line starts
+lineBuffer_get_line_contiguous(lb, row, &size); //NOTE: Pointer to the line's text with the gap moved out of the way
+
+*/
+
+//NOTE: Lines are allocated out of size classes so a 200k line file isn't 200k calls to the heap
+#define LINE_BUFFER_POOL_PAGE_SIZE (64*1024)
+#define LINE_BUFFER_POOL_SMALLEST_CLASS 16
+#define LINE_BUFFER_POOL_CLASS_COUNT 11 //NOTE: 16 bytes up to 16 kilobytes, anything bigger goes to the heap
+
+#define LINE_BUFFER_GAP_SIZE_IN_BYTES 16
+
+struct WL_Line_Pool_Page {
+	WL_Line_Pool_Page *next;
+};
+
+struct WL_Line_Pool {
+	void *free_lists[LINE_BUFFER_POOL_CLASS_COUNT];
+
+	WL_Line_Pool_Page *pages;
+	u8 *page_at;
+	size_t page_bytes_left;
+};
+
+struct WL_Line {
+	u8 *memory;
+	u32 total_size_in_bytes; //NOTE: Size of the allocation
+
+	u32 gap_start;
+	u32 gap_end;
+};
+
+struct WL_Line_Buffer {
+	WL_Line *lines;
+	s64 line_count;
+	s64 total_line_count; //NOTE: How many lines we have room for
+
+	s64 size_in_bytes;
+
+	//NOTE: The size of each line, for finding where a row starts & which row an offset is on. See wl_line_index.cpp
+	WL_Line_Index line_index;
+
+	WL_Line_Pool pool;
+};
+
+static int lineBuffer_get_pool_class(u32 size_in_bytes) {
+	int result = 0;
+	u32 class_size = LINE_BUFFER_POOL_SMALLEST_CLASS;
+	while(class_size < size_in_bytes) {
+		class_size <<= 1;
+		result++;
+	}
+	return result;
+}
+
+static u8 *lineBuffer_pool_alloc(WL_Line_Pool *pool, u32 *size_in_bytes) {
+	u8 *result = 0;
+	int class_index = lineBuffer_get_pool_class(*size_in_bytes);
+
+	if(class_index >= LINE_BUFFER_POOL_CLASS_COUNT) {
+		//NOTE: Really long line, just get it from the heap
+		result = (u8 *)platform_alloc_memory(*size_in_bytes, false);
+	} else {
+		u32 class_size = LINE_BUFFER_POOL_SMALLEST_CLASS << class_index;
+
+		if(pool->free_lists[class_index]) {
+			result = (u8 *)pool->free_lists[class_index];
+			pool->free_lists[class_index] = *((void **)result);
+		} else {
+			if(pool->page_bytes_left < class_size) {
+				//NOTE: Get a new page. The left over bytes on the old page are wasted, but they are less than one class size
+				WL_Line_Pool_Page *page = (WL_Line_Pool_Page *)platform_alloc_memory_pages(LINE_BUFFER_POOL_PAGE_SIZE);
+				page->next = pool->pages;
+				pool->pages = page;
+
+				//NOTE: Keep the allocations 16 byte aligned
+				pool->page_at = ((u8 *)page) + 16;
+				pool->page_bytes_left = LINE_BUFFER_POOL_PAGE_SIZE - 16;
+			}
+
+			result = pool->page_at;
+			pool->page_at += class_size;
+			pool->page_bytes_left -= class_size;
+		}
+
+		*size_in_bytes = class_size;
+	}
+
+	return result;
+}
+
+static void lineBuffer_pool_free(WL_Line_Pool *pool, u8 *memory, u32 size_in_bytes) {
+	if(memory) {
+		int class_index = lineBuffer_get_pool_class(size_in_bytes);
+		if(class_index >= LINE_BUFFER_POOL_CLASS_COUNT) {
+			platform_free_memory(memory);
+		} else {
+			*((void **)memory) = pool->free_lists[class_index];
+			pool->free_lists[class_index] = memory;
+		}
+	}
+}
+
+static void lineBuffer_pool_release_all(WL_Line_Pool *pool) {
+	WL_Line_Pool_Page *page = pool->pages;
+	while(page) {
+		WL_Line_Pool_Page *next = page->next;
+		platform_free_memory_pages(page, LINE_BUFFER_POOL_PAGE_SIZE);
+		page = next;
+	}
+	memset(pool, 0, sizeof(WL_Line_Pool));
+}
+
+////////////////////////////////////////////////////////////////////
+//NOTE: Gap buffer for a single line
+
+static inline u32 line_get_size_in_bytes(WL_Line *line) {
+	return line->total_size_in_bytes - (line->gap_end - line->gap_start);
+}
+
+static inline u8 line_get_byte(WL_Line *line, u32 index) {
+	if(index >= line->gap_start) {
+		index += (line->gap_end - line->gap_start);
+	}
+	return line->memory[index];
+}
+
+//NOTE: Move the gap so it starts at byte_index, only moves the bytes between the old and new position
+static void line_move_gap(WL_Line *line, u32 byte_index) {
+	u32 gap_size = line->gap_end - line->gap_start;
+	if(byte_index < line->gap_start) {
+		u32 to_move = line->gap_start - byte_index;
+		memmove(line->memory + byte_index + gap_size, line->memory + byte_index, to_move);
+	} else if(byte_index > line->gap_start) {
+		u32 to_move = byte_index - line->gap_start;
+		memmove(line->memory + line->gap_start, line->memory + line->gap_end, to_move);
+	}
+	line->gap_start = byte_index;
+	line->gap_end = byte_index + gap_size;
+}
+
+//NOTE: Make sure the gap has room for size_in_bytes. Always leaves one spare byte so the line can be null terminated.
+static void line_ensure_gap(WL_Line_Pool *pool, WL_Line *line, u32 size_in_bytes) {
+	u32 gap_size = line->gap_end - line->gap_start;
+	if(gap_size < (size_in_bytes + 1)) {
+		u32 used = line_get_size_in_bytes(line);
+		u32 new_size = used + size_in_bytes + LINE_BUFFER_GAP_SIZE_IN_BYTES;
+
+		//NOTE: Grow the line geometrically so typing on one line doesn't realloc every key stroke
+		if(new_size < 2*line->total_size_in_bytes) {
+			new_size = 2*line->total_size_in_bytes;
+		}
+
+		u8 *new_memory = lineBuffer_pool_alloc(pool, &new_size);
+		u32 after_gap = line->total_size_in_bytes - line->gap_end;
+
+		if(line->memory) {
+			memcpy(new_memory, line->memory, line->gap_start);
+			memcpy(new_memory + new_size - after_gap, line->memory + line->gap_end, after_gap);
+			lineBuffer_pool_free(pool, line->memory, line->total_size_in_bytes);
+		}
+
+		line->memory = new_memory;
+		line->gap_end = new_size - after_gap;
+		line->total_size_in_bytes = new_size;
+	}
+}
+
+static void line_insert(WL_Line_Pool *pool, WL_Line *line, u32 byte_index, u8 *bytes, u32 size_in_bytes) {
+	if(size_in_bytes > 0) {
+		line_ensure_gap(pool, line, size_in_bytes);
+		line_move_gap(line, byte_index);
+		memcpy(line->memory + line->gap_start, bytes, size_in_bytes);
+		line->gap_start += size_in_bytes;
+	}
+}
+
+static void line_remove(WL_Line *line, u32 byte_index, u32 size_in_bytes) {
+	assert(byte_index + size_in_bytes <= line_get_size_in_bytes(line));
+	line_move_gap(line, byte_index);
+	line->gap_end += size_in_bytes;
+}
+
+static void line_copy_bytes(WL_Line *line, u32 byte_index, u32 size_in_bytes, u8 *dest) {
+	assert(byte_index + size_in_bytes <= line_get_size_in_bytes(line));
+	u32 end = byte_index + size_in_bytes;
+
+	if(byte_index < line->gap_start) {
+		u32 pre_end = (end < line->gap_start) ? end : line->gap_start;
+		memcpy(dest, line->memory + byte_index, pre_end - byte_index);
+		dest += (pre_end - byte_index);
+		byte_index = pre_end;
+	}
+
+	if(byte_index < end) {
+		u32 gap_size = line->gap_end - line->gap_start;
+		memcpy(dest, line->memory + byte_index + gap_size, end - byte_index);
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+
+static void lineBuffer_reserve_lines(WL_Line_Buffer *lb, s64 line_count) {
+	if(line_count > lb->total_line_count) {
+		s64 new_total = 2*lb->total_line_count;
+		if(new_total < line_count) { new_total = line_count; }
+		if(new_total < 64) { new_total = 64; }
+
+		WL_Line *new_lines = (WL_Line *)platform_alloc_memory(new_total*sizeof(WL_Line), true);
+
+		if(lb->lines) {
+			memcpy(new_lines, lb->lines, lb->line_count*sizeof(WL_Line));
+			platform_free_memory(lb->lines);
+		}
+
+		lb->lines = new_lines;
+		lb->total_line_count = new_total;
+	}
+}
+
+static void lineBuffer_init(WL_Line_Buffer *lb) {
+	memset(lb, 0, sizeof(WL_Line_Buffer));
+
+	//NOTE: An empty buffer still has one empty line
+	lineBuffer_reserve_lines(lb, 1);
+	lb->line_count = 1;
+
+	lineIndex_init(&lb->line_index);
+}
+
+static void lineBuffer_free(WL_Line_Buffer *lb) {
+	//NOTE: Lines from the pool get freed with their page, only the really long ones are on the heap
+	for(s64 i = 0; i < lb->line_count; ++i) {
+		WL_Line *line = &lb->lines[i];
+		if(lineBuffer_get_pool_class(line->total_size_in_bytes) >= LINE_BUFFER_POOL_CLASS_COUNT) {
+			platform_free_memory(line->memory);
+		}
+	}
+
+	lineBuffer_pool_release_all(&lb->pool);
+	lineIndex_free(&lb->line_index);
+
+	if(lb->lines) { platform_free_memory(lb->lines); }
+
+	memset(lb, 0, sizeof(WL_Line_Buffer));
+}
+
+//NOTE: Copies the lines into new memory with the gaps closed up, for when a snapshot takes the old memory. 
+//		The line index isn't copied, it moves over from src since the text is the same.
+static void lineBuffer_copy_from(WL_Line_Buffer *lb, WL_Line_Buffer *src) {
+	lineBuffer_init(lb);
+	lineBuffer_reserve_lines(lb, src->line_count);
+
+	for(s64 i = 0; i < src->line_count; ++i) {
+		WL_Line *from = &src->lines[i];
+		WL_Line *to = &lb->lines[i];
+
+		u32 size = line_get_size_in_bytes(from);
+		if(size > 0) {
+			u32 total_size = size + LINE_BUFFER_GAP_SIZE_IN_BYTES;
+			to->memory = lineBuffer_pool_alloc(&lb->pool, &total_size);
+			to->total_size_in_bytes = total_size;
+			line_copy_bytes(from, 0, size, to->memory);
+
+			to->gap_start = size;
+			to->gap_end = total_size;
+		}
+	}
+
+	lb->line_count = src->line_count;
+	lb->size_in_bytes = src->size_in_bytes;
+
+	lineIndex_free(&lb->line_index);
+	lb->line_index = src->line_index;
+	lineIndex_init(&src->line_index);
+}
+
+static inline s64 lineBuffer_get_size_in_bytes(WL_Line_Buffer *lb) {
+	return lb->size_in_bytes;
+}
+
+static inline s64 lineBuffer_get_line_count(WL_Line_Buffer *lb) {
+	return lb->line_count;
+}
+
+static inline u32 lineBuffer_get_line_size(WL_Line_Buffer *lb, s64 row) {
+	assert(row >= 0 && row < lb->line_count);
+	return line_get_size_in_bytes(&lb->lines[row]);
+}
+
+static inline s64 lineBuffer_get_line_start(WL_Line_Buffer *lb, s64 row) {
+	assert(row >= 0 && row < lb->line_count);
+	return lineIndex_get_offset_of_line(&lb->line_index, row);
+}
+
+//NOTE: The end of the buffer counts as being on the last line
+static inline s64 lineBuffer_get_row_at_offset(WL_Line_Buffer *lb, s64 byte_offset, s64 *line_start = 0) {
+	assert(byte_offset >= 0 && byte_offset <= lb->size_in_bytes);
+	return lineIndex_get_line_at_offset(&lb->line_index, byte_offset, line_start);
+}
+
+static u8 lineBuffer_get_byte(WL_Line_Buffer *lb, s64 byte_offset) {
+	u8 result = 0;
+	if(byte_offset >= 0 && byte_offset < lb->size_in_bytes) {
+		s64 line_start = 0;
+		s64 row = lineBuffer_get_row_at_offset(lb, byte_offset, &line_start);
+		result = line_get_byte(&lb->lines[row], (u32)(byte_offset - line_start));
+	}
+	return result;
+}
+
+static void lineBuffer_copy_bytes(WL_Line_Buffer *lb, s64 byte_offset, s64 size_in_bytes, u8 *dest) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= lb->size_in_bytes);
+	if(size_in_bytes > 0) {
+		s64 line_start = 0;
+		s64 row = lineBuffer_get_row_at_offset(lb, byte_offset, &line_start);
+		u32 col = (u32)(byte_offset - line_start);
+
+		while(size_in_bytes > 0) {
+			WL_Line *line = &lb->lines[row];
+			u32 line_size = line_get_size_in_bytes(line);
+			u32 to_copy = line_size - col;
+			if(to_copy > size_in_bytes) { to_copy = (u32)size_in_bytes; }
+
+			line_copy_bytes(line, col, to_copy, dest);
+
+			dest += to_copy;
+			size_in_bytes -= to_copy;
+			col = 0;
+			row++;
+		}
+	}
+}
+
+//NOTE: The bytes from byte_offset up to the line's gap or the end of the line. Doesn't move the gap like lineBuffer_get_line_contiguous does.
+static u8 *lineBuffer_get_span(WL_Line_Buffer *lb, s64 byte_offset, s64 *size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset < lb->size_in_bytes);
+	s64 line_start = 0;
+	s64 row = lineBuffer_get_row_at_offset(lb, byte_offset, &line_start);
+	WL_Line *line = &lb->lines[row];
+	u32 col = (u32)(byte_offset - line_start);
+
+	u8 *result = 0;
+	if(col < line->gap_start) {
+		result = line->memory + col;
+		*size_in_bytes = line->gap_start - col;
+	} else {
+		result = line->memory + col + (line->gap_end - line->gap_start);
+		*size_in_bytes = line_get_size_in_bytes(line) - col;
+	}
+	return result;
+}
+
+//NOTE: Moves the line's gap to the end, so the text is contiguous and null terminated. Used for walking the glyphs in a line.
+static u8 *lineBuffer_get_line_contiguous(WL_Line_Buffer *lb, s64 row, u32 *size_in_bytes) {
+	assert(row >= 0 && row < lb->line_count);
+	WL_Line *line = &lb->lines[row];
+
+	//NOTE: Make sure we have room for the null terminator
+	line_ensure_gap(&lb->pool, line, 0);
+
+	u32 size = line_get_size_in_bytes(line);
+	line_move_gap(line, size);
+	line->memory[size] = '\0';
+
+	*size_in_bytes = size;
+	return line->memory;
+}
+
+//NOTE: Open up room for count lines after row
+static void lineBuffer_insert_lines(WL_Line_Buffer *lb, s64 row, s64 count) {
+	lineBuffer_reserve_lines(lb, lb->line_count + count);
+
+	s64 to_move = lb->line_count - (row + 1);
+	if(to_move > 0) {
+		memmove(&lb->lines[row + 1 + count], &lb->lines[row + 1], to_move*sizeof(WL_Line));
+	}
+	memset(&lb->lines[row + 1], 0, count*sizeof(WL_Line));
+	lb->line_count += count;
+}
+
+static void lineBuffer_insert(WL_Line_Buffer *lb, s64 byte_offset, u8 *bytes, s64 size_in_bytes) {
+	if(size_in_bytes > 0) {
+		s64 line_start = 0;
+		s64 row = lineBuffer_get_row_at_offset(lb, byte_offset, &line_start);
+		u32 col = (u32)(byte_offset - line_start);
+
+		//NOTE: Count the new lines so we only move the line array once
+		s64 newline_count = 0;
+		for(s64 i = 0; i < size_in_bytes; ++i) {
+			if(bytes[i] == '\n') { newline_count++; }
+		}
+
+		if(newline_count == 0) {
+			line_insert(&lb->pool, &lb->lines[row], col, bytes, (u32)size_in_bytes);
+		} else {
+			WL_Line *line = &lb->lines[row];
+
+			//NOTE: Take the text after the insert point off the line, it goes on the end of the last new line
+			u32 tail_size = line_get_size_in_bytes(line) - col;
+			u8 *tail = 0;
+			if(tail_size > 0) {
+				tail = (u8 *)pushSize(&globalPerFrameArena, tail_size);
+				line_copy_bytes(line, col, tail_size, tail);
+				line_remove(line, col, tail_size);
+			}
+
+			lineBuffer_insert_lines(lb, row, newline_count);
+
+			s64 row_at = row;
+			u8 *segment_start = bytes;
+			u8 *end = bytes + size_in_bytes;
+			for(u8 *at = bytes; at < end; ++at) {
+				if(*at == '\n') {
+					u8 *segment_end = at + 1;
+					WL_Line *l = &lb->lines[row_at];
+					line_insert(&lb->pool, l, line_get_size_in_bytes(l), segment_start, (u32)(segment_end - segment_start));
+
+					segment_start = segment_end;
+					row_at++;
+				}
+			}
+
+			//NOTE: Last segment & what was after the insert point
+			WL_Line *last = &lb->lines[row_at];
+			line_insert(&lb->pool, last, 0, segment_start, (u32)(end - segment_start));
+			line_insert(&lb->pool, last, line_get_size_in_bytes(last), tail, tail_size);
+		}
+
+		lb->size_in_bytes += size_in_bytes;
+		lineIndex_insert(&lb->line_index, byte_offset, bytes, size_in_bytes);
+	}
+}
+
+static void lineBuffer_remove(WL_Line_Buffer *lb, s64 byte_offset, s64 size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= lb->size_in_bytes);
+
+	if(size_in_bytes > 0) {
+		s64 start_line_start = 0;
+		s64 start_row = lineBuffer_get_row_at_offset(lb, byte_offset, &start_line_start);
+		s64 end_line_start = 0;
+		s64 end_row = lineBuffer_get_row_at_offset(lb, byte_offset + size_in_bytes, &end_line_start);
+
+		u32 start_col = (u32)(byte_offset - start_line_start);
+
+		if(start_row == end_row) {
+			line_remove(&lb->lines[start_row], start_col, (u32)size_in_bytes);
+		} else {
+			u32 end_col = (u32)(byte_offset + size_in_bytes - end_line_start);
+
+			WL_Line *first = &lb->lines[start_row];
+			WL_Line *last = &lb->lines[end_row];
+
+			//NOTE: Join what's left of the last line on to the first line
+			line_remove(first, start_col, line_get_size_in_bytes(first) - start_col);
+
+			u32 last_left = line_get_size_in_bytes(last) - end_col;
+			if(last_left > 0) {
+				u8 *temp = (u8 *)pushSize(&globalPerFrameArena, last_left);
+				line_copy_bytes(last, end_col, last_left, temp);
+				line_insert(&lb->pool, first, start_col, temp, last_left);
+			}
+
+			//NOTE: Free the lines in between & the last line
+			for(s64 i = start_row + 1; i <= end_row; ++i) {
+				lineBuffer_pool_free(&lb->pool, lb->lines[i].memory, lb->lines[i].total_size_in_bytes);
+			}
+
+			s64 to_move = lb->line_count - (end_row + 1);
+			if(to_move > 0) {
+				memmove(&lb->lines[start_row + 1], &lb->lines[end_row + 1], to_move*sizeof(WL_Line));
+			}
+			lb->line_count -= (end_row - start_row);
+		}
+
+		lb->size_in_bytes -= size_in_bytes;
+		lineIndex_remove(&lb->line_index, byte_offset, size_in_bytes);
+	}
+}
@@ -0,0 +1,818 @@
+/*
+Newline index for the storage types that don't keep track of their own lines (the gap buffer & the piece table).
+The line buffer keeps one too, for finding its rows. See wl_line_buffer.cpp
+
+A B-tree where the leaves hold how long each line is in bytes, including the newline at the end of it. Every node keeps
+how many lines and bytes are under it, so going from a byte offset to a line or a line to a byte offset is just walking
+down the tree, O(log n). Typing that doesn't add a newline only changes the size of one line and the nodes above it.
+
+There is always at least one line. The last line doesn't end in a newline, so it can be empty.
+
+Functions to use:
+
+lineIndex_insert(index, byteOffset, bytes, size); //NOTE: Call these with the text as it's added & removed from the buffer
+lineIndex_remove(index, byteOffset, size);
+
+lineIndex_get_line_at_offset(index, byteOffset);
+lineIndex_get_offset_of_line(index, line);
+
+lineIndex_build(index, bytes, size); //NOTE: Uses all the cores to index a whole file at once
+
+*/
+
+#define LINE_INDEX_LEAF_COUNT 64
+#define LINE_INDEX_MAX_CHILDREN 16
+
+#define LINE_INDEX_POOL_PAGE_SIZE (64*1024)
+
+struct WL_Line_Index_Node {
+	s64 line_count;
+	s64 size_in_bytes;
+
+	bool is_leaf;
+	u32 count; //NOTE: Lines used if it's a leaf, children used if it isn't
+
+	union {
+		WL_Line_Index_Node *children[LINE_INDEX_MAX_CHILDREN];
+		s64 line_sizes[LINE_INDEX_LEAF_COUNT];
+	};
+};
+
+struct WL_Line_Index_Pool_Page {
+	WL_Line_Index_Pool_Page *next;
+};
+
+struct WL_Line_Index {
+	WL_Line_Index_Node *root;
+
+	//NOTE: All the nodes are the same size, so they come out of pages with a free list
+	WL_Line_Index_Node *free_list;
+	WL_Line_Index_Pool_Page *pages;
+	u8 *page_at;
+	size_t page_bytes_left;
+};
+
+static WL_Line_Index_Node *lineIndex_alloc_node(WL_Line_Index *index, bool is_leaf) {
+	WL_Line_Index_Node *result = 0;
+
+	if(index->free_list) {
+		result = index->free_list;
+		index->free_list = *((WL_Line_Index_Node **)result);
+	} else {
+		if(index->page_bytes_left < sizeof(WL_Line_Index_Node)) {
+			WL_Line_Index_Pool_Page *page = (WL_Line_Index_Pool_Page *)platform_alloc_memory_pages(LINE_INDEX_POOL_PAGE_SIZE);
+			page->next = index->pages;
+			index->pages = page;
+
+			index->page_at = ((u8 *)page) + 16;
+			index->page_bytes_left = LINE_INDEX_POOL_PAGE_SIZE - 16;
+		}
+
+		result = (WL_Line_Index_Node *)index->page_at;
+		index->page_at += sizeof(WL_Line_Index_Node);
+		index->page_bytes_left -= sizeof(WL_Line_Index_Node);
+	}
+
+	memset(result, 0, sizeof(WL_Line_Index_Node));
+	result->is_leaf = is_leaf;
+
+	return result;
+}
+
+static void lineIndex_free_node(WL_Line_Index *index, WL_Line_Index_Node *node) {
+	*((WL_Line_Index_Node **)node) = index->free_list;
+	index->free_list = node;
+}
+
+static void lineIndex_free_tree(WL_Line_Index *index, WL_Line_Index_Node *node) {
+	if(!node->is_leaf) {
+		for(u32 i = 0; i < node->count; ++i) {
+			lineIndex_free_tree(index, node->children[i]);
+		}
+	}
+	lineIndex_free_node(index, node);
+}
+
+static void lineIndex_update_summary(WL_Line_Index_Node *node) {
+	node->line_count = 0;
+	node->size_in_bytes = 0;
+
+	if(node->is_leaf) {
+		node->line_count = node->count;
+		for(u32 i = 0; i < node->count; ++i) {
+			node->size_in_bytes += node->line_sizes[i];
+		}
+	} else {
+		for(u32 i = 0; i < node->count; ++i) {
+			node->line_count += node->children[i]->line_count;
+			node->size_in_bytes += node->children[i]->size_in_bytes;
+		}
+	}
+}
+
+static void lineIndex_init(WL_Line_Index *index) {
+	memset(index, 0, sizeof(WL_Line_Index));
+	index->root = lineIndex_alloc_node(index, true);
+
+	//NOTE: An empty buffer still has one line
+	index->root->count = 1;
+	lineIndex_update_summary(index->root);
+}
+
+static void lineIndex_free(WL_Line_Index *index) {
+	//NOTE: Nodes get freed with their page
+	WL_Line_Index_Pool_Page *page = index->pages;
+	while(page) {
+		WL_Line_Index_Pool_Page *next = page->next;
+		platform_free_memory_pages(page, LINE_INDEX_POOL_PAGE_SIZE);
+		page = next;
+	}
+
+	memset(index, 0, sizeof(WL_Line_Index));
+}
+
+static inline s64 lineIndex_get_line_count(WL_Line_Index *index) {
+	return index->root->line_count;
+}
+
+static inline s64 lineIndex_get_size_in_bytes(WL_Line_Index *index) {
+	return index->root->size_in_bytes;
+}
+
+//NOTE: Which line the offset is on, lines start at 0. A newline counts as being on the line it ends.
+static s64 lineIndex_get_line_at_offset(WL_Line_Index *index, s64 byte_offset, s64 *line_start = 0) {
+	assert(byte_offset >= 0 && byte_offset <= lineIndex_get_size_in_bytes(index));
+
+	s64 result = 0;
+	s64 start = 0;
+
+	WL_Line_Index_Node *node = index->root;
+	while(!node->is_leaf) {
+		u32 i = 0;
+		while(i < (node->count - 1) && byte_offset >= node->children[i]->size_in_bytes) {
+			byte_offset -= node->children[i]->size_in_bytes;
+			start += node->children[i]->size_in_bytes;
+			result += node->children[i]->line_count;
+			i++;
+		}
+		node = node->children[i];
+	}
+
+	u32 i = 0;
+	while(i < (node->count - 1) && byte_offset >= node->line_sizes[i]) {
+		byte_offset -= node->line_sizes[i];
+		start += node->line_sizes[i];
+		i++;
+	}
+	result += i;
+
+	if(line_start) { *line_start = start; }
+
+	return result;
+}
+
+//NOTE: Byte offset of the start of the line. Returns the end of the buffer if there aren't that many lines
+static s64 lineIndex_get_offset_of_line(WL_Line_Index *index, s64 line) {
+	s64 result = 0;
+
+	if(line >= lineIndex_get_line_count(index)) {
+		result = lineIndex_get_size_in_bytes(index);
+	} else if(line > 0) {
+		WL_Line_Index_Node *node = index->root;
+		while(!node->is_leaf) {
+			u32 i = 0;
+			while(line >= node->children[i]->line_count) {
+				line -= node->children[i]->line_count;
+				result += node->children[i]->size_in_bytes;
+				i++;
+			}
+			node = node->children[i];
+		}
+
+		for(s64 i = 0; i < line; ++i) {
+			result += node->line_sizes[i];
+		}
+	}
+
+	return result;
+}
+
+static s64 lineIndex_get_line_size(WL_Line_Index *index, s64 line) {
+	assert(line >= 0 && line < lineIndex_get_line_count(index));
+
+	WL_Line_Index_Node *node = index->root;
+	while(!node->is_leaf) {
+		u32 i = 0;
+		while(line >= node->children[i]->line_count) {
+			line -= node->children[i]->line_count;
+			i++;
+		}
+		node = node->children[i];
+	}
+
+	return node->line_sizes[line];
+}
+
+static void lineIndex_add_to_line_size(WL_Line_Index *index, s64 line, s64 size_in_bytes) {
+	assert(line >= 0 && line < lineIndex_get_line_count(index));
+
+	WL_Line_Index_Node *node = index->root;
+	while(!node->is_leaf) {
+		node->size_in_bytes += size_in_bytes;
+
+		u32 i = 0;
+		while(line >= node->children[i]->line_count) {
+			line -= node->children[i]->line_count;
+			i++;
+		}
+		node = node->children[i];
+	}
+
+	node->line_sizes[line] += size_in_bytes;
+	node->size_in_bytes += size_in_bytes;
+
+	assert(node->line_sizes[line] >= 0);
+}
+
+//NOTE: Put the child in at position, splitting the node if it's full. Returns the new right half if it split.
+static WL_Line_Index_Node *lineIndex_add_child(WL_Line_Index *index, WL_Line_Index_Node *node, u32 position, WL_Line_Index_Node *child) {
+	WL_Line_Index_Node *split = 0;
+
+	WL_Line_Index_Node *children[LINE_INDEX_MAX_CHILDREN + 1];
+	u32 count = 0;
+	for(u32 i = 0; i < node->count; ++i) {
+		if(i == position) { children[count++] = child; }
+		children[count++] = node->children[i];
+	}
+	if(position == node->count) { children[count++] = child; }
+
+	if(count <= LINE_INDEX_MAX_CHILDREN) {
+		memcpy(node->children, children, count*sizeof(WL_Line_Index_Node *));
+		node->count = count;
+	} else {
+		split = lineIndex_alloc_node(index, false);
+
+		u32 left_count = count / 2;
+		memcpy(node->children, children, left_count*sizeof(WL_Line_Index_Node *));
+		node->count = left_count;
+
+		memcpy(split->children, children + left_count, (count - left_count)*sizeof(WL_Line_Index_Node *));
+		split->count = count - left_count;
+
+		lineIndex_update_summary(split);
+	}
+
+	lineIndex_update_summary(node);
+
+	return split;
+}
+
+//NOTE: count is at most a leaf. Returns the new right half if the node split.
+static WL_Line_Index_Node *lineIndex_insert_lines_(WL_Line_Index *index, WL_Line_Index_Node *node, s64 line, s64 *line_sizes, u32 count) {
+	WL_Line_Index_Node *split = 0;
+
+	if(node->is_leaf) {
+		u32 at = (u32)line;
+
+		if(node->count + count <= LINE_INDEX_LEAF_COUNT) {
+			memmove(node->line_sizes + at + count, node->line_sizes + at, (node->count - at)*sizeof(s64));
+			memcpy(node->line_sizes + at, line_sizes, count*sizeof(s64));
+			node->count += count;
+		} else {
+			//NOTE: Doesn't fit, split the leaf in half
+			s64 temp[2*LINE_INDEX_LEAF_COUNT];
+			u32 total = node->count + count;
+
+			memcpy(temp, node->line_sizes, at*sizeof(s64));
+			memcpy(temp + at, line_sizes, count*sizeof(s64));
+			memcpy(temp + at + count, node->line_sizes + at, (node->count - at)*sizeof(s64));
+
+			u32 left_count = total / 2;
+
+			split = lineIndex_alloc_node(index, true);
+			memcpy(split->line_sizes, temp + left_count, (total - left_count)*sizeof(s64));
+			split->count = total - left_count;
+			lineIndex_update_summary(split);
+
+			memcpy(node->line_sizes, temp, left_count*sizeof(s64));
+			node->count = left_count;
+		}
+
+		lineIndex_update_summary(node);
+	} else {
+		//NOTE: Find the child the line goes in. Lines on the end of a child go on the end of that child
+		u32 i = 0;
+		while(i < (node->count - 1) && line > node->children[i]->line_count) {
+			line -= node->children[i]->line_count;
+			i++;
+		}
+
+		WL_Line_Index_Node *new_child = lineIndex_insert_lines_(index, node->children[i], line, line_sizes, count);
+
+		if(new_child) {
+			split = lineIndex_add_child(index, node, i + 1, new_child);
+		} else {
+			lineIndex_update_summary(node);
+		}
+	}
+
+	return split;
+}
+
+//NOTE: Adds new lines so the first one is at line
+static void lineIndex_insert_lines(WL_Line_Index *index, s64 line, s64 *line_sizes, s64 count) {
+	assert(line >= 0 && line <= lineIndex_get_line_count(index));
+
+	//NOTE: Put them in a leaf at a time
+	while(count > 0) {
+		u32 size = (count > LINE_INDEX_LEAF_COUNT) ? LINE_INDEX_LEAF_COUNT : (u32)count;
+
+		WL_Line_Index_Node *split = lineIndex_insert_lines_(index, index->root, line, line_sizes, size);
+
+		if(split) {
+			//NOTE: The root split so the tree gets one level deeper
+			WL_Line_Index_Node *new_root = lineIndex_alloc_node(index, false);
+			new_root->children[0] = index->root;
+			new_root->children[1] = split;
+			new_root->count = 2;
+			lineIndex_update_summary(new_root);
+
+			index->root = new_root;
+		}
+
+		line_sizes += size;
+		line += size;
+		count -= size;
+	}
+}
+
+static void lineIndex_remove_child(WL_Line_Index_Node *node, u32 position) {
+	memmove(&node->children[position], &node->children[position + 1], (node->count - position - 1)*sizeof(WL_Line_Index_Node *));
+	node->count--;
+}
+
+//NOTE: Join neighbours back together if one of them has got small, so the tree doesn't fill up with nearly empty nodes
+static void lineIndex_merge_small_children(WL_Line_Index *index, WL_Line_Index_Node *node) {
+	u32 i = 0;
+	while(i + 1 < node->count) {
+		WL_Line_Index_Node *a = node->children[i];
+		WL_Line_Index_Node *b = node->children[i + 1];
+
+		bool merged = false;
+
+		if(a->is_leaf) {
+			bool is_small = (a->count < LINE_INDEX_LEAF_COUNT / 4) || (b->count < LINE_INDEX_LEAF_COUNT / 4);
+			if(is_small && (a->count + b->count) <= LINE_INDEX_LEAF_COUNT) {
+				memcpy(a->line_sizes + a->count, b->line_sizes, b->count*sizeof(s64));
+				a->count += b->count;
+				merged = true;
+			}
+		} else {
+			bool is_small = (a->count < LINE_INDEX_MAX_CHILDREN / 4) || (b->count < LINE_INDEX_MAX_CHILDREN / 4);
+			if(is_small && (a->count + b->count) <= LINE_INDEX_MAX_CHILDREN) {
+				memcpy(a->children + a->count, b->children, b->count*sizeof(WL_Line_Index_Node *));
+				a->count += b->count;
+				merged = true;
+
+				//NOTE: The children where the two nodes joined might be small now too
+				lineIndex_merge_small_children(index, a);
+			}
+		}
+
+		if(merged) {
+			lineIndex_update_summary(a);
+			lineIndex_free_node(index, b);
+			lineIndex_remove_child(node, i + 1);
+		} else {
+			i++;
+		}
+	}
+}
+
+static void lineIndex_remove_lines_(WL_Line_Index *index, WL_Line_Index_Node *node, s64 line, s64 count) {
+	if(node->is_leaf) {
+		u32 at = (u32)line;
+		memmove(node->line_sizes + at, node->line_sizes + at + count, (node->count - (at + count))*sizeof(s64));
+		node->count -= (u32)count;
+		lineIndex_update_summary(node);
+	} else {
+		s64 child_start = 0;
+		u32 i = 0;
+
+		while(i < node->count && count > 0) {
+			WL_Line_Index_Node *child = node->children[i];
+			s64 child_count = child->line_count;
+
+			if(line < child_start + child_count) {
+				s64 line_in_child = line - child_start;
+				s64 to_remove = child_count - line_in_child;
+				if(to_remove > count) { to_remove = count; }
+
+				count -= to_remove;
+
+				if(to_remove == child_count) {
+					//NOTE: The whole child goes, the next child moves into this slot
+					lineIndex_free_tree(index, child);
+					lineIndex_remove_child(node, i);
+				} else {
+					lineIndex_remove_lines_(index, child, line_in_child, to_remove);
+
+					child_start += child->line_count;
+					i++;
+				}
+			} else {
+				child_start += child_count;
+				i++;
+			}
+		}
+
+		lineIndex_merge_small_children(index, node);
+		lineIndex_update_summary(node);
+	}
+}
+
+static void lineIndex_remove_lines(WL_Line_Index *index, s64 line, s64 count) {
+	//NOTE: Always keep one line
+	assert(line >= 0 && line + count <= lineIndex_get_line_count(index) && count < lineIndex_get_line_count(index));
+
+	if(count > 0) {
+		lineIndex_remove_lines_(index, index->root, line, count);
+
+		//NOTE: Make the tree shallower if the root only has one child left
+		while(!index->root->is_leaf && index->root->count == 1) {
+			WL_Line_Index_Node *old_root = index->root;
+			index->root = old_root->children[0];
+			lineIndex_free_node(index, old_root);
+		}
+	}
+}
+
+/*
+Building the index for a whole file at once, when it's opened.
+
+The file gets split into one chunk per thread. The first pass counts the newlines in each chunk with SSE2, or AVX2 if the
+cpu has it. Adding the counts up tells each chunk which line it starts on, so the second pass can write the line sizes 
+straight into the leaves without waiting on the other chunks. Only '\n' ends a line, the '\r' of a \r\n is part of the 
+line before it, so a \r\n split across two chunks doesn't need anything special.
+*/
+
+#define LINE_INDEX_MIN_BYTES_PER_THREAD (1024*1024)
+#define LINE_INDEX_MAX_THREADS 32
+
+struct WL_Line_Index_Scan_Chunk {
+	u8 *bytes;
+	s64 start; //NOTE: Where the chunk is in the whole text
+	s64 size_in_bytes;
+	bool use_avx2;
+
+	//NOTE: Filled out by the first pass
+	s64 newline_count;
+	s64 last_line_start; //NOTE: After the last newline in the chunk, -1 if there isn't one
+
+	//NOTE: Used by the second pass
+	s64 first_line; //NOTE: The line the first newline in the chunk ends
+	s64 line_start; //NOTE: Where that line starts, might be in an earlier chunk
+	WL_Line_Index_Node **leaves;
+};
+
+static s64 lineIndex_count_newlines_scalar(u8 *bytes, s64 size_in_bytes) {
+	s64 result = 0;
+	for(s64 i = 0; i < size_in_bytes; ++i) {
+		if(bytes[i] == '\n') { result++; }
+	}
+	return result;
+}
+
+static s64 lineIndex_count_newlines_sse2(u8 *bytes, s64 size_in_bytes) {
+	s64 result = 0;
+	s64 at = 0;
+
+	__m128i newline = _mm_set1_epi8('\n');
+	__m128i zero = _mm_setzero_si128();
+
+	while(at + 16 <= size_in_bytes) {
+		//NOTE: A compare gives -1 for each newline, so subtracting it counts them in each byte. A byte can only count to 255 so add them up before then.
+		s64 block_count = (size_in_bytes - at) / 16;
+		if(block_count > 255) { block_count = 255; }
+
+		__m128i counts = _mm_setzero_si128();
+		for(s64 i = 0; i < block_count; ++i) {
+			__m128i block = _mm_loadu_si128((__m128i *)(bytes + at));
+			counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(block, newline));
+			at += 16;
+		}
+
+		//NOTE: Gives two sums, in the bottom of each 64bit half
+		__m128i sums = _mm_sad_epu8(counts, zero);
+		result += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+	}
+
+	result += lineIndex_count_newlines_scalar(bytes + at, size_in_bytes - at);
+
+	return result;
+}
+
+static s64 lineIndex_count_newlines_avx2(u8 *bytes, s64 size_in_bytes) {
+	s64 result = 0;
+	s64 at = 0;
+
+	__m256i newline = _mm256_set1_epi8('\n');
+	__m256i zero = _mm256_setzero_si256();
+
+	while(at + 32 <= size_in_bytes) {
+		s64 block_count = (size_in_bytes - at) / 32;
+		if(block_count > 255) { block_count = 255; }
+
+		__m256i counts = _mm256_setzero_si256();
+		for(s64 i = 0; i < block_count; ++i) {
+			__m256i block = _mm256_loadu_si256((__m256i *)(bytes + at));
+			counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(block, newline));
+			at += 32;
+		}
+
+		//NOTE: Gives four sums, in the bottom of each 64bit quarter
+		__m256i sums = _mm256_sad_epu8(counts, zero);
+		result += _mm256_extract_epi16(sums, 0) + _mm256_extract_epi16(sums, 4) + _mm256_extract_epi16(sums, 8) + _mm256_extract_epi16(sums, 12);
+	}
+
+	result += lineIndex_count_newlines_sse2(bytes + at, size_in_bytes - at);
+
+	return result;
+}
+
+//NOTE: A bit set for each newline in the 32 bytes
+static inline u32 lineIndex_get_newline_mask(u8 *bytes, bool use_avx2) {
+	u32 result = 0;
+	if(use_avx2) {
+		__m256i block = _mm256_loadu_si256((__m256i *)bytes);
+		result = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+	} else {
+		__m128i newline = _mm_set1_epi8('\n');
+		u32 low = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)bytes), newline));
+		u32 high = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)(bytes + 16)), newline));
+		result = low | (high << 16);
+	}
+	return result;
+}
+
+static THREAD_WORK_FUNCTION(lineIndex_count_newlines_work) {
+	WL_Line_Index_Scan_Chunk *chunk = (WL_Line_Index_Scan_Chunk *)Data;
+
+	if(chunk->use_avx2) {
+		chunk->newline_count = lineIndex_count_newlines_avx2(chunk->bytes, chunk->size_in_bytes);
+	} else {
+		chunk->newline_count = lineIndex_count_newlines_sse2(chunk->bytes, chunk->size_in_bytes);
+	}
+
+	chunk->last_line_start = -1;
+	if(chunk->newline_count > 0) {
+		s64 at = chunk->size_in_bytes - 1;
+		while(chunk->bytes[at] != '\n') { at--; }
+		chunk->last_line_start = chunk->start + at + 1;
+	}
+}
+
+static THREAD_WORK_FUNCTION(lineIndex_write_line_sizes_work) {
+	WL_Line_Index_Scan_Chunk *chunk = (WL_Line_Index_Scan_Chunk *)Data;
+
+	s64 line = chunk->first_line;
+	s64 line_start = chunk->line_start;
+
+	s64 at = 0;
+	while(at < chunk->size_in_bytes) {
+		u32 mask = 0;
+		s64 block_size = 32;
+
+		if(at + 32 <= chunk->size_in_bytes) {
+			mask = lineIndex_get_newline_mask(chunk->bytes + at, chunk->use_avx2);
+		} else {
+			//NOTE: Not enough left for a whole block
+			block_size = chunk->size_in_bytes - at;
+			for(s64 i = 0; i < block_size; ++i) {
+				if(chunk->bytes[at + i] == '\n') { mask |= (1u << i); }
+			}
+		}
+
+		while(mask) {
+			unsigned long bit;
+			_BitScanForward(&bit, mask);
+			mask &= (mask - 1);
+
+			s64 line_end = chunk->start + at + bit + 1;
+			chunk->leaves[line / LINE_INDEX_LEAF_COUNT]->line_sizes[line % LINE_INDEX_LEAF_COUNT] = line_end - line_start;
+
+			line_start = line_end;
+			line++;
+		}
+
+		at += block_size;
+	}
+
+	assert(line == chunk->first_line + chunk->newline_count);
+}
+
+static void lineIndex_split_into_chunks(WL_Line_Index_Scan_Chunk *chunks, u32 chunk_count, u8 *bytes, s64 size_in_bytes) {
+	bool use_avx2 = platform_cpu_has_avx2();
+
+	s64 chunk_size = size_in_bytes / chunk_count;
+	for(u32 i = 0; i < chunk_count; ++i) {
+		WL_Line_Index_Scan_Chunk *chunk = &chunks[i];
+		memset(chunk, 0, sizeof(WL_Line_Index_Scan_Chunk));
+
+		chunk->start = i*chunk_size;
+		chunk->size_in_bytes = (i == (chunk_count - 1)) ? (size_in_bytes - chunk->start) : chunk_size;
+		chunk->bytes = bytes + chunk->start;
+		chunk->use_avx2 = use_avx2;
+	}
+}
+
+static u32 lineIndex_get_chunk_count(s64 size_in_bytes) {
+	s64 result = platform_get_processor_count();
+	if(result > LINE_INDEX_MAX_THREADS) { result = LINE_INDEX_MAX_THREADS; }
+
+	//NOTE: Not worth starting a thread for a small amount of text
+	s64 most_for_size = size_in_bytes / LINE_INDEX_MIN_BYTES_PER_THREAD;
+	if(result > most_for_size) { result = most_for_size; }
+	if(result < 1) { result = 1; }
+
+	return (u32)result;
+}
+
+//NOTE: Counts the newlines using all the cores, for deciding how to store a file before loading it
+static s64 lineIndex_count_newlines(u8 *bytes, s64 size_in_bytes) {
+	WL_Line_Index_Scan_Chunk chunks[LINE_INDEX_MAX_THREADS];
+	u32 chunk_count = lineIndex_get_chunk_count(size_in_bytes);
+	lineIndex_split_into_chunks(chunks, chunk_count, bytes, size_in_bytes);
+
+	platform_do_work_in_parallel(lineIndex_count_newlines_work, chunks, sizeof(WL_Line_Index_Scan_Chunk), chunk_count);
+
+	s64 result = 0;
+	for(u32 i = 0; i < chunk_count; ++i) {
+		result += chunks[i].newline_count;
+	}
+	return result;
+}
+
+//NOTE: Throws away what's in the index and builds it for the text instead
+static void lineIndex_build_(WL_Line_Index *index, u8 *bytes, s64 size_in_bytes, u32 chunk_count) {
+	assert(chunk_count > 0 && chunk_count <= LINE_INDEX_MAX_THREADS);
+
+	WL_Line_Index_Scan_Chunk chunks[LINE_INDEX_MAX_THREADS];
+	lineIndex_split_into_chunks(chunks, chunk_count, bytes, size_in_bytes);
+
+	platform_do_work_in_parallel(lineIndex_count_newlines_work, chunks, sizeof(WL_Line_Index_Scan_Chunk), chunk_count);
+
+	//NOTE: Add up the counts so each chunk knows which line it starts on
+	s64 line_count = 1;
+	s64 line_start = 0;
+	for(u32 i = 0; i < chunk_count; ++i) {
+		chunks[i].first_line = line_count - 1;
+		chunks[i].line_start = line_start;
+
+		line_count += chunks[i].newline_count;
+		if(chunks[i].last_line_start >= 0) {
+			line_start = chunks[i].last_line_start;
+		}
+	}
+
+	//NOTE: Make all the leaves first so the threads can write into them 
+	lineIndex_free(index);
+
+	s64 leaf_count = (line_count + LINE_INDEX_LEAF_COUNT - 1) / LINE_INDEX_LEAF_COUNT;
+	WL_Line_Index_Node **nodes = (WL_Line_Index_Node **)platform_alloc_memory(leaf_count*sizeof(WL_Line_Index_Node *), false);
+
+	for(s64 i = 0; i < leaf_count; ++i) {
+		WL_Line_Index_Node *leaf = lineIndex_alloc_node(index, true);
+		leaf->count = (i == (leaf_count - 1)) ? (u32)(line_count - i*LINE_INDEX_LEAF_COUNT) : LINE_INDEX_LEAF_COUNT;
+		nodes[i] = leaf;
+	}
+
+	for(u32 i = 0; i < chunk_count; ++i) {
+		chunks[i].leaves = nodes;
+	}
+
+	platform_do_work_in_parallel(lineIndex_write_line_sizes_work, chunks, sizeof(WL_Line_Index_Scan_Chunk), chunk_count);
+
+	//NOTE: The last line doesn't end in a newline, so none of the chunks wrote it
+	nodes[(line_count - 1) / LINE_INDEX_LEAF_COUNT]->line_sizes[(line_count - 1) % LINE_INDEX_LEAF_COUNT] = size_in_bytes - line_start;
+
+	for(s64 i = 0; i < leaf_count; ++i) {
+		lineIndex_update_summary(nodes[i]);
+	}
+
+	//NOTE: Build the tree up a level at a time. The parents go back in the same array since they're written behind where we're reading.
+	s64 node_count = leaf_count;
+	while(node_count > 1) {
+		s64 parent_count = (node_count + LINE_INDEX_MAX_CHILDREN - 1) / LINE_INDEX_MAX_CHILDREN;
+
+		for(s64 i = 0; i < parent_count; ++i) {
+			WL_Line_Index_Node *parent = lineIndex_alloc_node(index, false);
+
+			s64 first_child = i*LINE_INDEX_MAX_CHILDREN;
+			s64 child_count = node_count - first_child;
+			if(child_count > LINE_INDEX_MAX_CHILDREN) { child_count = LINE_INDEX_MAX_CHILDREN; }
+
+			memcpy(parent->children, nodes + first_child, child_count*sizeof(WL_Line_Index_Node *));
+			parent->count = (u32)child_count;
+			lineIndex_update_summary(parent);
+
+			nodes[i] = parent;
+		}
+
+		node_count = parent_count;
+	}
+
+	index->root = nodes[0];
+
+	platform_free_memory(nodes);
+
+	assert(lineIndex_get_line_count(index) == line_count);
+	assert(lineIndex_get_size_in_bytes(index) == size_in_bytes);
+}
+
+static void lineIndex_build(WL_Line_Index *index, u8 *bytes, s64 size_in_bytes) {
+	lineIndex_build_(index, bytes, size_in_bytes, lineIndex_get_chunk_count(size_in_bytes));
+}
+
+static void lineIndex_insert(WL_Line_Index *index, s64 byte_offset, u8 *bytes, s64 size_in_bytes) {
+	//NOTE: Nothing in it yet, like when a file is loaded, so build the whole thing at once
+	if(lineIndex_get_size_in_bytes(index) == 0 && size_in_bytes > 0) {
+		lineIndex_build(index, bytes, size_in_bytes);
+		return;
+	}
+
+	s64 line_start = 0;
+	s64 line = lineIndex_get_line_at_offset(index, byte_offset, &line_start);
+
+	s64 line_size = lineIndex_get_line_size(index, line);
+	s64 size_before = byte_offset - line_start;
+
+	//NOTE: Find the first newline, the line we're inserting into ends there now
+	s64 at = 0;
+	while(at < size_in_bytes && bytes[at] != '\n') { at++; }
+
+	if(at == size_in_bytes) {
+		//NOTE: No new lines, just a longer line
+		lineIndex_add_to_line_size(index, line, size_in_bytes);
+	} else {
+		at++;
+		lineIndex_add_to_line_size(index, line, (size_before + at) - line_size);
+
+		//NOTE: Add the new lines a batch at a time. The last one gets the rest of the line we split.
+		s64 new_lines[LINE_INDEX_LEAF_COUNT];
+		s64 new_line_count = 0;
+		s64 next_line = line + 1;
+
+		while(at < size_in_bytes) {
+			s64 start = at;
+			while(at < size_in_bytes && bytes[at] != '\n') { at++; }
+			if(at < size_in_bytes) { at++; }
+
+			if(new_line_count == LINE_INDEX_LEAF_COUNT) {
+				lineIndex_insert_lines(index, next_line, new_lines, new_line_count);
+				next_line += new_line_count;
+				new_line_count = 0;
+			}
+
+			new_lines[new_line_count++] = at - start;
+		}
+
+		//NOTE: The rest of the split line
+		s64 size_after = line_size - size_before;
+		if(bytes[size_in_bytes - 1] == '\n') {
+			if(new_line_count == LINE_INDEX_LEAF_COUNT) {
+				lineIndex_insert_lines(index, next_line, new_lines, new_line_count);
+				next_line += new_line_count;
+				new_line_count = 0;
+			}
+			new_lines[new_line_count++] = size_after;
+		} else {
+			new_lines[new_line_count - 1] += size_after;
+		}
+
+		lineIndex_insert_lines(index, next_line, new_lines, new_line_count);
+	}
+}
+
+static void lineIndex_remove(WL_Line_Index *index, s64 byte_offset, s64 size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= lineIndex_get_size_in_bytes(index));
+
+	if(size_in_bytes > 0) {
+		s64 first_start = 0;
+		s64 first_line = lineIndex_get_line_at_offset(index, byte_offset, &first_start);
+
+		s64 last_start = 0;
+		s64 last_line = lineIndex_get_line_at_offset(index, byte_offset + size_in_bytes, &last_start);
+
+		if(first_line == last_line) {
+			lineIndex_add_to_line_size(index, first_line, -size_in_bytes);
+		} else {
+			//NOTE: The first line gets what was left of the last line
+			s64 last_end = last_start + lineIndex_get_line_size(index, last_line);
+			s64 new_size = (byte_offset - first_start) + (last_end - (byte_offset + size_in_bytes));
+
+			lineIndex_remove_lines(index, first_line + 1, last_line - first_line);
+			lineIndex_add_to_line_size(index, first_line, new_size - lineIndex_get_line_size(index, first_line));
+		}
+	}
+}
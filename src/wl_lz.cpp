@@ -0,0 +1,198 @@
+/*
+A small LZ compressor, for squashing text we want to keep but aren't using, like old undo history.
+
+It's the same idea as LZ4: the output is a list of sequences, each one some bytes copied as they are (literals) then a
+match, which copies bytes from earlier in the output. A hash table of the last place each 4 bytes were seen finds the
+matches, so it's one pass & doesn't need any memory apart from the table. Decompressing is just copying bytes around.
+
+Each sequence starts with a token, the top 4 bits are the literal count & the bottom 4 bits are the match length minus
+LZ_MIN_MATCH. If either is 15 there's more of it after, in bytes of 255 till one that's less. Then it's the literals,
+then the match offset as 2 bytes. The last sequence is only literals.
+
+Safe on any thread.
+
+Functions to use:
+
+lz_get_max_compressed_size(size_in_bytes); //NOTE: How much room to give lz_compress
+lz_compress(src, size_in_bytes, dest, dest_size_in_bytes); //NOTE: Returns the compressed size, -1 if it didn't fit
+lz_decompress(src, size_in_bytes, dest, original_size_in_bytes); //NOTE: False if it isn't good compressed data
+
+*/
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 0xFFFF
+
+//NOTE: The last bytes are always literals, so looking for a match can read 4 bytes without checking for the end
+#define LZ_END_LITERALS 5
+
+#define LZ_HASH_BITS 12
+
+static inline s64 lz_get_max_compressed_size(s64 size_in_bytes) {
+	return size_in_bytes + (size_in_bytes / 255) + 16;
+}
+
+static inline u32 lz_read_u32(u8 *at) {
+	u32 result;
+	memcpy(&result, at, sizeof(u32));
+	return result;
+}
+
+static inline u32 lz_hash(u32 sequence) {
+	return (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+//NOTE: Writes the count that didn't fit in the token's 4 bits
+static inline u8 *lz_write_length(u8 *out, s64 length) {
+	while(length >= 255) {
+		*out++ = 255;
+		length -= 255;
+	}
+	*out++ = (u8)length;
+	return out;
+}
+
+//NOTE: The literals, then the match if there is one. Null if it doesn't fit.
+static u8 *lz_write_sequence(u8 *out, u8 *out_end, u8 *literals, s64 literal_count, s64 match_offset, s64 match_length) {
+	s64 room_needed = 1 + literal_count + (literal_count / 255) + 1 + 2 + (match_length / 255) + 1;
+	if(out_end - out < room_needed) {
+		return 0;
+	}
+
+	u8 *token = out++;
+	*token = (u8)(((literal_count < 15) ? literal_count : 15) << 4);
+	if(literal_count >= 15) {
+		out = lz_write_length(out, literal_count - 15);
+	}
+
+	memcpy(out, literals, literal_count);
+	out += literal_count;
+
+	if(match_length > 0) {
+		*out++ = (u8)(match_offset & 0xFF);
+		*out++ = (u8)(match_offset >> 8);
+
+		s64 length = match_length - LZ_MIN_MATCH;
+		*token |= (u8)((length < 15) ? length : 15);
+		if(length >= 15) {
+			out = lz_write_length(out, length - 15);
+		}
+	}
+
+	return out;
+}
+
+static s64 lz_compress(u8 *src, s64 size_in_bytes, u8 *dest, s64 dest_size_in_bytes) {
+	//NOTE: Where each hashed 4 bytes were last seen, plus one so 0 is nothing
+	u32 table[1 << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	u8 *out = dest;
+	u8 *out_end = dest + dest_size_in_bytes;
+
+	s64 literal_start = 0;
+	s64 at = 0;
+	s64 match_limit = size_in_bytes - LZ_END_LITERALS;
+
+	while(at + LZ_MIN_MATCH <= match_limit) {
+		u32 sequence = lz_read_u32(src + at);
+		u32 hash = lz_hash(sequence);
+		s64 candidate = (s64)table[hash] - 1;
+		table[hash] = (u32)(at + 1);
+
+		if(candidate >= 0 && (at - candidate) <= LZ_MAX_OFFSET && lz_read_u32(src + candidate) == sequence) {
+			s64 match_length = LZ_MIN_MATCH;
+			while(at + match_length < match_limit && src[candidate + match_length] == src[at + match_length]) {
+				match_length++;
+			}
+
+			out = lz_write_sequence(out, out_end, src + literal_start, at - literal_start, at - candidate, match_length);
+			if(!out) {
+				return -1;
+			}
+
+			at += match_length;
+			literal_start = at;
+		} else {
+			//NOTE: Step further the longer we go without a match, so text that doesn't compress goes through quickly
+			at += 1 + ((at - literal_start) >> 6);
+		}
+	}
+
+	out = lz_write_sequence(out, out_end, src + literal_start, size_in_bytes - literal_start, 0, 0);
+	if(!out) {
+		return -1;
+	}
+
+	return (out - dest);
+}
+
+//NOTE: Reads the count that didn't fit in the token's 4 bits. False if it runs off the end
+static inline bool lz_read_length(u8 **in, u8 *in_end, s64 *length) {
+	u8 byte = 255;
+	while(byte == 255) {
+		if(*in >= in_end) {
+			return false;
+		}
+		byte = *(*in)++;
+		*length += byte;
+	}
+	return true;
+}
+
+//NOTE: original_size_in_bytes has to be the size it was before it was compressed, dest needs that much room
+static bool lz_decompress(u8 *src, s64 size_in_bytes, u8 *dest, s64 original_size_in_bytes) {
+	u8 *in = src;
+	u8 *in_end = src + size_in_bytes;
+	u8 *out = dest;
+	u8 *out_end = dest + original_size_in_bytes;
+
+	while(in < in_end) {
+		u8 token = *in++;
+
+		s64 literal_count = token >> 4;
+		if(literal_count == 15 && !lz_read_length(&in, in_end, &literal_count)) {
+			return false;
+		}
+
+		if(literal_count > (in_end - in) || literal_count > (out_end - out)) {
+			return false;
+		}
+		memcpy(out, in, literal_count);
+		in += literal_count;
+		out += literal_count;
+
+		//NOTE: The last sequence doesn't have a match
+		if(in == in_end) {
+			break;
+		}
+
+		if(in_end - in < 2) {
+			return false;
+		}
+		s64 offset = in[0] | (in[1] << 8);
+		in += 2;
+
+		s64 match_length = token & 15;
+		if(match_length == 15 && !lz_read_length(&in, in_end, &match_length)) {
+			return false;
+		}
+		match_length += LZ_MIN_MATCH;
+
+		if(offset == 0 || offset > (out - dest) || match_length > (out_end - out)) {
+			return false;
+		}
+
+		u8 *match = out - offset;
+		if(offset >= match_length) {
+			memcpy(out, match, match_length);
+			out += match_length;
+		} else {
+			//NOTE: Overlaps what we're writing, i.e. a run of the same bytes, so it has to go a byte at a time
+			for(s64 i = 0; i < match_length; ++i) {
+				*out++ = *match++;
+			}
+		}
+	}
+
+	return (out == out_end);
+}
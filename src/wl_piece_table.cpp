@@ -0,0 +1,578 @@
+/*
+Piece table storage for a WL_Buffer. Used for really big files.
+
+The file is memory mapped read only and never copied. The text is a list of pieces, each piece is a span of either
+the original file or the add buffer. Anything typed goes on the end of the add buffer, which is append only,
+so nothing a piece points at ever moves.
+
+Opening a 2GB file is just mapping it, and the OS only reads in the pages we actually look at.
+
+Functions to use:
+
+pieceTable_insert(pt, byteOffset, bytes, size);
+pieceTable_remove(pt, byteOffset, size);
+
+pieceTable_get_byte(pt, byteOffset);
+pieceTable_copy_bytes(pt, byteOffset, size, dest);
+
+*/
+
+#define PIECE_TABLE_ADD_BUFFER_START_SIZE (64*1024)
+
+enum WL_Piece_Source {
+	WL_PIECE_SOURCE_ORIGINAL,
+	WL_PIECE_SOURCE_ADD,
+};
+
+struct WL_Piece {
+	WL_Piece_Source source;
+	s64 start; //NOTE: Byte offset into the original file or the add buffer
+	s64 size_in_bytes; //NOTE: Never 0, empty pieces get removed
+};
+
+//NOTE: Snapshots of the piece table read the mapped file too, so it only gets unmapped once the table & all the snapshots have let go of it
+struct WL_Piece_Table_File_Map {
+	Platform_File_Map map;
+	u32 ref_count; //NOTE: Only changed on the main thread
+};
+
+//NOTE: Snapshots read the add buffer too. It's append only, so a snapshot can share it while we keep typing on the end of it. 
+//		Growing it gets a new one, the old one only gets freed once the table & all the snapshots have let go of it.
+struct WL_Piece_Table_Add_Buffer {
+	u8 *memory; //NOTE: Straight after this in the same allocation
+	u32 ref_count; //NOTE: Only changed on the main thread
+};
+
+//NOTE: Original text that's in memory instead of a mapped file, i.e. a gap buffer's memory that a snapshot is still reading. 
+//		Shared the same way as the mapped file. See pieceTable_init_from_memory
+struct WL_Piece_Table_Memory {
+	u8 *memory;
+	u32 ref_count; //NOTE: Only changed on the main thread
+};
+
+struct WL_Piece_Table {
+	//NOTE: The original text, points into file_map if it's mapped or original_memory if it's in memory
+	u8 *original;
+	s64 original_size_in_bytes;
+	WL_Piece_Table_File_Map *file_map;
+	WL_Piece_Table_Memory *original_memory;
+
+	WL_Piece_Table_Add_Buffer *add_buffer;
+	s64 add_size_in_bytes;
+	s64 add_total_size_in_bytes;
+
+	WL_Piece *pieces;
+	s64 piece_count;
+	s64 total_piece_count;
+
+	s64 size_in_bytes;
+
+	//NOTE: Byte offset of the start of each piece. Only the first piece_starts_valid_count are up to date 
+	//		and we recompute lazily after an edit.
+	s64 *piece_starts;
+	s64 piece_starts_valid_count;
+};
+
+static void pieceTable_reserve_pieces(WL_Piece_Table *pt, s64 piece_count) {
+	if(piece_count > pt->total_piece_count) {
+		s64 new_total = 2*pt->total_piece_count;
+		if(new_total < piece_count) { new_total = piece_count; }
+		if(new_total < 64) { new_total = 64; }
+
+		WL_Piece *new_pieces = (WL_Piece *)platform_alloc_memory(new_total*sizeof(WL_Piece), true);
+		s64 *new_starts = (s64 *)platform_alloc_memory(new_total*sizeof(s64), true);
+
+		if(pt->pieces) {
+			memcpy(new_pieces, pt->pieces, pt->piece_count*sizeof(WL_Piece));
+			memcpy(new_starts, pt->piece_starts, pt->piece_starts_valid_count*sizeof(s64));
+			platform_free_memory(pt->pieces);
+			platform_free_memory(pt->piece_starts);
+		}
+
+		pt->pieces = new_pieces;
+		pt->piece_starts = new_starts;
+		pt->total_piece_count = new_total;
+	}
+}
+
+//NOTE: The piece table doesn't copy the original text, so it has to stay around till pieceTable_free
+static void pieceTable_init(WL_Piece_Table *pt, u8 *original, s64 original_size_in_bytes) {
+	memset(pt, 0, sizeof(WL_Piece_Table));
+
+	pt->original = original;
+	pt->original_size_in_bytes = original_size_in_bytes;
+
+	pieceTable_reserve_pieces(pt, 1);
+
+	if(original_size_in_bytes > 0) {
+		WL_Piece *piece = &pt->pieces[pt->piece_count++];
+		piece->source = WL_PIECE_SOURCE_ORIGINAL;
+		piece->start = 0;
+		piece->size_in_bytes = original_size_in_bytes;
+	}
+
+	pt->size_in_bytes = original_size_in_bytes;
+}
+
+//NOTE: The piece table owns the file map and unmaps it when it's freed. It starts out empty, 
+//		the file's text goes in with pieceTable_append_original once we know it's utf8.
+static void pieceTable_init_from_file_map(WL_Piece_Table *pt, Platform_File_Map file_map, s64 skip_in_bytes) {
+	pieceTable_init(pt, 0, 0);
+	pt->original = ((u8 *)file_map.memory) + skip_in_bytes;
+	pt->original_size_in_bytes = (s64)file_map.size_in_bytes - skip_in_bytes;
+
+	pt->file_map = (WL_Piece_Table_File_Map *)platform_alloc_memory(sizeof(WL_Piece_Table_File_Map), true);
+	pt->file_map->map = file_map;
+	pt->file_map->ref_count = 1;
+}
+
+static void pieceTable_release_file_map_ref(WL_Piece_Table_File_Map *file_map) {
+	assert(file_map->ref_count > 0);
+	file_map->ref_count--;
+
+	if(file_map->ref_count == 0) {
+		platform_unmap_file(&file_map->map);
+		platform_free_memory(file_map);
+	}
+}
+
+//NOTE: The table takes a reference to the memory instead of copying it. Like the mapped file it starts out empty, 
+//		put the text in with pieceTable_append_original.
+static void pieceTable_init_from_memory(WL_Piece_Table *pt, WL_Piece_Table_Memory *original_memory, s64 original_size_in_bytes) {
+	pieceTable_init(pt, 0, 0);
+	pt->original = original_memory->memory;
+	pt->original_size_in_bytes = original_size_in_bytes;
+
+	pt->original_memory = original_memory;
+	pt->original_memory->ref_count++;
+}
+
+static void pieceTable_release_memory_ref(WL_Piece_Table_Memory *original_memory) {
+	assert(original_memory->ref_count > 0);
+	original_memory->ref_count--;
+
+	if(original_memory->ref_count == 0) {
+		platform_free_memory(original_memory->memory);
+		platform_free_memory(original_memory);
+	}
+}
+
+static void pieceTable_release_add_buffer_ref(WL_Piece_Table_Add_Buffer *add_buffer) {
+	assert(add_buffer->ref_count > 0);
+	add_buffer->ref_count--;
+
+	if(add_buffer->ref_count == 0) {
+		platform_free_memory(add_buffer);
+	}
+}
+
+static void pieceTable_free(WL_Piece_Table *pt) {
+	if(pt->file_map) {
+		pieceTable_release_file_map_ref(pt->file_map);
+	}
+
+	if(pt->original_memory) { pieceTable_release_memory_ref(pt->original_memory); }
+	if(pt->add_buffer) { pieceTable_release_add_buffer_ref(pt->add_buffer); }
+	if(pt->pieces) { platform_free_memory(pt->pieces); }
+	if(pt->piece_starts) { platform_free_memory(pt->piece_starts); }
+
+	memset(pt, 0, sizeof(WL_Piece_Table));
+}
+
+static inline s64 pieceTable_get_size_in_bytes(WL_Piece_Table *pt) {
+	return pt->size_in_bytes;
+}
+
+static inline u8 *pieceTable_get_piece_memory(WL_Piece_Table *pt, WL_Piece *piece) {
+	u8 *result = (piece->source == WL_PIECE_SOURCE_ORIGINAL) ? pt->original : pt->add_buffer->memory;
+	return result + piece->start;
+}
+
+//NOTE: Everything after this piece has moved, so the start offsets after it aren't valid anymore
+static inline void pieceTable_invalidate_after_piece(WL_Piece_Table *pt, s64 index) {
+	if(pt->piece_starts_valid_count > index + 1) {
+		pt->piece_starts_valid_count = index + 1;
+	}
+	if(pt->piece_starts_valid_count > pt->piece_count) {
+		pt->piece_starts_valid_count = pt->piece_count;
+	}
+}
+
+static s64 pieceTable_get_piece_start(WL_Piece_Table *pt, s64 index) {
+	assert(index >= 0 && index < pt->piece_count);
+
+	if(pt->piece_starts_valid_count == 0) {
+		pt->piece_starts[0] = 0;
+		pt->piece_starts_valid_count = 1;
+	}
+
+	//NOTE: Bring the start offsets up to date as far as this piece
+	while(pt->piece_starts_valid_count <= index) {
+		s64 prev = pt->piece_starts_valid_count - 1;
+		pt->piece_starts[prev + 1] = pt->piece_starts[prev] + pt->pieces[prev].size_in_bytes;
+		pt->piece_starts_valid_count++;
+	}
+
+	return pt->piece_starts[index];
+}
+
+//NOTE: Returns the piece the byte is in. The end of the buffer returns piece_count, so it's one past the last piece.
+static s64 pieceTable_find_piece(WL_Piece_Table *pt, s64 byte_offset, s64 *piece_start) {
+	assert(byte_offset >= 0 && byte_offset <= pt->size_in_bytes);
+
+	s64 result = pt->piece_count;
+	*piece_start = pt->size_in_bytes;
+
+	if(byte_offset < pt->size_in_bytes) {
+		//NOTE: Make sure at least the first piece's start is valid
+		pieceTable_get_piece_start(pt, 0);
+
+		s64 last_valid = pt->piece_starts_valid_count - 1;
+		s64 end_of_valid = pt->piece_starts[last_valid] + pt->pieces[last_valid].size_in_bytes;
+
+		if(byte_offset < end_of_valid) {
+			//NOTE: Binary search the pieces we already know the start of
+			s64 low = 0;
+			s64 high = last_valid;
+			while(low < high) {
+				s64 mid = low + (high - low + 1) / 2;
+				if(pt->piece_starts[mid] <= byte_offset) {
+					low = mid;
+				} else {
+					high = mid - 1;
+				}
+			}
+			result = low;
+		} else {
+			//NOTE: Walk forward from the last piece we know, filling in the start offsets as we go
+			result = last_valid + 1;
+			while((pieceTable_get_piece_start(pt, result) + pt->pieces[result].size_in_bytes) <= byte_offset) {
+				result++;
+			}
+		}
+
+		*piece_start = pt->piece_starts[result];
+	}
+
+	return result;
+}
+
+static u8 pieceTable_get_byte(WL_Piece_Table *pt, s64 byte_offset) {
+	u8 result = 0;
+	if(byte_offset >= 0 && byte_offset < pt->size_in_bytes) {
+		s64 piece_start = 0;
+		s64 index = pieceTable_find_piece(pt, byte_offset, &piece_start);
+		result = pieceTable_get_piece_memory(pt, &pt->pieces[index])[byte_offset - piece_start];
+	}
+	return result;
+}
+
+static void pieceTable_copy_bytes(WL_Piece_Table *pt, s64 byte_offset, s64 size_in_bytes, u8 *dest) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= pt->size_in_bytes);
+	if(size_in_bytes > 0) {
+		s64 piece_start = 0;
+		s64 index = pieceTable_find_piece(pt, byte_offset, &piece_start);
+		s64 offset_in_piece = byte_offset - piece_start;
+
+		while(size_in_bytes > 0) {
+			WL_Piece *piece = &pt->pieces[index];
+			s64 to_copy = piece->size_in_bytes - offset_in_piece;
+			if(to_copy > size_in_bytes) { to_copy = size_in_bytes; }
+
+			memcpy(dest, pieceTable_get_piece_memory(pt, piece) + offset_in_piece, to_copy);
+
+			dest += to_copy;
+			size_in_bytes -= to_copy;
+			offset_in_piece = 0;
+			index++;
+		}
+	}
+}
+
+//NOTE: The bytes from byte_offset to the end of the piece it's in
+static u8 *pieceTable_get_span(WL_Piece_Table *pt, s64 byte_offset, s64 *size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset < pt->size_in_bytes);
+	s64 piece_start = 0;
+	WL_Piece *piece = &pt->pieces[pieceTable_find_piece(pt, byte_offset, &piece_start)];
+
+	*size_in_bytes = piece->size_in_bytes - (byte_offset - piece_start);
+	return pieceTable_get_piece_memory(pt, piece) + (byte_offset - piece_start);
+}
+
+//NOTE: Open up room for count pieces at index
+static void pieceTable_insert_pieces(WL_Piece_Table *pt, s64 index, s64 count) {
+	pieceTable_reserve_pieces(pt, pt->piece_count + count);
+
+	s64 to_move = pt->piece_count - index;
+	if(to_move > 0) {
+		memmove(&pt->pieces[index + count], &pt->pieces[index], to_move*sizeof(WL_Piece));
+	}
+	pt->piece_count += count;
+}
+
+static void pieceTable_remove_pieces(WL_Piece_Table *pt, s64 index, s64 count) {
+	s64 to_move = pt->piece_count - (index + count);
+	if(to_move > 0) {
+		memmove(&pt->pieces[index], &pt->pieces[index + count], to_move*sizeof(WL_Piece));
+	}
+	pt->piece_count -= count;
+}
+
+//NOTE: Returns the offset in the add buffer the bytes were put at
+static s64 pieceTable_append_to_add_buffer(WL_Piece_Table *pt, u8 *bytes, s64 size_in_bytes) {
+	if(pt->add_size_in_bytes + size_in_bytes > pt->add_total_size_in_bytes) {
+		//NOTE: Grow geometrically. Pieces store offsets not pointers so the add buffer can move
+		s64 new_size = 2*pt->add_total_size_in_bytes;
+		if(new_size < PIECE_TABLE_ADD_BUFFER_START_SIZE) { new_size = PIECE_TABLE_ADD_BUFFER_START_SIZE; }
+		if(new_size < pt->add_size_in_bytes + size_in_bytes) { new_size = pt->add_size_in_bytes + size_in_bytes; }
+
+		WL_Piece_Table_Add_Buffer *new_buffer = (WL_Piece_Table_Add_Buffer *)platform_alloc_memory(sizeof(WL_Piece_Table_Add_Buffer) + new_size, false);
+		new_buffer->memory = (u8 *)(new_buffer + 1);
+		new_buffer->ref_count = 1;
+
+		if(pt->add_buffer) {
+			//NOTE: A snapshot might still be reading the old one, so just let go of it
+			memcpy(new_buffer->memory, pt->add_buffer->memory, pt->add_size_in_bytes);
+			pieceTable_release_add_buffer_ref(pt->add_buffer);
+		}
+
+		pt->add_buffer = new_buffer;
+		pt->add_total_size_in_bytes = new_size;
+	}
+
+	s64 result = pt->add_size_in_bytes;
+	memcpy(pt->add_buffer->memory + result, bytes, size_in_bytes);
+	pt->add_size_in_bytes += size_in_bytes;
+
+	return result;
+}
+
+//NOTE: Puts more of the original text on the end without copying it, for a file that's still being checked as it loads 
+//		or memory from pieceTable_init_from_memory
+static void pieceTable_append_original(WL_Piece_Table *pt, s64 original_start, s64 size_in_bytes) {
+	assert(original_start >= 0 && original_start + size_in_bytes <= pt->original_size_in_bytes);
+
+	if(size_in_bytes > 0) {
+		WL_Piece *last = (pt->piece_count > 0) ? &pt->pieces[pt->piece_count - 1] : 0;
+
+		if(last && last->source == WL_PIECE_SOURCE_ORIGINAL && (last->start + last->size_in_bytes) == original_start) {
+			last->size_in_bytes += size_in_bytes;
+		} else {
+			pieceTable_insert_pieces(pt, pt->piece_count, 1);
+
+			WL_Piece *piece = &pt->pieces[pt->piece_count - 1];
+			piece->source = WL_PIECE_SOURCE_ORIGINAL;
+			piece->start = original_start;
+			piece->size_in_bytes = size_in_bytes;
+		}
+
+		pt->size_in_bytes += size_in_bytes;
+	}
+}
+
+static void pieceTable_insert(WL_Piece_Table *pt, s64 byte_offset, u8 *bytes, s64 size_in_bytes) {
+	if(size_in_bytes > 0) {
+		s64 piece_start = 0;
+		s64 index = pieceTable_find_piece(pt, byte_offset, &piece_start);
+
+		s64 add_at = pieceTable_append_to_add_buffer(pt, bytes, size_in_bytes);
+
+		WL_Piece *prev = (byte_offset == piece_start && index > 0) ? &pt->pieces[index - 1] : 0;
+
+		if(prev && prev->source == WL_PIECE_SOURCE_ADD && (prev->start + prev->size_in_bytes) == add_at) {
+			//NOTE: Typing on the end of what we just typed, just make the piece bigger instead of adding a new one
+			prev->size_in_bytes += size_in_bytes;
+			pieceTable_invalidate_after_piece(pt, index - 1);
+		} else {
+			WL_Piece new_piece = {};
+			new_piece.source = WL_PIECE_SOURCE_ADD;
+			new_piece.start = add_at;
+			new_piece.size_in_bytes = size_in_bytes;
+
+			if(byte_offset == piece_start) {
+				//NOTE: On a boundary between pieces
+				pieceTable_insert_pieces(pt, index, 1);
+				pt->pieces[index] = new_piece;
+			} else {
+				//NOTE: In the middle of a piece, split it in two around the new piece
+				pieceTable_insert_pieces(pt, index + 1, 2);
+
+				WL_Piece *left = &pt->pieces[index];
+				WL_Piece right = *left;
+
+				s64 split = byte_offset - piece_start;
+				left->size_in_bytes = split;
+				right.start += split;
+				right.size_in_bytes -= split;
+
+				pt->pieces[index + 1] = new_piece;
+				pt->pieces[index + 2] = right;
+			}
+
+			pieceTable_invalidate_after_piece(pt, index);
+		}
+
+		pt->size_in_bytes += size_in_bytes;
+	}
+}
+
+static void pieceTable_remove(WL_Piece_Table *pt, s64 byte_offset, s64 size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= pt->size_in_bytes);
+
+	if(size_in_bytes > 0) {
+		s64 piece_start = 0;
+		s64 index = pieceTable_find_piece(pt, byte_offset, &piece_start);
+		s64 first_changed = index;
+
+		s64 end = byte_offset + size_in_bytes;
+		WL_Piece *piece = &pt->pieces[index];
+		s64 piece_end = piece_start + piece->size_in_bytes;
+
+		if(byte_offset > piece_start && end < piece_end) {
+			//NOTE: Removing from the middle of one piece, split it in two
+			pieceTable_insert_pieces(pt, index + 1, 1);
+
+			WL_Piece *left = &pt->pieces[index];
+			WL_Piece right = *left;
+
+			left->size_in_bytes = byte_offset - piece_start;
+			right.start += (end - piece_start);
+			right.size_in_bytes = piece_end - end;
+
+			pt->pieces[index + 1] = right;
+		} else {
+			if(byte_offset > piece_start) {
+				//NOTE: Cut the end off the first piece
+				piece->size_in_bytes = byte_offset - piece_start;
+				piece_start = piece_end;
+				index++;
+			}
+
+			//NOTE: Pieces that are completely removed
+			s64 remove_from = index;
+			while(index < pt->piece_count && (piece_start + pt->pieces[index].size_in_bytes) <= end) {
+				piece_start += pt->pieces[index].size_in_bytes;
+				index++;
+			}
+
+			//NOTE: Cut the start off the last piece
+			if(index < pt->piece_count && piece_start < end) {
+				s64 cut = end - piece_start;
+				pt->pieces[index].start += cut;
+				pt->pieces[index].size_in_bytes -= cut;
+			}
+
+			pieceTable_remove_pieces(pt, remove_from, index - remove_from);
+		}
+
+		pt->size_in_bytes -= size_in_bytes;
+		pieceTable_invalidate_after_piece(pt, first_changed);
+	}
+}
+
+//NOTE: The text of saved_pieces (a snapshot of this table) has just been written out to a new file. Works out where the text we have from 
+//		the original file is in the new one, so once it replaces the original we can read out of it without copying anything into memory.
+//		The original pieces are always in the order they are in the file, edits only cut them up, so it's one walk along both lists.
+//		Anything that isn't in the new file goes on the add buffer, that can't happen while the snapshot came from this table but it's cheap to be safe.
+//		Returns the pieces for the new file, free them with platform_free_memory.
+static WL_Piece *pieceTable_rebase_pieces(WL_Piece_Table *pt, WL_Piece *saved_pieces, s64 saved_piece_count, s64 *piece_count) {
+	//NOTE: Each of our pieces can get cut up by the saved pieces, but only once per saved piece
+	WL_Piece *result = (WL_Piece *)platform_alloc_memory((pt->piece_count + saved_piece_count)*sizeof(WL_Piece), false);
+	s64 count = 0;
+
+	s64 saved_index = 0;
+	s64 saved_start = 0; //NOTE: Where the saved piece is in the new file
+
+	for(s64 i = 0; i < pt->piece_count; ++i) {
+		WL_Piece piece = pt->pieces[i];
+
+		while(piece.source == WL_PIECE_SOURCE_ORIGINAL && piece.size_in_bytes > 0) {
+			//NOTE: Skip the saved pieces that end before this one starts
+			while(saved_index < saved_piece_count && (saved_pieces[saved_index].source != WL_PIECE_SOURCE_ORIGINAL || 
+				  (saved_pieces[saved_index].start + saved_pieces[saved_index].size_in_bytes) <= piece.start)) {
+				saved_start += saved_pieces[saved_index].size_in_bytes;
+				saved_index++;
+			}
+
+			WL_Piece *saved = (saved_index < saved_piece_count) ? &saved_pieces[saved_index] : 0;
+
+			WL_Piece new_piece = {};
+			if(saved && saved->start <= piece.start) {
+				//NOTE: As much of it as the saved piece has
+				s64 size = saved->start + saved->size_in_bytes - piece.start;
+				if(size > piece.size_in_bytes) { size = piece.size_in_bytes; }
+
+				new_piece.source = WL_PIECE_SOURCE_ORIGINAL;
+				new_piece.start = saved_start + (piece.start - saved->start);
+				new_piece.size_in_bytes = size;
+			} else {
+				//NOTE: Not in the new file, up to where the next saved piece starts
+				s64 size = piece.size_in_bytes;
+				if(saved && saved->start - piece.start < size) { size = saved->start - piece.start; }
+
+				new_piece.source = WL_PIECE_SOURCE_ADD;
+				new_piece.start = pieceTable_append_to_add_buffer(pt, pt->original + piece.start, size);
+				new_piece.size_in_bytes = size;
+			}
+
+			result[count++] = new_piece;
+			piece.start += new_piece.size_in_bytes;
+			piece.size_in_bytes -= new_piece.size_in_bytes;
+		}
+
+		if(piece.source == WL_PIECE_SOURCE_ADD) {
+			result[count++] = piece;
+		}
+	}
+	assert(count <= pt->piece_count + saved_piece_count);
+
+	*piece_count = count;
+	return result;
+}
+
+//NOTE: Read out of new text instead of the original. With pieces from pieceTable_rebase_pieces if it's a new file, 
+//		or null to keep the pieces we have if it's the same text again.
+static void pieceTable_set_original(WL_Piece_Table *pt, u8 *original, s64 original_size_in_bytes, WL_Piece *pieces, s64 piece_count) {
+	pt->original = original;
+	pt->original_size_in_bytes = original_size_in_bytes;
+
+	if(pieces) {
+		pt->piece_count = 0;
+		pt->piece_starts_valid_count = 0;
+		pieceTable_reserve_pieces(pt, piece_count);
+
+		memcpy(pt->pieces, pieces, piece_count*sizeof(WL_Piece));
+		pt->piece_count = piece_count;
+	}
+
+	s64 size = 0;
+	for(s64 i = 0; i < pt->piece_count; ++i) {
+		WL_Piece *piece = &pt->pieces[i];
+		assert(piece->source != WL_PIECE_SOURCE_ORIGINAL || piece->start + piece->size_in_bytes <= original_size_in_bytes);
+		size += piece->size_in_bytes;
+	}
+	assert(size == pt->size_in_bytes);
+}
+
+//NOTE: Lets go of the mapped file so it can be saved over. Nothing can read the table till pieceTable_map_file gives it a file again, 
+//		and no snapshots can be reading the file. Returns how far into the file the text started, i.e. the size of a BOM.
+static s64 pieceTable_unmap_file(WL_Piece_Table *pt) {
+	assert(pt->file_map && pt->file_map->ref_count == 1);
+	s64 result = pt->original - (u8 *)pt->file_map->map.memory;
+
+	pieceTable_release_file_map_ref(pt->file_map);
+	pt->file_map = 0;
+	pt->original = 0;
+
+	return result;
+}
+
+//NOTE: After pieceTable_unmap_file. The pieces are the same as for pieceTable_set_original
+static void pieceTable_map_file(WL_Piece_Table *pt, Platform_File_Map file_map, s64 skip_in_bytes, WL_Piece *pieces, s64 piece_count) {
+	assert(!pt->file_map);
+	pt->file_map = (WL_Piece_Table_File_Map *)platform_alloc_memory(sizeof(WL_Piece_Table_File_Map), true);
+	pt->file_map->map = file_map;
+	pt->file_map->ref_count = 1;
+
+	pieceTable_set_original(pt, ((u8 *)file_map.memory) + skip_in_bytes, (s64)file_map.size_in_bytes - skip_in_bytes, pieces, piece_count);
+}
@@ -0,0 +1,741 @@
+/*
+Rope storage for a WL_Buffer. A B-tree where the leaves hold chunks of the text.
+
+Every node keeps a summary of the text under it: how many bytes, new lines and utf8 codepoints. So going from a byte offset
+to a line, a line to a byte offset, or counting codepoints for a column is just walking down the tree, O(log n).
+Inserting & removing only touches the leaves the edit lands in and the nodes above them, so edits spread all over a
+huge file don't shift the whole buffer around like the gap buffer does.
+
+All the leaves are at the same depth. Leaves split when they get full and small neighbours get merged back together.
+
+Nodes are reference counted so a snapshot can keep the tree as it was by holding a reference to the root, which is O(1).
+An edit copies the nodes on its path that something else still shares instead of changing them, so the snapshot
+never sees the edit and the two trees share everything the edit didn't touch. See rope_make_unique
+
+Functions to use:
+
+rope_insert(rope, byteOffset, bytes, size);
+rope_remove(rope, byteOffset, size);
+
+rope_get_line_at_offset(rope, byteOffset);
+rope_get_offset_of_line(rope, line);
+rope_get_codepoints_at_offset(rope, byteOffset);
+
+*/
+
+#define ROPE_LEAF_SIZE_IN_BYTES 1024
+#define ROPE_LEAF_LOAD_SIZE_IN_BYTES (3*ROPE_LEAF_SIZE_IN_BYTES/4) //NOTE: How full we make the leaves when we build the rope from a whole file, so typing doesn't split them straight away
+#define ROPE_MAX_CHILDREN 16
+
+#define ROPE_POOL_PAGE_SIZE (1024*1024)
+
+struct WL_Rope_Summary {
+	s64 size_in_bytes;
+	s64 newline_count;
+	s64 codepoint_count;
+};
+
+struct WL_Rope_Node {
+	WL_Rope_Summary summary;
+
+	//NOTE: How many parents, ropes & snapshots point at this node. Only changed on the main thread
+	u32 ref_count;
+
+	bool is_leaf;
+	u32 count; //NOTE: Bytes used if it's a leaf, children used if it isn't
+
+	union {
+		WL_Rope_Node *children[ROPE_MAX_CHILDREN];
+		u8 bytes[ROPE_LEAF_SIZE_IN_BYTES];
+	};
+};
+
+struct WL_Rope_Pool_Page {
+	WL_Rope_Pool_Page *next;
+};
+
+//NOTE: All the nodes are the same size, so they come out of pages with a free list. 
+//		Snapshots share the rope's nodes, so the pool stays around till the rope & all its snapshots are gone.
+struct WL_Rope_Pool {
+	u32 ref_count;
+
+	WL_Rope_Node *free_list;
+	WL_Rope_Pool_Page *pages;
+	u8 *page_at;
+	size_t page_bytes_left;
+};
+
+struct WL_Rope {
+	WL_Rope_Node *root;
+	WL_Rope_Pool *pool;
+};
+
+static WL_Rope_Node *rope_alloc_node(WL_Rope_Pool *pool, bool is_leaf) {
+	WL_Rope_Node *result = 0;
+
+	if(pool->free_list) {
+		result = pool->free_list;
+		pool->free_list = *((WL_Rope_Node **)result);
+	} else {
+		if(pool->page_bytes_left < sizeof(WL_Rope_Node)) {
+			WL_Rope_Pool_Page *page = (WL_Rope_Pool_Page *)platform_alloc_memory_pages(ROPE_POOL_PAGE_SIZE);
+			page->next = pool->pages;
+			pool->pages = page;
+
+			//NOTE: Keep the nodes 16 byte aligned
+			pool->page_at = ((u8 *)page) + 16;
+			pool->page_bytes_left = ROPE_POOL_PAGE_SIZE - 16;
+		}
+
+		result = (WL_Rope_Node *)pool->page_at;
+		pool->page_at += sizeof(WL_Rope_Node);
+		pool->page_bytes_left -= sizeof(WL_Rope_Node);
+	}
+
+	memset(result, 0, sizeof(WL_Rope_Node));
+	result->is_leaf = is_leaf;
+	result->ref_count = 1;
+
+	return result;
+}
+
+static void rope_free_node(WL_Rope_Pool *pool, WL_Rope_Node *node) {
+	*((WL_Rope_Node **)node) = pool->free_list;
+	pool->free_list = node;
+}
+
+//NOTE: Let go of a reference to the node, and everything under it that nothing else is using
+static void rope_release_tree(WL_Rope_Pool *pool, WL_Rope_Node *node) {
+	assert(node->ref_count > 0);
+	node->ref_count--;
+
+	if(node->ref_count == 0) {
+		if(!node->is_leaf) {
+			for(u32 i = 0; i < node->count; ++i) {
+				rope_release_tree(pool, node->children[i]);
+			}
+		}
+		rope_free_node(pool, node);
+	}
+}
+
+//NOTE: Let go of a reference to the node after something else has taken its children. 
+//		If the node is still shared the children have one more parent now.
+static void rope_release_node_keep_children(WL_Rope_Pool *pool, WL_Rope_Node *node) {
+	if(node->ref_count > 1) {
+		node->ref_count--;
+		if(!node->is_leaf) {
+			for(u32 i = 0; i < node->count; ++i) {
+				node->children[i]->ref_count++;
+			}
+		}
+	} else {
+		rope_free_node(pool, node);
+	}
+}
+
+//NOTE: Get a node we're allowed to change. If a snapshot or another node shares it, copy it and point the slot at the copy. 
+//		The copy's children have another parent now, so they're shared till they get copied on the way down.
+static WL_Rope_Node *rope_make_unique(WL_Rope *rope, WL_Rope_Node **slot) {
+	WL_Rope_Node *node = *slot;
+
+	if(node->ref_count > 1) {
+		WL_Rope_Node *copy = rope_alloc_node(rope->pool, node->is_leaf);
+		memcpy(copy, node, sizeof(WL_Rope_Node));
+		copy->ref_count = 1;
+
+		if(!copy->is_leaf) {
+			for(u32 i = 0; i < copy->count; ++i) {
+				copy->children[i]->ref_count++;
+			}
+		}
+
+		node->ref_count--;
+		*slot = copy;
+		node = copy;
+	}
+
+	return node;
+}
+
+static WL_Rope_Summary rope_summarize_bytes(u8 *bytes, s64 size_in_bytes) {
+	WL_Rope_Summary result = {};
+	result.size_in_bytes = size_in_bytes;
+
+	for(s64 i = 0; i < size_in_bytes; ++i) {
+		u8 byte = bytes[i];
+		if(byte == '\n') { result.newline_count++; }
+
+		//NOTE: Count everything that isn't a continuation byte, so a codepoint split across two leaves still only counts once
+		if((byte & 0xC0) != 0x80) { result.codepoint_count++; }
+	}
+
+	return result;
+}
+
+static inline void rope_add_summary(WL_Rope_Summary *a, WL_Rope_Summary b) {
+	a->size_in_bytes += b.size_in_bytes;
+	a->newline_count += b.newline_count;
+	a->codepoint_count += b.codepoint_count;
+}
+
+static void rope_update_summary(WL_Rope_Node *node) {
+	if(node->is_leaf) {
+		node->summary = rope_summarize_bytes(node->bytes, node->count);
+	} else {
+		WL_Rope_Summary summary = {};
+		for(u32 i = 0; i < node->count; ++i) {
+			rope_add_summary(&summary, node->children[i]->summary);
+		}
+		node->summary = summary;
+	}
+}
+
+static void rope_init(WL_Rope *rope) {
+	memset(rope, 0, sizeof(WL_Rope));
+	rope->pool = (WL_Rope_Pool *)platform_alloc_memory(sizeof(WL_Rope_Pool), true);
+	rope->pool->ref_count = 1;
+	rope->root = rope_alloc_node(rope->pool, true);
+}
+
+//NOTE: For the rope & each snapshot of it
+static void rope_release_pool(WL_Rope_Pool *pool) {
+	assert(pool->ref_count > 0);
+	pool->ref_count--;
+
+	if(pool->ref_count == 0) {
+		//NOTE: Nodes get freed with their page
+		WL_Rope_Pool_Page *page = pool->pages;
+		while(page) {
+			WL_Rope_Pool_Page *next = page->next;
+			platform_free_memory_pages(page, ROPE_POOL_PAGE_SIZE);
+			page = next;
+		}
+
+		platform_free_memory(pool);
+	}
+}
+
+static void rope_free(WL_Rope *rope) {
+	//NOTE: Only need to walk the tree if a snapshot is still using some of it, otherwise it all goes with the pages
+	if(rope->pool->ref_count > 1) {
+		rope_release_tree(rope->pool, rope->root);
+	}
+	rope_release_pool(rope->pool);
+
+	memset(rope, 0, sizeof(WL_Rope));
+}
+
+static inline s64 rope_get_size_in_bytes(WL_Rope *rope) {
+	return rope->root->summary.size_in_bytes;
+}
+
+static inline s64 rope_get_line_count(WL_Rope *rope) {
+	return rope->root->summary.newline_count + 1;
+}
+
+//NOTE: Build the rope bottom up in one go. Used when loading a file into an empty rope, instead of inserting a leaf at a time.
+static void rope_build_from_text(WL_Rope *rope, u8 *bytes, s64 size_in_bytes) {
+	assert(rope_get_size_in_bytes(rope) == 0);
+
+	s64 count = (size_in_bytes + ROPE_LEAF_LOAD_SIZE_IN_BYTES - 1) / ROPE_LEAF_LOAD_SIZE_IN_BYTES;
+	WL_Rope_Node **level = (WL_Rope_Node **)platform_alloc_memory(count*sizeof(WL_Rope_Node *), false);
+
+	for(s64 i = 0; i < count; ++i) {
+		WL_Rope_Node *leaf = rope_alloc_node(rope->pool, true);
+		s64 start = i*ROPE_LEAF_LOAD_SIZE_IN_BYTES;
+		s64 size = size_in_bytes - start;
+		if(size > ROPE_LEAF_LOAD_SIZE_IN_BYTES) { size = ROPE_LEAF_LOAD_SIZE_IN_BYTES; }
+
+		memcpy(leaf->bytes, bytes + start, size);
+		leaf->count = (u32)size;
+		rope_update_summary(leaf);
+
+		level[i] = leaf;
+	}
+
+	//NOTE: Group the level into parents till there is only one node left
+	while(count > 1) {
+		s64 parent_count = (count + ROPE_MAX_CHILDREN - 1) / ROPE_MAX_CHILDREN;
+
+		for(s64 i = 0; i < parent_count; ++i) {
+			WL_Rope_Node *parent = rope_alloc_node(rope->pool, false);
+			for(s64 j = i*ROPE_MAX_CHILDREN; j < count && parent->count < ROPE_MAX_CHILDREN; ++j) {
+				parent->children[parent->count++] = level[j];
+			}
+			rope_update_summary(parent);
+
+			level[i] = parent;
+		}
+
+		count = parent_count;
+	}
+
+	rope_release_tree(rope->pool, rope->root);
+	rope->root = level[0];
+
+	platform_free_memory(level);
+}
+
+//NOTE: Put the child in at index, splitting the node if it's full. Returns the new right half if it split.
+static WL_Rope_Node *rope_add_child(WL_Rope *rope, WL_Rope_Node *node, u32 index, WL_Rope_Node *child) {
+	WL_Rope_Node *split = 0;
+
+	WL_Rope_Node *children[ROPE_MAX_CHILDREN + 1];
+	u32 count = 0;
+	for(u32 i = 0; i < node->count; ++i) {
+		if(i == index) { children[count++] = child; }
+		children[count++] = node->children[i];
+	}
+	if(index == node->count) { children[count++] = child; }
+
+	if(count <= ROPE_MAX_CHILDREN) {
+		memcpy(node->children, children, count*sizeof(WL_Rope_Node *));
+		node->count = count;
+	} else {
+		split = rope_alloc_node(rope->pool, false);
+
+		u32 left_count = count / 2;
+		memcpy(node->children, children, left_count*sizeof(WL_Rope_Node *));
+		node->count = left_count;
+
+		memcpy(split->children, children + left_count, (count - left_count)*sizeof(WL_Rope_Node *));
+		split->count = count - left_count;
+
+		rope_update_summary(split);
+	}
+
+	rope_update_summary(node);
+
+	return split;
+}
+
+//NOTE: size_in_bytes is at most a leaf. Returns the new right half if the node split.
+static WL_Rope_Node *rope_insert_(WL_Rope *rope, WL_Rope_Node *node, s64 byte_offset, u8 *bytes, u32 size_in_bytes) {
+	WL_Rope_Node *split = 0;
+	u32 offset = (u32)byte_offset;
+
+	if(node->is_leaf) {
+		if(node->count + size_in_bytes <= ROPE_LEAF_SIZE_IN_BYTES) {
+			memmove(node->bytes + offset + size_in_bytes, node->bytes + offset, node->count - offset);
+			memcpy(node->bytes + offset, bytes, size_in_bytes);
+			node->count += size_in_bytes;
+
+			rope_add_summary(&node->summary, rope_summarize_bytes(bytes, size_in_bytes));
+		} else {
+			//NOTE: Doesn't fit, split the leaf in half
+			u8 temp[2*ROPE_LEAF_SIZE_IN_BYTES];
+			u32 total = node->count + size_in_bytes;
+
+			memcpy(temp, node->bytes, offset);
+			memcpy(temp + offset, bytes, size_in_bytes);
+			memcpy(temp + offset + size_in_bytes, node->bytes + offset, node->count - offset);
+
+			u32 left_size = total / 2;
+
+			split = rope_alloc_node(rope->pool, true);
+			memcpy(split->bytes, temp + left_size, total - left_size);
+			split->count = total - left_size;
+			rope_update_summary(split);
+
+			memcpy(node->bytes, temp, left_size);
+			node->count = left_size;
+			rope_update_summary(node);
+		}
+	} else {
+		//NOTE: Find the child the offset is in. Offsets on the end of a child go on the end of that child
+		u32 index = 0;
+		s64 at = byte_offset;
+		while(index < (node->count - 1) && at > node->children[index]->summary.size_in_bytes) {
+			at -= node->children[index]->summary.size_in_bytes;
+			index++;
+		}
+
+		WL_Rope_Node *child = rope_make_unique(rope, &node->children[index]);
+		WL_Rope_Node *new_child = rope_insert_(rope, child, at, bytes, size_in_bytes);
+
+		if(new_child) {
+			split = rope_add_child(rope, node, index + 1, new_child);
+		} else {
+			rope_add_summary(&node->summary, rope_summarize_bytes(bytes, size_in_bytes));
+		}
+	}
+
+	return split;
+}
+
+static void rope_insert(WL_Rope *rope, s64 byte_offset, u8 *bytes, s64 size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset <= rope_get_size_in_bytes(rope));
+
+	if(rope_get_size_in_bytes(rope) == 0 && size_in_bytes > ROPE_LEAF_SIZE_IN_BYTES) {
+		rope_build_from_text(rope, bytes, size_in_bytes);
+	} else {
+		//NOTE: Put it in a leaf at a time
+		while(size_in_bytes > 0) {
+			u32 size = (size_in_bytes > ROPE_LEAF_SIZE_IN_BYTES) ? ROPE_LEAF_SIZE_IN_BYTES : (u32)size_in_bytes;
+
+			WL_Rope_Node *split = rope_insert_(rope, rope_make_unique(rope, &rope->root), byte_offset, bytes, size);
+
+			if(split) {
+				//NOTE: The root split so the tree gets one level deeper
+				WL_Rope_Node *new_root = rope_alloc_node(rope->pool, false);
+				new_root->children[0] = rope->root;
+				new_root->children[1] = split;
+				new_root->count = 2;
+				rope_update_summary(new_root);
+
+				rope->root = new_root;
+			}
+
+			bytes += size;
+			byte_offset += size;
+			size_in_bytes -= size;
+		}
+	}
+}
+
+static void rope_remove_child(WL_Rope *rope, WL_Rope_Node *node, u32 index) {
+	memmove(&node->children[index], &node->children[index + 1], (node->count - index - 1)*sizeof(WL_Rope_Node *));
+	node->count--;
+}
+
+//NOTE: Join neighbours back together if one of them has got small, so the tree doesn't fill up with nearly empty nodes
+static void rope_merge_small_children(WL_Rope *rope, WL_Rope_Node *node) {
+	u32 index = 0;
+	while(index + 1 < node->count) {
+		WL_Rope_Node *a = node->children[index];
+		WL_Rope_Node *b = node->children[index + 1];
+
+		bool merged = false;
+
+		if(a->is_leaf) {
+			bool is_small = (a->count < ROPE_LEAF_SIZE_IN_BYTES / 4) || (b->count < ROPE_LEAF_SIZE_IN_BYTES / 4);
+			if(is_small && (a->count + b->count) <= ROPE_LEAF_SIZE_IN_BYTES) {
+				a = rope_make_unique(rope, &node->children[index]);
+				memcpy(a->bytes + a->count, b->bytes, b->count);
+				a->count += b->count;
+				merged = true;
+			}
+		} else {
+			bool is_small = (a->count < ROPE_MAX_CHILDREN / 4) || (b->count < ROPE_MAX_CHILDREN / 4);
+			if(is_small && (a->count + b->count) <= ROPE_MAX_CHILDREN) {
+				a = rope_make_unique(rope, &node->children[index]);
+				memcpy(a->children + a->count, b->children, b->count*sizeof(WL_Rope_Node *));
+				a->count += b->count;
+				merged = true;
+
+				//NOTE: The children where the two nodes joined might be small now too
+				rope_merge_small_children(rope, a);
+			}
+		}
+
+		if(merged) {
+			rope_add_summary(&a->summary, b->summary);
+			rope_release_node_keep_children(rope->pool, b);
+			rope_remove_child(rope, node, index + 1);
+		} else {
+			index++;
+		}
+	}
+}
+
+static void rope_remove_(WL_Rope *rope, WL_Rope_Node *node, s64 byte_offset, s64 size_in_bytes) {
+	if(node->is_leaf) {
+		u32 offset = (u32)byte_offset;
+		u32 size = (u32)size_in_bytes;
+
+		memmove(node->bytes + offset, node->bytes + offset + size, node->count - (offset + size));
+		node->count -= size;
+		rope_update_summary(node);
+	} else {
+		s64 child_start = 0;
+		u32 index = 0;
+
+		while(index < node->count && size_in_bytes > 0) {
+			WL_Rope_Node *child = node->children[index];
+			s64 child_size = child->summary.size_in_bytes;
+
+			if(byte_offset < child_start + child_size) {
+				s64 offset_in_child = byte_offset - child_start;
+				s64 to_remove = child_size - offset_in_child;
+				if(to_remove > size_in_bytes) { to_remove = size_in_bytes; }
+
+				size_in_bytes -= to_remove;
+
+				if(to_remove == child_size) {
+					//NOTE: The whole child goes, the next child moves into this slot
+					rope_release_tree(rope->pool, child);
+					rope_remove_child(rope, node, index);
+				} else {
+					child = rope_make_unique(rope, &node->children[index]);
+					rope_remove_(rope, child, offset_in_child, to_remove);
+
+					child_start += child->summary.size_in_bytes;
+					index++;
+				}
+			} else {
+				child_start += child_size;
+				index++;
+			}
+		}
+
+		rope_merge_small_children(rope, node);
+		rope_update_summary(node);
+	}
+}
+
+static void rope_remove(WL_Rope *rope, s64 byte_offset, s64 size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= rope_get_size_in_bytes(rope));
+
+	if(size_in_bytes > 0) {
+		rope_remove_(rope, rope_make_unique(rope, &rope->root), byte_offset, size_in_bytes);
+
+		//NOTE: Make the tree shallower if the root only has one child left
+		while(!rope->root->is_leaf && rope->root->count <= 1) {
+			WL_Rope_Node *old_root = rope->root;
+
+			if(old_root->count == 1) {
+				rope->root = old_root->children[0];
+				rope->root->ref_count++;
+			} else {
+				rope->root = rope_alloc_node(rope->pool, true);
+			}
+
+			//NOTE: A snapshot might still be using the old root
+			rope_release_tree(rope->pool, old_root);
+		}
+	}
+}
+
+static u8 rope_get_byte(WL_Rope *rope, s64 byte_offset) {
+	u8 result = 0;
+
+	if(byte_offset >= 0 && byte_offset < rope_get_size_in_bytes(rope)) {
+		WL_Rope_Node *node = rope->root;
+		while(!node->is_leaf) {
+			u32 index = 0;
+			while(byte_offset >= node->children[index]->summary.size_in_bytes) {
+				byte_offset -= node->children[index]->summary.size_in_bytes;
+				index++;
+			}
+			node = node->children[index];
+		}
+
+		result = node->bytes[byte_offset];
+	}
+
+	return result;
+}
+
+static void rope_copy_bytes_(WL_Rope_Node *node, s64 byte_offset, s64 size_in_bytes, u8 *dest) {
+	if(node->is_leaf) {
+		memcpy(dest, node->bytes + byte_offset, size_in_bytes);
+	} else {
+		s64 child_start = 0;
+		for(u32 i = 0; i < node->count && size_in_bytes > 0; ++i) {
+			WL_Rope_Node *child = node->children[i];
+			s64 child_size = child->summary.size_in_bytes;
+
+			if(byte_offset < child_start + child_size) {
+				s64 offset_in_child = byte_offset - child_start;
+				s64 to_copy = child_size - offset_in_child;
+				if(to_copy > size_in_bytes) { to_copy = size_in_bytes; }
+
+				rope_copy_bytes_(child, offset_in_child, to_copy, dest);
+
+				dest += to_copy;
+				byte_offset += to_copy;
+				size_in_bytes -= to_copy;
+			}
+
+			child_start += child_size;
+		}
+	}
+}
+
+static void rope_copy_bytes(WL_Rope *rope, s64 byte_offset, s64 size_in_bytes, u8 *dest) {
+	assert(byte_offset >= 0 && byte_offset + size_in_bytes <= rope_get_size_in_bytes(rope));
+	if(size_in_bytes > 0) {
+		rope_copy_bytes_(rope->root, byte_offset, size_in_bytes, dest);
+	}
+}
+
+//NOTE: The bytes from byte_offset to the end of the leaf it's in
+static u8 *rope_get_span(WL_Rope *rope, s64 byte_offset, s64 *size_in_bytes) {
+	assert(byte_offset >= 0 && byte_offset < rope_get_size_in_bytes(rope));
+
+	WL_Rope_Node *node = rope->root;
+	while(!node->is_leaf) {
+		u32 index = 0;
+		while(byte_offset >= node->children[index]->summary.size_in_bytes) {
+			byte_offset -= node->children[index]->summary.size_in_bytes;
+			index++;
+		}
+		node = node->children[index];
+	}
+
+	*size_in_bytes = node->count - byte_offset;
+	return node->bytes + byte_offset;
+}
+
+//NOTE: Deeper than a rope can get, even with the smallest nodes
+#define ROPE_MAX_DEPTH 32
+
+//NOTE: Walks the leaves in order without changing anything, so another thread can walk a snapshot's tree while the main thread edits. 
+//		The main thread never changes a node a snapshot shares, it copies it. See rope_make_unique
+struct WL_Rope_Leaf_Iterator {
+	WL_Rope_Node *nodes[ROPE_MAX_DEPTH];
+	u32 indexes[ROPE_MAX_DEPTH];
+	int depth; //NOTE: -1 once we've walked off the end
+
+	s64 offset_in_leaf;
+};
+
+static void rope_begin_leaf_iterator(WL_Rope_Leaf_Iterator *it, WL_Rope_Node *root, s64 byte_offset) {
+	memset(it, 0, sizeof(WL_Rope_Leaf_Iterator));
+
+	if(byte_offset >= root->summary.size_in_bytes) {
+		it->depth = -1;
+	} else {
+		WL_Rope_Node *node = root;
+		while(!node->is_leaf) {
+			u32 index = 0;
+			while(byte_offset >= node->children[index]->summary.size_in_bytes) {
+				byte_offset -= node->children[index]->summary.size_in_bytes;
+				index++;
+			}
+			it->nodes[it->depth] = node;
+			it->indexes[it->depth] = index;
+			it->depth++;
+			assert(it->depth < ROPE_MAX_DEPTH);
+
+			node = node->children[index];
+		}
+
+		it->nodes[it->depth] = node;
+		it->offset_in_leaf = byte_offset;
+	}
+}
+
+//NOTE: The rest of the leaf the iterator is on, then moves on to the next leaf. Returns null at the end.
+static u8 *rope_next_leaf_span(WL_Rope_Leaf_Iterator *it, s64 *size_in_bytes) {
+	u8 *result = 0;
+	*size_in_bytes = 0;
+
+	while(!result && it->depth >= 0) {
+		WL_Rope_Node *leaf = it->nodes[it->depth];
+		if(it->offset_in_leaf < leaf->count) {
+			result = leaf->bytes + it->offset_in_leaf;
+			*size_in_bytes = leaf->count - it->offset_in_leaf;
+		}
+		it->offset_in_leaf = 0;
+
+		//NOTE: Go up till there's a child to the right, then down the left of it to the next leaf
+		int depth = it->depth - 1;
+		while(depth >= 0 && (it->indexes[depth] + 1) >= it->nodes[depth]->count) {
+			depth--;
+		}
+
+		if(depth < 0) {
+			it->depth = -1;
+		} else {
+			it->indexes[depth]++;
+			WL_Rope_Node *node = it->nodes[depth]->children[it->indexes[depth]];
+			depth++;
+
+			while(!node->is_leaf) {
+				it->nodes[depth] = node;
+				it->indexes[depth] = 0;
+				depth++;
+				node = node->children[0];
+			}
+			it->nodes[depth] = node;
+			it->depth = depth;
+		}
+	}
+
+	return result;
+}
+
+//NOTE: Which line the offset is on, lines start at 0. A newline counts as being on the line it ends.
+static s64 rope_get_line_at_offset(WL_Rope *rope, s64 byte_offset) {
+	assert(byte_offset >= 0 && byte_offset <= rope_get_size_in_bytes(rope));
+
+	s64 result = 0;
+
+	WL_Rope_Node *node = rope->root;
+	while(!node->is_leaf) {
+		u32 index = 0;
+		while(index < (node->count - 1) && byte_offset >= node->children[index]->summary.size_in_bytes) {
+			byte_offset -= node->children[index]->summary.size_in_bytes;
+			result += node->children[index]->summary.newline_count;
+			index++;
+		}
+		node = node->children[index];
+	}
+
+	for(s64 i = 0; i < byte_offset; ++i) {
+		if(node->bytes[i] == '\n') { result++; }
+	}
+
+	return result;
+}
+
+//NOTE: Byte offset of the start of the line. Returns the end of the rope if there aren't that many lines
+static s64 rope_get_offset_of_line(WL_Rope *rope, s64 line) {
+	s64 result = 0;
+
+	if(line >= rope_get_line_count(rope)) {
+		result = rope_get_size_in_bytes(rope);
+	} else if(line > 0) {
+		//NOTE: Find the line'th new line, the line starts after it
+		s64 newlines_left = line;
+
+		WL_Rope_Node *node = rope->root;
+		while(!node->is_leaf) {
+			u32 index = 0;
+			while(node->children[index]->summary.newline_count < newlines_left) {
+				newlines_left -= node->children[index]->summary.newline_count;
+				result += node->children[index]->summary.size_in_bytes;
+				index++;
+			}
+			node = node->children[index];
+		}
+
+		for(u32 i = 0; i < node->count; ++i) {
+			if(node->bytes[i] == '\n') {
+				newlines_left--;
+				if(newlines_left == 0) {
+					result += i + 1;
+					break;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+//NOTE: How many codepoints come before the offset. Take away the count at the start of the line to get the column.
+static s64 rope_get_codepoints_at_offset(WL_Rope *rope, s64 byte_offset) {
+	assert(byte_offset >= 0 && byte_offset <= rope_get_size_in_bytes(rope));
+
+	s64 result = 0;
+
+	WL_Rope_Node *node = rope->root;
+	while(!node->is_leaf) {
+		u32 index = 0;
+		while(index < (node->count - 1) && byte_offset >= node->children[index]->summary.size_in_bytes) {
+			byte_offset -= node->children[index]->summary.size_in_bytes;
+			result += node->children[index]->summary.codepoint_count;
+			index++;
+		}
+		node = node->children[index];
+	}
+
+	for(s64 i = 0; i < byte_offset; ++i) {
+		if((node->bytes[i] & 0xC0) != 0x80) { result++; }
+	}
+
+	return result;
+}
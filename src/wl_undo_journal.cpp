@@ -0,0 +1,562 @@
+/*
+Undo journal, so the undo history & unsaved edits survive a crash or restart.
+
+Every change to a buffer's UndoRedoState gets appended to a journal file next to the file being edited. The main thread
+only adds the records to memory, once a frame they get handed to another thread which writes & flushes them to the disk.
+
+The journal starts with a header saying which text it was started from (the file as it was on disk), then a HISTORY
+record with the undo tree as it was then. After that it's a record for every block pushed, every typed bit added
+onto a block, every undo & redo, and every jump to another revision. Replaying it on top of the same file gets back the 
+same text & the same history.
+
+When a save starts the journal starts again from the text being saved, so it doesn't get longer forever, and once
+the save has replaced the file the new journal gets written over the old one. If the file gets changed by someone
+else the header won't match it anymore & the journal gets ignored.
+
+Functions to use:
+
+undoJournal_create(path_utf8);
+undoJournal_start(journal, state, buffer_size_in_bytes, base_time_stamp, existing_records, existing_size); //NOTE: Once the file's finished loading
+
+undoJournal_update(journal); //NOTE: Every frame, writes what's been added on another thread
+
+undoJournal_begin_rebase(journal, state, base_size_in_bytes, base_undo_redo_id); //NOTE: When a save starts
+undoJournal_end_rebase(journal, replaced, base_time_stamp); //NOTE: When it's finished
+
+undoJournal_replay(b, records, size, base_size_in_bytes, base_time_stamp); //NOTE: When opening a file that has a journal
+
+undoJournal_free(journal); //NOTE: Once it's not writing
+
+*/
+
+//NOTE: Goes on the end of the file name
+#define UNDO_JOURNAL_EXTENSION ".woodland_journal"
+
+#define UNDO_JOURNAL_MAGIC 0x4A554C57 //NOTE: WLUJ
+#define UNDO_JOURNAL_VERSION 2
+
+enum WL_Undo_Journal_Record_Type {
+	UNDO_JOURNAL_HISTORY = 1, //NOTE: All the blocks & where the text is in them, starts the journal
+	UNDO_JOURNAL_PUSH, //NOTE: A new block that gets done to the text
+	UNDO_JOURNAL_EXTEND, //NOTE: Text typed onto the last block, see undoRedo_extend_last_block
+	UNDO_JOURNAL_UNDO,
+	UNDO_JOURNAL_REDO, //NOTE: Has the child it went to, since there can be more than one
+	UNDO_JOURNAL_JUMP, //NOTE: See wl_buffer_jump_to_revision
+};
+
+struct WL_Undo_Journal_Header {
+	u32 magic;
+	u32 version;
+
+	//NOTE: The text the journal starts from, so we know it's the same file when we replay it
+	s64 base_size_in_bytes;
+	u64 base_time_stamp;
+};
+
+//NOTE: Growing bytes the records get written into
+struct WL_Undo_Journal_Bytes {
+	u8 *memory;
+	s64 size_in_bytes;
+	s64 total_size_in_bytes;
+};
+
+struct WL_Undo_Journal {
+	char *path_utf8;
+	Platform_File_Handle file;
+
+	//NOTE: Records the main thread is adding to
+	WL_Undo_Journal_Bytes pending;
+
+	//NOTE: Records the thread is writing, the main thread leaves them alone till is_writing is false
+	WL_Undo_Journal_Bytes writing;
+	bool write_starts_new_file;
+	s64 size_on_disk;
+	volatile bool is_writing;
+
+	//NOTE: While a save is going, the journal it'll start again from once the save replaces the file
+	bool is_rebasing;
+	bool rebase_ready;
+	WL_Undo_Journal_Bytes rebase;
+};
+
+static void undoJournal_push_bytes(WL_Undo_Journal_Bytes *bytes, void *data, s64 size_in_bytes) {
+	if(bytes->size_in_bytes + size_in_bytes > bytes->total_size_in_bytes) {
+		s64 new_total = 2*bytes->total_size_in_bytes;
+		if(new_total < bytes->size_in_bytes + size_in_bytes) { new_total = bytes->size_in_bytes + size_in_bytes + Kilobytes(4); }
+
+		u8 *new_memory = (u8 *)platform_alloc_memory(new_total, false);
+		if(bytes->memory) {
+			memcpy(new_memory, bytes->memory, bytes->size_in_bytes);
+			platform_free_memory(bytes->memory);
+		}
+
+		bytes->memory = new_memory;
+		bytes->total_size_in_bytes = new_total;
+	}
+
+	memcpy(bytes->memory + bytes->size_in_bytes, data, size_in_bytes);
+	bytes->size_in_bytes += size_in_bytes;
+}
+
+#define undoJournal_push_value(bytes, value) undoJournal_push_bytes(bytes, &(value), sizeof(value))
+
+static void undoJournal_write_header(WL_Undo_Journal_Bytes *bytes, s64 base_size_in_bytes, u64 base_time_stamp) {
+	WL_Undo_Journal_Header header = {};
+	header.magic = UNDO_JOURNAL_MAGIC;
+	header.version = UNDO_JOURNAL_VERSION;
+	header.base_size_in_bytes = base_size_in_bytes;
+	header.base_time_stamp = base_time_stamp;
+
+	undoJournal_push_value(bytes, header);
+}
+
+static void undoJournal_write_block(WL_Undo_Journal_Bytes *bytes, UndoRedoBlock *block, char *string) {
+	u8 block_type = (u8)block->type;
+	undoJournal_push_value(bytes, block_type);
+	undoJournal_push_value(bytes, block->groupId);
+	undoJournal_push_value(bytes, block->id);
+	undoJournal_push_value(bytes, block->byteAt);
+	undoJournal_push_value(bytes, block->cursorAt);
+	undoJournal_push_value(bytes, block->stringLength);
+	undoJournal_push_bytes(bytes, string, block->stringLength);
+}
+
+//NOTE: The text the journal starts from is the text at the base block, the replay moves from there to where the history is now.
+//		The blocks are in the order they were made so the parents come first. The redo children go after them all.
+static void undoJournal_write_history(WL_Undo_Journal_Bytes *bytes, UndoRedoState *state, s32 base, u32 base_undo_redo_id) {
+	u8 type = UNDO_JOURNAL_HISTORY;
+	s32 block_count = state->block_count;
+
+	undoJournal_push_value(bytes, type);
+	undoJournal_push_value(bytes, block_count);
+	undoJournal_push_value(bytes, state->current);
+	undoJournal_push_value(bytes, base);
+	undoJournal_push_value(bytes, base_undo_redo_id);
+	undoJournal_push_value(bytes, state->idAt);
+	undoJournal_push_value(bytes, state->groupIdAt);
+
+	//NOTE: Reads the compressed text without putting it all back in memory
+	UndoRedo_Chunk_Reader chunk_reader = {};
+	for(int i = 0; i < state->block_count; ++i) {
+		UndoRedoBlock *block = &state->history[i];
+		undoJournal_write_block(bytes, block, undoRedo_read_block_string(state, block, &chunk_reader));
+		undoJournal_push_value(bytes, block->parent);
+	}
+	undoRedo_end_reading(&chunk_reader);
+
+	undoJournal_push_value(bytes, state->root_redo_child);
+	for(int i = 0; i < state->block_count; ++i) {
+		undoJournal_push_value(bytes, state->history[i].redo_child);
+	}
+}
+
+//NOTE: Records go to the journal, and to the one we're going to start again from if a save is going
+static void undoJournal_log_push(WL_Undo_Journal *journal, UndoRedoBlock *block) {
+	u8 type = UNDO_JOURNAL_PUSH;
+	undoJournal_push_value(&journal->pending, type);
+	undoJournal_write_block(&journal->pending, block, block->string);
+
+	if(journal->is_rebasing) {
+		undoJournal_push_value(&journal->rebase, type);
+		undoJournal_write_block(&journal->rebase, block, block->string);
+	}
+}
+
+static void undoJournal_log_extend(WL_Undo_Journal *journal, s64 byteAt, char *string, s64 stringLength) {
+	u8 type = UNDO_JOURNAL_EXTEND;
+
+	WL_Undo_Journal_Bytes *outputs[] = { &journal->pending, &journal->rebase };
+	int output_count = (journal->is_rebasing) ? 2 : 1;
+
+	for(int i = 0; i < output_count; ++i) {
+		undoJournal_push_value(outputs[i], type);
+		undoJournal_push_value(outputs[i], byteAt);
+		undoJournal_push_value(outputs[i], stringLength);
+		undoJournal_push_bytes(outputs[i], string, stringLength);
+	}
+}
+
+static void undoJournal_log_move(WL_Undo_Journal *journal, bool is_redo, s32 redo_child) {
+	u8 type = (is_redo) ? UNDO_JOURNAL_REDO : UNDO_JOURNAL_UNDO;
+
+	WL_Undo_Journal_Bytes *outputs[] = { &journal->pending, &journal->rebase };
+	int output_count = (journal->is_rebasing) ? 2 : 1;
+
+	for(int i = 0; i < output_count; ++i) {
+		undoJournal_push_value(outputs[i], type);
+		if(is_redo) {
+			undoJournal_push_value(outputs[i], redo_child);
+		}
+	}
+}
+
+static void undoJournal_log_jump(WL_Undo_Journal *journal, s32 target) {
+	u8 type = UNDO_JOURNAL_JUMP;
+
+	WL_Undo_Journal_Bytes *outputs[] = { &journal->pending, &journal->rebase };
+	int output_count = (journal->is_rebasing) ? 2 : 1;
+
+	for(int i = 0; i < output_count; ++i) {
+		undoJournal_push_value(outputs[i], type);
+		undoJournal_push_value(outputs[i], target);
+	}
+}
+
+static WL_Undo_Journal *undoJournal_create(char *path_utf8) {
+	WL_Undo_Journal *journal = (WL_Undo_Journal *)platform_alloc_memory(sizeof(WL_Undo_Journal), true);
+	journal->path_utf8 = path_utf8;
+	return journal;
+}
+
+//NOTE: Can't free it while the thread is still writing
+static void undoJournal_free(WL_Undo_Journal *journal) {
+	assert(!journal->is_writing);
+
+	if(journal->file.data) {
+		platform_close_file(journal->file);
+	}
+
+	WL_Undo_Journal_Bytes *bytes[] = { &journal->pending, &journal->writing, &journal->rebase };
+	for(int i = 0; i < arrayCount(bytes); ++i) {
+		if(bytes[i]->memory) {
+			platform_free_memory(bytes[i]->memory);
+		}
+	}
+
+	platform_free_memory(journal);
+}
+
+//NOTE: Starts writing the history out. If we replayed a journal, existing_records is the part of it that was good, so we
+//		carry on from it. Otherwise the journal starts from the file, which is the text from before the blocks in the history,
+//		since anything typed while it was loading is already in the history.
+static void undoJournal_start(WL_Undo_Journal *journal, UndoRedoState *state, s64 buffer_size_in_bytes, u64 base_time_stamp, u8 *existing_records, s64 existing_size) {
+	assert(!journal->is_writing);
+	assert(!state->journal);
+
+	journal->pending.size_in_bytes = 0;
+
+	if(existing_records) {
+		undoJournal_push_bytes(&journal->pending, existing_records, existing_size);
+	} else {
+		s64 base_size_in_bytes = buffer_size_in_bytes;
+		for(s32 at = state->current; at >= 0; at = state->history[at].parent) {
+			UndoRedoBlock *block = &state->history[at];
+			base_size_in_bytes += (block->type == UNDO_REDO_INSERT) ? -block->stringLength : block->stringLength;
+		}
+
+		undoJournal_write_header(&journal->pending, base_size_in_bytes, base_time_stamp);
+		undoJournal_write_history(&journal->pending, state, -1, 0);
+	}
+
+	//NOTE: The first write replaces whatever journal was there before
+	journal->write_starts_new_file = true;
+	state->journal = journal;
+}
+
+//NOTE: A save has started, the journal will start again from the text getting saved. Until the save has finished the
+//		records still go to the old journal too, in case we crash before then.
+static void undoJournal_begin_rebase(WL_Undo_Journal *journal, UndoRedoState *state, s64 base_size_in_bytes, u32 base_undo_redo_id) {
+	journal->is_rebasing = true;
+	journal->rebase_ready = false;
+	journal->rebase.size_in_bytes = 0;
+
+	//NOTE: We don't know the time stamp till the file's been replaced, see undoJournal_end_rebase
+	undoJournal_write_header(&journal->rebase, base_size_in_bytes, 0);
+	undoJournal_write_history(&journal->rebase, state, state->current, base_undo_redo_id);
+}
+
+static void undoJournal_end_rebase(WL_Undo_Journal *journal, bool replaced, u64 base_time_stamp) {
+	//NOTE: The save might have started before the journal did
+	if(!journal->is_rebasing) {
+		return;
+	}
+	journal->is_rebasing = false;
+
+	if(replaced) {
+		WL_Undo_Journal_Header *header = (WL_Undo_Journal_Header *)journal->rebase.memory;
+		header->base_time_stamp = base_time_stamp;
+
+		//NOTE: Everything pending is in the rebase as well
+		journal->rebase_ready = true;
+		journal->pending.size_in_bytes = 0;
+	}
+}
+
+static THREAD_WORK_FUNCTION(thread_work_write_undo_journal);
+
+//NOTE: Called every frame. If the last write has finished, hands what's been added since to another thread.
+static void undoJournal_update(WL_Undo_Journal *journal) {
+	if(journal->is_writing) {
+		return;
+	}
+
+	journal->writing.size_in_bytes = 0;
+
+	if(journal->rebase_ready) {
+		//NOTE: Write the new journal over the old one, then carry on adding to it
+		WL_Undo_Journal_Bytes temp = journal->writing;
+		journal->writing = journal->rebase;
+		journal->rebase = temp;
+
+		journal->rebase_ready = false;
+		journal->write_starts_new_file = true;
+	}
+
+	if(journal->pending.size_in_bytes > 0) {
+		//NOTE: Anything pending goes after the rebase
+		undoJournal_push_bytes(&journal->writing, journal->pending.memory, journal->pending.size_in_bytes);
+		journal->pending.size_in_bytes = 0;
+	}
+
+	if(journal->writing.size_in_bytes > 0) {
+		if(journal->write_starts_new_file) {
+			//NOTE: Write over the old journal. Opened here since the path gets turned into wide chars in the per frame arena
+			if(journal->file.data) {
+				platform_close_file(journal->file);
+			}
+			journal->file = platform_begin_file_write_utf8_file_path(journal->path_utf8);
+			journal->size_on_disk = 0;
+			journal->write_starts_new_file = false;
+		}
+
+		journal->is_writing = true;
+
+		if(global_platform.push_work_onto_queue) {
+			global_platform.push_work_onto_queue(global_platform.work_queue, thread_work_write_undo_journal, journal);
+		} else {
+			thread_work_write_undo_journal(journal);
+		}
+	}
+}
+
+//NOTE: Reads the journal back out. Stops at the first record that isn't all there, which is where we crashed halfway through a write.
+struct WL_Undo_Journal_Reader {
+	u8 *at;
+	u8 *end;
+	bool ok;
+};
+
+static void undoJournal_read_bytes(WL_Undo_Journal_Reader *reader, void *dest, s64 size_in_bytes) {
+	if(reader->ok && (reader->end - reader->at) >= size_in_bytes) {
+		memcpy(dest, reader->at, size_in_bytes);
+		reader->at += size_in_bytes;
+	} else {
+		reader->ok = false;
+	}
+}
+
+#define undoJournal_read_value(reader, value) undoJournal_read_bytes(reader, &(value), sizeof(value))
+
+//NOTE: Points at the text in the journal instead of copying it
+static char *undoJournal_read_string(WL_Undo_Journal_Reader *reader, s64 size_in_bytes) {
+	char *result = 0;
+	if(reader->ok && size_in_bytes >= 0 && (reader->end - reader->at) >= size_in_bytes) {
+		result = (char *)reader->at;
+		reader->at += size_in_bytes;
+	} else {
+		reader->ok = false;
+	}
+	return result;
+}
+
+static UndoRedoBlock undoJournal_read_block(WL_Undo_Journal_Reader *reader) {
+	UndoRedoBlock block = {};
+	u8 block_type = 0;
+	undoJournal_read_value(reader, block_type);
+	undoJournal_read_value(reader, block.groupId);
+	undoJournal_read_value(reader, block.id);
+	undoJournal_read_value(reader, block.byteAt);
+	undoJournal_read_value(reader, block.cursorAt);
+	undoJournal_read_value(reader, block.stringLength);
+	block.string = undoJournal_read_string(reader, block.stringLength);
+	block.type = (block_type == UNDO_REDO_DELETE) ? UNDO_REDO_DELETE : UNDO_REDO_INSERT;
+
+	if(block_type > UNDO_REDO_DELETE) {
+		reader->ok = false;
+	}
+	return block;
+}
+
+struct WL_Undo_Journal_Replay {
+	bool replayed;
+
+	//NOTE: How much of the journal was good, to carry on adding to with undoJournal_start
+	s64 good_size_in_bytes;
+
+	//NOTE: The undo id the file on disk matches, and if the text still matches it
+	u32 base_undo_redo_id;
+	bool matches_base;
+};
+
+//NOTE: The buffer has to have just the file's text in it & no history. Puts back the history & the edits that weren't saved.
+static WL_Undo_Journal_Replay undoJournal_replay(WL_Buffer *b, u8 *records, s64 size_in_bytes, s64 base_size_in_bytes, u64 base_time_stamp) {
+	WL_Undo_Journal_Replay result = {};
+	UndoRedoState *state = &b->undo_redo_state;
+	assert(state->block_count == 0 && !state->journal);
+
+	WL_Undo_Journal_Reader reader = {};
+	reader.at = records;
+	reader.end = records + size_in_bytes;
+	reader.ok = true;
+
+	WL_Undo_Journal_Header header = {};
+	undoJournal_read_value(&reader, header);
+
+	//NOTE: Only if it was started from the file we've got
+	if(!reader.ok || header.magic != UNDO_JOURNAL_MAGIC || header.version != UNDO_JOURNAL_VERSION ||
+	   header.base_size_in_bytes != base_size_in_bytes || header.base_time_stamp != base_time_stamp) {
+		return result;
+	}
+
+	u8 type = 0;
+	undoJournal_read_value(&reader, type);
+	if(!reader.ok || type != UNDO_JOURNAL_HISTORY) {
+		return result;
+	}
+
+	s32 block_count = 0;
+	s32 current = -1;
+	s32 base = -1;
+	u32 idAt = 0;
+	s32 groupIdAt = 0;
+	undoJournal_read_value(&reader, block_count);
+	undoJournal_read_value(&reader, current);
+	undoJournal_read_value(&reader, base);
+	undoJournal_read_value(&reader, result.base_undo_redo_id);
+	undoJournal_read_value(&reader, idAt);
+	undoJournal_read_value(&reader, groupIdAt);
+
+	if(!reader.ok || block_count < 0 || current < -1 || current >= block_count || base < -1 || base >= block_count) {
+		return result;
+	}
+
+	for(int i = 0; i < block_count && reader.ok; ++i) {
+		UndoRedoBlock block = undoJournal_read_block(&reader);
+		s32 parent = -1;
+		undoJournal_read_value(&reader, parent);
+
+		//NOTE: The parents come before their children
+		if(reader.ok && parent >= -1 && parent < i) {
+			state->current = parent;
+			push_block(state, block.type, block.byteAt, block.string, block.stringLength, block.cursorAt, block.groupId);
+			state->history[i].id = block.id;
+		} else {
+			reader.ok = false;
+		}
+	}
+
+	if(!reader.ok) {
+		wl_buffer_release_undo_checkpoints(b);
+		free_undo_redo_state(state);
+		init_undo_redo_state(state);
+		return result;
+	}
+
+	state->idAt = idAt;
+	state->groupIdAt = groupIdAt;
+
+	//NOTE: The file's text is the text at the base, move from there to where the history was
+	state->current = base;
+	bool text_ok = wl_buffer_walk_to_revision(b, current);
+
+	//NOTE: Then point redo where it was going
+	for(int i = -1; i < block_count && text_ok; ++i) {
+		s32 child = -1;
+		undoJournal_read_value(&reader, child);
+
+		text_ok = reader.ok && child >= -1 && child < block_count && (child < 0 || state->history[child].parent == i);
+		if(text_ok) {
+			*undoRedo_get_redo_child(state, i) = child;
+		}
+	}
+
+	if(!text_ok) {
+		//NOTE: Put the file's text back
+		bool went_back = wl_buffer_walk_to_revision(b, base);
+		assert(went_back);
+
+		wl_buffer_release_undo_checkpoints(b);
+		free_undo_redo_state(state);
+		init_undo_redo_state(state);
+		return result;
+	}
+
+	result.replayed = true;
+
+	//NOTE: The records after it. Stops at the first one that isn't all there or doesn't fit the text, and only changes 
+	//		anything once it knows the record is good.
+	s64 good_size = reader.at - records;
+	while(reader.ok && reader.at < reader.end) {
+		undoJournal_read_value(&reader, type);
+
+		bool record_ok = false;
+		if(type == UNDO_JOURNAL_PUSH) {
+			UndoRedoBlock block = undoJournal_read_block(&reader);
+			if(reader.ok && wl_buffer_apply_undo_block(b, &block, true)) {
+				push_block(state, block.type, block.byteAt, block.string, block.stringLength, block.cursorAt, block.groupId);
+				state->history[state->current].id = block.id;
+				state->idAt = block.id;
+				record_ok = true;
+			}
+		} else if(type == UNDO_JOURNAL_EXTEND) {
+			s64 byteAt = 0;
+			s64 stringLength = 0;
+			undoJournal_read_value(&reader, byteAt);
+			undoJournal_read_value(&reader, stringLength);
+			char *string = undoJournal_read_string(&reader, stringLength);
+
+			UndoRedoBlock *block = (state->block_count > 0 && state->current == state->block_count - 1) ? &state->history[state->current] : 0;
+			if(reader.ok && block) {
+				bool carries_on = (block->type == UNDO_REDO_INSERT) ? (block->byteAt + block->stringLength == byteAt) : (byteAt + stringLength == block->byteAt);
+
+				UndoRedoBlock added = *block;
+				added.byteAt = byteAt;
+				added.string = string;
+				added.stringLength = stringLength;
+
+				if(carries_on && wl_buffer_apply_undo_block(b, &added, true)) {
+					undoRedo_extend_last_block(state, byteAt, string, stringLength);
+					record_ok = true;
+				}
+			}
+		} else if(type == UNDO_JOURNAL_UNDO) {
+			if(reader.ok && state->current >= 0 && wl_buffer_apply_undo_block(b, &state->history[state->current], false)) {
+				get_undo_block(state);
+				record_ok = true;
+			}
+		} else if(type == UNDO_JOURNAL_REDO) {
+			s32 child = -1;
+			undoJournal_read_value(&reader, child);
+
+			if(reader.ok && child >= 0 && child < state->block_count && state->history[child].parent == state->current && 
+			   wl_buffer_apply_undo_block(b, &state->history[child], true)) {
+				*undoRedo_get_redo_child(state, state->current) = child;
+				get_redo_block(state);
+				record_ok = true;
+			}
+		} else if(type == UNDO_JOURNAL_JUMP) {
+			s32 target = -1;
+			undoJournal_read_value(&reader, target);
+
+			if(reader.ok && target >= -1 && target < state->block_count) {
+				s32 from = state->current;
+				record_ok = wl_buffer_walk_to_revision(b, target);
+
+				if(!record_ok) {
+					bool went_back = wl_buffer_walk_to_revision(b, from);
+					assert(went_back);
+				}
+			}
+		}
+
+		if(!record_ok) {
+			break;
+		}
+		good_size = reader.at - records;
+	}
+
+	result.good_size_in_bytes = good_size;
+	result.matches_base = (state->current == base);
+
+	return result;
+}
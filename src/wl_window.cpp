@@ -12,33 +12,26 @@ static bool isValidDoubleClickCharacter(char a) {
 	}
 } 
 
-static DoubleClickWordResult isDoubleClickInWord(size_t memory_offset, char *text) {
+static DoubleClickWordResult isDoubleClickInWord(size_t memory_offset, WL_Buffer_View *view) {
 	DoubleClickWordResult result = {};
 
-	char *str = text + memory_offset;
-
-	if(isValidDoubleClickCharacter(str[0])) {
+	if(isValidDoubleClickCharacter(wl_buffer_view_get_byte(view, memory_offset))) {
 		result.isInWord = true;
 
-		char *forward = str;
 		//NOTE: Walk forward
-		while(*forward && isValidDoubleClickCharacter(forward[0])) {	
-			forward++;
+		WL_Buffer_View_Iterator forward = wl_buffer_view_begin_iterator(view, memory_offset);
+		while(wl_buffer_view_iterator_valid(&forward) && isValidDoubleClickCharacter(*forward.at)) {	
+			wl_buffer_view_iterator_next(&forward);
 		}
 
-		char *back = str;
+		s64 back = memory_offset;
 		//NOTE: Walk back
-		while(isValidDoubleClickCharacter(back[0]) && back > text) {	
+		while(back > 0 && isValidDoubleClickCharacter(wl_buffer_view_get_byte(view, back - 1))) {	
 			back--;
 		}
 
-		//NOTE: Know this stopped because we weren't at the end of the buffer, so actually move forward one byte so we didn't over step the edge
-		if(back > text) {
-			back++;
-		}
-
-		result.shift_end = forward - text;
-		result.shift_start = back - text;
+		result.shift_end = forward.offset;
+		result.shift_start = back;
 	} else {
 		//NOTE: Could just select this one? 
 	} 
@@ -170,8 +163,6 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 
 		// u8 *str = compileBuffer_toNullTerminateString(b);
 
-		Compiled_Buffer_For_Drawing buffer_to_draw = compileBuffer_toDraw(b, &globalPerFrameArena, &open_buffer->selectable_state);
-
 		// OutputDebugStringA((LPCSTR)str);
 		// OutputDebugStringA((LPCSTR)"\n");
 
@@ -182,30 +173,84 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 		float startX = window_bounds.minX - open_buffer->scroll_pos.x + leftMargin; 
 		float startY = -1.0f*font.fontHeight*fontScale - buffer_title_height - window_bounds.minY + open_buffer->scroll_pos.y;
 
+		float newLineIncrement = font.fontHeight*fontScale*editorState->line_spacing;
+
+		//NOTE: Only lay out the lines that are on the screen, so scrolling down a big file doesn't get slower. 
+		//		Wrapped lines take as many rows as they did the last time they were drawn, see wl_buffer_get_wrapped_row_of_line
+		bool should_wrap_text = editorState->should_wrap_text;
+		s64 line_count = wl_buffer_get_line_count(b);
+
+		//NOTE: The last row above the top of the window & the first row below the bottom of it
+		s64 first_row = (s64)(startY / newLineIncrement);
+		s64 last_row = (s64)((startY + window_bounds.maxY + font.fontHeight) / newLineIncrement) + 1;
+
+		if(should_wrap_text) {
+			float wrap_width = (window_bounds.maxX - startX) / fontScale;
+			if(b->wrap_width != wrap_width) {
+				//NOTE: The rows get counted again, so keep the same line at the top of the window
+				s64 top_row = (first_row > 0) ? first_row : 0;
+				s64 row_in_line = 0;
+				s64 top_line = wl_buffer_get_line_of_wrapped_row(b, top_row, &row_in_line);
+				wl_buffer_set_wrap_width(b, wrap_width);
+
+				float shift = (float)(top_row - row_in_line - top_line)*newLineIncrement;
+				open_buffer->scroll_pos.y -= shift;
+				open_buffer->scroll_target_pos.y -= shift;
+				startY -= shift;
+
+				first_row = (s64)(startY / newLineIncrement);
+				last_row = (s64)((startY + window_bounds.maxY + font.fontHeight) / newLineIncrement) + 1;
+			}
+		}
+
+		s64 first_line = first_row;
+		if(should_wrap_text) {
+			first_line = wl_buffer_get_line_of_wrapped_row(b, first_row, 0);
+		}
+		if(first_line > line_count - 1) { first_line = line_count - 1; }
+		if(first_line < 0) { first_line = 0; }
+
+		//NOTE: Every line is at least one row, so this many lines is always enough to get to the bottom of the window
+		s64 last_line = first_line + (last_row - first_row);
+
+		s64 layout_start = wl_buffer_get_offset_of_line(b, first_line);
+		s64 layout_end = wl_buffer_get_offset_of_line(b, last_line + 1);
+
+		//NOTE: The lexer has to start where we know a token starts, so start at the checkpoint before the first line & skip the tokens till we get to it
+		WL_Lex_Checkpoint lex_checkpoint = wl_buffer_get_lex_checkpoint(b, layout_start);
+
+		WL_Buffer_View buffer_to_draw = wl_buffer_get_view_of_range(b, &globalPerFrameArena, &open_buffer->selectable_state, lex_checkpoint.offset, layout_end);
+
+		s64 first_line_row = (should_wrap_text) ? wl_buffer_get_wrapped_row_of_line(b, first_line) : first_line;
+
 		float xAt = startX;
-		float yAt = startY;
+		float yAt = startY - first_line_row*newLineIncrement;
+
+		//NOTE: Count the rows each line takes, so the lines after it know where they start next frame
+		s64 line_start_offset = layout_start;
+		s64 line_rows = 1;
+		s64 cursor_offset = wl_buffer_get_cursor(b);
 
 		float max_x = 0;
 
 		float cursorX = startX;
 		float cursorY = startY;
 
-		float newLineIncrement = font.fontHeight*fontScale*editorState->line_spacing;
-
 		bool parsing = true;
-		EasyTokenizer tokenizer = lexBeginParsing((char *)buffer_to_draw.memory, EASY_LEX_OPTION_NONE);
+		WL_Buffer_View_Tokenizer tokenizer = wl_buffer_view_begin_lexing(&buffer_to_draw, &globalPerFrameArena, lex_checkpoint.offset, lex_checkpoint.lineNumber);
 
 		bool hit_start = true;
 		bool hit_end = true;
 
-		s32 memory_offset = 0;
+		s64 memory_offset = 0;
 
 		bool drawing = false;
 		//NOTE: Output the buffer
 
 		bool got_cursor = false;
 
-		bool in_select = false;
+		//NOTE: The selection might have started above the screen
+		bool in_select = (buffer_to_draw.shift_begin < layout_start && layout_start < buffer_to_draw.shift_end);
 
 		//NOTE: Null if this isn't the active buffer
 		int searchBufferAt = 0;
@@ -216,6 +261,13 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 		Highlight_Array *highlight_array = 0;
 		highlight_array = init_highlight_array(&globalPerFrameArena);
 
+		//NOTE: The extra cursors on the screen, in order through the text
+		s32 extra_site_count = 0;
+		s32 extra_site_at = 0;
+		Multi_Cursor_Site *extra_sites = multiCursor_get_sites_in_range(&open_buffer->selectable_state, b, &globalPerFrameArena, layout_start, layout_end, &extra_site_count);
+		float2 *extra_cursor_positions = pushArray(&globalPerFrameArena, extra_site_count, float2);
+		s32 extra_cursor_count = 0;
+
 		if(is_active) {
 			open_buffer->cursor_blink_time += 2*dt;
 
@@ -241,10 +293,25 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 		while(parsing) {
 			bool isNotNullTerminator = true;
 
-			EasyToken token = lexGetNextToken(&tokenizer);
+			EasyToken token = wl_buffer_view_get_next_token(&tokenizer);
+			s64 token_offset = wl_buffer_view_get_token_offset(&tokenizer, token.at);
+
+			if(token.type != TOKEN_NULL_TERMINATOR) {
+				wl_buffer_add_lex_checkpoint(b, token_offset, token.lineNumber);
+
+				//NOTE: Still above the screen
+				if(token_offset + token.size <= layout_start) {
+					continue;
+				}
+			}
 
 			if(token.type == TOKEN_NULL_TERMINATOR) {
-				memory_offset = (s32)((char *)token.at - (char *)buffer_to_draw.memory); 
+				memory_offset = wl_buffer_view_get_token_offset(&tokenizer, token.at); 
+
+				//NOTE: The last line doesn't end in a newline. The view can stop before the end of the buffer, then the line's carried on past it.
+				if(should_wrap_text && memory_offset == wl_buffer_get_size_in_bytes(b)) {
+					wl_buffer_set_wrapped_rows(b, line_start_offset, memory_offset, line_rows - 1);
+				}
 
 				check_if_clicking_of_dragging_nearby(memory_offset, tried_clicking, mouseIsDown, xAt, yAt, mouse_point_top_left_origin, &closest_click_distance, &closest_click_buffer_point);
 
@@ -276,9 +343,14 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 
 			char *at = token.at;
 			char *start_token = token.at;
+
+			//NOTE: Token started above the screen, like a comment over a few lines
+			if(token_offset < layout_start) {
+				at += (layout_start - token_offset);
+			}
 			while((at - start_token) < token.size && isNotNullTerminator) {
 
-				memory_offset = (s32)((char *)at - (char *)buffer_to_draw.memory); 
+				memory_offset = wl_buffer_view_get_token_offset(&tokenizer, at); 
 
 				u32 rune = easyUnicode_utf8_codepoint_To_Utf32_codepoint(&((char *)at), true);
 
@@ -316,8 +388,25 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 					got_cursor = true; 
 				}
 
+				//NOTE: The extra cursors & what they've got selected
+				bool in_extra_select = false;
+				{
+					while(extra_site_at < extra_site_count && extra_sites[extra_site_at].end < memory_offset) {
+						extra_site_at++;
+					}
 
-				if(rune == '\n' || rune == '\r' || (editorState->should_wrap_text && xAt > window_bounds.maxX)) {
+					if(extra_site_at < extra_site_count) {
+						Multi_Cursor_Site *site = &extra_sites[extra_site_at];
+						if(site->cursor == memory_offset) {
+							extra_cursor_positions[extra_cursor_count++] = make_float2(xAt, yAt);
+						}
+						in_extra_select = (site->start <= memory_offset && memory_offset < site->end);
+					}
+				}
+
+
+				bool is_newline = (rune == '\n' || rune == '\r');
+				if(is_newline || (should_wrap_text && xAt > window_bounds.maxX)) {
 					yAt -= newLineIncrement;
 					xAt = startX;
 
@@ -326,7 +415,7 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 						assert(token.size == 2);
 
 						//NOTE: Check the cursor location again
-						memory_offset = (s32)((char *)at - (char *)buffer_to_draw.memory); 
+						memory_offset = wl_buffer_view_get_token_offset(&tokenizer, at); 
 						if(memory_offset == buffer_to_draw.cursor_at) {
 							cursorX = xAt;
 							cursorY = yAt;
@@ -337,13 +426,29 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 						at++;
 					}
 
+					if(is_newline) {
+						if(should_wrap_text) {
+							s64 row_change = wl_buffer_set_wrapped_rows(b, line_start_offset, memory_offset, line_rows - 1);
+
+							//NOTE: The top line is a different height to what we thought, so keep the lines under it where they were. 
+							//		Unless it's the line being typed on, then it's the line that should stay put.
+							bool has_cursor = (line_start_offset <= cursor_offset && cursor_offset <= memory_offset);
+							if(row_change != 0 && line_start_offset == layout_start && !has_cursor) {
+								open_buffer->scroll_pos.y += row_change*newLineIncrement;
+								open_buffer->scroll_target_pos.y += row_change*newLineIncrement;
+							}
+						}
+
+						line_start_offset = wl_buffer_view_get_token_offset(&tokenizer, at);
+						line_rows = 1;
+					} else {
+						line_rows++;
+					}
+
 					//NOTE: Gone below the window view
 					if(yAt < -window_bounds.maxY) {
 						drawing = false;
-						if (!w->needToGetTotalBounds) {
-							parsing = false;
-						}	
-						
+						parsing = false;
 					}
 					
 				} else {
@@ -379,7 +484,7 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 						pos.z = 1.0f;
 
 						//NOTE: If highlighting the text
-						if(in_select) {
+						if(in_select || in_extra_select) {
 							float2 selectScale = scale;
 							selectScale.y = default_hight_light_height;
 
@@ -434,12 +539,10 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 		open_buffer->max_scroll_bounds.x = max_x - startX;
 
 
-		if (w->needToGetTotalBounds) {
-			//both should be positive versions
-			open_buffer->max_scroll_bounds.y = get_abs_value(yAt - startY);
-
-			w->needToGetTotalBounds = false;
-		}
+		//NOTE: The line index knows how many lines there are, and the buffer remembers how many rows the wrapped ones took, so this is always up to date
+		s64 last_line_row = (should_wrap_text) ? wl_buffer_get_wrapped_row_of_line(b, line_count - 1) : (line_count - 1);
+		open_buffer->max_scroll_bounds.y = (float)last_line_row*newLineIncrement;
+		w->needToGetTotalBounds = false;
 
 		//NOTE: Update cursor postion
 		if(memory_offset == buffer_to_draw.cursor_at) {
@@ -450,6 +553,25 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 			got_cursor = true;
 		}
 
+		for(; extra_site_at < extra_site_count; ++extra_site_at) {
+			if(extra_sites[extra_site_at].cursor == memory_offset) {
+				extra_cursor_positions[extra_cursor_count++] = make_float2(xAt, yAt);
+			}
+		}
+
+		//NOTE: The cursor is off the screen so we didn't lay it out, but scrolling to it still needs to know where it is
+		if(!got_cursor) {
+			s64 cursor_line = wl_buffer_get_line_index(b, buffer_to_draw.cursor_at);
+			if(should_wrap_text) {
+				//NOTE: We don't know which row of its line it's on, but the start of the line is close enough to scroll to
+				cursorX = startX;
+				cursorY = startY - wl_buffer_get_wrapped_row_of_line(b, cursor_line)*newLineIncrement;
+			} else {
+				cursorX = startX + getXposAtInLine(b, &font, fontScale);
+				cursorY = startY - cursor_line*newLineIncrement;
+			}
+		}
+
 		//assert(got_cursor);
 
 		//NOTE:Just active buffer logic
@@ -473,8 +595,19 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 
 			if(tried_clicking) {
 				if(closest_click_distance.x != FLT_MAX) { //NOTE: See if this is a valid position 
-					endGapBuffer(b);
-					b->cursorAt_inBytes = closest_click_buffer_point;
+					//NOTE: Ctrl click keeps the cursor that's there as an extra one, & dragging from it makes a column of cursors
+					open_buffer->selectable_state.is_column_select = global_platformInput.keyStates[PLATFORM_KEY_CTRL].isDown && !global_platformInput.doubleClicked;
+					open_buffer->selectable_state.column_start_offset_in_bytes = closest_click_buffer_point;
+
+					if(open_buffer->selectable_state.is_column_select) {
+						if(wl_buffer_get_cursor(b) != (s64)closest_click_buffer_point) {
+							multiCursor_add(&open_buffer->selectable_state, b, wl_buffer_get_cursor(b), wl_buffer_get_cursor(b));
+						}
+					} else {
+						multiCursor_clear(&open_buffer->selectable_state, b);
+					}
+
+					wl_buffer_set_cursor(b, closest_click_buffer_point);
 
 					//NOTE: Reset the blink rate
 					open_buffer->cursor_blink_time = 0.0f;
@@ -483,33 +616,38 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 
 					//NOTE: User double clicked on a glyph, so see if clicked a word
 					if(global_platformInput.doubleClicked) {
-						DoubleClickWordResult doubleClickResult = isDoubleClickInWord(closest_click_buffer_point, (char *)buffer_to_draw.memory);
+						DoubleClickWordResult doubleClickResult = isDoubleClickInWord(closest_click_buffer_point, &buffer_to_draw);
 						if(doubleClickResult.isInWord) {
 
-							size_t shiftEnd = convert_compiled_byte_point_to_buffer_byte_point(b, doubleClickResult.shift_end);
-							size_t shiftStart = convert_compiled_byte_point_to_buffer_byte_point(b, doubleClickResult.shift_start);
+							size_t shiftEnd = doubleClickResult.shift_end;
+							size_t shiftStart = doubleClickResult.shift_start;
 
 							//NOTE: Update the highlight with the new bytes. Update select will set the start and end based on if this is a new active select
 							update_select(&open_buffer->selectable_state, shiftStart);
 							update_select(&open_buffer->selectable_state, shiftEnd);
 
-							b->cursorAt_inBytes = shiftEnd;
+							wl_buffer_set_cursor(b, shiftEnd);
 						}
 					} else {
 						//NOTE: Just reset the highlight text when we try clicking and prepare the select if the user is 
 						//		going to drag and highlight 
-						update_select(&open_buffer->selectable_state, b->cursorAt_inBytes);
+						update_select(&open_buffer->selectable_state, wl_buffer_get_cursor(b));
 					}
 				}
 			}
 
 			//NOTE: Drag select
 			if(mouseIsDown && open_buffer->selectable_state.is_active) {
-				endGapBuffer(b);
-				b->cursorAt_inBytes = closest_click_buffer_point;
+				if(open_buffer->selectable_state.is_column_select) {
+					if(open_buffer->selectable_state.column_start_offset_in_bytes != (s64)closest_click_buffer_point) {
+						multiCursor_select_column(&open_buffer->selectable_state, b, open_buffer->selectable_state.column_start_offset_in_bytes, closest_click_buffer_point, &font, fontScale);
+					}
+				} else {
+					wl_buffer_set_cursor(b, closest_click_buffer_point);
 
-				//NOTE: We are dragging 
-				update_select(&open_buffer->selectable_state, b->cursorAt_inBytes);
+					//NOTE: We are dragging 
+					update_select(&open_buffer->selectable_state, wl_buffer_get_cursor(b));
+				}
 
 				//NOTE: How far to jump when we're trying to scroll and get to the edges
 				float scroll_factor = 0.05f;
@@ -548,7 +686,7 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 
 				color.w = 0.5f;
 				//NOTE: Draw the highlighted search rectangles
-				for(int i = 0; i < editorState->current_search_reults.byteOffsetCount; ++i) {
+				for(int i = 0; i < searchBufferAt; ++i) {
 					float2 p = rectsToDraw_forSearch[i];
 
 					Rect2f r = make_rect2f(p.x, p.y, p.x + width, p.y + height);
@@ -583,10 +721,15 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 				scale.x = 3;
 
 				pushTexture(renderer, global_white_texture, make_float3(cursorX, cursorY + 0.25f*font.fontHeight*fontScale, 1.0f), scale, cursorColor, make_float4(0, 1, 0, 1));
+
+				for(int i = 0; i < extra_cursor_count; ++i) {
+					float2 p = extra_cursor_positions[i];
+					pushTexture(renderer, global_white_texture, make_float3(p.x - 0.5f*cursor_width*fontScale, p.y + 0.25f*font.fontHeight*fontScale, 1.0f), scale, cursorColor, make_float4(0, 1, 0, 1));
+				}
 			}
 		}
 		//NOTE: This is drawing the selectable overlay 
-		if(open_buffer->selectable_state.is_active) {
+		if(open_buffer->selectable_state.is_active || extra_site_count > 0) {
 			
 			for(int i = 0; i < highlight_array->number_of_rects; ++i) {
 				Hightlight_Rect *r = highlight_get_rectangle(highlight_array, i); 
@@ -615,6 +758,18 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 			pushShader(renderer, &rectOutlineShader);
 			pushRectOutline(renderer, make_float3(centre.x, centre.y, 1.0f), scale, editorState->color_palette.standard);
 
+			//NOTE: Draw how much of the file has loaded along the bottom of the title
+			float load_percent = -1;
+			if(open_buffer->file_load && open_buffer->file_load->file_size_in_bytes > 0) {
+				load_percent = (float)open_buffer->file_load->bytes_added / (float)open_buffer->file_load->file_size_in_bytes;
+
+				pushShader(renderer, &textureShader);
+				float bar_height = 0.1f*buffer_title_height;
+				float bar_width = load_percent*window_scale.x;
+				float4 bar_color = editorState->color_palette.function;
+				pushTexture(renderer, global_white_texture, make_float3(window_bounds.minX + 0.5f*bar_width, -window_bounds.minY - buffer_title_height + 0.5f*bar_height, 1.0f), make_float2(bar_width, bar_height), bar_color, make_float4(0, 0, 1, 1));
+			}
+
 			//NOTE: Draw the name of the file
 			pushShader(renderer, &sdfFontShader);
 
@@ -622,7 +777,11 @@ static void draw_wl_window(EditorState *editorState, WL_Window *w, Renderer *ren
 
 			char *name_str = open_buffer->name;
 
-			if(!open_buffer->is_up_to_date) {
+			if(load_percent >= 0) {
+				name_str = easy_createString_printf(&globalPerFrameArena, "%s  loading %d%%  (esc to stop)", open_buffer->name, (int)(100*load_percent));
+			} else if(open_buffer->save_failed) {
+				name_str = easy_createString_printf(&globalPerFrameArena, "%s  *  save failed", open_buffer->name);
+			} else if(!open_buffer->is_up_to_date) {
 
 				name_str = easy_createString_printf(&globalPerFrameArena, "%s  %s", open_buffer->name, "*");
 			}